@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "program.h"
+#include "endian.h"
+
+#include <callback/archive.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(MSVC)
+  #include <windows.h>
+#endif
+
+#include <vector>
+#include <string>
+
+using namespace callback;
+
+struct ArchivedProgram
+{
+  std::string       m_Name;
+  std::vector<char> m_Program;
+};
+
+typedef std::vector<ArchivedProgram> ArchivedPrograms;
+
+static void swap_header( ArchiveHeader* h )
+{
+  EndianSwap( h->m_Magic );
+  EndianSwap( h->m_Version );
+  EndianSwap( h->m_Count );
+  EndianSwap( h->m_Size );
+  EndianSwap( h->m_Checksum );
+}
+
+static void swap_entry( ArchiveEntry* e )
+{
+  EndianSwap( e->m_Offset );
+  EndianSwap( e->m_Size );
+  EndianSwap( e->m_Checksum );
+  EndianSwap( e->m_Pad );
+}
+
+static bool read_whole( FILE* f, std::vector<char>* out )
+{
+  fseek( f, 0, SEEK_END );
+  long size = ftell( f );
+  fseek( f, 0, SEEK_SET );
+  if( size < 0 )
+    return false;
+  out->resize( size );
+  return size == 0 || fread( &(*out)[0], 1, size, f ) == (size_t)size;
+}
+
+/*
+ * Reads the programs of an existing archive, written in the same byte order.
+ * Returns -1 if the file is there but is not such an archive.
+ */
+static int load_archive( const char* archive, bool swapEndian, ArchivedPrograms* out )
+{
+  FILE* f = fopen( archive, "rb" );
+  if( !f )
+    return 0;
+  std::vector<char> file;
+  bool ok = read_whole( f, &file );
+  fclose( f );
+  if( !ok || file.size() < sizeof(ArchiveHeader) )
+    return -1;
+
+  ArchiveHeader h;
+  memcpy( &h, &file[0], sizeof(ArchiveHeader) );
+  if( swapEndian )
+    swap_header( &h );
+  if( h.m_Magic != ARCHIVE_MAGIC || h.m_Version != ARCHIVE_VERSION
+    || h.m_Size != file.size()
+    || h.m_Count > file.size() / sizeof(ArchiveEntry) )
+    return -1;
+
+  for( unsigned int i = 0; i < h.m_Count; ++i )
+  {
+    ArchiveEntry e;
+    memcpy( &e, &file[sizeof(ArchiveHeader) + sizeof(ArchiveEntry) * i], sizeof(ArchiveEntry) );
+    if( swapEndian )
+      swap_entry( &e );
+    if( e.m_Offset > file.size() || e.m_Size > file.size() - e.m_Offset )
+      return -1;
+    e.m_Name[ARCHIVE_NAME_SIZE - 1] = 0;
+
+    ArchivedProgram ap;
+    ap.m_Name = e.m_Name;
+    ap.m_Program.assign( file.begin() + e.m_Offset, file.begin() + e.m_Offset + e.m_Size );
+    out->push_back( ap );
+  }
+  return 0;
+}
+
+static unsigned int align( unsigned int v )
+{
+  return (v + ARCHIVE_ALIGNMENT - 1) & ~(ARCHIVE_ALIGNMENT - 1);
+}
+
+static bool write_archive( FILE* f, bool swapEndian, const ArchivedPrograms& programs )
+{
+  const unsigned int count = (unsigned int)programs.size();
+  std::vector<ArchiveEntry> entries( count );
+
+  unsigned int offset = align( sizeof(ArchiveHeader) + sizeof(ArchiveEntry) * count );
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    ArchiveEntry& e = entries[i];
+    memset( &e, 0, sizeof(ArchiveEntry) );
+    strcpy( e.m_Name, programs[i].m_Name.c_str() );
+    e.m_Offset   = offset;
+    e.m_Size     = (unsigned int)programs[i].m_Program.size();
+    e.m_Checksum = archive_checksum( &programs[i].m_Program[0], e.m_Size );
+    if( swapEndian )
+      swap_entry( &e );
+    offset = align( offset + (unsigned int)programs[i].m_Program.size() );
+  }
+
+  ArchiveHeader h;
+  h.m_Magic    = ARCHIVE_MAGIC;
+  h.m_Version  = ARCHIVE_VERSION;
+  h.m_Count    = count;
+  h.m_Size     = offset;
+  h.m_Checksum = count ? archive_checksum( &entries[0], sizeof(ArchiveEntry) * count ) : 0;
+  if( swapEndian )
+    swap_header( &h );
+
+  std::vector<char> file( offset, 0 );
+  memcpy( &file[0], &h, sizeof(ArchiveHeader) );
+  if( count )
+    memcpy( &file[sizeof(ArchiveHeader)], &entries[0], sizeof(ArchiveEntry) * count );
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    unsigned int o = entries[i].m_Offset;
+    if( swapEndian )
+      EndianSwap( o );
+    memcpy( &file[o], &programs[i].m_Program[0], programs[i].m_Program.size() );
+  }
+  return fwrite( &file[0], 1, file.size(), f ) == file.size();
+}
+
+/*
+ * Moves "from" over "to" in one step. Readers that have "to" open or mapped
+ * keep the file they had.
+ */
+static bool replace_file( const char* from, const char* to )
+{
+#if defined(MSVC)
+  return MoveFileExA( from, to, MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+  return rename( from, to ) == 0;
+#endif
+}
+
+int save_archive( const char* archive, const char* name, bool swapEndian, Program* p )
+{
+  if( strlen( name ) >= ARCHIVE_NAME_SIZE )
+  {
+    fprintf( stderr, "error: program name \"%s\" is too long for an archive.\n", name );
+    return -1;
+  }
+
+  ArchivedPrograms programs;
+  if( load_archive( archive, swapEndian, &programs ) != 0 )
+  {
+    fprintf( stderr, "error: %s is not an archive of this version and byte order.\n",
+      archive );
+    return -1;
+  }
+
+  ArchivedProgram ap;
+  ap.m_Name = name;
+  FILE* tmp = tmpfile();
+  bool ok = tmp && save_program( tmp, swapEndian, p ) == 0 && read_whole( tmp, &ap.m_Program );
+  if( tmp )
+    fclose( tmp );
+  if( !ok )
+    return -1;
+
+  //Replace the program with the same name, or add it last
+  ArchivedPrograms::iterator it, it_e( programs.end() );
+  for( it = programs.begin(); it != it_e; ++it )
+  {
+    if( it->m_Name == ap.m_Name )
+      break;
+  }
+  if( it != it_e )
+    it->m_Program.swap( ap.m_Program );
+  else
+    programs.push_back( ap );
+
+  //Written next to the archive and moved over it, so the archive is never
+  //left half written and running programs mapped from it are not changed
+  const std::string written = std::string( archive ) + ".tmp";
+  FILE* f = fopen( written.c_str(), "wb" );
+  if( !f )
+  {
+    fprintf( stderr, "error: unable to open %s for writing.\n", written.c_str() );
+    return -1;
+  }
+  ok = write_archive( f, swapEndian, programs );
+  ok = fclose( f ) == 0 && ok;
+  if( ok && !replace_file( written.c_str(), archive ) )
+  {
+    fprintf( stderr, "error: unable to replace archive %s.\n", archive );
+    ok = false;
+  }
+  if( !ok )
+    remove( written.c_str() );
+  return ok ? 0 : -1;
+}
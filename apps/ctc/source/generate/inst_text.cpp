@@ -37,6 +37,11 @@ const char * const g_InstructionNames[MAXIMUM_INSTRUCTION_COUNT] =
     "INST_CALL_DEST_FUN",
     "INST_CALL_PRUN_FUN",
     "INST_CALL_MODI_FUN",
+    "INST_FUSE_CONS_FUN",
+    "INST_FUSE_EXEC_FUN",
+    "INST_FUSE_DEST_FUN",
+    "INST_FUSE_PRUN_FUN",
+    "INST_FUSE_MODI_FUN",
     "INST_JABC_R_EQUA_C",
     "INST_JABC_R_DIFF_C",
     "INST_JABC_C_EQUA_B",
@@ -66,5 +71,11 @@ const char * const g_InstructionNames[MAXIMUM_INSTRUCTION_COUNT] =
     "INST_LOAD_REGISTRY",
     "INST_SCRIPT_C",
     "INST_SCRIPT_R",
+    "INST_SCRIPT_A",
+    "INST_SCRIPT_P",
+    "INST_SCRIPT_F",
+    "INST_COUNT_NODE",
+    "INST_TRACE_NODE",
+    "INST_BREAKPOINT",
     "INST_______SUSPEND"
 };
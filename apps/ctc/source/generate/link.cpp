@@ -0,0 +1,837 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "program.h"
+#include "link.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace callback;
+
+void print_instruction( FILE* outFile, const WideInstruction& inst, int g, int f,
+  bool wide );
+
+typedef std::vector<WideInstruction> Instructions;
+typedef std::vector<unsigned char>   Kinds;
+
+/*
+ * Finds what moved when the program was generated again at LINK_CODE_SHIFT
+ * and LINK_DATA_SHIFT. Anything else that differs is an error.
+ */
+static int find_relocations( Program* p, Program* s, std::vector<LinkReloc>* out )
+{
+  const int count = p->m_I.Count();
+  if( s->m_I.Count() != count + (int)LINK_CODE_SHIFT || s->m_D.Size() != p->m_D.Size()
+    || s->m_D.BlockCount() != p->m_D.BlockCount() )
+    return -1;
+
+  for( int i = 0; i < count; ++i )
+  {
+    const WideInstruction& a = p->m_I.Get( i );
+    const WideInstruction& b = s->m_I.Get( i + LINK_CODE_SHIFT );
+    if( a.m_I != b.m_I )
+      return -1;
+
+    LinkReloc r;
+    r.m_Index = i;
+    if( a.m_I == INST_LOAD_REGISTRY )
+    {
+      WideVMIType d = ((b.m_A2 << 16) + b.m_A3) - ((a.m_A2 << 16) + a.m_A3);
+      if( a.m_A1 != b.m_A1 || (d != 0 && d != LINK_DATA_SHIFT) )
+        return -1;
+      r.m_Type = E_LINK_DATA_JOINED;
+      r.m_Operand = 2;
+      if( d != 0 )
+        out->push_back( r );
+      continue;
+    }
+
+    const WideVMIType* oa[3] = { &a.m_A1, &a.m_A2, &a.m_A3 };
+    const WideVMIType* ob[3] = { &b.m_A1, &b.m_A2, &b.m_A3 };
+    for( int o = 0; o < 3; ++o )
+    {
+      WideVMIType d = *ob[o] - *oa[o];
+      if( d == 0 )
+        continue;
+      if( d == LINK_CODE_SHIFT )
+        r.m_Type = E_LINK_CODE;
+      else if( d == LINK_DATA_SHIFT )
+        r.m_Type = E_LINK_DATA;
+      else
+        return -1;
+      r.m_Operand = o + 1;
+      out->push_back( r );
+    }
+  }
+
+  //The debug scopes moved with the code, and with the names they point at
+  if( s->m_I.DebugScopeCount() != p->m_I.DebugScopeCount() )
+    return -1;
+  for( int i = 0; i < p->m_I.DebugScopeCount(); ++i )
+  {
+    const DebugScope& a = p->m_I.GetDebugScope( i );
+    const DebugScope& b = s->m_I.GetDebugScope( i );
+    if( b.m_IP - a.m_IP != LINK_CODE_SHIFT || b.m_Begin - a.m_Begin != LINK_CODE_SHIFT
+      || b.m_End - a.m_End != LINK_CODE_SHIFT || b.m_Action - a.m_Action != LINK_DATA_SHIFT
+      || b.m_Name - a.m_Name != LINK_DATA_SHIFT || a.m_NodeId != b.m_NodeId
+      || a.m_Flags != b.m_Flags || a.m_LineNo != b.m_LineNo )
+      return -1;
+  }
+
+  //Their table is left out, the linker makes its own
+  const int table = p->m_I.DebugScopeCount() != 0 ? p->m_DebugTable : -1;
+  const char* da = p->m_D.Data();
+  const char* db = s->m_D.Data();
+  for( int i = 0; i < p->m_D.BlockCount(); ++i )
+  {
+    int type, offset, values;
+    p->m_D.GetBlock( i, &type, &offset, &values );
+    if( offset == table )
+      continue;
+    if( type == DataSection::E_DT_STRING )
+    {
+      if( strcmp( da + offset, db + offset ) != 0 )
+        return -1;
+      continue;
+    }
+    for( int v = 0; v < values; ++v )
+    {
+      const int o = offset + sizeof(int) * v;
+      unsigned int d = *(const unsigned int*)(db + o) - *(const unsigned int*)(da + o);
+      if( d == 0 )
+        continue;
+      if( d != LINK_DATA_SHIFT || type != DataSection::E_DT_INTEGER )
+        return -1;
+      LinkReloc r;
+      r.m_Type = E_LINK_DATA_WORD;
+      r.m_Index = o;
+      r.m_Operand = 0;
+      out->push_back( r );
+    }
+  }
+  return 0;
+}
+
+template<typename T>
+static bool write_array( FILE* f, const T* data, size_t count )
+{
+  return count == 0 || fwrite( data, sizeof(T), count, f ) == count;
+}
+
+int save_unit( const char* unit, BehaviorTreeContext ctx, Program* p, Program* shifted )
+{
+  //The counter blocks of the units would share bss
+  if( !p->m_CounterIds.empty() )
+  {
+    fprintf( stderr, "error: programs with node counters can not be linked.\n" );
+    return -1;
+  }
+  shifted->m_I.SetBase( LINK_CODE_SHIFT );
+  shifted->m_D.SetBase( LINK_DATA_SHIFT );
+  int r = setup( ctx, shifted );
+  if( r == 0 )
+    r = generate( shifted );
+  teardown( shifted );
+
+  std::vector<LinkReloc> relocs;
+  if( r != 0 || find_relocations( p, shifted, &relocs ) != 0 )
+  {
+    fprintf( stderr, "error: unable to find the relocations of the program.\n" );
+    return -1;
+  }
+
+  std::vector<LinkTree> trees;
+  for( BehaviorTreeList* btl = p->m_First; btl; btl = btl->m_Next )
+  {
+    const char* name = btl->m_Tree->m_Id.m_Text;
+    if( strlen( name ) >= LINK_NAME_SIZE )
+    {
+      fprintf( stderr, "error: tree name \"%s\" is too long for a link unit.\n", name );
+      return -1;
+    }
+    LinkTree t;
+    memset( &t, 0, sizeof(LinkTree) );
+    strcpy( t.m_Name, name );
+    t.m_First = btl->m_FirstInst;
+    t.m_Count = (btl->m_Next ? btl->m_Next->m_FirstInst : p->m_I.Count()) - t.m_First;
+    trees.push_back( t );
+  }
+
+  const int table = p->m_I.DebugScopeCount() != 0 ? p->m_DebugTable : -1;
+  std::vector<LinkBlock> blocks;
+  for( int i = 0; i < p->m_D.BlockCount(); ++i )
+  {
+    int type, offset, values;
+    p->m_D.GetBlock( i, &type, &offset, &values );
+    if( offset == table )
+      continue;
+    LinkBlock b;
+    b.m_Type   = type;
+    b.m_Offset = offset;
+    b.m_Count  = values;
+    blocks.push_back( b );
+  }
+
+  std::vector<DebugScope> scopes( p->m_I.DebugScopeCount() );
+  for( size_t i = 0; i < scopes.size(); ++i )
+    scopes[i] = p->m_I.GetDebugScope( (int)i );
+
+  Instructions inst( p->m_I.Count() );
+  for( size_t i = 0; i < inst.size(); ++i )
+    inst[i] = p->m_I.Get( (int)i );
+
+  LinkHeader h;
+  h.m_Magic   = LINK_MAGIC;
+  h.m_Version = LINK_VERSION;
+  h.m_IC      = (unsigned int)inst.size();
+  h.m_DS      = p->m_D.Size();
+  h.m_BS      = p->m_Memory;
+  h.m_FS      = p->m_FrameSize;
+  h.m_FC      = p->m_FrameCount;
+  h.m_CC      = (unsigned int)p->m_Callbacks.size();
+  h.m_CT      = p->m_CallbackTable;
+  h.m_TC      = (unsigned int)trees.size();
+  h.m_RC      = (unsigned int)relocs.size();
+  h.m_BC      = (unsigned int)blocks.size();
+  h.m_SC      = (unsigned int)scopes.size();
+
+  FILE* f = fopen( unit, "wb" );
+  if( !f )
+  {
+    fprintf( stderr, "error: unable to open link unit %s for writing.\n", unit );
+    return -1;
+  }
+  bool ok = write_array( f, &h, 1 );
+  ok = ok && write_array( f, inst.empty() ? 0x0 : &inst[0], inst.size() );
+  ok = ok && write_array( f, p->m_D.Data(), h.m_DS );
+  ok = ok && write_array( f, trees.empty() ? 0x0 : &trees[0], trees.size() );
+  ok = ok && write_array( f, relocs.empty() ? 0x0 : &relocs[0], relocs.size() );
+  ok = ok && write_array( f, blocks.empty() ? 0x0 : &blocks[0], blocks.size() );
+  ok = ok && write_array( f, scopes.empty() ? 0x0 : &scopes[0], scopes.size() );
+  fclose( f );
+  return ok ? 0 : -1;
+}
+
+/*
+ * Linking lays the units out as one program. The code at instruction zero
+ * jumps to the entry stub of the agent's unit, see set_entry_point, and each
+ * tree is linked once for all the units that have it. Trees are the same if
+ * their instructions are, once callback indices and data offsets are the
+ * linked ones and calls are made by tree name. A tree must be the same in all
+ * units that have a tree of its name, except "main" which every unit has its
+ * own of; it is still linked once if it is the same as another unit's. The
+ * debug scopes of a tree go with its code, a tree linked once for several
+ * units has the scopes of the first of them.
+ */
+
+// Operand kind while linking, a call to the tree that is number A in the name
+// table of the Linker.
+const unsigned char E_LINK_CALL = E_LINK_DATA_WORD + 1;
+
+// The code at instruction zero.
+const unsigned int LINK_DISPATCH = 3;
+
+struct Unit
+{
+  std::string               m_Name;
+  LinkHeader                m_Header;
+  Instructions              m_Inst;
+  std::vector<char>         m_Data;
+  std::vector<LinkTree>     m_Trees;
+  std::vector<LinkReloc>    m_Relocs;
+  std::vector<LinkBlock>    m_Blocks;
+  std::vector<DebugScope>   m_Scopes;
+  Kinds                     m_Kind;      // LinkRelocType of the operands, three per instruction
+  std::vector<unsigned int> m_Words;     // Offsets of the E_LINK_DATA_WORDs, sorted
+  std::vector<int>          m_Callbacks; // Linked callback index of each of the unit's
+  std::map<unsigned int, unsigned int> m_DataMap; // Block offset to linked data offset
+};
+
+struct LinkedCode
+{
+  std::string  m_Name;
+  std::string  m_Units;
+  Instructions m_Inst; // E_LINK_CODE operands are from m_First
+  Kinds        m_Kind;
+  unsigned int m_First;
+  std::vector<DebugScope> m_Scopes; // Instructions are from m_First, as for the code
+};
+
+struct Linker
+{
+  std::vector<Unit>          m_Units;
+  std::vector<LinkedCode>    m_Stubs;
+  std::vector<LinkedCode>    m_Trees;
+  std::vector<std::string>   m_Names;
+  std::map<std::string, int> m_NameIds;
+  std::map<std::string, int> m_ByName;    // Tree name to m_Trees index
+  std::map<std::string, int> m_ByContent; // Instructions to m_Trees index
+  std::map<std::string, int> m_Blocks;    // Type and bytes to linked data offset
+};
+
+template<typename T>
+static const char* read_array( const char* r, unsigned int count, std::vector<T>* out )
+{
+  out->resize( count );
+  if( count )
+    memcpy( &(*out)[0], r, sizeof(T) * count );
+  return r + sizeof(T) * count;
+}
+
+static bool valid_unit( const Unit& u, size_t size )
+{
+  const LinkHeader& h = u.m_Header;
+  if( h.m_Magic != LINK_MAGIC || h.m_Version != LINK_VERSION || h.m_TC == 0 )
+    return false;
+  return size == sizeof(LinkHeader) + sizeof(WideInstruction) * h.m_IC + h.m_DS
+    + sizeof(LinkTree) * h.m_TC + sizeof(LinkReloc) * h.m_RC + sizeof(LinkBlock) * h.m_BC
+    + sizeof(DebugScope) * h.m_SC
+    && h.m_CT + sizeof(int) * h.m_CC <= h.m_DS;
+}
+
+static int load_unit( const char* path, Unit* u )
+{
+  FILE* f = fopen( path, "rb" );
+  if( !f )
+  {
+    fprintf( stderr, "error: unable to open link unit %s for reading.\n", path );
+    return -1;
+  }
+  fseek( f, 0, SEEK_END );
+  long size = ftell( f );
+  fseek( f, 0, SEEK_SET );
+  std::vector<char> file( size > 0 ? size : 0 );
+  bool ok = size >= (long)sizeof(LinkHeader)
+    && fread( &file[0], 1, size, f ) == (size_t)size;
+  fclose( f );
+
+  if( ok )
+  {
+    memcpy( &u->m_Header, &file[0], sizeof(LinkHeader) );
+    ok = valid_unit( *u, file.size() );
+  }
+  if( !ok )
+  {
+    fprintf( stderr, "error: %s is not a link unit of this version.\n", path );
+    return -1;
+  }
+
+  const LinkHeader& h = u->m_Header;
+  const char* r = &file[sizeof(LinkHeader)];
+  r = read_array( r, h.m_IC, &u->m_Inst );
+  r = read_array( r, h.m_DS, &u->m_Data );
+  r = read_array( r, h.m_TC, &u->m_Trees );
+  r = read_array( r, h.m_RC, &u->m_Relocs );
+  r = read_array( r, h.m_BC, &u->m_Blocks );
+  r = read_array( r, h.m_SC, &u->m_Scopes );
+
+  u->m_Kind.assign( h.m_IC * 3, (unsigned char)E_LINK_NONE );
+  for( unsigned int i = 0; i < h.m_RC; ++i )
+  {
+    const LinkReloc& lr = u->m_Relocs[i];
+    if( lr.m_Type == E_LINK_DATA_WORD )
+      u->m_Words.push_back( lr.m_Index );
+    else if( lr.m_Index < h.m_IC && lr.m_Operand >= 1 && lr.m_Operand <= 3 )
+      u->m_Kind[lr.m_Index * 3 + lr.m_Operand - 1] = (unsigned char)lr.m_Type;
+    else
+      ok = false;
+  }
+  std::sort( u->m_Words.begin(), u->m_Words.end() );
+
+  for( unsigned int i = 0; i < h.m_TC; ++i )
+  {
+    const LinkTree& t = u->m_Trees[i];
+    if( t.m_Name[LINK_NAME_SIZE - 1] != 0 || t.m_First > h.m_IC
+      || t.m_Count > h.m_IC - t.m_First )
+      ok = false;
+  }
+  for( unsigned int i = 0; i < h.m_SC; ++i )
+  {
+    const DebugScope& s = u->m_Scopes[i];
+    if( s.m_Begin > s.m_End || s.m_End > h.m_IC || s.m_IP > h.m_IC )
+      ok = false;
+  }
+  if( !ok )
+  {
+    fprintf( stderr, "error: %s is not a link unit of this version.\n", path );
+    return -1;
+  }
+
+  //The unit is named after the file, without path or extension
+  const char* name = strrchr( path, '/' );
+  u->m_Name = name ? name + 1 : path;
+  size_t dot = u->m_Name.rfind( '.' );
+  if( dot != std::string::npos )
+    u->m_Name.erase( dot );
+  return 0;
+}
+
+/*
+ * The name a tree is linked by, "main" is the unit's own.
+ */
+static std::string tree_name( const Unit& u, unsigned int tree )
+{
+  if( tree == 0 )
+    return u.m_Name + ":main";
+  return u.m_Trees[tree].m_Name;
+}
+
+static int name_id( Linker* l, const std::string& name )
+{
+  std::map<std::string, int>::iterator it = l->m_NameIds.find( name );
+  if( it != l->m_NameIds.end() )
+    return it->second;
+  int id = (int)l->m_Names.size();
+  l->m_Names.push_back( name );
+  l->m_NameIds[name] = id;
+  return id;
+}
+
+static void link_callbacks( Linker* l, Program* p )
+{
+  p->m_Callbacks.clear();
+  for( size_t i = 0; i < l->m_Units.size(); ++i )
+  {
+    Unit& u = l->m_Units[i];
+    const int* ids = (const int*)(&u.m_Data[0] + u.m_Header.m_CT);
+    for( unsigned int c = 0; c < u.m_Header.m_CC; ++c )
+    {
+      CallbackIdList::iterator it = std::find( p->m_Callbacks.begin(),
+        p->m_Callbacks.end(), ids[c] );
+      u.m_Callbacks.push_back( (int)(it - p->m_Callbacks.begin()) );
+      if( it == p->m_Callbacks.end() )
+        p->m_Callbacks.push_back( ids[c] );
+    }
+  }
+}
+
+static bool map_data( const Unit& u, WideVMIType* v )
+{
+  std::map<unsigned int, unsigned int>::const_iterator it = u.m_DataMap.find( *v );
+  if( it == u.m_DataMap.end() )
+    return false;
+  *v = it->second;
+  return true;
+}
+
+/*
+ * Pushes the blocks of every unit that are not already in the linked data
+ * section. Blocks only refer to blocks pushed before them.
+ */
+static int link_data( Linker* l, Program* p )
+{
+  for( size_t i = 0; i < l->m_Units.size(); ++i )
+  {
+    Unit& u = l->m_Units[i];
+    for( size_t b = 0; b < u.m_Blocks.size(); ++b )
+    {
+      const LinkBlock& lb = u.m_Blocks[b];
+      //The callback table is made again
+      if( u.m_Header.m_CC && lb.m_Offset == u.m_Header.m_CT )
+        continue;
+
+      const char* data = &u.m_Data[0];
+      std::vector<WideVMIType> values;
+      std::string key( 1, (char)('0' + lb.m_Type) );
+      if( lb.m_Type == DataSection::E_DT_STRING )
+      {
+        if( lb.m_Offset >= u.m_Header.m_DS
+          || !memchr( data + lb.m_Offset, 0, u.m_Header.m_DS - lb.m_Offset ) )
+          return -1;
+        key += data + lb.m_Offset;
+      }
+      else
+      {
+        if( lb.m_Count == 0 || lb.m_Offset + sizeof(int) * lb.m_Count > u.m_Header.m_DS )
+          return -1;
+        values.resize( lb.m_Count );
+        memcpy( &values[0], data + lb.m_Offset, sizeof(int) * lb.m_Count );
+        for( unsigned int v = 0; v < lb.m_Count; ++v )
+        {
+          unsigned int o = lb.m_Offset + sizeof(int) * v;
+          if( std::binary_search( u.m_Words.begin(), u.m_Words.end(), o )
+            && !map_data( u, &values[v] ) )
+            return -1;
+        }
+        key.append( (const char*)&values[0], sizeof(int) * values.size() );
+      }
+
+      std::map<std::string, int>::iterator it = l->m_Blocks.find( key );
+      int offset;
+      if( it != l->m_Blocks.end() )
+        offset = it->second;
+      else if( lb.m_Type == DataSection::E_DT_STRING )
+        offset = p->m_D.PushString( data + lb.m_Offset );
+      else if( lb.m_Type == DataSection::E_DT_FLOAT )
+        offset = p->m_D.PushFloat( *(const float*)&values[0] );
+      else
+        offset = p->m_D.PushIntegers( (const int*)&values[0], (int)values.size() );
+      l->m_Blocks[key] = offset;
+      u.m_DataMap[lb.m_Offset] = offset;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Instructions "first" to "first + count" of the unit, with callback indices
+ * and data offsets linked and code operands relative to "first" or calls.
+ */
+static int relocate( Linker* l, const Unit& u, unsigned int first, unsigned int count,
+  LinkedCode* c )
+{
+  for( unsigned int i = first; i < first + count; ++i )
+  {
+    WideInstruction w = u.m_Inst[i];
+    unsigned char k[3];
+    memcpy( k, &u.m_Kind[i * 3], 3 );
+
+    if( w.m_I >= INST_FUSE_CONS_FUN && w.m_I <= INST_FUSE_MODI_FUN )
+    {
+      if( w.m_A1 >= u.m_Callbacks.size() )
+        return -1;
+      w.m_A1 = u.m_Callbacks[w.m_A1];
+    }
+
+    WideVMIType* a[3] = { &w.m_A1, &w.m_A2, &w.m_A3 };
+    for( int o = 0; o < 3; ++o )
+    {
+      switch( k[o] )
+      {
+      case E_LINK_CODE:
+        if( *a[o] >= first && *a[o] < first + count )
+        {
+          *a[o] -= first;
+        }
+        else
+        {
+          //Only whole trees are called
+          unsigned int t = 0;
+          while( t < u.m_Trees.size() && u.m_Trees[t].m_First != *a[o] )
+            ++t;
+          if( t == u.m_Trees.size() )
+            return -1;
+          *a[o] = name_id( l, tree_name( u, t ) );
+          k[o] = E_LINK_CALL;
+        }
+        break;
+      case E_LINK_DATA:
+        if( !map_data( u, a[o] ) )
+          return -1;
+        break;
+      case E_LINK_DATA_JOINED:
+        {
+          WideVMIType v = (w.m_A2 << 16) + w.m_A3;
+          if( !map_data( u, &v ) )
+            return -1;
+          w.m_A2 = (v & 0xffff0000) >> 16;
+          w.m_A3 = (v & 0x0000ffff);
+        }
+        break;
+      }
+    }
+    c->m_Inst.push_back( w );
+    c->m_Kind.insert( c->m_Kind.end(), k, k + 3 );
+  }
+
+  //The scopes of the nodes whose code starts in these instructions
+  for( size_t i = 0; i < u.m_Scopes.size(); ++i )
+  {
+    DebugScope s = u.m_Scopes[i];
+    if( s.m_Begin < first || s.m_Begin >= first + count )
+      continue;
+    if( s.m_End > first + count || s.m_IP < first || s.m_IP > first + count
+      || !map_data( u, &s.m_Action ) || !map_data( u, &s.m_Name ) )
+      return -1;
+    s.m_IP    -= first;
+    s.m_Begin -= first;
+    s.m_End   -= first;
+    c->m_Scopes.push_back( s );
+  }
+  return 0;
+}
+
+static std::string content( const LinkedCode& c )
+{
+  std::string s;
+  if( !c.m_Inst.empty() )
+  {
+    s.append( (const char*)&c.m_Inst[0], sizeof(WideInstruction) * c.m_Inst.size() );
+    s.append( (const char*)&c.m_Kind[0], c.m_Kind.size() );
+  }
+  return s;
+}
+
+static int link_trees( Linker* l )
+{
+  for( size_t i = 0; i < l->m_Units.size(); ++i )
+  {
+    const Unit& u = l->m_Units[i];
+
+    LinkedCode stub;
+    stub.m_Name = u.m_Name;
+    stub.m_Units = u.m_Name;
+    if( relocate( l, u, 0, u.m_Trees[0].m_First, &stub ) != 0 )
+    {
+      fprintf( stderr, "error: %s has code the linker can not follow.\n", u.m_Name.c_str() );
+      return -1;
+    }
+    l->m_Stubs.push_back( stub );
+    size_t scopes = stub.m_Scopes.size();
+
+    for( unsigned int t = 0; t < u.m_Trees.size(); ++t )
+    {
+      LinkedCode c;
+      c.m_Name = u.m_Trees[t].m_Name;
+      c.m_Units = u.m_Name;
+      if( relocate( l, u, u.m_Trees[t].m_First, u.m_Trees[t].m_Count, &c ) != 0 )
+      {
+        fprintf( stderr, "error: %s has code the linker can not follow.\n", u.m_Name.c_str() );
+        return -1;
+      }
+
+      scopes += c.m_Scopes.size();
+
+      const std::string name = tree_name( u, t );
+      const std::string key = content( c );
+      std::map<std::string, int>::iterator it = l->m_ByName.find( name );
+      if( it != l->m_ByName.end() )
+      {
+        LinkedCode& same = l->m_Trees[it->second];
+        if( content( same ) != key )
+        {
+          fprintf( stderr, "error: tree \"%s\" of %s is not the same as the one in %s.\n",
+            c.m_Name.c_str(), u.m_Name.c_str(), same.m_Units.c_str() );
+          return -1;
+        }
+        same.m_Units += " " + u.m_Name;
+        continue;
+      }
+
+      it = l->m_ByContent.find( key );
+      if( it != l->m_ByContent.end() )
+      {
+        l->m_Trees[it->second].m_Units += " " + u.m_Name;
+        l->m_ByName[name] = it->second;
+        continue;
+      }
+
+      l->m_ByName[name] = (int)l->m_Trees.size();
+      l->m_ByContent[key] = (int)l->m_Trees.size();
+      l->m_Trees.push_back( c );
+    }
+
+    //Every scope belongs to the code of one tree, or of the entry stub
+    if( scopes != u.m_Scopes.size() )
+    {
+      fprintf( stderr, "error: %s has debug scopes the linker can not follow.\n",
+        u.m_Name.c_str() );
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void push_code( const Linker& l, const LinkedCode& c, Program* p,
+  std::vector<DebugScope>* scopes )
+{
+  for( size_t i = 0; i < c.m_Scopes.size(); ++i )
+  {
+    DebugScope s = c.m_Scopes[i];
+    s.m_IP    += c.m_First;
+    s.m_Begin += c.m_First;
+    s.m_End   += c.m_First;
+    scopes->push_back( s );
+  }
+
+  for( size_t i = 0; i < c.m_Inst.size(); ++i )
+  {
+    WideInstruction w = c.m_Inst[i];
+    WideVMIType* a[3] = { &w.m_A1, &w.m_A2, &w.m_A3 };
+    for( int o = 0; o < 3; ++o )
+    {
+      if( c.m_Kind[i * 3 + o] == E_LINK_CODE )
+        *a[o] += c.m_First;
+      else if( c.m_Kind[i * 3 + o] == E_LINK_CALL )
+        *a[o] = l.m_Trees[l.m_ByName.find( l.m_Names[*a[o]] )->second].m_First;
+    }
+    p->m_I.Push( w.m_I, w.m_A1, w.m_A2, w.m_A3 );
+  }
+}
+
+static bool scope_before( const DebugScope& a, const DebugScope& b )
+{
+  return a.m_IP < b.m_IP;
+}
+
+static void print_code( FILE* f, const Program* p, const char* name, unsigned int first,
+  unsigned int count, bool wide )
+{
+  fprintf( f, "%s\n", name );
+  fprintf( f, "%-8s%-8s%-20s%-10s%-10s%-10s\n", "Global", "Func",
+    "Instruction", "A1", "A2", "A3" );
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    print_instruction( f, p->m_I.Get( first + i ), first + i, i, wide );
+    fprintf( f, "\n" );
+  }
+}
+
+static int print_linked( const char* listing, const Linker& l, Program* p )
+{
+  FILE* f = fopen( listing, "w" );
+  if( !f )
+  {
+    fprintf( stderr, "error: unable to open assembly file %s for writing.\n", listing );
+    return -1;
+  }
+
+  const bool wide = p->m_I.Flags() != 0;
+  print_code( f, p, "__dispatch", 0, LINK_DISPATCH, wide );
+  for( size_t i = 0; i < l.m_Stubs.size(); ++i )
+  {
+    const LinkedCode& c = l.m_Stubs[i];
+    std::string name = "\n__entry_" + c.m_Name;
+    print_code( f, p, name.c_str(), c.m_First, (unsigned int)c.m_Inst.size(), wide );
+  }
+
+  unsigned int trees = 0;
+  for( size_t i = 0; i < l.m_Units.size(); ++i )
+    trees += l.m_Units[i].m_Header.m_TC;
+  for( size_t i = 0; i < l.m_Trees.size(); ++i )
+  {
+    const LinkedCode& c = l.m_Trees[i];
+    std::string name = "\n" + c.m_Name + " (" + c.m_Units + ")";
+    print_code( f, p, name.c_str(), c.m_First, (unsigned int)c.m_Inst.size(), wide );
+  }
+
+  const unsigned int s = p->m_I.Count();
+  fprintf( f, "\nCode:\t%d (%d %sinstructions)\n",
+    (int)(s * (wide ? sizeof(WideInstruction) : sizeof(Instruction))), s,
+    wide ? "wide " : "" );
+  fprintf( f, "Linked:\t%u units, %u trees, %u unique\n",
+    (unsigned int)l.m_Units.size(), trees, (unsigned int)l.m_Trees.size() );
+  fprintf( f, "\nMemory: %u bytes.\n", p->m_Memory );
+  if( p->m_FrameCount )
+    fprintf( f, "Pooled frames: %u of %u bytes.\n", p->m_FrameCount, p->m_FrameSize );
+  if( p->m_I.DebugScopeCount() != 0 )
+    fprintf( f, "Debug scopes: %d at %d.\n", p->m_I.DebugScopeCount(), p->m_DebugTable );
+  p->m_D.Print( f );
+  fclose( f );
+  return 0;
+}
+
+int link_units( int count, char** units, const char* listing, Program* p )
+{
+  Linker l;
+  l.m_Units.resize( count );
+  for( int i = 0; i < count; ++i )
+  {
+    if( load_unit( units[i], &l.m_Units[i] ) != 0 )
+      return -1;
+    for( int j = 0; j < i; ++j )
+    {
+      if( l.m_Units[j].m_Name == l.m_Units[i].m_Name )
+      {
+        fprintf( stderr, "error: more than one link unit is called %s.\n",
+          l.m_Units[i].m_Name.c_str() );
+        return -1;
+      }
+    }
+  }
+
+  p->m_Context = 0x0;
+  p->m_First = 0x0;
+  p->m_Memory = 0;
+  p->m_FrameSize = 0;
+  p->m_FrameCount = 0;
+  p->m_CallbackTable = 0;
+  p->m_DebugTable = 0;
+  p->m_NodeCounters = 0;
+  p->m_CounterBlock = 0;
+  p->m_CounterTable = 0;
+  p->m_NodeTrace = 0;
+
+  //The agent's unit is picked by the entry point after the bss of the biggest
+  unsigned int slot = 0;
+  for( int i = 0; i < count; ++i )
+  {
+    const LinkHeader& h = l.m_Units[i].m_Header;
+    slot = std::max( slot, (unsigned int)(h.m_BS - sizeof(BssHeader)) );
+    p->m_FrameSize = std::max( p->m_FrameSize, h.m_FS );
+    p->m_FrameCount = std::max( p->m_FrameCount, h.m_FC );
+  }
+  slot = (slot + 3) & ~3;
+  p->m_Memory = sizeof(BssHeader) + slot + sizeof(int);
+
+  link_callbacks( &l, p );
+  if( link_data( &l, p ) != 0 )
+  {
+    fprintf( stderr, "error: the data of the link units can not be linked.\n" );
+    return -1;
+  }
+  if( link_trees( &l ) != 0 )
+    return -1;
+
+  unsigned int ip = LINK_DISPATCH;
+  for( size_t i = 0; i < l.m_Stubs.size(); ++i )
+  {
+    l.m_Stubs[i].m_First = ip;
+    ip += (unsigned int)l.m_Stubs[i].m_Inst.size();
+  }
+  for( size_t i = 0; i < l.m_Trees.size(); ++i )
+  {
+    l.m_Trees[i].m_First = ip;
+    ip += (unsigned int)l.m_Trees[i].m_Inst.size();
+  }
+
+  //Jump to the agent's entry stub, or to the first while it is not set
+  p->m_I.Push( INST_JABC_C_DIFF_B, 2, 0, slot );
+  p->m_I.Push( INST_JABC_CONSTANT, l.m_Stubs[0].m_First, 0, 0 );
+  p->m_I.Push( INST_JABB_BSSVALUE, slot, 0, 0 );
+  std::vector<DebugScope> scopes;
+  for( size_t i = 0; i < l.m_Stubs.size(); ++i )
+    push_code( l, l.m_Stubs[i], p, &scopes );
+  for( size_t i = 0; i < l.m_Trees.size(); ++i )
+    push_code( l, l.m_Trees[i], p, &scopes );
+
+  //Scopes of the same instruction keep the order they had in their unit
+  std::stable_sort( scopes.begin(), scopes.end(), scope_before );
+  for( size_t i = 0; i < scopes.size(); ++i )
+    p->m_I.AppendDebugScope( scopes[i] );
+
+  std::vector<int> table;
+  table.push_back( slot );
+  for( size_t i = 0; i < l.m_Stubs.size(); ++i )
+  {
+    table.push_back( p->m_D.PushString( l.m_Stubs[i].m_Name.c_str() ) );
+    table.push_back( l.m_Stubs[i].m_First );
+  }
+  p->m_EntryCount = (unsigned int)l.m_Stubs.size();
+  p->m_EntryTable = p->m_D.PushIntegers( &table[0], (int)table.size() );
+
+  if( !p->m_Callbacks.empty() )
+    p->m_CallbackTable = p->m_D.PushIntegers( &(p->m_Callbacks[0]),
+      (int)p->m_Callbacks.size() );
+
+  if( p->m_I.DebugScopeCount() != 0 )
+    p->m_DebugTable = p->m_I.PushDebugScopes( &p->m_D );
+
+  if( listing )
+    return print_linked( listing, l, p );
+  return 0;
+}
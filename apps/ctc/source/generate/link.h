@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef LINK_H_INCLUDED
+#define LINK_H_INCLUDED
+
+/*
+ * A link unit is a compiled program that ctc -k can link with others, written
+ * by ctc -u. It is a LinkHeader, the m_IC WideInstructions and the m_DS bytes
+ * of data of the program, then m_TC LinkTrees, m_RC LinkRelocs, m_BC
+ * LinkBlocks and m_SC callback::DebugScopes. Units are only read by ctc and
+ * are in the byte order of the machine that wrote them.
+ *
+ * The debug scopes are the program's own, with instruction and data offsets
+ * of the unit. Their table in the data section is not one of the blocks, the
+ * linker makes a table of the scopes of the linked code.
+ */
+const unsigned int LINK_MAGIC     = 0x4b4e4c43; // "CLNK"
+const unsigned int LINK_VERSION   = 2;
+const unsigned int LINK_NAME_SIZE = 64;
+
+/*
+ * The program is generated a second time with its code and data starting at
+ * these offsets. Operands and data that moved are the ones to relocate.
+ */
+const unsigned int LINK_CODE_SHIFT = 0x00100000;
+const unsigned int LINK_DATA_SHIFT = 0x00300000;
+
+struct LinkHeader
+{
+  unsigned int m_Magic;
+  unsigned int m_Version;
+  unsigned int m_IC; // Instruction COUNT
+  unsigned int m_DS; // Data SIZE
+  unsigned int m_BS; // .bss SIZE
+  unsigned int m_FS; // Pooled frame SIZE
+  unsigned int m_FC; // Pooled frame COUNT
+  unsigned int m_CC; // Callback COUNT
+  unsigned int m_CT; // Callback id TABLE, offset into the data section
+  unsigned int m_TC; // Tree COUNT, "main" first
+  unsigned int m_RC; // Relocation COUNT
+  unsigned int m_BC; // Data block COUNT
+  unsigned int m_SC; // Debug scope COUNT
+};
+
+/*
+ * The instructions of a tree. The instructions before the first tree are the
+ * entry stub that runs "main".
+ */
+struct LinkTree
+{
+  char         m_Name[LINK_NAME_SIZE]; // Null terminated
+  unsigned int m_First;
+  unsigned int m_Count;
+};
+
+enum LinkRelocType
+{
+  E_LINK_NONE,
+  E_LINK_CODE,        // Operand is an instruction
+  E_LINK_DATA,        // Operand is a data offset
+  E_LINK_DATA_JOINED, // m_A2 and m_A3 are a data offset, as for INST_LOAD_REGISTRY
+  E_LINK_DATA_WORD    // Data word at byte m_Index is a data offset
+};
+
+struct LinkReloc
+{
+  unsigned int m_Type;
+  unsigned int m_Index;   // Instruction, or data offset for E_LINK_DATA_WORD
+  unsigned int m_Operand; // 1 to 3 for m_A1 to m_A3
+};
+
+/*
+ * A push to the data section, of DataSection::DataType. The linker pushes
+ * them again, once for every block that is the same after relocation.
+ */
+struct LinkBlock
+{
+  unsigned int m_Type;
+  unsigned int m_Offset;
+  unsigned int m_Count; // Values, one for a string
+};
+
+#endif /*LINK_H_INCLUDED*/
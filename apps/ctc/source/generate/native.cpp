@@ -0,0 +1,455 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+/*
+ * Translates a generated program into C++ source that does what the
+ * interpreter in libs/callback would do with the same program, one
+ * instruction at a time. Every instruction gets a label, constant jumps become
+ * gotos and jumps through the bss (subtree returns and resumed runs) go
+ * through a switch on the instruction index. The bss layout, BssHeader and
+ * instruction counter are kept exactly as the interpreter keeps them, so the
+ * two can be swapped for each other on the same agent.
+ *
+ * The generated file defines:
+ *
+ *   const unsigned int <function>_bss_size;
+ *   int  <function>( callback::CallbackProgram* ); // Like run_program
+ *   void <function>_batch( callback::CallbackBatch* ); // Like run_programs
+ *   const callback::CounterLayout <function>_counters; // If nodes are counted
+ *
+ * m_Program is ignored by both, the program is compiled in.
+ */
+
+#include "program.h"
+#include "inst_text.h"
+
+#include <btree/btree_data.h>
+
+#include <stdio.h>
+
+#include <vector>
+
+using namespace callback;
+
+/*
+ * The instructions with debug scopes, see callback::DebugScope. Falling
+ * through or making a constant jump to one of them makes the debug callbacks
+ * on the way there, other jumps remember the instruction they are made from
+ * and make them before the dispatch switch.
+ */
+struct ScopeSites
+{
+  std::vector<char> m_At; // Non zero for the instructions with scopes
+  int               m_Count;
+};
+
+static void print_debug( FILE* f, const ScopeSites& ss, int from, unsigned int to )
+{
+  fprintf( f, "if( dh ) { bh->m_IP = 0x%04x; bh->m_IC = ic; "
+    "call_debug_scopes( info, scopes, %du, data, 0x%04x ); } ", to, ss.m_Count, from );
+}
+
+static void print_dispatch( FILE* f, const ScopeSites& ss, int from )
+{
+  if( ss.m_Count != 0 )
+    fprintf( f, "from = 0x%04x; ", from );
+  fprintf( f, "goto dispatch;" );
+}
+
+static void print_label( FILE* f, const ScopeSites& ss, int from, unsigned int target,
+  int count )
+{
+  if( target < (unsigned int)count && ss.m_At[target] )
+  {
+    fprintf( f, "{ " );
+    print_debug( f, ss, from, target );
+    fprintf( f, "goto L_%04x; }", target );
+  }
+  else if( target < (unsigned int)count )
+    fprintf( f, "goto L_%04x;", target );
+  else
+  {
+    fprintf( f, "{ ip = 0x%04x; ", target );
+    print_dispatch( f, ss, from );
+    fprintf( f, " }" );
+  }
+}
+
+static void print_bss_int( FILE* f, VMIType offset )
+{
+  fprintf( f, "*((int*)&(bss[%u]))", offset );
+}
+
+static const char* action_name( unsigned int i )
+{
+  switch( i )
+  {
+  case INST_CALL_CONS_FUN:
+  case INST_FUSE_CONS_FUN:
+    return "ACT_CONSTRUCT";
+  case INST_CALL_EXEC_FUN:
+  case INST_FUSE_EXEC_FUN:
+    return "ACT_EXECUTE";
+  case INST_CALL_DEST_FUN:
+  case INST_FUSE_DEST_FUN:
+    return "ACT_DESTRUCT";
+  case INST_CALL_PRUN_FUN:
+  case INST_FUSE_PRUN_FUN:
+    return "ACT_PRUNE";
+  }
+  return "ACT_MODIFY";
+}
+
+static bool sets_return( unsigned int i )
+{
+  return i != INST_CALL_CONS_FUN && i != INST_CALL_DEST_FUN
+      && i != INST_FUSE_CONS_FUN && i != INST_FUSE_DEST_FUN;
+}
+
+static void print_instruction( FILE* f, Program* p, const ScopeSites& ss, bool wide, int g )
+{
+  //Narrow programs only keep the low bits of each operand, as they are saved
+  WideInstruction inst = p->m_I.Get( g );
+  const WideVMIType none = wide ? WIDE_NO_OPERAND : NO_OPERAND;
+  if( !wide )
+  {
+    inst.m_A1 = (VMIType)inst.m_A1;
+    inst.m_A2 = (VMIType)inst.m_A2;
+    inst.m_A3 = (VMIType)inst.m_A3;
+  }
+  const int count = p->m_I.Count();
+  const unsigned int next = g + 1;
+
+  fprintf( f, "L_%04x: ++ic; // %s 0x%04x 0x%04x 0x%04x\n  ", g,
+    g_InstructionNames[inst.m_I], inst.m_A1, inst.m_A2, inst.m_A3 );
+
+  switch( inst.m_I )
+  {
+  case INST_CALL_CONS_FUN:
+  case INST_CALL_EXEC_FUN:
+  case INST_CALL_DEST_FUN:
+  case INST_CALL_PRUN_FUN:
+  case INST_CALL_MODI_FUN:
+    fprintf( f, "%sch( bh->m_R[%u], %s, resolve_register( bh, bh->m_R[%u] ), "
+      "bh->m_R[%u] ? resolve_variables( &(data[bh->m_R[%u]]), "
+      "data, vars ) : 0x0, info->m_UserData );\n  ",
+      sets_return( inst.m_I ) ? "bh->m_RE = " : "", inst.m_A1,
+      action_name( inst.m_I ), inst.m_A2, inst.m_A3, inst.m_A3 );
+    fprintf( f, "bh->m_R[%u] = 0; bh->m_R[%u] = 0; bh->m_R[%u] = 0;",
+      inst.m_A1, inst.m_A2, inst.m_A3 );
+    break;
+  case INST_FUSE_CONS_FUN:
+  case INST_FUSE_EXEC_FUN:
+  case INST_FUSE_DEST_FUN:
+  case INST_FUSE_PRUN_FUN:
+  case INST_FUSE_MODI_FUN:
+    {
+      char b[32], d[64];
+      if( inst.m_A2 == none )
+        sprintf( b, "0x0" );
+      else
+        sprintf( b, "(void*)&(bss[%u])", inst.m_A2 );
+      if( inst.m_A3 == none )
+        sprintf( d, "(void**)0x0" );
+      else
+        sprintf( d, "resolve_variables( &(data[%u]), data, vars )", inst.m_A3 );
+      fprintf( f, "%s(tab ? tab[%u] : ch)( 0x%08x, %s, %s, %s, info->m_UserData );",
+        sets_return( inst.m_I ) ? "bh->m_RE = " : "", inst.m_A1,
+        p->m_Callbacks[inst.m_A1], action_name( inst.m_I ), b, d );
+    }
+    break;
+  case INST_JABC_R_EQUA_C:
+    fprintf( f, "if( bh->m_RE == %uu ) ", inst.m_A2 );
+    print_label( f, ss, g, inst.m_A1, count );
+    break;
+  case INST_JABC_R_DIFF_C:
+    fprintf( f, "if( bh->m_RE != %uu ) ", inst.m_A2 );
+    print_label( f, ss, g, inst.m_A1, count );
+    break;
+  case INST_JABC_C_EQUA_B:
+  case INST_JABC_C_DIFF_B:
+    fprintf( f, "if( %d %s ", inst.m_A2,
+      inst.m_I == INST_JABC_C_EQUA_B ? "==" : "!=" );
+    print_bss_int( f, inst.m_A3 );
+    fprintf( f, " ) " );
+    print_label( f, ss, g, inst.m_A1, count );
+    break;
+  case INST_JABB_C_EQUA_B:
+  case INST_JABB_C_DIFF_B:
+    fprintf( f, "if( %d %s ", inst.m_A2,
+      inst.m_I == INST_JABB_C_EQUA_B ? "==" : "!=" );
+    print_bss_int( f, inst.m_A3 );
+    fprintf( f, " ) { ip = " );
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, "; " );
+    print_dispatch( f, ss, g );
+    fprintf( f, " }" );
+    break;
+  case INST_JABB_B_EQUA_B:
+  case INST_JABB_B_DIFF_B:
+    fprintf( f, "if( " );
+    print_bss_int( f, inst.m_A2 );
+    fprintf( f, " %s ", inst.m_I == INST_JABB_B_EQUA_B ? "==" : "!=" );
+    print_bss_int( f, inst.m_A3 );
+    fprintf( f, " ) { ip = " );
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, "; " );
+    print_dispatch( f, ss, g );
+    fprintf( f, " }" );
+    break;
+  case INST_JABC_CONSTANT:
+    print_label( f, ss, g, inst.m_A1, count );
+    break;
+  case INST_JREC_CONSTANT:
+    print_label( f, ss, g, next + inst.m_A1, count );
+    break;
+  case INST_JABB_BSSVALUE:
+    fprintf( f, "ip = " );
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, "; " );
+    print_dispatch( f, ss, g );
+    break;
+  case INST_JREB_BSSVALUE:
+    fprintf( f, "ip = 0x%04x + ", next );
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, "; " );
+    print_dispatch( f, ss, g );
+    break;
+  case INST_JABC_S_C_IN_B:
+  case INST_JREC_S_C_IN_B:
+    print_bss_int( f, inst.m_A2 );
+    fprintf( f, " = %d; ", inst.m_A3 );
+    print_label( f, ss, g, inst.m_I == INST_JABC_S_C_IN_B ? inst.m_A1 : next + inst.m_A1,
+      count );
+    break;
+  case INST_JABB_S_C_IN_B:
+  case INST_JREB_S_C_IN_B:
+    fprintf( f, "ip = " );
+    if( inst.m_I == INST_JREB_S_C_IN_B )
+      fprintf( f, "0x%04x + ", next );
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, "; " );
+    print_bss_int( f, inst.m_A2 );
+    fprintf( f, " = %d; ", inst.m_A3 );
+    print_dispatch( f, ss, g );
+    break;
+  case INST__STORE_R_IN_B:
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, " = bh->m_RE;" );
+    break;
+  case INST__STORE_B_IN_R:
+    fprintf( f, "bh->m_RE = " );
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, ";" );
+    break;
+  case INST__STORE_C_IN_B:
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, " = (int)0x%08x;", (((unsigned int)inst.m_A3) << 16)
+      | ((unsigned int)inst.m_A2) );
+    break;
+  case INST__STORE_B_IN_B:
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, " = " );
+    print_bss_int( f, inst.m_A2 );
+    fprintf( f, ";" );
+    break;
+  case INST__STORE_C_IN_R:
+    fprintf( f, "bh->m_RE = %uu;", inst.m_A1 );
+    break;
+  case INST_STORE_PD_IN_B:
+    fprintf( f, "*((unsigned int*)&(bss[%u])) = %uu;", inst.m_A1, inst.m_A2 );
+    break;
+  case INST_STORE_PB_IN_R:
+    fprintf( f, "bh->m_R[%u] = (unsigned int)(&(bss[%u]) - (char*)bh);", inst.m_A1,
+      inst.m_A2 );
+    break;
+  case INST__INC_BSSVALUE:
+  case INST__DEC_BSSVALUE:
+    //The interpreter adds for both
+    print_bss_int( f, inst.m_A1 );
+    fprintf( f, " += %u;", inst.m_A2 );
+    break;
+  case INST__SET_REGISTRY:
+    fprintf( f, "bh->m_R[%u] = 0x%08xu;", inst.m_A1,
+      (((unsigned int)inst.m_A2) << 16) + inst.m_A3 );
+    break;
+  case INST_LOAD_REGISTRY:
+    fprintf( f, "bh->m_R[%u] = 0x%08xu;", inst.m_A1,
+      (((unsigned int)inst.m_A2) << 16) + inst.m_A3 );
+    break;
+  case INST_SCRIPT_C:
+    fprintf( f, "{ CallFrame* fr = (CallFrame*)(bss + %u); "
+      "fr->m_FP = (unsigned int)(bss - base); "
+      "fr->m_IP = 0x%04x; bss = (char*)(fr + 1); } ", inst.m_A2, next );
+    print_label( f, ss, g, inst.m_A1, count );
+    break;
+  case INST_SCRIPT_R:
+    fprintf( f, "{ CallFrame* fr = (CallFrame*)(bss - sizeof(CallFrame)); "
+      "bss = base + fr->m_FP; ip = fr->m_IP; } " );
+    //Debug scopes see the return as the tree call
+    if( ss.m_Count != 0 )
+      fprintf( f, "from = ip - 1; " );
+    fprintf( f, "goto dispatch;" );
+    break;
+  case INST_COUNT_NODE:
+    fprintf( f, "count_node( (NodeCounters*)(base + %u), %uu, bh->m_RE );", inst.m_A1,
+      inst.m_A2 );
+    break;
+  case INST_TRACE_NODE:
+    fprintf( f, "trace_node( bh, 0x%08xu, %uu, bh->m_RE );",
+      (((unsigned int)inst.m_A2) << 16) + inst.m_A3, inst.m_A1 );
+    break;
+  case INST_______SUSPEND:
+    fprintf( f, "goto exit;" );
+    break;
+  }
+  fprintf( f, "\n" );
+  if( next < (unsigned int)count && ss.m_At[next] )
+  {
+    fprintf( f, "  " );
+    print_debug( f, ss, g, next );
+    fprintf( f, "\n" );
+  }
+}
+
+int save_native( FILE* f, bool swapEndian, const char* file_name,
+  const char* function, Program* p )
+{
+  const int count = p->m_I.Count();
+
+  fprintf( f, "/*\n * This file is auto generated by ctc from %s.\n"
+    " * Manual edits will be lost when regenerated.\n */\n\n", file_name );
+  fprintf( f, "#include <callback/callback.h>\n" );
+  fprintf( f, "#include <callback/instructions.h>\n" );
+  if( !p->m_CounterIds.empty() )
+    fprintf( f, "#include <callback/counters.h>\n" );
+  //Linked programs are traced if any of their units are
+  bool traced = false;
+  for( int i = 0; i < count; ++i )
+    traced = traced || p->m_I.Get( i ).m_I == INST_TRACE_NODE;
+  if( traced )
+    fprintf( f, "#include <callback/trace.h>\n" );
+  fprintf( f, "\n#include <stddef.h>\n\n" );
+  fprintf( f, "using namespace callback;\n\n" );
+
+  //Declared extern, namespace scope consts would not be seen outside the file
+  fprintf( f, "extern const unsigned int %s_bss_size = %u;\n\n", function, p->m_Memory );
+
+  if( !p->m_CounterIds.empty() )
+  {
+    fprintf( f, "static const unsigned int s_%s_CounterIds[] =\n{", function );
+    for( size_t i = 0; i < p->m_CounterIds.size(); ++i )
+      fprintf( f, "%s0x%08xu,", (i % 8) == 0 ? "\n  " : " ",
+        (unsigned int)p->m_CounterIds[i] );
+    fprintf( f, "\n};\n\n" );
+    fprintf( f, "extern const CounterLayout %s_counters =\n{\n  %u, %u, %u, s_%s_CounterIds\n};\n\n",
+      function, (unsigned int)p->m_CounterIds.size(), p->m_CounterBlock, counter_size( p ),
+      function );
+  }
+
+  //The bss holds offsets, these make the pointers callbacks get like the VM does
+  fprintf( f, "static inline void** resolve_variables( const char* list, char* data, void** vars )\n{\n" );
+  fprintf( f, "  const unsigned int* l = (const unsigned int*)list;\n" );
+  fprintf( f, "  for( unsigned int v = 0; v < l[0]; ++v )\n    vars[v] = data + l[v + 1];\n" );
+  fprintf( f, "  return vars;\n}\n\n" );
+  fprintf( f, "static inline void* resolve_register( BssHeader* bh, unsigned int r )\n{\n" );
+  fprintf( f, "  return r ? (void*)((char*)bh + r) : 0x0;\n}\n\n" );
+  //The data section, as it would have been saved, aligned like a loaded program
+  std::vector<char> data;
+  p->m_D.Copy( &data, swapEndian );
+  fprintf( f, "static union\n{\n  unsigned char m_Bytes[%u];\n  double m_Align;\n}"
+    " s_%s_Data =\n{\n  {", data.empty() ? 1 : (unsigned int)data.size(), function );
+  for( size_t i = 0; i < data.size(); ++i )
+  {
+    if( (i % 16) == 0 )
+      fprintf( f, "\n    " );
+    fprintf( f, "0x%02x,", (unsigned char)data[i] );
+  }
+  if( data.empty() )
+    fprintf( f, " 0" );
+  fprintf( f, "\n  }\n};\n\n" );
+
+  fprintf( f, "static void %s_execute( CallbackProgram* info )\n{\n", function );
+  fprintf( f, "  char* data = (char*)s_%s_Data.m_Bytes;\n", function );
+  fprintf( f, "  BssHeader* bh = (BssHeader*)info->m_bss;\n" );
+  fprintf( f, "  char* const base = (char*)(info->m_bss) + sizeof(BssHeader);\n" );
+  fprintf( f, "  char* bss = base + bh->m_FP;\n" );
+  fprintf( f, "  CallbackHandler ch = info->m_Callback;\n" );
+  fprintf( f, "  DebugHandler dh = info->m_Debug;\n" );
+  fprintf( f, "  const CallbackHandler* tab = info->m_Table;\n" );
+  fprintf( f, "  unsigned int ic = bh->m_IC;\n" );
+  fprintf( f, "  unsigned int ip = bh->m_IP;\n" );
+  fprintf( f, "  void* vars[MAX_CALLBACK_VARIABLES];\n" );
+  fprintf( f, "  (void)data; (void)ch; (void)dh; (void)tab; (void)vars;\n" );
+  //The debug scopes of the program and the instruction the dispatch is from
+  ScopeSites ss;
+  ss.m_At.assign( count, 0 );
+  ss.m_Count = p->m_I.DebugScopeCount();
+  for( int i = 0; i < ss.m_Count; ++i )
+    ss.m_At[p->m_I.GetDebugScope( i ).m_IP] = 1;
+  if( ss.m_Count != 0 )
+  {
+    fprintf( f, "  const DebugScope* scopes = (const DebugScope*)(data + %d);\n",
+      p->m_DebugTable );
+    fprintf( f, "  unsigned int from = 0xffffffffu;\n" );
+  }
+  fprintf( f, "\n  if( ip == 0 )\n    goto L_0000;\n\n" );
+
+  fprintf( f, "dispatch:\n" );
+  if( ss.m_Count != 0 )
+    fprintf( f, "  if( dh && from != 0xffffffffu ) { bh->m_IP = ip; bh->m_IC = ic; "
+      "call_debug_scopes( info, scopes, %du, data, from ); }\n", ss.m_Count );
+  fprintf( f, "  switch( ip )\n  {\n" );
+  for( int g = 0; g < count; ++g )
+    fprintf( f, "  case 0x%04x: goto L_%04x;\n", g, g );
+  fprintf( f, "  }\n  goto exit;\n\n" );
+
+  //Compact code keeps the operands wide
+  const bool wide = (p->m_I.Flags() & (E_PROGRAM_WIDE | E_PROGRAM_COMPACT)) != 0;
+  BehaviorTreeList* btl = p->m_First;
+  fprintf( f, "  //__entry_stub\n" );
+  for( int g = 0; g < count; ++g )
+  {
+    if( btl && btl->m_FirstInst == g )
+    {
+      fprintf( f, "\n  //%s\n", btl->m_Tree->m_Id.m_Text );
+      btl = btl->m_Next;
+    }
+    print_instruction( f, p, ss, wide, g );
+  }
+
+  fprintf( f, "\nexit:\n" );
+  fprintf( f, "  bh->m_IC = ic;\n" );
+  fprintf( f, "  bh->m_IP = 0;\n" );
+  fprintf( f, "  bh->m_FP = 0;\n" );
+  fprintf( f, "}\n\n" );
+
+  fprintf( f, "int %s( CallbackProgram* info )\n{\n", function );
+  fprintf( f, "  %s_execute( info );\n", function );
+  fprintf( f, "  return ((BssHeader*)info->m_bss)->m_RE;\n}\n\n" );
+
+  fprintf( f, "void %s_batch( CallbackBatch* batch )\n{\n", function );
+  fprintf( f, "  CallbackProgram cp;\n" );
+  fprintf( f, "  cp.m_Program  = batch->m_Program;\n" );
+  fprintf( f, "  cp.m_Callback = batch->m_Callback;\n" );
+  fprintf( f, "  cp.m_Debug    = batch->m_Debug;\n" );
+  fprintf( f, "  cp.m_Table    = batch->m_Table;\n" );
+  fprintf( f, "  cp.m_Flags    = batch->m_Flags;\n" );
+  fprintf( f, "  cp.m_Frames   = batch->m_Frames;\n" );
+  fprintf( f, "  cp.m_UserData = 0x0;\n\n" );
+  fprintf( f, "  char* bss = (char*)batch->m_bss;\n" );
+  fprintf( f, "  for( unsigned int a = 0; a < batch->m_Count; ++a, bss += batch->m_Stride )\n  {\n" );
+  fprintf( f, "    cp.m_bss = bss;\n" );
+  fprintf( f, "    if( batch->m_UserData )\n      cp.m_UserData = batch->m_UserData[a];\n" );
+  fprintf( f, "    %s_execute( &cp );\n  }\n}\n", function );
+
+  return ferror( f ) ? -1 : 0;
+}
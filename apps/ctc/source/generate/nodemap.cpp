@@ -0,0 +1,279 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "program.h"
+#include "nodes.h"
+#include "endian.h"
+
+#include <btree/btree_func.h>
+#include <callback/nodemap.h>
+#include <other/lookup3.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+#include <map>
+#include <string>
+
+using namespace callback;
+
+typedef std::map<Node*, unsigned int>         NodeIndices;
+typedef std::map<BehaviorTree*, unsigned int> TreeIndices;
+typedef std::map<std::string, unsigned int>   StringOffsets;
+
+struct NodeMapData
+{
+  std::vector<MapTree> m_Trees;
+  std::vector<MapNode> m_Nodes;
+  std::vector<MapSlot> m_Slots;
+  std::vector<Node*>   m_Source;
+  std::vector<char>    m_Strings;
+  StringOffsets        m_Offsets;
+  NodeIndices          m_Index;
+  TreeIndices          m_TreeIndex;
+};
+
+static unsigned int mix( unsigned int h, unsigned int v )
+{
+  for( int i = 0; i < 4; ++i, v >>= 8 )
+  {
+    h ^= v & 0xff;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static unsigned int push_string( NodeMapData* d, const char* str )
+{
+  StringOffsets::iterator it = d->m_Offsets.find( str );
+  if( it != d->m_Offsets.end() )
+    return it->second;
+  unsigned int offset = (unsigned int)d->m_Strings.size();
+  d->m_Strings.insert( d->m_Strings.end(), str, str + strlen( str ) + 1 );
+  d->m_Offsets[str] = offset;
+  return offset;
+}
+
+static const char* node_name( Node* n )
+{
+  switch( n->m_Grist.m_Type )
+  {
+  case E_GRIST_SEQUENCE:
+    return "sequence";
+  case E_GRIST_SELECTOR:
+    return "selector";
+  case E_GRIST_PARALLEL:
+    return "parallel";
+  case E_GRIST_DYN_SELECTOR:
+    return "dyn_selector";
+  case E_GRIST_SUCCEED:
+    return "succeed";
+  case E_GRIST_FAIL:
+    return "fail";
+  case E_GRIST_WORK:
+    return "work";
+  case E_GRIST_TREE:
+    return n->m_Grist.m_Tree.m_Tree->m_Id.m_Text;
+  case E_GRIST_ACTION:
+    return n->m_Grist.m_Action.m_Action->m_Id.m_Text;
+  case E_GRIST_DECORATOR:
+    return n->m_Grist.m_Decorator.m_Decorator->m_Id.m_Text;
+  default:
+    break;
+  }
+  return "unknown";
+}
+
+static unsigned int tree_index( NodeMapData* d, BehaviorTree* t )
+{
+  TreeIndices::iterator it = d->m_TreeIndex.find( t );
+  return it == d->m_TreeIndex.end() ? MAP_NONE : it->second;
+}
+
+/*
+ * A node's key is made from its parent's key, its type and name and how many
+ * of its earlier siblings have the same type and name, so it stays the same
+ * when siblings of other kinds come and go.
+ */
+static void add_nodes( NodeMapData* d, Program* p, Node* n, unsigned int parent,
+  unsigned int tree, unsigned int parent_key )
+{
+  unsigned int same = 0;
+  for( Node* s = n->m_Prev; s; s = s->m_Prev )
+  {
+    if( s->m_Grist.m_Type == n->m_Grist.m_Type
+      && strcmp( node_name( s ), node_name( n ) ) == 0 )
+      ++same;
+  }
+
+  MapNode mn;
+  mn.m_Key    = mix( mix( mix( parent_key, n->m_Grist.m_Type ), hashlittle( node_name( n ) ) ), same );
+  mn.m_Signature = 0;
+  mn.m_Id     = n->m_NodeId;
+  mn.m_Type   = n->m_Grist.m_Type - E_GRIST_SEQUENCE;
+  mn.m_Flags  = node_map_flags( n );
+  mn.m_Name   = push_string( d, node_name( n ) );
+  mn.m_Line   = n->m_Locator.m_LineNo;
+  mn.m_Parent = parent;
+  mn.m_Tree   = tree;
+  mn.m_Callee = MAP_NONE;
+  if( n->m_Grist.m_Type == E_GRIST_TREE && !is_pooled_tree( n ) )
+    mn.m_Callee = tree_index( d, n->m_Grist.m_Tree.m_Tree );
+  for( int a = 0; a < 3; ++a )
+  {
+    int e = p->m_I.GetEntry( n, (NodeAction)a );
+    mn.m_Entry[a] = e < 0 ? MAP_NONE : (unsigned int)e;
+  }
+
+  MapSlot slots[MAX_NODE_SLOTS];
+  int count = node_slots( n, slots );
+  //Constants are cut to the operand width of narrow programs
+  for( int i = 0; i < count; ++i )
+  {
+    if( slots[i].m_Kind == E_MAP_SLOT_CODE && p->m_I.Flags() == 0 )
+      slots[i].m_Reset &= 0xffff;
+  }
+  mn.m_Slot      = (unsigned int)d->m_Slots.size();
+  mn.m_SlotCount = count;
+  d->m_Slots.insert( d->m_Slots.end(), slots, slots + count );
+
+  const unsigned int index = (unsigned int)d->m_Nodes.size();
+  d->m_Nodes.push_back( mn );
+  d->m_Source.push_back( n );
+  d->m_Index[n] = index;
+
+  for( Node* c = get_first_child( n ); c; c = c->m_Next )
+    add_nodes( d, p, c, index, tree, mn.m_Key );
+}
+
+/*
+ * The signature covers what the node's code does and the bss it keeps, but
+ * not the offsets or the data it uses.
+ */
+static void sign_nodes( NodeMapData* d, Program* p, std::vector<unsigned int>* owners,
+  std::vector<unsigned int>* actions )
+{
+  const unsigned int count = (unsigned int)d->m_Nodes.size();
+  std::vector<unsigned int> sign( count, 2166136261u );
+  std::vector<unsigned int> children( count, 0 );
+
+  for( int i = 0; i < p->m_I.Count(); ++i )
+  {
+    NodeIndices::iterator it = d->m_Index.find( p->m_I.GetNode( i ) );
+    unsigned int o = it == d->m_Index.end() ? MAP_NONE : it->second;
+    owners->push_back( o );
+    actions->push_back( o == MAP_NONE ? MAP_NONE : (unsigned int)p->m_I.GetAction( i ) );
+    if( o != MAP_NONE )
+      sign[o] = mix( sign[o], p->m_I.Get( i ).m_I );
+  }
+
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    MapNode& mn = d->m_Nodes[i];
+    if( mn.m_Parent != MAP_NONE )
+      ++children[mn.m_Parent];
+  }
+
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    MapNode& mn = d->m_Nodes[i];
+    unsigned int h = mix( mix( mix( sign[i], mn.m_Type ), mn.m_Flags ), children[i] );
+    for( unsigned int s = mn.m_Slot; s < mn.m_Slot + mn.m_SlotCount; ++s )
+    {
+      const MapSlot& ms = d->m_Slots[s];
+      h = mix( mix( h, ms.m_Kind ), ms.m_Size );
+      if( ms.m_Kind != E_MAP_SLOT_CODE )
+        h = mix( h, ms.m_Reset );
+    }
+
+    Node* n = d->m_Source[i];
+    NamedSymbol ns;
+    ns.m_Type = E_ST_UNKOWN;
+    if( n->m_Grist.m_Type == E_GRIST_ACTION )
+    {
+      ns.m_Type = E_ST_ACTION;
+      ns.m_Symbol.m_Action = n->m_Grist.m_Action.m_Action;
+    }
+    else if( n->m_Grist.m_Type == E_GRIST_DECORATOR )
+    {
+      ns.m_Type = E_ST_DECORATOR;
+      ns.m_Symbol.m_Decorator = n->m_Grist.m_Decorator.m_Decorator;
+    }
+    if( ns.m_Type != E_ST_UNKOWN )
+      h = mix( h, callback_id( &ns ) );
+    if( n->m_Grist.m_Type == E_GRIST_TREE )
+      h = mix( h, hashlittle( node_name( n ) ) );
+    mn.m_Signature = h;
+  }
+}
+
+template<typename T>
+static bool write_words( FILE* f, bool swapEndian, const T* data, size_t count )
+{
+  if( count == 0 )
+    return true;
+  std::vector<unsigned int> w( (const unsigned int*)data,
+    (const unsigned int*)data + count * (sizeof(T) / sizeof(unsigned int)) );
+  if( swapEndian )
+  {
+    for( size_t i = 0; i < w.size(); ++i )
+      EndianSwap( w[i] );
+  }
+  return fwrite( &w[0], sizeof(unsigned int), w.size(), f ) == w.size();
+}
+
+int save_node_map( FILE* outFile, bool swapEndian, Program* p )
+{
+  NodeMapData d;
+
+  unsigned int tree = 0;
+  for( BehaviorTreeList* btl = p->m_First; btl; btl = btl->m_Next )
+    d.m_TreeIndex[btl->m_Tree] = tree++;
+
+  for( BehaviorTreeList* btl = p->m_First; btl; btl = btl->m_Next )
+  {
+    BehaviorTree* t = btl->m_Tree;
+    MapTree mt;
+    mt.m_Name  = push_string( &d, t->m_Id.m_Text );
+    mt.m_Root  = (unsigned int)d.m_Nodes.size();
+    mt.m_First = btl->m_FirstInst;
+    d.m_Trees.push_back( mt );
+    add_nodes( &d, p, t->m_Root, MAP_NONE, tree_index( &d, t ), hashlittle( t->m_Id.m_Text ) );
+  }
+
+  std::vector<unsigned int> owners, actions;
+  sign_nodes( &d, p, &owners, &actions );
+
+  //Strings are padded to whole words
+  while( d.m_Strings.size() % sizeof(unsigned int) )
+    d.m_Strings.push_back( 0 );
+
+  NodeMapHeader h;
+  h.m_Magic   = NODE_MAP_MAGIC;
+  h.m_Version = NODE_MAP_VERSION;
+  h.m_IC      = p->m_I.Count();
+  h.m_BS      = p->m_Memory;
+  h.m_TC      = (unsigned int)d.m_Trees.size();
+  h.m_NC      = (unsigned int)d.m_Nodes.size();
+  h.m_SC      = (unsigned int)d.m_Slots.size();
+  h.m_SS      = (unsigned int)d.m_Strings.size();
+
+  bool ok = write_words( outFile, swapEndian, &h, 1 )
+    && write_words( outFile, swapEndian, d.m_Trees.empty() ? 0x0 : &d.m_Trees[0], d.m_Trees.size() )
+    && write_words( outFile, swapEndian, d.m_Nodes.empty() ? 0x0 : &d.m_Nodes[0], d.m_Nodes.size() )
+    && write_words( outFile, swapEndian, d.m_Slots.empty() ? 0x0 : &d.m_Slots[0], d.m_Slots.size() )
+    && write_words( outFile, swapEndian, owners.empty() ? 0x0 : &owners[0], owners.size() )
+    && write_words( outFile, swapEndian, actions.empty() ? 0x0 : &actions[0], actions.size() );
+  if( ok && !d.m_Strings.empty() )
+    ok = fwrite( &d.m_Strings[0], 1, d.m_Strings.size(), outFile ) == d.m_Strings.size();
+  return ok ? 0 : -1;
+}
@@ -15,6 +15,9 @@
 #include <btree/btree_data.h>
 #include <btree/btree_func.h>
 #include <callback/callback.h>
+#include <callback/counters.h>
+#include <callback/nodemap.h>
+#include <callback/trace.h>
 #include <other/lookup3.h>
 
 #include <vector>
@@ -41,8 +44,7 @@ typedef std::vector<int> IntVector;
 
 struct VariableGenerateData
 {
-  int m_bssStart;
-  IntVector m_Data;
+  int m_ListPos; // Data section offset of the variable list, or WIDE_NO_OPERAND
 };
 
 int memory_need_variables(
@@ -62,16 +64,12 @@ int store_variables_in_data_section(
     int mo
   );
 
-int generate_variable_instructions(
-    VariableGenerateData* vd,
-    Parameter* vars,
-    Program* p
-  );
-
-int setup_variable_registry(
-    VariableGenerateData* vd,
-    Parameter* vars,
-    Program* p
+void gen_callback(
+    Program* p,
+    InstructionSet inst,
+    int cb_index,
+    int bss_pos,
+    VariableGenerateData* vd
   );
 
 void print_badalignment_warning( NamedSymbol* ns );
@@ -154,7 +152,7 @@ int teardown_gen( Node* n, Program* p )
   return r;
 }
 
-int gen_con( Node* n, Program* p )
+static int con_node( Node* n, Program* p )
 {
   switch( n->m_Grist.m_Type )
   {
@@ -195,7 +193,7 @@ int gen_con( Node* n, Program* p )
   return -1;
 }
 
-int gen_exe( Node* n, Program* p )
+static int exe_node( Node* n, Program* p )
 {
   switch( n->m_Grist.m_Type )
   {
@@ -236,7 +234,7 @@ int gen_exe( Node* n, Program* p )
   return -1;
 }
 
-int gen_des( Node* n, Program* p )
+static int des_node( Node* n, Program* p )
 {
   switch( n->m_Grist.m_Type )
   {
@@ -277,6 +275,46 @@ int gen_des( Node* n, Program* p )
   return -1;
 }
 
+/*
+ * The instructions pushed while generating a node's code are the node's, see
+ * CodeSection::EnterNode.
+ */
+int gen_con( Node* n, Program* p )
+{
+  CodeScope outer = p->m_I.EnterNode( n, ACT_CONSTRUCT );
+  int r = con_node( n, p );
+  p->m_I.LeaveNode( outer );
+  return r;
+}
+
+/*
+ * Every way out of a node's execute code goes past its end, where the result
+ * is counted and traced.
+ */
+int gen_exe( Node* n, Program* p )
+{
+  CodeScope outer = p->m_I.EnterNode( n, ACT_EXECUTE );
+  const int counter = node_counter( n, p );
+  const unsigned int cycles = p->m_NodeCounters > 1 ? E_COUNT_CYCLES : 0;
+  if( counter >= 0 )
+    p->m_I.Push( INST_COUNT_NODE, counter, E_COUNT_ENTER | cycles, 0 );
+  gen_trace( n, p, E_TRACE_ENTER );
+  int r = exe_node( n, p );
+  gen_trace( n, p, E_TRACE_EXIT );
+  if( counter >= 0 )
+    p->m_I.Push( INST_COUNT_NODE, counter, E_COUNT_RESULT | cycles, 0 );
+  p->m_I.LeaveNode( outer );
+  return r;
+}
+
+int gen_des( Node* n, Program* p )
+{
+  CodeScope outer = p->m_I.EnterNode( n, ACT_DESTRUCT );
+  int r = des_node( n, p );
+  p->m_I.LeaveNode( outer );
+  return r;
+}
+
 int calc_memory_need( Node* n )
 {
   if( !n )
@@ -362,7 +400,12 @@ int gen_setup_btree( BehaviorTree* t, Program* p, int mo )
 
   t->m_UserData = nd;
 
-  return setup_gen( t->m_Root, p, mo );
+  mo = setup_gen( t->m_Root, p, mo );
+  if( mo < 0 )
+    return mo;
+
+  //The nodes' scratch goes after the tree's state.
+  return setup_scratch( t->m_Root, mo );
 }
 
 int gen_teardown_btree( BehaviorTree* t, Program* p )
@@ -452,7 +495,7 @@ int memory_need_btree( BehaviorTree* bt )
   int bnc = calc_memory_need( bt->m_Root );
   if( bnc < 0 )
     return bnc;
-  return bnc + sizeof(int);
+  return bnc + sizeof(int) + scratch_need( bt->m_Root );
 }
 
 /*
@@ -913,9 +956,8 @@ int gen_setup_parallel( Node* n, Program* p, int mo )
   //Store needed generation data in the node's UserData pointer
   n->m_UserData = nd;
 
-  //Alloc storage space for the success counter
-  nd->m_bss_SuccessCounter = mo;
-  mo += sizeof( int );
+  //The success counter is scratch, see setup_scratch.
+  nd->m_bss_SuccessCounter = -1;
 
   int r = 0;
   Node* c = get_first_child( n );
@@ -1045,7 +1087,7 @@ int gen_des_parallel( Node* n, Program* p )
 
 int memory_need_parallel( Node* n )
 {
-  int r = sizeof(int) * 1;
+  int r = 0;
   Node* c = get_first_child( n );
   while( c )
   {
@@ -1080,10 +1122,11 @@ int gen_setup_dynselector( Node* n, Program* p, int mo )
   //Store needed generation data in the node's UserData pointer
   n->m_UserData = nd;
 
-  //Alloc storage area in bss
-  nd->m_bss_NewBranch = mo; mo += sizeof( int );
+  //Alloc storage area in bss, the new branch and the jump-back target are
+  //scratch, see setup_scratch.
+  nd->m_bss_NewBranch = -1;
   nd->m_bss_OldBranch = mo; mo += sizeof( int );
-  nd->m_bss_JumpBackTarget = mo; mo += sizeof( int );
+  nd->m_bss_JumpBackTarget = -1;
   nd->m_bss_RunningChild = mo; mo += sizeof(int) * count_children( n );
 
   int r = 0;
@@ -1133,8 +1176,7 @@ int gen_con_dynselector( Node* n, Program* p )
     ++i;
   }
 
-  //Set bss values to undefined
-  p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_NewBranch, 0xffffffff, 0 );
+  //Set old branch to undefined, the new branch is set before it is read
   p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_OldBranch, 0xffffffff, 0 );
 
   // Exit Debug scope
@@ -1297,7 +1339,7 @@ int gen_des_dynselector( Node* n, Program* p )
 
 int memory_need_dynselector( Node* n )
 {
-  int r = sizeof(int) * 3;
+  int r = sizeof(int) * 1;
   r += sizeof( int ) * count_children( n );
   Node* c = get_first_child( n );
   while( c )
@@ -1427,12 +1469,19 @@ int memory_need_work( Node* n )
 
 struct TreeNodeData
 {
+  bool m_Pooled;
   int m_bss_Call;
   int m_ConsCallPatch;
   int m_ExecCallPatch;
   int m_DestCallPatch;
 };
 
+bool is_pooled_tree( Node* n )
+{
+  Parameter* t = find_by_hash( n->m_Grist.m_Tree.m_Parameters, hashlittle( "pooled" ) );
+  return t && as_bool( *t );
+}
+
 int gen_setup_tree( Node* n, Program* p, int mo )
 {
   if( !n->m_Grist.m_Tree.m_Tree->m_Declared )
@@ -1451,11 +1500,20 @@ int gen_setup_tree( Node* n, Program* p, int mo )
   //Store needed generation data in the node's UserData pointer
   n->m_UserData = nd;
 
-  //"Alloc" space needed for the "call"
-  nd->m_bss_Call = mo; mo += sizeof( CallFrame );
+  nd->m_Pooled = is_pooled_tree( n );
+  if( nd->m_Pooled )
+  {
+    //"Alloc" space for the handle of the pooled frame
+    nd->m_bss_Call = mo; mo += sizeof( int );
+  }
+  else
+  {
+    //"Alloc" space needed for the "call"
+    nd->m_bss_Call = mo; mo += sizeof( CallFrame );
 
-  //"Alloc" space needed for the called tree
-  mo += memory_need_btree( n->m_Grist.m_Tree.m_Tree );
+    //"Alloc" space needed for the called tree
+    mo += memory_need_btree( n->m_Grist.m_Tree.m_Tree );
+  }
 
   //Append this tree to the list of tree's that need generation.
   BehaviorTreeList* btl = p->m_First;
@@ -1491,12 +1549,24 @@ int gen_con_tree( Node* n, Program* p )
   TreeNodeData* nd = ((TreeNodeData*)n->m_UserData);
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_CONSTRUCT, TREE_CONSTRUCT_DBGLVL );
-  //Set the tree argument to construct
-  p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_Call + sizeof(CallFrame), ACT_CONSTRUCT, 0 );
-  //Store the call instruction to patch.
-  nd->m_ConsCallPatch = p->m_I.Count();
-  //Make the call
-  p->m_I.Push( INST_SCRIPT_C, 0xffffffff, nd->m_bss_Call, 0 );
+  if( nd->m_Pooled )
+  {
+    //Get a frame, unless the last destruct did not give it back
+    p->m_I.Push( INST_SCRIPT_A, nd->m_bss_Call, 0, 0 );
+    //Store the call instruction to patch.
+    nd->m_ConsCallPatch = p->m_I.Count();
+    //Make the call in the pooled frame, with the tree argument
+    p->m_I.Push( INST_SCRIPT_P, 0xffffffff, nd->m_bss_Call, ACT_CONSTRUCT );
+  }
+  else
+  {
+    //Set the tree argument to construct
+    p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_Call + sizeof(CallFrame), ACT_CONSTRUCT, 0 );
+    //Store the call instruction to patch.
+    nd->m_ConsCallPatch = p->m_I.Count();
+    //Make the call
+    p->m_I.Push( INST_SCRIPT_C, 0xffffffff, nd->m_bss_Call, 0 );
+  }
   // Exit Debug scope
   p->m_I.PopDebugScope( p, n, ACT_CONSTRUCT, TREE_CONSTRUCT_DBGLVL );
   return 0;
@@ -1507,12 +1577,22 @@ int gen_exe_tree( Node* n, Program* p )
   TreeNodeData* nd = ((TreeNodeData*)n->m_UserData);
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_EXECUTE, TREE_EXECUTE_DBGLVL );
-  //Set the tree argument to execute
-  p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_Call + sizeof(CallFrame), ACT_EXECUTE, 0 );
-  //Store the call instruction to patch.
-  nd->m_ExecCallPatch = p->m_I.Count();
-  //Make the call
-  p->m_I.Push( INST_SCRIPT_C, 0xffffffff, nd->m_bss_Call, 0 );
+  if( nd->m_Pooled )
+  {
+    //Store the call instruction to patch.
+    nd->m_ExecCallPatch = p->m_I.Count();
+    //Make the call in the pooled frame, with the tree argument
+    p->m_I.Push( INST_SCRIPT_P, 0xffffffff, nd->m_bss_Call, ACT_EXECUTE );
+  }
+  else
+  {
+    //Set the tree argument to execute
+    p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_Call + sizeof(CallFrame), ACT_EXECUTE, 0 );
+    //Store the call instruction to patch.
+    nd->m_ExecCallPatch = p->m_I.Count();
+    //Make the call
+    p->m_I.Push( INST_SCRIPT_C, 0xffffffff, nd->m_bss_Call, 0 );
+  }
   // Exit Debug scope
   p->m_I.PopDebugScope( p, n, ACT_EXECUTE, TREE_EXECUTE_DBGLVL );
   return 0;
@@ -1523,12 +1603,24 @@ int gen_des_tree( Node* n, Program* p )
   TreeNodeData* nd = ((TreeNodeData*)n->m_UserData);
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_DESTRUCT, TREE_DESTRUCT_DBGLVL );
-  //Set the tree argument to destroy
-  p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_Call + sizeof(CallFrame), ACT_DESTRUCT, 0 );
-  //Store the call instruction to patch.
-  nd->m_DestCallPatch = p->m_I.Count();
-  //Make the call
-  p->m_I.Push( INST_SCRIPT_C, 0xffffffff, nd->m_bss_Call, 0 );
+  if( nd->m_Pooled )
+  {
+    //Store the call instruction to patch.
+    nd->m_DestCallPatch = p->m_I.Count();
+    //Make the call in the pooled frame, with the tree argument
+    p->m_I.Push( INST_SCRIPT_P, 0xffffffff, nd->m_bss_Call, ACT_DESTRUCT );
+    //Give the frame back
+    p->m_I.Push( INST_SCRIPT_F, nd->m_bss_Call, 0, 0 );
+  }
+  else
+  {
+    //Set the tree argument to destroy
+    p->m_I.Push( INST__STORE_C_IN_B, nd->m_bss_Call + sizeof(CallFrame), ACT_DESTRUCT, 0 );
+    //Store the call instruction to patch.
+    nd->m_DestCallPatch = p->m_I.Count();
+    //Make the call
+    p->m_I.Push( INST_SCRIPT_C, 0xffffffff, nd->m_bss_Call, 0 );
+  }
   // Exit Debug scope
   p->m_I.PopDebugScope( p, n, ACT_DESTRUCT, TREE_DESTRUCT_DBGLVL );
   return 0;
@@ -1536,12 +1628,45 @@ int gen_des_tree( Node* n, Program* p )
 
 int memory_need_tree( Node* n )
 {
+  if( is_pooled_tree( n ) )
+    return sizeof( int );
   int bnt = memory_need_btree( n->m_Grist.m_Tree.m_Tree );
   if( bnt < 0 )
     return bnt;
   return sizeof( CallFrame ) + bnt;
 }
 
+static int pooled_frames( Node* n, int* size )
+{
+  int count = 0;
+  Node* c = get_first_child( n );
+  while( c )
+  {
+    count += pooled_frames( c, size );
+    c = c->m_Next;
+  }
+  if( n->m_Grist.m_Type == E_GRIST_TREE )
+  {
+    BehaviorTree* t = n->m_Grist.m_Tree.m_Tree;
+    if( is_pooled_tree( n ) )
+    {
+      int fs = sizeof( CallFrame ) + memory_need_btree( t );
+      if( fs > *size )
+        *size = fs;
+      ++count;
+    }
+    count += pooled_frames_btree( t, size );
+  }
+  return count;
+}
+
+int pooled_frames_btree( BehaviorTree* t, int* size )
+{
+  if( !t->m_Root )
+    return 0;
+  return pooled_frames( t->m_Root, size );
+}
+
 /*
  *
  * Decorator
@@ -1552,6 +1677,7 @@ struct DecoratorNodeData
 {
   int m_bssPos;
   int m_bssModPos;
+  int m_cbIndex;
   bool m_usesBss;
   VariableGenerateData m_VD;
 };
@@ -1578,6 +1704,7 @@ int gen_setup_decorator( Node* n, Program* p, int mo )
   //init the bss members
   nd->m_bssPos      = 0;
   nd->m_bssModPos   = 0;
+  nd->m_cbIndex     = 0;
   nd->m_usesBss     = false;
 
   //Store needed generation data in the node's UserData pointer
@@ -1613,6 +1740,8 @@ int gen_setup_decorator( Node* n, Program* p, int mo )
     NamedSymbol tns;
     tns.m_Type = E_ST_DECORATOR;
     tns.m_Symbol.m_Decorator = d;
+    //Look up the callback index.
+    nd->m_cbIndex = callback_index( p->m_Callbacks, &tns );
     //Store the variable values in the data section.
     mo = store_variables_in_data_section( &nd->m_VD, n,
       n->m_Grist.m_Decorator.m_Parameters, &tns, d->m_Declarations, p, mo );
@@ -1647,43 +1776,17 @@ int gen_con_decorator( Node* n, Program* p )
 
   Decorator* d = n->m_Grist.m_Decorator.m_Decorator;
 
-  Parameter* t = find_by_hash( d->m_Options, hashlittle( "id" ) );
-  int fid = t ? as_integer( *t ) : d->m_Id.m_Hash;
-
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_CONSTRUCT, DECORATOR_CONSTRUCT_DBGLVL );
 
   int err;
 
-  // Load bss section with pointers to the data section, for the variables
-  err = generate_variable_instructions( &nd->m_VD,
-    n->m_Grist.m_Decorator.m_Parameters, p );
-  if( err != 0 )
-    return err;
-
-  t = find_by_hash( d->m_Options, hashlittle( "construct" ) );
+  Parameter* t = find_by_hash( d->m_Options, hashlittle( "construct" ) );
   if( t && as_bool( *t ) )
   {
-    //Setup the register for the data pointer
-    err = setup_variable_registry( &nd->m_VD,
-      n->m_Grist.m_Decorator.m_Parameters, p );
-    if( err != 0 )
-      return err;
-    if( nd->m_usesBss )
-    {
-      // Load bss register with bss pointer
-      p->m_I.Push( INST_STORE_PB_IN_R, 1, nd->m_bssPos, 0 );
-    }
-    else
-    {
-      // Reset the bss register
-      p->m_I.Push( INST__SET_REGISTRY, 1, 0, 0 );
-    }
-    // Load the register with the correct id
-    p->m_I.Push( INST__SET_REGISTRY, 0, (fid >> 16) & 0x0000ffff, fid
-        & 0x0000ffff );
     // Call the decorator construction function
-    p->m_I.Push( INST_CALL_CONS_FUN, 0, 1, 2 );
+    gen_callback( p, INST_FUSE_CONS_FUN, nd->m_cbIndex,
+      nd->m_usesBss ? nd->m_bssPos : WIDE_NO_OPERAND, &nd->m_VD );
   }
 
   //Generate child construction code
@@ -1704,41 +1807,21 @@ int gen_exe_decorator( Node* n, Program* p )
   DecoratorNodeData* nd = (DecoratorNodeData*)n->m_UserData;
   Decorator* d = n->m_Grist.m_Decorator.m_Decorator;
 
-  Parameter* t = find_by_hash( d->m_Options, hashlittle( "id" ) );
-  int fid = t ? as_integer( *t ) : d->m_Id.m_Hash;
-
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_EXECUTE, DECORATOR_EXECUTE_DBGLVL );
 
   int err;
   int jump_out = -1;
 
-  t = find_by_hash( d->m_Options, hashlittle( "prune" ) );
+  Parameter* t = find_by_hash( d->m_Options, hashlittle( "prune" ) );
   if( t && as_bool( *t ) )
   {
     // Enter Debug scope
     p->m_I.PushDebugScope( p, n, ACT_PRUNE, DECORATOR_EXECUTE_DBGLVL );
 
-    //Setup the register for the data pointer
-    err = setup_variable_registry( &nd->m_VD,
-      n->m_Grist.m_Decorator.m_Parameters, p );
-    if( err != 0 )
-      return err;
-    if( nd->m_usesBss )
-    {
-      // Load bss register with bss pointer
-      p->m_I.Push( INST_STORE_PB_IN_R, 1, nd->m_bssPos, 0 );
-    }
-    else
-    {
-      // Reset the bss register
-      p->m_I.Push( INST__SET_REGISTRY, 1, 0, 0 );
-    }
-    // Load the register with the correct id
-    p->m_I.Push( INST__SET_REGISTRY, 0, (fid >> 16) & 0x0000ffff, fid
-        & 0x0000ffff );
     // Call the decorator prune function
-    p->m_I.Push( INST_CALL_PRUN_FUN, 0, 1, 2 );
+    gen_callback( p, INST_FUSE_PRUN_FUN, nd->m_cbIndex,
+      nd->m_usesBss ? nd->m_bssPos : WIDE_NO_OPERAND, &nd->m_VD );
 
     // Exit Debug scope
     p->m_I.PopDebugScope( p, n, ACT_PRUNE, DECORATOR_EXECUTE_DBGLVL );
@@ -1761,26 +1844,9 @@ int gen_exe_decorator( Node* n, Program* p )
     //Copy return value to bss section
     p->m_I.Push( INST__STORE_R_IN_B, nd->m_bssModPos, 0, 0 );
 
-    //Setup the register for the data pointer
-    err = setup_variable_registry( &nd->m_VD,
-      n->m_Grist.m_Decorator.m_Parameters, p );
-    if( err != 0 )
-      return err;
-    if( nd->m_usesBss )
-    {
-      // Load bss register with bss pointer
-      p->m_I.Push( INST_STORE_PB_IN_R, 1, nd->m_bssPos, 0 );
-    }
-    else
-    {
-      // Reset the bss register
-      p->m_I.Push( INST__SET_REGISTRY, 1, 0, 0 );
-    }
-    // Load the register with the correct id
-    p->m_I.Push( INST__SET_REGISTRY, 0, (fid >> 16) & 0x0000ffff, fid
-        & 0x0000ffff );
     //Call the decorator modify function
-    p->m_I.Push( INST_CALL_MODI_FUN, 0, 1, 2 );
+    gen_callback( p, INST_FUSE_MODI_FUN, nd->m_cbIndex,
+      nd->m_usesBss ? nd->m_bssPos : WIDE_NO_OPERAND, &nd->m_VD );
 
     // Exit Debug scope
     p->m_I.PopDebugScope( p, n, ACT_MODIFY, DECORATOR_EXECUTE_DBGLVL );
@@ -1804,9 +1870,6 @@ int gen_des_decorator( Node* n, Program* p )
   DecoratorNodeData* nd = (DecoratorNodeData*)n->m_UserData;
   Decorator* d = n->m_Grist.m_Decorator.m_Decorator;
 
-  Parameter* t = find_by_hash( d->m_Options, hashlittle( "id" ) );
-  int fid = t ? as_integer( *t ) : d->m_Id.m_Hash;
-
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_DESTRUCT, DECORATOR_DESTRUCT_DBGLVL );
 
@@ -1816,29 +1879,12 @@ int gen_des_decorator( Node* n, Program* p )
   if( (err = gen_des( c, p )) != 0 )
     return err;
 
-  t = find_by_hash( d->m_Options, hashlittle( "destruct" ) );
+  Parameter* t = find_by_hash( d->m_Options, hashlittle( "destruct" ) );
   if( t && as_bool( *t ) )
   {
-    //Setup the register for the data pointer
-    err = setup_variable_registry( &nd->m_VD,
-      n->m_Grist.m_Decorator.m_Parameters, p );
-    if( err != 0 )
-      return err;
-    if( nd->m_usesBss )
-    {
-      // Load bss register with bss pointer
-      p->m_I.Push( INST_STORE_PB_IN_R, 1, nd->m_bssPos, 0 );
-    }
-    else
-    {
-      // Reset the bss register
-      p->m_I.Push( INST__SET_REGISTRY, 1, 0, 0 );
-    }
-    // Load the register with the correct id
-    p->m_I.Push( INST__SET_REGISTRY, 0, (fid >> 16) & 0x0000ffff, fid
-        & 0x0000ffff );
     // Call the decorator destruciton function
-    p->m_I.Push( INST_CALL_DEST_FUN, 0, 1, 2 );
+    gen_callback( p, INST_FUSE_DEST_FUN, nd->m_cbIndex,
+      nd->m_usesBss ? nd->m_bssPos : WIDE_NO_OPERAND, &nd->m_VD );
   }
 
   // Exit Debug scope
@@ -1895,6 +1941,7 @@ int memory_need_decorator( Node* n )
 struct ActionNodeData
 {
   int m_bssPos;
+  int m_cbIndex;
   bool m_usesBss;
   VariableGenerateData m_VD;
 };
@@ -1915,6 +1962,7 @@ int gen_setup_action( Node* n, Program* p, int mo )
   ActionNodeData* nd = new ActionNodeData;
   //Set the bss pointer to zero.
   nd->m_bssPos = 0;
+  nd->m_cbIndex = 0;
   nd->m_usesBss = false;
   //Store needed generation data in the node's UserData pointer
   n->m_UserData = nd;
@@ -1944,6 +1992,8 @@ int gen_setup_action( Node* n, Program* p, int mo )
     NamedSymbol tns;
     tns.m_Type = E_ST_ACTION;
     tns.m_Symbol.m_Action = a;
+    //Look up the callback index.
+    nd->m_cbIndex = callback_index( p->m_Callbacks, &tns );
     //Store the variable values in the data section.
     mo = store_variables_in_data_section( &nd->m_VD, n,
       n->m_Grist.m_Action.m_Parameters, &tns, a->m_Declarations, p, mo );
@@ -1966,44 +2016,15 @@ int gen_con_action( Node* n, Program* p )
   ActionNodeData* nd = (ActionNodeData*)n->m_UserData;
   //Obtain action declaration
   Action* a = n->m_Grist.m_Action.m_Action;
-  //Get the actions function id
-  Parameter* t = find_by_hash( a->m_Options, hashlittle( "id" ) );
-  int fid = t ? as_integer( *t ) : a->m_Id.m_Hash;
-
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_CONSTRUCT, ACTION_CONSTRUCT_DBGLVL );
 
-  int err;
-
-  // Load bss section with pointers to the data section, for the variables
-  err = generate_variable_instructions( &nd->m_VD,
-    n->m_Grist.m_Action.m_Parameters, p );
-  if( err != 0 )
-    return err;
-
-  t = find_by_hash( a->m_Options, hashlittle( "construct" ) );
+  Parameter* t = find_by_hash( a->m_Options, hashlittle( "construct" ) );
   if( t && as_bool( *t ) )
   {
-    //Setup the register for the data pointer
-    err = setup_variable_registry( &nd->m_VD, n->m_Grist.m_Action.m_Parameters,
-      p );
-    if( err != 0 )
-      return err;
-    if( nd->m_usesBss )
-    {
-      // Load bss register with bss pointer
-      p->m_I.Push( INST_STORE_PB_IN_R, 1, nd->m_bssPos, 0 );
-    }
-    else
-    {
-      // Reset the bss register
-      p->m_I.Push( INST__SET_REGISTRY, 1, 0, 0 );
-    }
-    // Load the callback id register with the correct id
-    p->m_I.Push( INST__SET_REGISTRY, 0, (fid >> 16) & 0x0000ffff, fid
-        & 0x0000ffff );
     // Call the construction callback
-    p->m_I.Push( INST_CALL_CONS_FUN, 0, 1, 2 );
+    gen_callback( p, INST_FUSE_CONS_FUN, nd->m_cbIndex,
+      nd->m_usesBss ? nd->m_bssPos : WIDE_NO_OPERAND, &nd->m_VD );
   }
 
   // Exit Debug scope
@@ -2017,35 +2038,14 @@ int gen_exe_action( Node* n, Program* p )
   ActionNodeData* nd = (ActionNodeData*)n->m_UserData;
   //Obtain action declaration
   Action* a = n->m_Grist.m_Action.m_Action;
-  //Get the actions function id
-  Parameter* t = find_by_hash( a->m_Options, hashlittle( "id" ) );
-  int fid = t ? as_integer( *t ) : a->m_Id.m_Hash;
-
-  t = find_by_hash( a->m_Options, hashlittle( "execute" ) );
+  Parameter* t = find_by_hash( a->m_Options, hashlittle( "execute" ) );
   if( !t || as_bool( *t ) )
   {
     // Enter Debug scope
     p->m_I.PushDebugScope( p, n, ACT_EXECUTE, ACTION_EXECUTE_DBGLVL );
-    //Setup the register for the data pointer
-    int err = setup_variable_registry( &nd->m_VD,
-      n->m_Grist.m_Action.m_Parameters, p );
-    if( err != 0 )
-      return err;
-    if( nd->m_usesBss )
-    {
-      // Load bss register with bss pointer
-      p->m_I.Push( INST_STORE_PB_IN_R, 1, nd->m_bssPos, 0 );
-    }
-    else
-    {
-      // Reset the bss register
-      p->m_I.Push( INST__SET_REGISTRY, 1, 0, 0 );
-    }
-    // Load the callback id register with the correct id
-    p->m_I.Push( INST__SET_REGISTRY, 0, (fid >> 16) & 0x0000ffff, fid
-        & 0x0000ffff );
     // Call the destruction callback
-    p->m_I.Push( INST_CALL_EXEC_FUN, 0, 1, 2 );
+    gen_callback( p, INST_FUSE_EXEC_FUN, nd->m_cbIndex,
+      nd->m_usesBss ? nd->m_bssPos : WIDE_NO_OPERAND, &nd->m_VD );
     // Exit Debug scope
     p->m_I.PopDebugScope( p, n, ACT_EXECUTE, ACTION_EXECUTE_DBGLVL );
   }
@@ -2057,36 +2057,15 @@ int gen_des_action( Node* n, Program* p )
   ActionNodeData* nd = (ActionNodeData*)n->m_UserData;
   //Obtain action declaration
   Action* a = n->m_Grist.m_Action.m_Action;
-  //Get the actions function id
-  Parameter* t = find_by_hash( a->m_Options, hashlittle( "id" ) );
-  int fid = t ? as_integer( *t ) : a->m_Id.m_Hash;
-
   // Enter Debug scope
   p->m_I.PushDebugScope( p, n, ACT_DESTRUCT, ACTION_DESTRUCT_DBGLVL );
 
-  t = find_by_hash( a->m_Options, hashlittle( "destruct" ) );
+  Parameter* t = find_by_hash( a->m_Options, hashlittle( "destruct" ) );
   if( t && as_bool( *t ) )
   {
-    //Setup the register for the data pointer
-    int err = setup_variable_registry( &nd->m_VD,
-      n->m_Grist.m_Action.m_Parameters, p );
-    if( err != 0 )
-      return err;
-    if( nd->m_usesBss )
-    {
-      // Load bss register with bss pointer
-      p->m_I.Push( INST_STORE_PB_IN_R, 1, nd->m_bssPos, 0 );
-    }
-    else
-    {
-      // Reset the bss register
-      p->m_I.Push( INST__SET_REGISTRY, 1, 0, 0 );
-    }
-    // Load the callback id register with the correct id
-    p->m_I.Push( INST__SET_REGISTRY, 0, (fid >> 16) & 0x0000ffff, fid
-        & 0x0000ffff );
     // Call the destruction callback
-    p->m_I.Push( INST_CALL_DEST_FUN, 0, 1, 2 );
+    gen_callback( p, INST_FUSE_DEST_FUN, nd->m_cbIndex,
+      nd->m_usesBss ? nd->m_bssPos : WIDE_NO_OPERAND, &nd->m_VD );
   }
 
   // Exit Debug scope
@@ -2125,6 +2104,115 @@ int memory_need_action( Node* n )
   return bss + bnv;
 }
 
+/*
+ *
+ * Scratch
+ *
+ */
+
+/*
+ * Scratch is bss that a node only uses while its own code runs, not between
+ * ticks. The code of a node only ever runs inside the code of its ancestors,
+ * so each node's scratch is placed above its parent's and siblings share the
+ * same bytes. A called tree keeps its scratch in its own frame.
+ */
+int scratch_self( Node* n )
+{
+  switch( n->m_Grist.m_Type )
+  {
+  case E_GRIST_PARALLEL:
+    //Success counter
+    return sizeof( int );
+  case E_GRIST_DYN_SELECTOR:
+    //New branch and jump-back target
+    return sizeof( int ) * 2;
+  default:
+    break;
+  }
+  return 0;
+}
+
+int scratch_need( Node* n )
+{
+  if( !n )
+    return 0;
+
+  int max_child = 0;
+  Node* c = get_first_child( n );
+  while( c )
+  {
+    int cs = scratch_need( c );
+    if( cs > max_child )
+      max_child = cs;
+    c = c->m_Next;
+  }
+  return scratch_self( n ) + max_child;
+}
+
+int setup_scratch( Node* n, int so )
+{
+  if( !n )
+    return so;
+
+  switch( n->m_Grist.m_Type )
+  {
+  case E_GRIST_PARALLEL:
+    {
+      ParallelNodeData* nd = (ParallelNodeData*)n->m_UserData;
+      nd->m_bss_SuccessCounter = so;
+    }
+    break;
+  case E_GRIST_DYN_SELECTOR:
+    {
+      DynamicSelectorNodeData* nd = (DynamicSelectorNodeData*)n->m_UserData;
+      nd->m_bss_NewBranch      = so;
+      nd->m_bss_JumpBackTarget = so + sizeof( int );
+    }
+    break;
+  default:
+    break;
+  }
+
+  const int base = so + scratch_self( n );
+  int maximum = base;
+  Node* c = get_first_child( n );
+  while( c )
+  {
+    int cs = setup_scratch( c, base );
+    if( cs > maximum )
+      maximum = cs;
+    c = c->m_Next;
+  }
+  return maximum;
+}
+
+/*
+ * Bytes of scratch the tree and the trees it calls would take if nothing
+ * was shared, less what they take now.
+ */
+static int scratch_total( Node* n, int* saved )
+{
+  int total = scratch_self( n );
+  Node* c = get_first_child( n );
+  while( c )
+  {
+    total += scratch_total( c, saved );
+    c = c->m_Next;
+  }
+  if( n->m_Grist.m_Type == E_GRIST_TREE )
+    *saved += scratch_saving_btree( n->m_Grist.m_Tree.m_Tree );
+  return total;
+}
+
+int scratch_saving_btree( BehaviorTree* t )
+{
+  if( !t->m_Root )
+    return 0;
+  int saved = 0;
+  int total = scratch_total( t->m_Root, &saved );
+  return saved + total - scratch_need( t->m_Root );
+}
+
 /*
  *
  * Warning printing functions
@@ -2261,6 +2349,16 @@ void print_unable_to_convert_param_error( Node* n, Parameter* v, Parameter* d, N
   );
 }
 
+void print_too_many_params_error( Node* n, int count )
+{
+  fprintf( stderr, "%s(%d): error: %d parameters given, a callback can take at most %u.\n",
+    n->m_Locator.m_Buffer,
+    n->m_Locator.m_LineNo,
+    count,
+    MAX_CALLBACK_VARIABLES
+  );
+}
+
 /*
  *
  * Argument list functions
@@ -2282,7 +2380,8 @@ int memory_need_variables( Node* vars_n, Parameter* vars, NamedSymbol* dec_s, Pa
       print_missing_param_error( vars_n, it, dec_s );
     return -1;
   }
-  return sizeof( void* ) * count_elements( dec );
+  //The variable list is in the data section, shared by all agents
+  return 0;
 }
 
 int store_variables_in_data_section(
@@ -2295,8 +2394,7 @@ int store_variables_in_data_section(
     int mo
   )
 {
-  vd->m_Data.clear();
-  vd->m_bssStart = 0;
+  vd->m_ListPos = WIDE_NO_OPERAND;
 
   if( !vars && !dec )
     return mo;
@@ -2312,8 +2410,12 @@ int store_variables_in_data_section(
     return -1;
   }
 
-  vd->m_bssStart = mo;
-  mo += sizeof(void*) * count_elements( dec );
+  const int count = count_elements( dec );
+  if( count > (int)MAX_CALLBACK_VARIABLES )
+  {
+    print_too_many_params_error( vars_n, count );
+    return -1;
+  }
 
   bool errors = false;
   Parameter* it;
@@ -2332,11 +2434,12 @@ int store_variables_in_data_section(
   }
 
   if( errors )
-  {
-    vd->m_bssStart = 0;
-    vd->m_Data.clear();
     return -1;
-  }
+
+  //The variable count followed by the data section offset of each variable,
+  //the VM makes pointers of them for the call.
+  IntVector list;
+  list.push_back( count );
 
   DataSection& d = p->m_D;
   for( it = dec; it != 0x0; it = it->m_Next )
@@ -2345,19 +2448,19 @@ int store_variables_in_data_section(
     switch( it->m_Type )
     {
     case E_VART_INTEGER:
-      vd->m_Data.push_back( d.PushInteger( as_integer( *v ) ) );
+      list.push_back( d.PushInteger( as_integer( *v ) ) );
       break;
     case E_VART_FLOAT:
-      vd->m_Data.push_back( d.PushFloat( as_float( *v ) ) );
+      list.push_back( d.PushFloat( as_float( *v ) ) );
       break;
     case E_VART_STRING:
-      vd->m_Data.push_back( d.PushString( as_string( *v )->m_Parsed ) );
+      list.push_back( d.PushString( as_string( *v )->m_Parsed ) );
       break;
     case E_VART_BOOL:
-      vd->m_Data.push_back( d.PushInteger( as_integer( *v ) ) );
+      list.push_back( d.PushInteger( as_integer( *v ) ) );
       break;
     case E_VART_HASH:
-      vd->m_Data.push_back( d.PushInteger( as_hash( *v ) ) );
+      list.push_back( d.PushInteger( as_hash( *v ) ) );
       break;
     case E_VART_UNDEFINED:
     case E_MAX_VARIABLE_TYPE:
@@ -2365,37 +2468,22 @@ int store_variables_in_data_section(
       break;
     }
   }
-  return mo;
-}
 
-int generate_variable_instructions( VariableGenerateData* vd, Parameter*,
-  Program* p )
-{
-  IntVector::iterator it, it_e( vd->m_Data.end() );
-  int i = 0;
-  for( it = vd->m_Data.begin(); it != it_e; ++it, ++i )
-  {
-    //Store a pointer to a variable in the data section in the bss section.
-    p->m_I.Push( INST_STORE_PD_IN_B, vd->m_bssStart + (sizeof(void*) * i), *it,
-      0 );
-  }
-  return 0;
+  vd->m_ListPos = d.PushIntegers( &list[0], (int)list.size() );
+  return mo;
 }
 
-int setup_variable_registry( VariableGenerateData* vd, Parameter*,
-  Program* p )
+void gen_callback( Program* p, InstructionSet inst, int cb_index, int bss_pos,
+  VariableGenerateData* vd )
 {
-  if( !vd->m_Data.empty() )
-  {
-    // Load the user data register with a pointer to the bss structure for variables
-    p->m_I.Push( INST_STORE_PB_IN_R, 2, vd->m_bssStart, 0 );
-  }
-  else
-  {
-    //Load the user data register with a null pointer
-    p->m_I.Push( INST__SET_REGISTRY, 2, 0, 0 );
-  }
-  return 0;
+  const unsigned int action = (inst - INST_FUSE_CONS_FUN) << TRACE_ACTION_SHIFT;
+  Node* n = p->m_I.CurrentNode();
+  gen_trace( n, p, E_TRACE_CALLBACK_BEGIN | action );
+  //The fused call instructions replace the register setup and the call with
+  //a single instruction: callback index, the bss offset of the callback's
+  //memory and the data section offset of the variable list.
+  p->m_I.Push( inst, cb_index, bss_pos, vd->m_ListPos );
+  gen_trace( n, p, E_TRACE_CALLBACK_END | action );
 }
 
 
@@ -2424,3 +2512,101 @@ void patch_calls( Node* n, Program* p )
   }
 }
 
+
+/*
+ *
+ * Node maps
+ *
+ */
+
+static int callback_bss( Parameter* options )
+{
+  Parameter* t = find_by_hash( options, hashlittle( "bss" ) );
+  int bss = t ? as_integer( *t ) : 0;
+  return (bss + 3) & ~3;
+}
+
+static int set_slot( MapSlot* s, int offset, int size, MapSlotKind kind,
+  unsigned int reset )
+{
+  s->m_Offset = offset;
+  s->m_Size   = size;
+  s->m_Kind   = kind;
+  s->m_Reset  = reset;
+  return 1;
+}
+
+int node_slots( Node* n, MapSlot* slots )
+{
+  switch( n->m_Grist.m_Type )
+  {
+  case E_GRIST_SEQUENCE:
+    {
+      SequenceNodeData* nd = (SequenceNodeData*)n->m_UserData;
+      set_slot( slots + 0, nd->m_bss_ReEntry, sizeof(int), E_MAP_SLOT_CODE, 0xffffffff );
+      set_slot( slots + 1, nd->m_bss_JumpBackTarget, sizeof(int), E_MAP_SLOT_CODE, 0xffffffff );
+    }
+    return 2;
+  case E_GRIST_SELECTOR:
+    {
+      SelectorNodeData* nd = (SelectorNodeData*)n->m_UserData;
+      set_slot( slots + 0, nd->m_bss_ReEntry, sizeof(int), E_MAP_SLOT_CODE, 0xffffffff );
+      set_slot( slots + 1, nd->m_bss_JumpBackTarget, sizeof(int), E_MAP_SLOT_CODE, 0xffffffff );
+    }
+    return 2;
+  case E_GRIST_DYN_SELECTOR:
+    {
+      DynamicSelectorNodeData* nd = (DynamicSelectorNodeData*)n->m_UserData;
+      set_slot( slots + 0, nd->m_bss_OldBranch, sizeof(int), E_MAP_SLOT_CODE, 0xffffffff );
+      set_slot( slots + 1, nd->m_bss_RunningChild, sizeof(int) * count_children( n ),
+        E_MAP_SLOT_STATE, E_NODE_UNDEFINED );
+    }
+    return 2;
+  case E_GRIST_TREE:
+    {
+      TreeNodeData* nd = (TreeNodeData*)n->m_UserData;
+      if( nd->m_Pooled )
+        return set_slot( slots, nd->m_bss_Call, sizeof(int), E_MAP_SLOT_POOLED, 0 );
+      return set_slot( slots, nd->m_bss_Call, sizeof(CallFrame), E_MAP_SLOT_FRAME, 0 );
+    }
+  case E_GRIST_DECORATOR:
+    {
+      DecoratorNodeData* nd = (DecoratorNodeData*)n->m_UserData;
+      if( !nd || !nd->m_usesBss )
+        return 0;
+      return set_slot( slots, nd->m_bssPos, nd->m_bssModPos + sizeof(int) - nd->m_bssPos,
+        E_MAP_SLOT_CALLBACK, 0 );
+    }
+  case E_GRIST_ACTION:
+    {
+      ActionNodeData* nd = (ActionNodeData*)n->m_UserData;
+      if( !nd->m_usesBss )
+        return 0;
+      return set_slot( slots, nd->m_bssPos,
+        callback_bss( n->m_Grist.m_Action.m_Action->m_Options ), E_MAP_SLOT_CALLBACK, 0 );
+    }
+  default:
+    break;
+  }
+  return 0;
+}
+
+unsigned int node_map_flags( Node* n )
+{
+  switch( n->m_Grist.m_Type )
+  {
+  case E_GRIST_SEQUENCE:
+  case E_GRIST_SELECTOR:
+    return E_MAP_LIVE_ENTRY | E_MAP_RESTARTABLE;
+  case E_GRIST_DYN_SELECTOR:
+    return E_MAP_LIVE_STATE | E_MAP_RESTARTABLE;
+  case E_GRIST_PARALLEL:
+  case E_GRIST_DECORATOR:
+    return E_MAP_LIVE_ALL;
+  case E_GRIST_TREE:
+    return is_pooled_tree( n ) ? 0 : E_MAP_LIVE_ALL;
+  default:
+    break;
+  }
+  return 0;
+}
@@ -16,6 +16,11 @@ struct Program;
 struct Node;
 struct BehaviorTree;
 
+namespace callback
+{
+  struct MapSlot;
+}
+
 int setup_gen( Node* n, Program* p, int memory_offset );
 int teardown_gen( Node* n, Program* p );
 
@@ -28,6 +33,10 @@ int gen_teardown_btree( BehaviorTree* t, Program* p );
 int gen_btree( BehaviorTree* t, Program* p );
 int memory_need_btree( BehaviorTree* t );
 
+int scratch_need( Node* n );
+int setup_scratch( Node* n, int scratch_offset );
+int scratch_saving_btree( BehaviorTree* t );
+
 int gen_setup_sequence( Node* n, Program* p, int memory_offset );
 int gen_teardown_sequence( Node* n, Program* p );
 int gen_con_sequence( Node* n, Program* p );
@@ -83,6 +92,11 @@ int gen_con_tree( Node* n, Program* p );
 int gen_exe_tree( Node* n, Program* p );
 int gen_des_tree( Node* n, Program* p );
 int memory_need_tree( Node* n );
+// True for calls made with (tree 'name ((pooled true))).
+bool is_pooled_tree( Node* n );
+// The most pooled frames the calls in "t" and the trees it calls hold at once,
+// with the size of the largest frame stored in "size".
+int pooled_frames_btree( BehaviorTree* t, int* size );
 
 int gen_setup_decorator( Node* n, Program* p, int memory_offset );
 int gen_teardown_decorator( Node* n, Program* p );
@@ -100,4 +114,12 @@ int memory_need_action( Node* n );
 
 void patch_calls( Node* n, Program* p );
 
+// The most slots node_slots gives a node.
+const int MAX_NODE_SLOTS = 2;
+// The bss "n" keeps between runs, see callback/nodemap.h. Returns the number
+// of slots.
+int node_slots( Node* n, callback::MapSlot* slots );
+// The MapNodeFlags of "n".
+unsigned int node_map_flags( Node* n );
+
 #endif /* NODES_H_INCLUDED */
@@ -15,6 +15,8 @@
 #include "inst_text.h"
 
 #include <btree/btree_func.h>
+#include <callback/compact.h>
+#include <callback/counters.h>
 #include <other/lookup3.h>
 
 #include <stdio.h>
@@ -24,15 +26,18 @@
 
 using namespace callback;
 
-void print_instruction( FILE* outFile, const Instruction& inst, int g, int f )
+void print_instruction( FILE* outFile, const WideInstruction& inst, int g, int f,
+  bool wide )
 {
   char func[16], glob[16], a1[16], a2[16], a3[16];
 
+  //List the operands as they are saved
+  const WideVMIType mask = wide ? WIDE_NO_OPERAND : NO_OPERAND;
   sprintf( func, "0x%04x", f );
   sprintf( glob, "0x%04x", g );
-  sprintf( a1, "0x%04x", inst.m_A1 );
-  sprintf( a2, "0x%04x", inst.m_A2 );
-  sprintf( a3, "0x%04x", inst.m_A3 );
+  sprintf( a1, "0x%04x", inst.m_A1 & mask );
+  sprintf( a2, "0x%04x", inst.m_A2 & mask );
+  sprintf( a3, "0x%04x", inst.m_A3 & mask );
   fprintf( outFile, "%-8s%-8s%-20s", glob, func, g_InstructionNames[inst.m_I] );
 
   switch( inst.m_I )
@@ -53,8 +58,13 @@ void print_instruction( FILE* outFile, const Instruction& inst, int g, int f )
 }
 
 CodeSection::CodeSection() :
-  m_DebugLevel( 0 )
+  m_DebugLevel( 0 ),
+  m_Base( 0 ),
+  m_ForceWide( false ),
+  m_Compact( false )
 {
+  m_Scope.m_Node   = 0x0;
+  m_Scope.m_Action = -1;
 }
 
 void CodeSection::SetGenerateDebugInfo( int debug_level )
@@ -62,6 +72,21 @@ void CodeSection::SetGenerateDebugInfo( int debug_level )
   m_DebugLevel = debug_level;
 }
 
+void CodeSection::SetForceWide( bool force )
+{
+  m_ForceWide = force;
+}
+
+void CodeSection::SetCompact( bool compact )
+{
+  m_Compact = compact;
+}
+
+void CodeSection::SetBase( int base )
+{
+  m_Base = base;
+}
+
 void CodeSection::Setup( Program* p )
 {
 }
@@ -72,6 +97,7 @@ void CodeSection::Print( FILE* outFile, Program* p ) const
 
   int f = 0;
   int s = btl->m_FirstInst;
+  const bool wide = Flags() != 0;
 
   fprintf( outFile, "__entry_stub\n" );
   fprintf( outFile, "%-8s%-8s%-20s%-10s%-10s%-10s\n", "Global", "Func",
@@ -81,8 +107,8 @@ void CodeSection::Print( FILE* outFile, Program* p ) const
 
   for( int i = 0; i < s; ++i, ++f )
   {
-    const Instruction& inst = m_Inst[i];
-    print_instruction( outFile, inst, i, f );
+    const WideInstruction& inst = m_Inst[i];
+    print_instruction( outFile, inst, i, f, wide );
     fprintf( outFile, "\n" );
   }
 
@@ -93,7 +119,9 @@ void CodeSection::Print( FILE* outFile, Program* p ) const
     else
       s = Count();
     int mem =  memory_need_btree( btl->m_Tree );
-    fprintf( outFile, "\n%s (mem: %d 0x%04x)\n", btl->m_Tree->m_Id.m_Text, mem, mem );
+    int scr = scratch_need( btl->m_Tree->m_Root );
+    fprintf( outFile, "\n%s (mem: %d 0x%04x, scratch: %d)\n", btl->m_Tree->m_Id.m_Text,
+      mem, mem, scr );
     fprintf( outFile, "%-8s%-8s%-20s%-10s%-10s%-10s\n", "Global", "Func",
       "Instruction", "A1", "A2", "A3" );
 
@@ -101,53 +129,190 @@ void CodeSection::Print( FILE* outFile, Program* p ) const
 
     for( int i = btl->m_FirstInst; i < s; ++i, ++f )
     {
-      const Instruction& inst = m_Inst[i];
-      print_instruction( outFile, inst, i, f );
+      const WideInstruction& inst = m_Inst[i];
+      print_instruction( outFile, inst, i, f, wide );
       fprintf( outFile, "\n" );
     }
     btl = btl->m_Next;
   }
 
-  fprintf( outFile, "\nCode:\t%d (%d instructions)\n", s * sizeof(Instruction),
-    s );
+  const unsigned int flags = Flags();
+  const unsigned int array = s * (Wide() ? sizeof(WideInstruction) : sizeof(Instruction));
+  //The offset table and the padded code, as saved
+  const unsigned int bytes = compact_table_count( s ) * sizeof(unsigned int)
+    + ((CompactBytes() + 3) & ~3);
+  if( flags & E_PROGRAM_COMPACT )
+    fprintf( outFile, "\nCode:\t%d (%d compact instructions)\n", bytes, s );
+  else
+    fprintf( outFile, "\nCode:\t%d (%d %sinstructions)\n", array, s,
+      (flags & E_PROGRAM_WIDE) ? "wide " : "" );
+  fprintf( outFile, "Compact code:\t%u bytes, %u%% of %u bytes of %sinstructions\n",
+    bytes, array ? (bytes * 100) / array : 0, array, Wide() ? "wide " : "" );
 }
 
 int CodeSection::Count() const
 {
-  return (int)m_Inst.size();
+  return m_Base + (int)m_Inst.size();
+}
+
+const WideInstruction& CodeSection::Get( int i ) const
+{
+  return m_Inst[i - m_Base];
 }
 
 void CodeSection::Push( TIn inst, TIn A1, TIn A2, TIn A3 )
 {
-  Instruction i;
-  i.m_I = SafeConvert( inst );
-  i.m_A1 = SafeConvert( A1 );
-  i.m_A2 = SafeConvert( A2 );
-  i.m_A3 = SafeConvert( A3 );
+  WideInstruction i;
+  i.m_I = inst;
+  i.m_A1 = A1;
+  i.m_A2 = A2;
+  i.m_A3 = A3;
   m_Inst.push_back( i );
+  m_Owner.push_back( m_Scope );
+}
+
+CodeScope CodeSection::EnterNode( Node* n, NodeAction action )
+{
+  Entries::iterator it = m_Entries.find( n );
+  if( it == m_Entries.end() )
+  {
+    NodeEntry e = { { -1, -1, -1 } };
+    it = m_Entries.insert( Entries::value_type( n, e ) ).first;
+  }
+  it->second.m_Entry[action] = Count();
+  CodeScope outer = m_Scope;
+  m_Scope.m_Node   = n;
+  m_Scope.m_Action = action;
+  return outer;
+}
+
+void CodeSection::LeaveNode( const CodeScope& outer )
+{
+  m_Scope = outer;
+}
+
+Node* CodeSection::GetNode( int i ) const
+{
+  return m_Owner[i - m_Base].m_Node;
+}
+
+int CodeSection::GetAction( int i ) const
+{
+  return m_Owner[i - m_Base].m_Action;
+}
+
+Node* CodeSection::CurrentNode() const
+{
+  return m_Scope.m_Node;
+}
+
+int CodeSection::GetEntry( Node* n, NodeAction action ) const
+{
+  Entries::const_iterator it = m_Entries.find( n );
+  if( it == m_Entries.end() )
+    return -1;
+  return it->second.m_Entry[action];
 }
 
 void CodeSection::SetA1( int i, TIn A1 )
 {
-  m_Inst[i].m_A1 = SafeConvert( A1 );
+  m_Inst[i - m_Base].m_A1 = A1;
 }
 void CodeSection::SetA2( int i, TIn A2 )
 {
-  m_Inst[i].m_A2 = SafeConvert( A2 );
+  m_Inst[i - m_Base].m_A2 = A2;
 }
 void CodeSection::SetA3( int i, TIn A3 )
 {
-  m_Inst[i].m_A3 = SafeConvert( A3 );
+  m_Inst[i - m_Base].m_A3 = A3;
 }
 
-bool CodeSection::Save( FILE* outFile, bool swapEndian ) const
+/*
+ * Operands are kept wide while generating. They fit in an Instruction if they
+ * are below NO_OPERAND, or are WIDE_NO_OPERAND which becomes NO_OPERAND.
+ */
+static bool fits( WideVMIType v )
 {
-  if( m_Inst.empty() )
+  return v < NO_OPERAND || v == WIDE_NO_OPERAND;
+}
+
+bool CodeSection::Wide() const
+{
+  if( m_ForceWide )
     return true;
+  Instructions::const_iterator it, it_e( m_Inst.end() );
+  for( it = m_Inst.begin(); it != it_e; ++it )
+  {
+    if( !fits( it->m_A1 ) || !fits( it->m_A2 ) || !fits( it->m_A3 ) )
+      return true;
+  }
+  return false;
+}
 
-  Instructions t( m_Inst );
+unsigned int CodeSection::Flags() const
+{
+  if( m_Compact )
+    return E_PROGRAM_COMPACT;
+  return Wide() ? E_PROGRAM_WIDE : 0;
+}
+
+unsigned int CodeSection::CompactBytes() const
+{
+  unsigned char b[COMPACT_MAX_SIZE];
+  unsigned int bytes = 0;
+  Instructions::const_iterator it, it_e( m_Inst.end() );
+  for( it = m_Inst.begin(); it != it_e; ++it )
+    bytes += compact_encode( *it, b );
+  return bytes;
+}
+
+/*
+ * The offset of every COMPACT_STRIDE'th instruction, then the encoded
+ * instructions padded to four bytes, see compact.h.
+ */
+static bool save_compact( FILE* outFile, bool swapEndian,
+  const std::vector<WideInstruction>& in )
+{
+  size_t s = in.size();
+  std::vector<unsigned int> offsets( compact_table_count( (unsigned int)s ) );
+  std::vector<unsigned char> code( s * COMPACT_MAX_SIZE + 3 );
+  unsigned int bytes = 0;
+
+  for( size_t i = 0; i < s; ++i )
+  {
+    if( i % COMPACT_STRIDE == 0 )
+      offsets[i / COMPACT_STRIDE] = bytes;
+    bytes += compact_encode( in[i], &code[bytes] );
+  }
+  while( bytes & 3 )
+    code[bytes++] = 0;
+
+  if( swapEndian )
+  {
+    for( size_t i = 0; i < offsets.size(); ++i )
+      EndianSwap( offsets[i] );
+  }
+  size_t write = sizeof(unsigned int) * offsets.size();
+  if( fwrite( &(offsets[0]), 1, write, outFile ) != write )
+    return false;
+  return fwrite( &(code[0]), 1, bytes, outFile ) == bytes;
+}
+
+template<typename INST>
+static bool save_instructions( FILE* outFile, bool swapEndian,
+  const std::vector<WideInstruction>& in )
+{
+  std::vector<INST> t( in.size() );
   size_t s = t.size();
 
+  for( size_t i = 0; i < s; ++i )
+  {
+    t[i].m_I  = in[i].m_I;
+    t[i].m_A1 = in[i].m_A1;
+    t[i].m_A2 = in[i].m_A2;
+    t[i].m_A3 = in[i].m_A3;
+  }
+
   if( swapEndian )
   {
     for( size_t i = 0; i < s; ++i )
@@ -158,11 +323,22 @@ bool CodeSection::Save( FILE* outFile, bool swapEndian ) const
       EndianSwap( t[i].m_A3 );
     }
   }
-  size_t write = sizeof(Instruction) * s;
+  size_t write = sizeof(INST) * s;
   size_t written = fwrite( &(t[0]), 1, write, outFile );
   return written == write;
 }
 
+bool CodeSection::Save( FILE* outFile, bool swapEndian ) const
+{
+  if( m_Inst.empty() )
+    return true;
+  if( m_Compact )
+    return save_compact( outFile, swapEndian, m_Inst );
+  if( Wide() )
+    return save_instructions<WideInstruction>( outFile, swapEndian, m_Inst );
+  return save_instructions<Instruction>( outFile, swapEndian, m_Inst );
+}
+
 int StringFromAction( Program* p, NodeAction action )
 {
   return p->m_D.PushString( g_CBActionNames[action] );
@@ -252,43 +428,7 @@ void CodeSection::PushDebugScope( Program* p, Node* n, NodeAction action, int de
 
   flags |= E_ENTER_SCOPE;
 
-  unsigned int t;
-  Instruction i;
-  t = StringFromAction( p, action );
-  i.m_I = INST_LOAD_REGISTRY;
-  i.m_A1 = 0;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = StringFromNode( p, n );
-  i.m_I = INST_LOAD_REGISTRY;
-  i.m_A1 = 1;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = n->m_NodeId;
-  i.m_I = INST__SET_REGISTRY;
-  i.m_A1 = 2;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = flags;
-  i.m_I = INST__SET_REGISTRY;
-  i.m_A1 = 3;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = n->m_Locator.m_LineNo;
-  i.m_I = INST__SET_REGISTRY;
-  i.m_A1 = 4;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  i.m_I = INST_CALL_DEBUG_FN;
-  i.m_A1 = 0;
-  i.m_A2 = 0;
-  i.m_A3 = 0;
-  m_Inst.push_back( i );
+  AddDebugScope( p, n, action, flags );
 }
 
 void CodeSection::PopDebugScope( Program* p, Node* n, NodeAction action, int debug_level )
@@ -307,48 +447,74 @@ void CodeSection::PopDebugScope( Program* p, Node* n, NodeAction action, int deb
 
   flags |= E_EXIT_SCOPE;
 
-  unsigned int t;
-  Instruction i;
-  t = StringFromAction( p, action );
-  i.m_I = INST_LOAD_REGISTRY;
-  i.m_A1 = 0;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = StringFromNode( p, n );
-  i.m_I = INST_LOAD_REGISTRY;
-  i.m_A1 = 1;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = n->m_NodeId;
-  i.m_I = INST__SET_REGISTRY;
-  i.m_A1 = 2;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = flags;
-  i.m_I = INST__SET_REGISTRY;
-  i.m_A1 = 3;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  t = n->m_Locator.m_LineNo;
-  i.m_I = INST__SET_REGISTRY;
-  i.m_A1 = 4;
-  i.m_A2 = (unsigned short)((t & 0xffff0000) >> 16);
-  i.m_A3 = (unsigned short)((t & 0x0000ffff));
-  m_Inst.push_back( i );
-  i.m_I = INST_CALL_DEBUG_FN;
-  i.m_A1 = 0;
-  i.m_A2 = 0;
-  i.m_A3 = 0;
-  m_Inst.push_back( i );
+  AddDebugScope( p, n, action, flags );
 }
 
-VMIType CodeSection::SafeConvert( TIn i ) const
+void CodeSection::AddDebugScope( Program* p, Node* n, NodeAction action, unsigned int flags )
 {
-  return static_cast<VMIType> ( i );
+  //At the instruction pushed next, the scopes stay sorted on it
+  DebugScope s;
+  s.m_IP = Count();
+  if( flags & E_ENTER_SCOPE )
+  {
+    s.m_Begin = s.m_IP;
+    s.m_End   = s.m_IP;
+    m_OpenScopes.push_back( (int)m_Scopes.size() );
+  }
+  else
+  {
+    //Scopes are left in the reverse order they are entered
+    DebugScope& enter = m_Scopes[m_OpenScopes.back()];
+    m_OpenScopes.pop_back();
+    enter.m_End = s.m_IP;
+    s.m_Begin   = enter.m_Begin;
+    s.m_End     = s.m_IP;
+  }
+  s.m_NodeId = n->m_NodeId;
+  s.m_Flags  = flags;
+  s.m_LineNo = n->m_Locator.m_LineNo;
+  s.m_Action = StringFromAction( p, action );
+  s.m_Name   = StringFromNode( p, n );
+  m_Scopes.push_back( s );
+}
+
+int CodeSection::DebugScopeCount() const
+{
+  return (int)m_Scopes.size();
+}
+
+const DebugScope& CodeSection::GetDebugScope( int i ) const
+{
+  return m_Scopes[i];
+}
+
+void CodeSection::AppendDebugScope( const DebugScope& s )
+{
+  m_Scopes.push_back( s );
+}
+
+int CodeSection::PushDebugScopes( DataSection* d ) const
+{
+  //The bitmap is as big with any base, so the table can be found in a unit
+  const int words = sizeof(DebugScope) / sizeof(int);
+  std::vector<int> t( m_Scopes.size() * words + (m_Inst.size() + 31) / 32, 0 );
+  for( size_t i = 0; i < m_Scopes.size(); ++i )
+  {
+    memcpy( &t[i * words], &m_Scopes[i], sizeof(DebugScope) );
+    const unsigned int ip = m_Scopes[i].m_IP - m_Base;
+    t[m_Scopes.size() * words + ip / 32] |= (int)(1u << (ip % 32));
+  }
+  return d->PushIntegers( &t[0], (int)t.size() );
+}
+
+DataSection::DataSection() :
+  m_Base( 0 )
+{
+}
+
+void DataSection::SetBase( int base )
+{
+  m_Base = base;
 }
 
 void DataSection::Print( FILE* outFile )
@@ -356,39 +522,50 @@ void DataSection::Print( FILE* outFile )
   const char* type_strings[] =
     { "INTEGER", "FLOAT", "STRING" };
 
+  int elements = 0;
   MetaDataList::iterator it, it_e( m_Meta.end() );
   for( it = m_Meta.begin(); it != it_e; ++it )
   {
-    fprintf( outFile, "\n0x%04x\t%s\t", (*it).m_Index,
-      type_strings[(*it).m_Type] );
-    switch( (*it).m_Type )
+    elements += (*it).m_Count;
+    for( int v = 0; v < (*it).m_Count; ++v )
     {
-    case E_DT_INTEGER:
-      fprintf( outFile, "%d", *(int*)(&m_Data[(*it).m_Index]) );
-      break;
-    case E_DT_FLOAT:
-      fprintf( outFile, "%f", *(float*)(&m_Data[(*it).m_Index]) );
-      break;
-    case E_DT_STRING:
-      fprintf( outFile, "%s", &m_Data[(*it).m_Index] );
-      break;
+      int index = (*it).m_Index + sizeof(int) * v;
+      fprintf( outFile, "\n0x%04x\t%s\t", index, type_strings[(*it).m_Type] );
+      switch( (*it).m_Type )
+      {
+      case E_DT_INTEGER:
+        fprintf( outFile, "%d", *(int*)(&m_Data[index]) );
+        break;
+      case E_DT_FLOAT:
+        fprintf( outFile, "%f", *(float*)(&m_Data[index]) );
+        break;
+      case E_DT_STRING:
+        fprintf( outFile, "%s", &m_Data[index] );
+        break;
+      }
     }
   }
 
-  fprintf( outFile, "\n\nData Elements:\t%d\nData Size:\t%d\n", m_Meta.size(),
+  fprintf( outFile, "\n\nData Elements:\t%d\nData Size:\t%d\n", elements,
     m_Data.size() );
 
 }
 
 int DataSection::PushInteger( int value )
 {
-  int r = PushData( (char*)&value, sizeof(int) );
+  return PushIntegers( &value, 1 );
+}
+
+int DataSection::PushIntegers( const int* values, int count )
+{
+  int r = PushData( (const char*)values, sizeof(int) * count );
   MetaData md;
   md.m_Type = E_DT_INTEGER;
   md.m_Index = r;
+  md.m_Count = count;
   m_Meta.push_back( md );
 
-  return r;
+  return m_Base + r;
 }
 
 int DataSection::PushFloat( float value )
@@ -397,9 +574,10 @@ int DataSection::PushFloat( float value )
   MetaData md;
   md.m_Type = E_DT_FLOAT;
   md.m_Index = r;
+  md.m_Count = 1;
   m_Meta.push_back( md );
 
-  return r;
+  return m_Base + r;
 }
 
 int DataSection::PushString( const char* str )
@@ -415,15 +593,16 @@ int DataSection::PushString( const char* str )
     MetaData md;
     md.m_Type = E_DT_STRING;
     md.m_Index = r;
+    md.m_Count = 1;
     m_Meta.push_back( md );
     StringLookup sl;
     sl.m_Index = r;
     sl.m_Hash = hash;
     m_String.insert( it, sl );
-    return r;
+    return m_Base + r;
   }
 
-  return (*it).m_Index;
+  return m_Base + (*it).m_Index;
 }
 
 int DataSection::Size() const
@@ -436,20 +615,46 @@ bool DataSection::Save( FILE* outFile, bool swapEndian ) const
   if( m_Data.empty() )
     return true;
 
-  DataList t( m_Data );
+  DataList t;
+  Copy( &t, swapEndian );
+
+  size_t write = sizeof(char) * t.size();
+  size_t written = fwrite( &(t[0]), 1, write, outFile );
+  return written == write;
+}
+
+void DataSection::Copy( std::vector<char>* out, bool swapEndian ) const
+{
+  DataList& t = *out;
+  t = m_Data;
   if( swapEndian )
   {
     MetaDataList::const_iterator it, it_e( m_Meta.end() );
     for( it = m_Meta.begin(); it != it_e; ++it )
     {
-      if( (*it).m_Type == E_DT_INTEGER || (*it).m_Type == E_DT_FLOAT )
-        EndianSwap( *(int*)&(t[(*it).m_Index]) );
+      if( (*it).m_Type == E_DT_STRING )
+        continue;
+      for( int v = 0; v < (*it).m_Count; ++v )
+        EndianSwap( *(int*)&(t[(*it).m_Index + sizeof(int) * v]) );
     }
   }
+}
 
-  size_t write = sizeof(char) * t.size();
-  size_t written = fwrite( &(t[0]), 1, write, outFile );
-  return written == write;
+int DataSection::BlockCount() const
+{
+  return (int)m_Meta.size();
+}
+
+void DataSection::GetBlock( int i, int* type, int* offset, int* count ) const
+{
+  *type   = m_Meta[i].m_Type;
+  *offset = m_Meta[i].m_Index;
+  *count  = m_Meta[i].m_Count;
+}
+
+const char* DataSection::Data() const
+{
+  return m_Data.empty() ? 0x0 : &m_Data[0];
 }
 
 int DataSection::PushData( const char* data, int count )
@@ -469,7 +674,17 @@ int DataSection::PushData( const char* data, int count )
 int print_program( FILE* outFile, Program* p )
 {
   p->m_I.Print( outFile, p );
-  fprintf( outFile, "\nMemory: %u bytes.\n", p->m_Memory );
+  fprintf( outFile, "\nMemory: %u bytes, %u without shared scratch.\n",
+    p->m_Memory, p->m_Memory + scratch_saving_btree( p->m_First->m_Tree ) );
+  if( p->m_FrameCount )
+    fprintf( outFile, "Pooled frames: %u of %u bytes.\n", p->m_FrameCount,
+      p->m_FrameSize );
+  if( !p->m_CounterIds.empty() )
+    fprintf( outFile, "Node counters: %u of %u bytes at %u.\n",
+      (unsigned int)p->m_CounterIds.size(), counter_size( p ), p->m_CounterBlock );
+  if( p->m_I.DebugScopeCount() != 0 )
+    fprintf( outFile, "Debug scopes: %d at %d.\n", p->m_I.DebugScopeCount(),
+      p->m_DebugTable );
   p->m_D.Print( outFile );
   return 0;
 }
@@ -477,15 +692,47 @@ int print_program( FILE* outFile, Program* p )
 int save_program( FILE* outFile, bool swapEndian, Program* p )
 {
   ProgramHeader h;
+  h.m_Magic   = PROGRAM_MAGIC;
+  h.m_Version = PROGRAM_VERSION;
   h.m_IC = p->m_I.Count();
   h.m_DS = p->m_D.Size();
   h.m_BS = p->m_Memory;
+  h.m_CC = p->m_Callbacks.size();
+  h.m_CT = p->m_CallbackTable;
+  h.m_FS = p->m_FrameSize;
+  h.m_FC = p->m_FrameCount;
+  h.m_PF = p->m_I.Flags();
+  h.m_CB = (h.m_PF & E_PROGRAM_COMPACT) ? p->m_I.CompactBytes() : 0;
+  h.m_EC = p->m_EntryCount;
+  h.m_ET = p->m_EntryTable;
+  h.m_NC = p->m_CounterIds.size();
+  h.m_NB = h.m_NC ? p->m_CounterBlock : 0;
+  h.m_NS = h.m_NC ? counter_size( p ) : 0;
+  h.m_NT = h.m_NC ? p->m_CounterTable : 0;
+  h.m_DC = p->m_I.DebugScopeCount();
+  h.m_DT = h.m_DC ? p->m_DebugTable : 0;
 
   if( swapEndian )
   {
+    EndianSwap( h.m_Magic );
+    EndianSwap( h.m_Version );
     EndianSwap( h.m_IC );
     EndianSwap( h.m_DS );
     EndianSwap( h.m_BS );
+    EndianSwap( h.m_CC );
+    EndianSwap( h.m_CT );
+    EndianSwap( h.m_FS );
+    EndianSwap( h.m_FC );
+    EndianSwap( h.m_PF );
+    EndianSwap( h.m_CB );
+    EndianSwap( h.m_EC );
+    EndianSwap( h.m_ET );
+    EndianSwap( h.m_NC );
+    EndianSwap( h.m_NB );
+    EndianSwap( h.m_NS );
+    EndianSwap( h.m_NT );
+    EndianSwap( h.m_DC );
+    EndianSwap( h.m_DT );
   }
   size_t write = sizeof(ProgramHeader);
   size_t written = fwrite( &h, 1, write, outFile );
@@ -522,12 +769,35 @@ int setup( BehaviorTreeContext ctx, Program* p )
 
   p->m_I.Setup( p );
 
+  p->m_CallbackTable = 0;
+  setup_callbacks( ctx, &p->m_Callbacks );
+  p->m_EntryCount = 0;
+  p->m_EntryTable = 0;
+  p->m_DebugTable = 0;
+
+  p->m_NodeCounters = 0;
+  p->m_CounterTable = 0;
+  p->m_Counters.clear();
+  p->m_CounterIds.clear();
+  Parameter* counters = find_by_hash( get_options( ctx ), hashlittle( "node_counters" ) );
+  if( counters )
+    p->m_NodeCounters = as_integer( *counters );
+  Parameter* trace = find_by_hash( get_options( ctx ), hashlittle( "node_trace" ) );
+  p->m_NodeTrace = trace ? as_integer( *trace ) : 0;
+
   p->m_Memory = 0;
   p->m_Memory += sizeof(BssHeader);
   p->m_Memory += sizeof(int); // <- used for tree "state"
   p->m_Memory += sizeof(CallFrame);
   p->m_Memory += memory_need_btree( btl->m_Tree );
 
+  //The counters are put after everything else once it is known which nodes have code
+  p->m_CounterBlock = p->m_Memory - sizeof(BssHeader);
+
+  int frame_size = 0;
+  p->m_FrameCount = pooled_frames_btree( btl->m_Tree, &frame_size );
+  p->m_FrameSize  = p->m_FrameCount ? (frame_size + 7) & ~7 : 0;
+
   while( btl )
   {
     int mem_alloc = gen_setup_btree( btl->m_Tree, p, 0 );
@@ -626,6 +896,97 @@ int generate( Program* p )
     btl = btl->m_Next;
   }
 
+  //Store the callback ids in the data section, in callback index order
+  if( !p->m_Callbacks.empty() )
+    p->m_CallbackTable = p->m_D.PushIntegers( &(p->m_Callbacks[0]),
+      (int)p->m_Callbacks.size() );
+
+  //The debug scopes, with a bit for each instruction that has any
+  if( p->m_I.DebugScopeCount() != 0 )
+    p->m_DebugTable = p->m_I.PushDebugScopes( &p->m_D );
+
+  //And the node ids of the counters, in counter order
+  if( !p->m_CounterIds.empty() )
+  {
+    p->m_CounterTable = p->m_D.PushIntegers( &(p->m_CounterIds[0]),
+      (int)p->m_CounterIds.size() );
+    p->m_Memory += p->m_CounterIds.size() * counter_size( p );
+  }
+
   return 0;
 }
 
+unsigned int counter_size( Program* p )
+{
+  return p->m_NodeCounters > 1 ? NODE_CYCLE_SIZE : NODE_COUNTER_SIZE;
+}
+
+int node_counter( Node* n, Program* p )
+{
+  if( p->m_NodeCounters <= 0 )
+    return -1;
+  CounterOffsets::iterator it = p->m_Counters.find( n );
+  if( it != p->m_Counters.end() )
+    return it->second;
+  int offset = p->m_CounterBlock + p->m_CounterIds.size() * counter_size( p );
+  p->m_Counters[n] = offset;
+  p->m_CounterIds.push_back( n->m_NodeId );
+  return offset;
+}
+
+void gen_trace( Node* n, Program* p, unsigned int kind )
+{
+  if( p->m_NodeTrace <= 0 || !n )
+    return;
+  const unsigned int id = n->m_NodeId;
+  p->m_I.Push( INST_TRACE_NODE, kind, (id & 0xffff0000) >> 16, id & 0x0000ffff );
+}
+
+int callback_id( NamedSymbol* ns )
+{
+  Parameter* opts = 0x0;
+  int hash = 0;
+  switch( ns->m_Type )
+  {
+  case E_ST_ACTION:
+    opts = ns->m_Symbol.m_Action->m_Options;
+    hash = ns->m_Symbol.m_Action->m_Id.m_Hash;
+    break;
+  case E_ST_DECORATOR:
+    opts = ns->m_Symbol.m_Decorator->m_Options;
+    hash = ns->m_Symbol.m_Decorator->m_Id.m_Hash;
+    break;
+  default:
+    break;
+  }
+  Parameter* t = find_by_hash( opts, hashlittle( "id" ) );
+  if( t && safe_to_convert( t, E_VART_INTEGER ) )
+    return as_integer( *t );
+  return hash;
+}
+
+void setup_callbacks( BehaviorTreeContext ctx, CallbackIdList* ids )
+{
+  ids->clear();
+  int count;
+  NamedSymbol* ns = access_symbols( ctx, &count );
+  for( int i = 0; i < count; ++i )
+  {
+    if( ns[i].m_Type != E_ST_ACTION && ns[i].m_Type != E_ST_DECORATOR )
+      continue;
+    //Symbols that share an id share a callback index
+    int id = callback_id( &ns[i] );
+    if( std::find( ids->begin(), ids->end(), id ) == ids->end() )
+      ids->push_back( id );
+  }
+}
+
+int callback_index( const CallbackIdList& ids, NamedSymbol* ns )
+{
+  CallbackIdList::const_iterator it = std::find( ids.begin(), ids.end(),
+    callback_id( ns ) );
+  if( it == ids.end() )
+    return -1;
+  return (int)(it - ids.begin());
+}
+
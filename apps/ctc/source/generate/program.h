@@ -17,10 +17,19 @@
 #include <btree/btree_data.h>
 
 #include <vector>
+#include <map>
 
 #include <stdio.h>
 
 struct Program;
+class DataSection;
+
+// The node and action the code being pushed belongs to, action -1 for none.
+struct CodeScope
+{
+    Node* m_Node;
+    int   m_Action;
+};
 
 class CodeSection
 {
@@ -31,61 +40,125 @@ public:
     typedef unsigned int TIn;
 
     void    SetGenerateDebugInfo( int debug_level );
+    void    SetForceWide( bool force );
+    void    SetCompact( bool compact );
+    // Instruction "base" is the first one pushed, for finding relocations.
+    void    SetBase( int base );
 
     void    Setup( Program* p );
 
     void    Print( FILE* outFile, Program* p ) const;
 
     int     Count() const;
+    const callback::WideInstruction& Get( int i ) const;
     void    Push( TIn inst, TIn A1, TIn A2, TIn A3 );
 
     void    SetA1( int i, TIn A1 );
     void    SetA2( int i, TIn A2 );
     void    SetA3( int i, TIn A3 );
 
+    // True if the program must be saved as WideInstructions.
+    bool    Wide() const;
+    // The ProgramFlags for the format the program is saved in.
+    unsigned int Flags() const;
+    // Bytes of compact encoded code, without the offset table.
+    unsigned int CompactBytes() const;
     bool    Save( FILE* outFile, bool swapEndian ) const;
 
+    // Scopes are not code, they are kept in the debug scope table of the
+    // program; see callback::DebugScope.
     void    PushDebugScope( Program* p, Node* n, callback::NodeAction action, int dbg_lvl );
     void    PopDebugScope( Program* p, Node* n, callback::NodeAction action, int dbg_lvl );
+    int     DebugScopeCount() const;
+    const callback::DebugScope& GetDebugScope( int i ) const;
+    // Appends a scope that is already laid out, as the linker does. Scopes
+    // must be appended in m_IP order.
+    void    AppendDebugScope( const callback::DebugScope& s );
+    // Pushes the debug scope table and its bitmap, returns the data offset.
+    int     PushDebugScopes( DataSection* d ) const;
+
+    // Instructions pushed from here on are the "action" code of "n", until
+    // LeaveNode is given the scope that is returned.
+    CodeScope EnterNode( Node* n, callback::NodeAction action );
+    void    LeaveNode( const CodeScope& outer );
+    // The node instruction "i" belongs to, or null.
+    Node*   GetNode( int i ) const;
+    // The action of the node's code instruction "i" is part of, or -1.
+    int     GetAction( int i ) const;
+    // The node whose code is being pushed, or null.
+    Node*   CurrentNode() const;
+    // The first instruction of the "action" code of "n", or -1.
+    int     GetEntry( Node* n, callback::NodeAction action ) const;
 
 private:
 
-    callback::VMIType SafeConvert( TIn i ) const;
+    void    AddDebugScope( Program* p, Node* n, callback::NodeAction action,
+              unsigned int flags );
+
+    struct NodeEntry
+    {
+        int m_Entry[3]; // Construct, execute and destruct
+    };
 
-    typedef std::vector<callback::Instruction> Instructions;
+    typedef std::vector<callback::WideInstruction> Instructions;
+    typedef std::vector<CodeScope>                 Owners;
+    typedef std::map<Node*, NodeEntry>             Entries;
+    typedef std::vector<callback::DebugScope>      DebugScopes;
+    typedef std::vector<int>                       ScopeStack;
     Instructions m_Inst;
+    Owners       m_Owner;
+    Entries      m_Entries;
+    DebugScopes  m_Scopes;
+    ScopeStack   m_OpenScopes; // Entered and not yet left
+    CodeScope    m_Scope;
     int          m_DebugLevel;
+    int          m_Base;
+    bool         m_ForceWide;
+    bool         m_Compact;
 };
 
 class DataSection
 {
 public:
 
+    DataSection();
+
+    enum DataType
+    {
+        E_DT_INTEGER,
+        E_DT_FLOAT,
+        E_DT_STRING
+    };
+
+    // Offsets returned by the pushes start at "base", for finding relocations.
+    void SetBase( int base );
+
     void Print( FILE* outFile );
 
     int PushInteger( int value );
+    int PushIntegers( const int* values, int count );
     int PushFloat( float value );
     int PushString( const char* str );
 
     int Size() const;
 
     bool Save( FILE* outFile, bool swapEndian ) const;
+    void Copy( std::vector<char>* out, bool swapEndian ) const;
+
+    // The pushes in the order they were made, offsets do not include the base.
+    int  BlockCount() const;
+    void GetBlock( int i, int* type, int* offset, int* count ) const;
+    const char* Data() const;
 
 private:
 
     int PushData( const char* data, int count );
 
-    enum DataType
-    {
-        E_DT_INTEGER,
-        E_DT_FLOAT,
-        E_DT_STRING
-    };
-
     struct MetaData
     {
         int m_Type;
         int m_Index;
+        int m_Count; // Values pushed at once, one for a string
     };
 
     struct StringLookup
@@ -119,6 +192,7 @@ private:
     DataList     m_Data;
     MetaDataList m_Meta;
     StringTable  m_String;
+    int          m_Base;
 };
 
 struct BehaviorTreeList
@@ -128,13 +202,29 @@ struct BehaviorTreeList
   int               m_FirstInst;
 };
 
+typedef std::vector<int> CallbackIdList;
+typedef std::map<Node*, int> CounterOffsets;
+
 struct Program
 {
 	CodeSection  m_I;
 	DataSection  m_D;
 	unsigned int m_Memory;
+	unsigned int m_FrameSize;  // Of pooled frames, zero if there are none
+	unsigned int m_FrameCount; // Pooled frames an agent can hold at once
 	BehaviorTreeContext m_Context;
 	BehaviorTreeList* m_First;
+	CallbackIdList m_Callbacks;
+	int m_CallbackTable;
+	int m_DebugTable;            // Of the debug scopes, if there are any
+	unsigned int m_EntryCount; // Entry points of a linked program, see link.cpp
+	int m_EntryTable;
+	int m_NodeCounters;          // The node_counters option, see callback/counters.h
+	unsigned int m_CounterBlock; // Bss offset of the node counters, from the BssHeader
+	CounterOffsets m_Counters;   // Of each counted node, from the BssHeader
+	std::vector<int> m_CounterIds;
+	int m_CounterTable;
+	int m_NodeTrace;             // The node_trace option, see callback/trace.h
 };
 
 int setup( BehaviorTreeContext ctx, Program* p );
@@ -143,6 +233,39 @@ int generate( Program* p );
 
 int print_program( FILE* outfile, Program* p );
 
+// The id an action or decorator is called with: the "id" option, or the name hash.
+int callback_id( NamedSymbol* ns );
+// Numbers the callback ids of all actions and decorators densely from zero.
+void setup_callbacks( BehaviorTreeContext ctx, CallbackIdList* ids );
+// The dense index of an action or decorator, or -1 if it is not in the list.
+int callback_index( const CallbackIdList& ids, NamedSymbol* ns );
+// The bss offset of the counters of "n", from the BssHeader, or -1 if nodes
+// are not counted.
+int node_counter( Node* n, Program* p );
+// Bytes of counters per counted node.
+unsigned int counter_size( Program* p );
+// Pushes a trace event of "kind" for "n", if nodes are traced.
+void gen_trace( Node* n, Program* p, unsigned int kind );
+
 int save_program( FILE* outfile, bool swapEndian, Program* p );
 
+// Writes the node map of the program, see callback/nodemap.h.
+int save_node_map( FILE* outfile, bool swapEndian, Program* p );
+
+// Adds the program to the archive file, or replaces the one called "name"; see
+// callback/archive.h.
+int save_archive( const char* archive, const char* name, bool swapEndian, Program* p );
+
+// Writes the program as a link unit, see link.h. The program is generated a
+// second time in "shifted", which has the same options, to find relocations.
+int save_unit( const char* unit, BehaviorTreeContext ctx, Program* p, Program* shifted );
+
+// Links the units into "p", with an entry point per unit, and writes a listing
+// of the result to "listing" if it is set; see link.cpp.
+int link_units( int count, char** units, const char* listing, Program* p );
+
+// Writes the program as C++ source, see native.cpp.
+int save_native( FILE* outfile, bool swapEndian, const char* file_name,
+  const char* function, Program* p );
+
 #endif /*PROGRAM_H_INCLUDED*/
@@ -25,6 +25,11 @@ bool g_swapEndian = false;
 bool g_printIncludes = false;
 char* g_asmFileName = 0x0;
 char* g_outputHeaderName = 0x0;
+char* g_nativeFileName = 0x0;
+char* g_archiveFileName = 0x0;
+char* g_unitFileName = 0x0;
+char* g_mapFileName = 0x0;
+bool g_link = false;
 
 char* g_asmFileNameMemory = 0x0;
 
@@ -38,6 +43,7 @@ struct ParsingInfo
 };
 
 int print_header( FILE* outfile, const char* file_name, BehaviorTreeContext ctx );
+int print_native( const char* file_name, BehaviorTreeContext ctx, Program* p );
 
 int read_file( ParserContext pc, char* buffer, int maxsize );
 void parser_error( ParserContext pc, const char* msg );
@@ -54,6 +60,17 @@ void print_usage()
   fprintf( stdout, "\t-o\tOutput file. (optional)\n" );
   fprintf( stdout,
     "\t-a\tOutput text file of generated callback instructions. (optional)\n" );
+  fprintf( stdout,
+    "\t-c\tOutput C++ source file with the program compiled to native code. (optional)\n" );
+  fprintf(
+    stdout,
+    "\t-r\tArchive file to add the program to, named after the input file. (optional)\n" );
+  fprintf( stdout, "\t-u\tLink unit file to write, for linking with -k. (optional)\n" );
+  fprintf( stdout, "\t-m\tNode map file to write, for reloading the program. (optional)\n" );
+  fprintf(
+    stdout,
+    "\t-k\tLink the unit files given after the options into one program with an entry point\n"
+    "\t\tper unit, instead of compiling. Takes -o, -a and -e.\n" );
   fprintf(
     stdout,
     "\t-e\tSpecify endian, \"little\" or \"big\" as argument. (optional, default is \"little\").\n" );
@@ -63,13 +80,58 @@ void print_usage()
   fprintf( stdout, "\t-?\tPrint this message and exit.\n\n" );
 }
 
+void set_code_options( BehaviorTreeContext btc, CodeSection* cs )
+{
+  unsigned int debug_hash = hashlittle( "debug_info" );
+  Parameter* debug_param = find_by_hash( get_options( btc ), debug_hash );
+  if( debug_param )
+    cs->SetGenerateDebugInfo( as_integer( *debug_param ) );
+
+  unsigned int wide_hash = hashlittle( "wide_instructions" );
+  Parameter* wide_param = find_by_hash( get_options( btc ), wide_hash );
+  if( wide_param )
+    cs->SetForceWide( as_bool( *wide_param ) );
+
+  unsigned int compact_hash = hashlittle( "compact_instructions" );
+  Parameter* compact_param = find_by_hash( get_options( btc ), compact_hash );
+  if( compact_param )
+    cs->SetCompact( as_bool( *compact_param ) );
+}
+
+int link_program( int count, char** units )
+{
+  if( count == 0 || !g_outputFileName )
+  {
+    fprintf( stderr, "error: -k needs an output file and the link units to link.\n" );
+    return -1;
+  }
+
+  Program p;
+  if( link_units( count, units, g_asmFileName, &p ) != 0 )
+    return -1;
+
+  g_outputFile = fopen( g_outputFileName, "wb" );
+  if( !g_outputFile )
+  {
+    fprintf( stderr, "error: Unable to open output file %s for writing.\n",
+      g_outputFileName );
+    return -2;
+  }
+  if( save_program( g_outputFile, g_swapEndian, &p ) != 0 )
+  {
+    fprintf( stderr, "error: Failed to write output file %s.\n", g_outputFileName );
+    return -5;
+  }
+  return 0;
+}
+
 int main( int argc, char** argv )
 {
   GetOptContext ctx;
   init_getopt_context( &ctx );
   char c;
 
-  while( (c = getopt( argc, argv, "?i:o:a:de:x:lrh:v", &ctx )) != -1 )
+  while( (c = getopt( argc, argv, "?i:o:a:c:de:x:lr:u:km:h:v", &ctx )) != -1 )
   {
     switch( c )
     {
@@ -94,6 +156,21 @@ int main( int argc, char** argv )
     case 'a':
       g_asmFileName = ctx.optarg;
       break;
+    case 'c':
+      g_nativeFileName = ctx.optarg;
+      break;
+    case 'r':
+      g_archiveFileName = ctx.optarg;
+      break;
+    case 'u':
+      g_unitFileName = ctx.optarg;
+      break;
+    case 'k':
+      g_link = true;
+      break;
+    case 'm':
+      g_mapFileName = ctx.optarg;
+      break;
     case 'l':
       g_printIncludes = true;
       break;
@@ -114,6 +191,14 @@ int main( int argc, char** argv )
     }
   }
 
+  if( g_link )
+  {
+    int r = link_program( argc - ctx.optind, argv + ctx.optind );
+    if( g_outputFile )
+      fclose( g_outputFile );
+    return r;
+  }
+
   if(ctx.optind != argc)
   {
     fprintf( stdout, "%s: unexpected argument '%s'\n", argv[0], argv[ctx.optind] );
@@ -226,14 +311,11 @@ int main( int argc, char** argv )
       }
     }
 
-    if( g_outputFileName && returnCode == 0 )
+    if( (g_outputFileName || g_nativeFileName || g_archiveFileName || g_unitFileName
+      || g_mapFileName) && returnCode == 0 )
     {
       Program p;
-
-      unsigned int debug_hash = hashlittle( "debug_info" );
-      Parameter* debug_param = find_by_hash( get_options( btc ), debug_hash );
-      if( debug_param )
-        p.m_I.SetGenerateDebugInfo( as_integer( *debug_param ) );
+      set_code_options( btc, &p.m_I );
 
       returnCode = setup( btc, &p );
       if( returnCode == 0 )
@@ -249,7 +331,10 @@ int main( int argc, char** argv )
 
       teardown( &p );
 
-      if( returnCode == 0 )
+      if( returnCode == 0 && g_nativeFileName )
+        returnCode = print_native( g_inputFileName, btc, &p );
+
+      if( returnCode == 0 && g_outputFileName )
       {
         g_outputFile = fopen( g_outputFileName, "wb" );
         if( !g_outputFile )
@@ -269,7 +354,39 @@ int main( int argc, char** argv )
         }
       }
 
-      if( !g_asmFileName )
+      if( returnCode == 0 && g_archiveFileName )
+      {
+        //The program is named after the input file, without path or extension
+        const char* name = strrchr( g_inputFileName, '/' );
+        name = name ? name + 1 : g_inputFileName;
+        char* archive_name = (char*)malloc( strlen( name ) + 1 );
+        strcpy( archive_name, name );
+        char* dot = strrchr( archive_name, '.' );
+        if( dot )
+          *dot = 0;
+        if( save_archive( g_archiveFileName, archive_name, g_swapEndian, &p ) != 0 )
+        {
+          fprintf( stderr, "%s(0): error: Failed to write archive file %s.\n",
+            g_inputFileName, g_archiveFileName );
+          returnCode = -6;
+        }
+        free( archive_name );
+      }
+
+      if( returnCode == 0 && g_mapFileName )
+      {
+        FILE* mapFile = fopen( g_mapFileName, "wb" );
+        if( !mapFile || save_node_map( mapFile, g_swapEndian, &p ) != 0 )
+        {
+          fprintf( stderr, "%s(0): error: Failed to write node map %s.\n",
+            g_inputFileName, g_mapFileName );
+          returnCode = -8;
+        }
+        if( mapFile )
+          fclose( mapFile );
+      }
+
+      if( !g_asmFileName && g_outputFileName )
       {
         unsigned int hash = hashlittle( "force_asm" );
         Parameter* force_asm = find_by_hash( get_options( btc ), hash );
@@ -302,6 +419,19 @@ int main( int argc, char** argv )
           fclose( asmFile );
         }
       }
+
+      //Generates the program again, so it is the last thing done with it
+      if( returnCode == 0 && g_unitFileName )
+      {
+        Program shifted;
+        set_code_options( btc, &shifted.m_I );
+        if( save_unit( g_unitFileName, btc, &p, &shifted ) != 0 )
+        {
+          fprintf( stderr, "%s(0): error: Failed to write link unit %s.\n",
+            g_inputFileName, g_unitFileName );
+          returnCode = -7;
+        }
+      }
     }
     destroy( btc );
   }
@@ -323,18 +453,21 @@ const char* get_string_from_parameter_list( Parameter* pl, unsigned int hash )
   return as_string( *p )->m_Parsed;
 }
 
-void print_header_entry( FILE* f, const char* symbol, const char* name, unsigned int value )
+void print_header_entry( FILE* f, const char* symbol, const char* name,
+  const char* suffix, unsigned int value )
 {
-  if( symbol )
-  {
-    char tmp[1024];
-    sprintf( tmp, "%s%s", symbol, name );
-    fprintf( f, "const unsigned int %-60s = 0x%08x;\n", tmp, value );
-  }
-  else
-  {
-    fprintf( f, "const unsigned int %-60s = 0x%08x;\n", name, value );
-  }
+  char tmp[1024];
+  sprintf( tmp, "%s%s%s", symbol ? symbol : "", name, suffix );
+  fprintf( f, "const unsigned int %-60s = 0x%08x;\n", tmp, value );
+}
+
+const char* get_callback_name( NamedSymbol* ns )
+{
+  if( ns->m_Type == E_ST_ACTION )
+    return ns->m_Symbol.m_Action->m_Id.m_Text;
+  if( ns->m_Type == E_ST_DECORATOR )
+    return ns->m_Symbol.m_Decorator->m_Id.m_Text;
+  return 0x0;
 }
 
 int print_header( FILE* f, const char* file_name, BehaviorTreeContext ctx )
@@ -344,7 +477,6 @@ int print_header( FILE* f, const char* file_name, BehaviorTreeContext ctx )
   unsigned int header_hash = hashlittle( "ctc_h_header" );
   unsigned int footer_hash = hashlittle( "ctc_h_footer" );
   unsigned int symbol_hash = hashlittle( "ctc_h_symbol_prefix" );
-  unsigned int id_hash     = hashlittle( "id" );
 
   const char* header = get_string_from_parameter_list( opts, header_hash );
   const char* footer = get_string_from_parameter_list( opts, footer_hash );
@@ -355,32 +487,90 @@ int print_header( FILE* f, const char* file_name, BehaviorTreeContext ctx )
   if( header )
     fprintf( f, "%s\n\n", header );
 
+  CallbackIdList callbacks;
+  setup_callbacks( ctx, &callbacks );
+
   int count;
   NamedSymbol* ns = access_symbols( ctx, &count );
   for( int i = 0; i < count; ++i )
   {
-    if( ns[i].m_Type == E_ST_ACTION )
+    const char* name = get_callback_name( &ns[i] );
+    if( name )
+      print_header_entry( f, symbol, name, "", callback_id( &ns[i] ) );
+  }
+
+  //Dense callback indices, for binding a CallbackProgram::m_Table
+  fprintf( f, "\n" );
+  for( int i = 0; i < count; ++i )
+  {
+    const char* name = get_callback_name( &ns[i] );
+    if( name )
+      print_header_entry( f, symbol, name, "_index",
+        callback_index( callbacks, &ns[i] ) );
+  }
+  print_header_entry( f, symbol, "callback_count", "", callbacks.size() );
+
+  if( footer )
+    fprintf( f, "\n%s\n", footer );
+
+  return 0;
+}
+
+int print_native( const char* file_name, BehaviorTreeContext ctx, Program* p )
+{
+  if( p->m_FrameCount )
+  {
+    fprintf( stderr, "%s(0): error: Trees called in pooled frames can not be "
+      "written as C++.\n", file_name );
+    return -1;
+  }
+
+  //Name the functions after the option, or after the source file
+  unsigned int function_hash = hashlittle( "ctc_cpp_function" );
+  const char* option = get_string_from_parameter_list( get_options( ctx ),
+    function_hash );
+
+  char function[256];
+  if( option )
+  {
+    strncpy( function, option, sizeof(function) - 1 );
+    function[sizeof(function) - 1] = 0;
+  }
+  else
+  {
+    const char* start = g_nativeFileName;
+    for( const char* s = g_nativeFileName; *s; ++s )
     {
-      Parameter* p = find_by_hash( ns[i].m_Symbol.m_Action->m_Options, id_hash );
-      if( p && safe_to_convert( p, E_VART_INTEGER ) )
-        print_header_entry( f, symbol, ns[i].m_Symbol.m_Action->m_Id.m_Text, as_integer( *p ) );
-      else
-        print_header_entry( f, symbol, ns[i].m_Symbol.m_Action->m_Id.m_Text, ns[i].m_Symbol.m_Action->m_Id.m_Hash );
+      if( *s == '/' || *s == '\\' )
+        start = s + 1;
     }
-    else if( ns[i].m_Type == E_ST_DECORATOR )
+    unsigned int len = 0;
+    if( *start >= '0' && *start <= '9' )
+      function[len++] = '_';
+    for( ; *start && *start != '.' && len < sizeof(function) - 1; ++start )
     {
-      Parameter* p = find_by_hash( ns[i].m_Symbol.m_Decorator->m_Options, id_hash );
-      if( p && safe_to_convert( p, E_VART_INTEGER ) )
-        print_header_entry( f, symbol, ns[i].m_Symbol.m_Decorator->m_Id.m_Text, as_integer( *p ) );
-      else
-        print_header_entry( f, symbol, ns[i].m_Symbol.m_Decorator->m_Id.m_Text, ns[i].m_Symbol.m_Action->m_Id.m_Hash );
+      char c = *start;
+      bool alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+        || (c >= '0' && c <= '9');
+      function[len++] = alnum ? c : '_';
     }
+    function[len] = 0;
   }
 
-  if( footer )
-    fprintf( f, "\n%s\n", footer );
+  FILE* f = fopen( g_nativeFileName, "w" );
+  if( !f )
+  {
+    fprintf( stderr, "%s(0): error: Unable to open output file %s for writing.\n",
+      file_name, g_nativeFileName );
+    return -1;
+  }
 
-  return 0;
+  int r = save_native( f, g_swapEndian, file_name, function, p );
+  if( r != 0 )
+    fprintf( stderr, "%s(0): error: Failed to write output file %s.\n",
+      file_name, g_nativeFileName );
+  fclose( f );
+  return r;
 }
 
 int read_file( ParserContext pc, char* buffer, int maxsize )
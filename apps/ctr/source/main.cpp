@@ -13,15 +13,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <malloc.h>
+#include <math.h>
 
 #include <other/getopt.h>
+#include <callback/archive.h>
 #include <callback/callback.h>
+#include <callback/fork.h>
+#include <callback/frames.h>
 #include <callback/instructions.h>
+#include <callback/snapshot.h>
+#include <callback/trace.h>
+#include <callback/sampling.h>
+#include <scheduler/scheduler.h>
+#include <scheduler/workers.h>
 
 #include "timing.h"
 
 using namespace callback;
 
+const unsigned int EVENT_EXIT = 1;
 
 struct UserData
 {
@@ -32,6 +42,14 @@ struct UserData
     char        m_String[4096];
     bool        m_Silent;
     bool        m_Exit;
+    scheduler::Scheduler* m_Scheduler;
+    scheduler::Agent*     m_Agent;
+};
+
+struct WorkerData
+{
+    uint64      m_Calls;
+    char        m_Pad[56];
 };
 
 void cb_debug( CallbackProgram* cp, DebugInformation* di, BssHeader* bh, void* ud )
@@ -49,6 +67,8 @@ unsigned int cb_setexit(unsigned int action, void* bss, void** data, UserData& u
         return E_NODE_UNDEFINED;
 
     user_data.m_Exit = true;
+    if( user_data.m_Scheduler )
+        scheduler::wake_event( user_data.m_Scheduler, EVENT_EXIT );
     return E_NODE_SUCCESS;
 }
 
@@ -57,7 +77,13 @@ unsigned int cb_checkexit(unsigned int action, void* bss, void** data, UserData&
     if( action != ACT_EXECUTE )
         return E_NODE_UNDEFINED;
 
-    return user_data.m_Exit?E_NODE_SUCCESS:E_NODE_WORKING;
+    if( user_data.m_Exit )
+        return E_NODE_SUCCESS;
+
+    // Nothing to do until someone exits.
+    if( user_data.m_Agent )
+        scheduler::park_on_event( user_data.m_Agent, EVENT_EXIT );
+    return E_NODE_WORKING;
 }
 
 unsigned int cb_getline(unsigned int action, void* bss, void** data, UserData& ud)
@@ -172,6 +198,18 @@ unsigned int cb_time_delay( unsigned int action, void* bss, void** data, UserDat
     	*t -= ud.m_FrameTime;
         if( *t <= 0.0f )
             return E_NODE_SUCCESS;
+
+        // Sleep through the frames that can't finish the delay, the frame
+        // we wake on subtracts one more frame time.
+        if( ud.m_Agent && ud.m_FrameTime > 0.0 )
+        {
+            unsigned int frames = (unsigned int)ceil( *t / ud.m_FrameTime );
+            if( frames > 1 )
+            {
+                scheduler::park_for( ud.m_Agent, frames );
+                *t -= (frames - 1) * ud.m_FrameTime;
+            }
+        }
         return E_NODE_WORKING;
     }
 
@@ -205,12 +243,8 @@ unsigned int cb_modify_return( unsigned int action, void* bss, void** data, User
     return E_NODE_UNDEFINED;
 }
 
-unsigned int cb_handler(unsigned int id, unsigned int action, void* bss, void** data, void* user_data)
+unsigned int cb_dispatch(unsigned int id, unsigned int action, void* bss, void** data, void* user_data)
 {
-    uint64 start, end;
-
-    start = get_cpu_counter();
-
     UserData& ud = *((UserData*)user_data);
 
     unsigned int retVal = E_NODE_UNDEFINED;
@@ -262,6 +296,17 @@ unsigned int cb_handler(unsigned int id, unsigned int action, void* bss, void**
         break;
     }
 
+    return retVal;
+}
+
+unsigned int cb_handler(unsigned int id, unsigned int action, void* bss, void** data, void* user_data)
+{
+    uint64 start, end;
+
+    start = get_cpu_counter();
+
+    unsigned int retVal = cb_dispatch( id, action, bss, data, user_data );
+
     end = get_cpu_counter();
 
     ((UserData*)user_data)->m_FrameCounter += end - start;
@@ -270,31 +315,717 @@ unsigned int cb_handler(unsigned int id, unsigned int action, void* bss, void**
     return retVal;
 }
 
+/*
+ * Counts the calls made by each worker thread in its own WorkerData.
+ */
+unsigned int cb_worker(unsigned int id, unsigned int action, void* bss, void** data, void* user_data)
+{
+    WorkerData* wd = (WorkerData*)scheduler::get_worker_data();
+    if( wd )
+        ++wd->m_Calls;
+    return cb_dispatch( id, action, bss, data, user_data );
+}
+
+typedef unsigned int (*UserCallback)( unsigned int action, void* bss, void** data, UserData& ud );
+
+template<UserCallback F>
+unsigned int cb_bind( unsigned int id, unsigned int action, void* bss, void** data, void* user_data )
+{
+    return F( action, bss, data, *((UserData*)user_data) );
+}
+
+struct HandlerEntry
+{
+    unsigned int    m_Id;
+    CallbackHandler m_Handler;
+};
+
+const HandlerEntry g_Handlers[] =
+{
+    {   0, &cb_bind<cb_setexit> },
+    {   1, &cb_bind<cb_checkexit> },
+    {   2, &cb_bind<cb_getline> },
+    {   3, &cb_bind<cb_strcmp> },
+    {   4, &cb_bind<cb_print> },
+    {   7, &cb_bind<cb_count_to_zero> },
+    {   8, &cb_bind<cb_set_gc> },
+    {   9, &cb_bind<cb_dec_gc> },
+    {  10, &cb_bind<cb_inc_gc> },
+    {  11, &cb_bind<cb_check_gc_smlr> },
+    {  12, &cb_bind<cb_check_gc_grtr> },
+    {  13, &cb_bind<cb_time_delay> },
+    { 100, &cb_bind<cb_modify_return> }
+};
+
+/*
+ * Builds a per-index handler table for the program. Ids without a handler of
+ * their own go through "fallback".
+ */
+CallbackHandler* bind_handlers( char* program, CallbackHandler fallback )
+{
+    unsigned int count = get_callback_count( program );
+    CallbackHandler* table = (CallbackHandler*)malloc( sizeof(CallbackHandler) * count );
+    const unsigned int handlers = sizeof(g_Handlers) / sizeof(HandlerEntry);
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        unsigned int id = get_callback_id( program, i );
+        table[i] = fallback;
+        for( unsigned int h = 0; h < handlers; ++h )
+        {
+            if( g_Handlers[h].m_Id == id )
+                table[i] = g_Handlers[h].m_Handler;
+        }
+    }
+    return table;
+}
+
+// Frames for the trees the program calls in pooled frames, shared by all agents.
+FramePool* g_Frames = 0x0;
+
+void init_agents( char* bss, unsigned int stride, UserData* ud, unsigned int count )
+{
+    memset( bss, 0, stride * count );
+    reset_frame_pool( g_Frames );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        ud[i].m_Exit          = false;
+        ud[i].m_Silent        = true;
+        ud[i].m_TotalCounter  = 0;
+        ud[i].m_FrameCounter  = 0;
+        ud[i].m_FrameTime     = 1.0 / 60.0;
+        ud[i].m_GlobalCounter = 0;
+        ud[i].m_Scheduler     = 0x0;
+        ud[i].m_Agent         = 0x0;
+    }
+}
+
+// Events kept of a traced run, see -r.
+const unsigned int TRACE_EVENTS = 1 << 20;
+
+/*
+ * Writes the events left in "tb" to "file_name" as a trace dump, with the
+ * time stamp counter frequency measured over the run.
+ */
+int save_trace( const char* file_name, TraceBuffer* tb, uint64 ticks, uint64 counts )
+{
+    TraceEvent* events = (TraceEvent*)malloc( sizeof(TraceEvent) * TRACE_EVENTS );
+    FILE* f = fopen( file_name, "wb" );
+    if( !events || !f )
+    {
+        printf( "Error: unable to write the trace to %s\n", file_name );
+        free( events );
+        if( f )
+            fclose( f );
+        return -6;
+    }
+
+    TraceDumpHeader h;
+    memset( &h, 0, sizeof(h) );
+    h.m_Magic   = TRACE_DUMP_MAGIC;
+    h.m_Version = TRACE_DUMP_VERSION;
+    unsigned int cursor = 0;
+    h.m_Count   = read_trace( tb, &cursor, events, TRACE_EVENTS, &h.m_Lost );
+    if( counts )
+        h.m_Frequency = (uint64)((double)ticks * (double)get_cpu_frequency() / (double)counts);
+
+    bool ok = fwrite( &h, sizeof(h), 1, f ) == 1
+        && fwrite( events, sizeof(TraceEvent), h.m_Count, f ) == h.m_Count;
+    fclose( f );
+    free( events );
+    if( !ok )
+    {
+        printf( "Error: unable to write the trace to %s\n", file_name );
+        return -6;
+    }
+    printf( "Trace events:             %10d\n", h.m_Count );
+    printf( "Trace events lost:        %10d\n", h.m_Lost );
+    return 0;
+}
+
+// Samples kept of a sampled run and the microseconds between them, see -o.
+const unsigned int SAMPLE_COUNT    = 1 << 16;
+const unsigned int SAMPLE_INTERVAL = 1000;
+
+/*
+ * Writes the samples in "sb" to "file_name" as a sample dump.
+ */
+int save_samples( const char* file_name, SampleBuffer* sb )
+{
+    SampleDumpHeader h;
+    memset( &h, 0, sizeof(h) );
+    h.m_Magic    = SAMPLE_DUMP_MAGIC;
+    h.m_Version  = SAMPLE_DUMP_VERSION;
+    h.m_Count    = get_sample_count( sb );
+    h.m_Dropped  = get_samples_dropped( sb );
+    h.m_Interval = SAMPLE_INTERVAL;
+
+    FILE* f = fopen( file_name, "wb" );
+    bool ok = f && fwrite( &h, sizeof(h), 1, f ) == 1
+        && fwrite( get_samples( sb ), sizeof(Sample), h.m_Count, f ) == h.m_Count;
+    if( f )
+        fclose( f );
+    if( !ok )
+    {
+        printf( "Error: unable to write the samples to %s\n", file_name );
+        return -6;
+    }
+    printf( "Samples:                  %10d\n", h.m_Count );
+    printf( "Samples dropped:          %10d\n", h.m_Dropped );
+    return 0;
+}
+
+int run_batch_benchmark( char* program, unsigned int agents, unsigned int frames )
+{
+    unsigned int stride = (((ProgramHeader*)program)->m_BS + 15) & ~15;
+
+    char*      bss = (char*)malloc( stride * agents );
+    UserData*  ud  = (UserData*)malloc( sizeof(UserData) * agents );
+    void**     udp = (void**)malloc( sizeof(void*) * agents );
+
+    if( !bss || !ud || !udp )
+    {
+        printf( "Error: unable to allocate memory for %d agents\n", agents );
+        free( bss );
+        free( ud );
+        free( udp );
+        return -4;
+    }
+
+    for( unsigned int i = 0; i < agents; ++i )
+        udp[i] = &ud[i];
+
+    uint64 freq = get_cpu_frequency();
+    uint64 start, end;
+
+    // One run_program call per agent.
+    init_agents( bss, stride, ud, agents );
+
+    CallbackProgram cp;
+    cp.m_Program  = program;
+    cp.m_Callback = &cb_dispatch;
+    cp.m_Debug    = 0x0;
+    cp.m_Table    = 0x0;
+    cp.m_Flags    = 0;
+    cp.m_Frames   = g_Frames;
+
+    start = get_cpu_counter();
+    for( unsigned int f = 0; f < frames; ++f )
+    {
+        for( unsigned int i = 0; i < agents; ++i )
+        {
+            cp.m_bss      = bss + (stride * i);
+            cp.m_UserData = udp[i];
+            run_program( &cp );
+        }
+    }
+    end = get_cpu_counter();
+    double single = ((double)(end - start)) / ((double)freq);
+
+    // All agents in one run_programs call.
+    init_agents( bss, stride, ud, agents );
+
+    CallbackBatch cb;
+    cb.m_Program  = program;
+    cb.m_bss      = bss;
+    cb.m_UserData = udp;
+    cb.m_Stride   = stride;
+    cb.m_Count    = agents;
+    cb.m_Callback = &cb_dispatch;
+    cb.m_Debug    = 0x0;
+    cb.m_Table    = 0x0;
+    cb.m_Flags    = 0;
+    cb.m_Frames   = g_Frames;
+
+    start = get_cpu_counter();
+    for( unsigned int f = 0; f < frames; ++f )
+        run_programs( &cb );
+    end = get_cpu_counter();
+    double batch = ((double)(end - start)) / ((double)freq);
+
+    // All agents in one run_programs call, through a per-index handler table.
+    init_agents( bss, stride, ud, agents );
+
+    CallbackHandler* table = bind_handlers( program, &cb_dispatch );
+    cb.m_Table = table;
+
+    start = get_cpu_counter();
+    for( unsigned int f = 0; f < frames; ++f )
+        run_programs( &cb );
+    end = get_cpu_counter();
+    double tabled = ((double)(end - start)) / ((double)freq);
+
+    free( table );
+
+    // All agents in one run_programs call, as native code.
+    double jitted = 0.0;
+    bool jit = jit_compile( program );
+    if( jit )
+    {
+        init_agents( bss, stride, ud, agents );
+
+        cb.m_Table = 0x0;
+        cb.m_Flags = E_CALLBACK_JIT;
+
+        start = get_cpu_counter();
+        for( unsigned int f = 0; f < frames; ++f )
+            run_programs( &cb );
+        end = get_cpu_counter();
+        jitted = ((double)(end - start)) / ((double)freq);
+
+        jit_release( program );
+    }
+
+    // Snapshot all agents and roll them back, once per frame.
+    cb.m_Table = 0x0;
+    cb.m_Flags = 0;
+    unsigned int snap_bound = get_snapshot_bound( program, agents );
+    char* snap = (char*)malloc( snap_bound );
+    int snap_size = -1;
+    double saved = 0.0, loaded = 0.0;
+    if( snap )
+    {
+        start = get_cpu_counter();
+        for( unsigned int f = 0; f < frames; ++f )
+            snap_size = save_snapshots( &cb, snap, snap_bound );
+        end = get_cpu_counter();
+        saved = ((double)(end - start)) / ((double)freq);
+
+        start = get_cpu_counter();
+        for( unsigned int f = 0; f < frames; ++f )
+            load_snapshots( &cb, snap, snap_size );
+        end = get_cpu_counter();
+        loaded = ((double)(end - start)) / ((double)freq);
+    }
+    free( snap );
+
+    double runs = (double)agents * (double)frames;
+
+    printf( "Agents:                   %10d\n", agents );
+    printf( "Frames:                   %10d\n", frames );
+    printf( "Bss stride:               %10d\n\n", stride );
+
+    printf( "run_program, s:           %10.4f\n", single );
+    printf( "run_programs, s:          %10.4f\n", batch );
+    printf( "run_programs + table, s:  %10.4f\n", tabled );
+    printf( "run_program, ns/agent:    %10.2f\n", (single * 1000000000.0) / runs );
+    printf( "run_programs, ns/agent:   %10.2f\n", (batch * 1000000000.0) / runs );
+    printf( "+ table, ns/agent:        %10.2f\n", (tabled * 1000000000.0) / runs );
+    if( jit )
+    {
+        printf( "run_programs + jit, s:    %10.4f\n", jitted );
+        printf( "+ jit, ns/agent:          %10.2f\n", (jitted * 1000000000.0) / runs );
+    }
+    if( snap_size >= 0 )
+    {
+        printf( "Snapshot, bytes:          %10d\n", snap_size );
+        printf( "save_snapshots, us:       %10.2f\n", (saved * 1000000.0) / frames );
+        printf( "load_snapshots, us:       %10.2f\n", (loaded * 1000000.0) / frames );
+    }
+    if( batch > 0.0 )
+        printf( "Speed-up:                 %10.2f\n", single / batch );
+    if( tabled > 0.0 )
+        printf( "Speed-up, table:          %10.2f\n", single / tabled );
+    if( jitted > 0.0 )
+        printf( "Speed-up, jit:            %10.2f\n", single / jitted );
+    printf( "\n********************************************\n\n" );
+
+    free( bss );
+    free( ud );
+    free( udp );
+
+    return 0;
+}
+
+int run_scheduler_benchmark( char* program, unsigned int agents, unsigned int frames )
+{
+    unsigned int stride = (((ProgramHeader*)program)->m_BS + 15) & ~15;
+
+    char*             bss   = (char*)malloc( stride * agents );
+    UserData*         ud    = (UserData*)malloc( sizeof(UserData) * agents );
+    void**            udp   = (void**)malloc( sizeof(void*) * agents );
+    scheduler::Agent* agent = (scheduler::Agent*)malloc( sizeof(scheduler::Agent) * agents );
+    scheduler::Scheduler* s = (scheduler::Scheduler*)malloc( sizeof(scheduler::Scheduler) );
+
+    if( !bss || !ud || !udp || !agent || !s )
+    {
+        printf( "Error: unable to allocate memory for %d agents\n", agents );
+        free( bss );
+        free( ud );
+        free( udp );
+        free( agent );
+        free( s );
+        return -4;
+    }
+
+    for( unsigned int i = 0; i < agents; ++i )
+        udp[i] = &ud[i];
+
+    uint64 freq = get_cpu_frequency();
+    uint64 start, end;
+
+    // Every agent runs every frame.
+    init_agents( bss, stride, ud, agents );
+
+    CallbackBatch cb;
+    cb.m_Program  = program;
+    cb.m_bss      = bss;
+    cb.m_UserData = udp;
+    cb.m_Stride   = stride;
+    cb.m_Count    = agents;
+    cb.m_Callback = &cb_dispatch;
+    cb.m_Debug    = 0x0;
+    cb.m_Table    = 0x0;
+    cb.m_Flags    = 0;
+    cb.m_Frames   = g_Frames;
+
+    start = get_cpu_counter();
+    for( unsigned int f = 0; f < frames; ++f )
+        run_programs( &cb );
+    end = get_cpu_counter();
+    double batch = ((double)(end - start)) / ((double)freq);
+
+    // Agents that wait are parked in the scheduler.
+    init_agents( bss, stride, ud, agents );
+    scheduler::init( s );
+    for( unsigned int i = 0; i < agents; ++i )
+    {
+        agent[i].m_Program.m_Program  = program;
+        agent[i].m_Program.m_bss      = bss + (stride * i);
+        agent[i].m_Program.m_UserData = udp[i];
+        agent[i].m_Program.m_Callback = &cb_dispatch;
+        agent[i].m_Program.m_Debug    = 0x0;
+        agent[i].m_Program.m_Table    = 0x0;
+        agent[i].m_Program.m_Flags    = 0;
+        agent[i].m_Program.m_Frames   = g_Frames;
+        ud[i].m_Scheduler = s;
+        ud[i].m_Agent     = &agent[i];
+        scheduler::add_agent( s, &agent[i] );
+    }
+
+    uint64 runs = 0;
+    start = get_cpu_counter();
+    for( unsigned int f = 0; f < frames; ++f )
+        runs += scheduler::run_scheduler( s );
+    end = get_cpu_counter();
+    double scheduled = ((double)(end - start)) / ((double)freq);
+
+    printf( "Agents:                   %10d\n", agents );
+    printf( "Frames:                   %10d\n\n", frames );
+
+    printf( "run_programs, s:          %10.4f\n", batch );
+    printf( "run_scheduler, s:         %10.4f\n", scheduled );
+    printf( "Agents run per frame:     %10.2f\n", ((double)runs) / (double)frames );
+    printf( "Agents parked at exit:    %10d\n", s->m_Parked );
+    if( scheduled > 0.0 )
+        printf( "Speed-up:                 %10.2f\n", batch / scheduled );
+    printf( "\n********************************************\n\n" );
+
+    free( bss );
+    free( ud );
+    free( udp );
+    free( agent );
+    free( s );
+
+    return 0;
+}
+
+int run_thread_benchmark( char* program, unsigned int agents, unsigned int frames, unsigned int threads )
+{
+    unsigned int stride = (((ProgramHeader*)program)->m_BS + 15) & ~15;
+
+    char*       bss = (char*)malloc( stride * agents );
+    UserData*   ud  = (UserData*)malloc( sizeof(UserData) * agents );
+    void**      udp = (void**)malloc( sizeof(void*) * agents );
+    WorkerData* wd  = (WorkerData*)malloc( sizeof(WorkerData) * threads );
+    void**      wdp = (void**)malloc( sizeof(void*) * threads );
+
+    if( !bss || !ud || !udp || !wd || !wdp )
+    {
+        printf( "Error: unable to allocate memory for %d agents\n", agents );
+        free( bss );
+        free( ud );
+        free( udp );
+        free( wd );
+        free( wdp );
+        return -4;
+    }
+
+    for( unsigned int i = 0; i < agents; ++i )
+        udp[i] = &ud[i];
+    for( unsigned int i = 0; i < threads; ++i )
+    {
+        wd[i].m_Calls = 0;
+        wdp[i] = &wd[i];
+    }
+
+    uint64 freq = get_cpu_frequency();
+    uint64 start, end;
+
+    // All agents in one run_programs call on this thread.
+    init_agents( bss, stride, ud, agents );
+
+    CallbackBatch cb;
+    cb.m_Program  = program;
+    cb.m_bss      = bss;
+    cb.m_UserData = udp;
+    cb.m_Stride   = stride;
+    cb.m_Count    = agents;
+    cb.m_Callback = &cb_worker;
+    cb.m_Debug    = 0x0;
+    cb.m_Table    = 0x0;
+    cb.m_Flags    = 0;
+    cb.m_Frames   = g_Frames;
+
+    start = get_cpu_counter();
+    for( unsigned int f = 0; f < frames; ++f )
+        run_programs( &cb );
+    end = get_cpu_counter();
+    double batch = ((double)(end - start)) / ((double)freq);
+
+    int batch_gc = 0;
+    for( unsigned int i = 0; i < agents; ++i )
+        batch_gc += ud[i].m_GlobalCounter;
+
+    // The same agents spread over the worker pool.
+    init_agents( bss, stride, ud, agents );
+
+    scheduler::WorkerPool* wp = scheduler::create_worker_pool( threads, wdp );
+
+    uint64 steals = 0;
+    start = get_cpu_counter();
+    for( unsigned int f = 0; f < frames; ++f )
+        steals += scheduler::run_workers( wp, &cb, 1 );
+    end = get_cpu_counter();
+    double threaded = ((double)(end - start)) / ((double)freq);
+
+    scheduler::destroy_worker_pool( wp );
+
+    int threaded_gc = 0;
+    for( unsigned int i = 0; i < agents; ++i )
+        threaded_gc += ud[i].m_GlobalCounter;
+
+    printf( "Agents:                   %10d\n", agents );
+    printf( "Frames:                   %10d\n", frames );
+    printf( "Threads:                  %10d\n\n", threads );
+
+    printf( "run_programs, s:          %10.4f\n", batch );
+    printf( "run_workers, s:           %10.4f\n", threaded );
+    printf( "Chunks stolen per frame:  %10.2f\n", ((double)steals) / (double)frames );
+    for( unsigned int i = 0; i < threads; ++i )
+        printf( "Worker %2d callbacks:      %10llu\n", i, (unsigned long long)wd[i].m_Calls );
+    if( batch_gc != threaded_gc )
+        printf( "Error: global counters differ, %d != %d\n", batch_gc, threaded_gc );
+    if( threaded > 0.0 )
+        printf( "Speed-up:                 %10.2f\n", batch / threaded );
+    printf( "\n********************************************\n\n" );
+
+    free( bss );
+    free( ud );
+    free( udp );
+    free( wd );
+    free( wdp );
+
+    return batch_gc != threaded_gc ? -5 : 0;
+}
+
+void free_fork_benchmark( ForkArena* fa, UserData* ud, void** udp, char* cpy )
+{
+    destroy_fork_arena( fa );
+    free( ud );
+    free( udp );
+    free( cpy );
+}
+
+int run_fork_benchmark( char* program, unsigned int agents, unsigned int ticks )
+{
+    unsigned int bss_size = ((ProgramHeader*)program)->m_BS;
+
+    if( get_frame_size( program ) != 0 )
+    {
+        printf( "Error: agents that call trees in pooled frames can not be forked\n" );
+        return -5;
+    }
+
+    ForkArena* fa  = create_fork_arena( program, agents );
+    UserData*  ud  = (UserData*)malloc( sizeof(UserData) * agents );
+    void**     udp = (void**)malloc( sizeof(void*) * agents );
+
+    unsigned int stride = fa ? get_fork_stride( fa ) : 0;
+    char*      cpy = (char*)malloc( stride * agents );
+
+    if( !fa || !ud || !udp || !cpy )
+    {
+        printf( "Error: unable to allocate memory for %d agents\n", agents );
+        free_fork_benchmark( fa, ud, udp, cpy );
+        return -4;
+    }
+
+    for( unsigned int i = 0; i < agents; ++i )
+        udp[i] = &ud[i];
+
+    uint64 freq = get_cpu_frequency();
+    uint64 start, end;
+
+    // Give the agents some state to fork.
+    init_agents( (char*)get_agent_bss( fa, 0 ), stride, ud, agents );
+
+    CallbackBatch cb;
+    cb.m_Program  = program;
+    cb.m_bss      = get_agent_bss( fa, 0 );
+    cb.m_UserData = udp;
+    cb.m_Stride   = stride;
+    cb.m_Count    = agents;
+    cb.m_Callback = &cb_dispatch;
+    cb.m_Debug    = 0x0;
+    cb.m_Table    = 0x0;
+    cb.m_Flags    = 0;
+    cb.m_Frames   = g_Frames;
+
+    for( unsigned int f = 0; f < 10; ++f )
+        run_programs( &cb );
+
+    // Fork every agent, run the forks ahead and throw them away.
+    start = get_cpu_counter();
+    cb.m_bss = fork_agents( fa, 0, agents );
+    end = get_cpu_counter();
+    if( !cb.m_bss )
+    {
+        printf( "Error: unable to allocate memory for %d forks\n", agents );
+        free_fork_benchmark( fa, ud, udp, cpy );
+        return -4;
+    }
+    double forked = ((double)(end - start)) / ((double)freq);
+
+    start = get_cpu_counter();
+    for( unsigned int t = 0; t < ticks; ++t )
+        run_programs( &cb );
+    end = get_cpu_counter();
+    double fork_run = ((double)(end - start)) / ((double)freq);
+
+    start = get_cpu_counter();
+    discard_forks( fa, 0, agents );
+    end = get_cpu_counter();
+    double discarded = ((double)(end - start)) / ((double)freq);
+
+    // The same with a copy of each agent's bss.
+    start = get_cpu_counter();
+    for( unsigned int i = 0; i < agents; ++i )
+        memcpy( cpy + (stride * i), get_agent_bss( fa, i ), bss_size );
+    end = get_cpu_counter();
+    double copied = ((double)(end - start)) / ((double)freq);
+
+    cb.m_bss = cpy;
+    start = get_cpu_counter();
+    for( unsigned int t = 0; t < ticks; ++t )
+        run_programs( &cb );
+    end = get_cpu_counter();
+    double copy_run = ((double)(end - start)) / ((double)freq);
+
+    // And once more, keeping what the forks did.
+    cb.m_bss = fork_agents( fa, 0, agents );
+    if( !cb.m_bss )
+    {
+        printf( "Error: unable to allocate memory for %d forks\n", agents );
+        free_fork_benchmark( fa, ud, udp, cpy );
+        return -4;
+    }
+    for( unsigned int t = 0; t < ticks; ++t )
+        run_programs( &cb );
+    start = get_cpu_counter();
+    unsigned int pages = commit_forks( fa, 0, agents );
+    end = get_cpu_counter();
+    double committed = ((double)(end - start)) / ((double)freq);
+
+    printf( "Agents:                   %10d\n", agents );
+    printf( "Ticks:                    %10d\n", ticks );
+    printf( "Bss size:                 %10d\n", bss_size );
+    printf( "Bss stride:               %10d\n\n", stride );
+
+    printf( "fork_agents, ns/agent:    %10.2f\n", (forked * 1000000000.0) / agents );
+    printf( "Forks run, s:             %10.4f\n", fork_run );
+    printf( "discard_forks, ns/agent:  %10.2f\n", (discarded * 1000000000.0) / agents );
+    printf( "commit_forks, ns/agent:   %10.2f\n", (committed * 1000000000.0) / agents );
+    printf( "Pages committed:          %10d\n", pages );
+    printf( "Copy, ns/agent:           %10.2f\n", (copied * 1000000000.0) / agents );
+    printf( "Copies run, s:            %10.4f\n", copy_run );
+    printf( "\n********************************************\n\n" );
+
+    free_fork_benchmark( fa, ud, udp, cpy );
+
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
     int returnCode = 0;
     char c = 0;
     char *inputFileName = 0x0;
+    char *programName   = 0x0;
+    char *entryName     = 0x0;
+    char *traceFileName = 0x0;
+    char *sampleFileName = 0x0;
     bool silent = false;
+    unsigned int batch_agents = 0;
+    unsigned int sched_agents = 0;
+    unsigned int batch_frames = 100;
+    unsigned int threads      = 0;
+    unsigned int fork_count   = 0;
 
     GetOptContext ctx;
     init_getopt_context( &ctx );
 
-    while ( (c = getopt(argc, argv, "?i:s", &ctx)) != -1)
+    while ( (c = getopt(argc, argv, "?i:p:n:sb:f:w:t:k:r:o:", &ctx)) != -1)
     {
         switch (c)
         {
         case 'i':
             inputFileName = ctx.optarg;
             break;
+        case 'p':
+            programName = ctx.optarg;
+            break;
+        case 'n':
+            entryName = ctx.optarg;
+            break;
         case 's':
             silent = true;
             break;
+        case 'b':
+            batch_agents = atoi( ctx.optarg );
+            break;
+        case 'f':
+            batch_frames = atoi( ctx.optarg );
+            break;
+        case 'w':
+            sched_agents = atoi( ctx.optarg );
+            break;
+        case 't':
+            threads = atoi( ctx.optarg );
+            break;
+        case 'k':
+            fork_count = atoi( ctx.optarg );
+            break;
+        case 'r':
+            traceFileName = ctx.optarg;
+            break;
+        case 'o':
+            sampleFileName = ctx.optarg;
+            break;
         case '?':
             printf("calltree testing application version 0.1\n\n");
             printf("Options:\n");
-            printf("\t-i\tInput file\n");
+            printf("\t-i\tInput file, a program or an archive of programs\n");
+            printf("\t-p\tName of the program to run from an archive (default the first).\n" );
+            printf("\t-n\tEntry point of a linked program to run, when not benchmarking (default the first).\n" );
             printf("\t-s\tSilent mode. Prevents the \"print\" action from echoing to the screen.\n" );
+            printf("\t-b\tBatch benchmark. Runs the given number of agents with run_program and run_programs.\n" );
+            printf("\t-w\tScheduler benchmark. Runs the given number of agents with run_programs and the scheduler.\n" );
+            printf("\t-t\tRun the batch benchmark on the given number of threads, comparing run_programs with a worker pool.\n" );
+            printf("\t-k\tFork benchmark. Forks the given number of agents and runs the forks for the given number of frames.\n" );
+            printf("\t-f\tNumber of frames to run in the benchmarks (default 100).\n" );
+            printf("\t-r\tTrace file to write. Records the nodes run on the main thread by programs\n"
+                   "\t\tcompiled with (node_trace 1), see ctt.\n" );
+            printf("\t-o\tSample file to write. Samples the programs run on any thread, see ctt.\n" );
             printf("\t-?\tPrint this message and exit.\n\n");
             return 0;
             break;
@@ -307,19 +1038,38 @@ int main(int argc, char** argv)
         returnCode = -1;
     }
 
-    char*  program   = 0x0;
-    size_t fileSize  = 0;
-    FILE*  inputFile = 0x0;
+    char*    program   = 0x0;
+    size_t   fileSize  = 0;
+    FILE*    inputFile = 0x0;
+    Archive* archive   = 0x0;
 
+    // Archives are mapped and run in place, plain programs are read
     if (returnCode == 0)
+        archive = open_archive(inputFileName);
+
+    if (archive)
+    {
+        int index = programName ? find_archive_program( archive, programName ) : 0;
+        if( index < 0 || get_archive_count( archive ) == 0 )
+        {
+            printf( "Error: no program %s in archive %s\n",
+                programName ? programName : "", inputFileName );
+            returnCode = -3;
+        }
+        else
+        {
+            program = (char*)get_archive_program( archive, index );
+        }
+    }
+    else if (returnCode == 0)
         inputFile = fopen(inputFileName, "rb");
 
-    if ( !inputFile)
+    if ( !archive && !inputFile)
     {
         printf("Error: Unable to open input file %s\n", inputFileName);
         returnCode = -2;
     }
-    else
+    else if (inputFile)
     {
         fseek(inputFile, 0, SEEK_END);
         fileSize = ftell(inputFile);
@@ -335,7 +1085,80 @@ int main(int argc, char** argv)
         fclose(inputFile);
     }
 
-    if (returnCode == 0)
+    if (returnCode == 0 && (!program || (!archive && !check_program( program, (unsigned int)fileSize ))))
+    {
+        printf("Error: %s is not a program of version %u\n", inputFileName, PROGRAM_VERSION);
+        returnCode = -3;
+    }
+
+    if (returnCode == 0 && get_frame_size( program ) != 0)
+    {
+        // Room for the busiest benchmark, or the single agent
+        unsigned int agents = batch_agents > sched_agents ? batch_agents : sched_agents;
+        if( fork_count > agents )
+            agents = fork_count;
+        g_Frames = create_frame_pool( program, agents ? agents : 1 );
+        if( !g_Frames )
+        {
+            printf( "Error: unable to allocate the frame pool\n" );
+            returnCode = -4;
+        }
+    }
+
+    int entry = 0;
+    if (returnCode == 0 && entryName)
+    {
+        entry = find_entry_point( program, entryName );
+        if( entry < 0 )
+        {
+            printf( "Error: no entry point %s in %s\n", entryName, inputFileName );
+            returnCode = -5;
+        }
+    }
+
+    TraceBuffer* trace = 0x0;
+    uint64 trace_ticks = 0, trace_counts = 0;
+    if (returnCode == 0 && traceFileName)
+    {
+        trace = create_trace_buffer( TRACE_EVENTS );
+        if( !trace )
+        {
+            printf( "Error: unable to allocate the trace buffer\n" );
+            returnCode = -4;
+        }
+        set_trace_buffer( trace );
+        trace_ticks  = read_time_stamp();
+        trace_counts = get_cpu_counter();
+    }
+
+    SampleBuffer* samples = 0x0;
+    if (returnCode == 0 && sampleFileName)
+    {
+        samples = create_sample_buffer( SAMPLE_COUNT );
+        if( !samples || !start_sampling( samples, SAMPLE_INTERVAL ) )
+        {
+            printf( "Error: unable to start sampling\n" );
+            returnCode = -4;
+        }
+    }
+
+    if (returnCode == 0 && batch_agents > 0 && threads > 0)
+    {
+        returnCode = run_thread_benchmark( program, batch_agents, batch_frames, threads );
+    }
+    else if (returnCode == 0 && batch_agents > 0)
+    {
+        returnCode = run_batch_benchmark( program, batch_agents, batch_frames );
+    }
+    else if (returnCode == 0 && sched_agents > 0)
+    {
+        returnCode = run_scheduler_benchmark( program, sched_agents, batch_frames );
+    }
+    else if (returnCode == 0 && fork_count > 0)
+    {
+        returnCode = run_fork_benchmark( program, fork_count, batch_frames );
+    }
+    else if (returnCode == 0)
     {
 
         UserData ud;
@@ -343,6 +1166,8 @@ int main(int argc, char** argv)
         ud.m_TotalCounter = 0;
         ud.m_Silent       = silent;
         ud.m_FrameTime    = 0.0f;
+        ud.m_Scheduler    = 0x0;
+        ud.m_Agent        = 0x0;
 
         uint64 start, frame_start, end, frame_end, freq;
 
@@ -356,7 +1181,12 @@ int main(int argc, char** argv)
         cp.m_UserData = (void*)&ud;
         cp.m_Callback = &cb_handler;
         cp.m_Debug    = &cb_debug;
+        cp.m_Table    = 0x0;
+        cp.m_Flags    = 0;
+        cp.m_Frames   = g_Frames;
         BssHeader* bh = (BssHeader*)bss;
+        if( entryName )
+            set_entry_point( &cp, entry );
 
         freq = get_cpu_frequency();
 
@@ -422,7 +1252,30 @@ int main(int argc, char** argv)
 
     }
 
-    if( program != 0x0 )
+    if( trace )
+    {
+        set_trace_buffer( 0x0 );
+        trace_ticks  = read_time_stamp() - trace_ticks;
+        trace_counts = get_cpu_counter() - trace_counts;
+        int r = save_trace( traceFileName, trace, trace_ticks, trace_counts );
+        if( returnCode == 0 )
+            returnCode = r;
+        destroy_trace_buffer( trace );
+    }
+
+    if( samples )
+    {
+        stop_sampling();
+        if( returnCode == 0 )
+            returnCode = save_samples( sampleFileName, samples );
+        destroy_sample_buffer( samples );
+    }
+
+    destroy_frame_pool( g_Frames );
+
+    if( archive )
+        close_archive( archive );
+    else if( program != 0x0 )
         free(program);
 
     return returnCode;
@@ -0,0 +1,408 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+/*
+ * Turns trace dumps (see callback/trace.h and ctr -r) into the JSON trace
+ * event format read by chrome://tracing and Perfetto. Every recording thread
+ * is a process and every agent a thread of it, with a slice per node run and
+ * callback. Nodes are named from the node map ctc -m writes for the program,
+ * or by their id without one.
+ *
+ * Sample dumps (see callback/sampling.h and ctr -o) are turned into folded
+ * stacks, one line per stack with the number of samples of it, as read by
+ * flamegraph.pl and speedscope. A stack is the trees and nodes the agent was
+ * in, with the action of the innermost node of each tree; it needs the node
+ * map, without one the instruction pointers are listed.
+ */
+
+#include <other/getopt.h>
+#include <callback/nodemap.h>
+#include <callback/trace.h>
+#include <callback/sampling.h>
+#include <callback/instructions.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+#include <map>
+#include <string>
+
+using namespace callback;
+
+struct TraceBlock
+{
+  TraceDumpHeader         m_Header;
+  std::vector<TraceEvent> m_Events;
+};
+
+struct AgentTrack
+{
+  unsigned int m_Tid;
+  unsigned int m_Depth; // Open slices, exits of nodes entered before the dump starts are dropped
+};
+
+struct NodeName
+{
+  std::string  m_Name;
+  unsigned int m_Line;
+};
+
+typedef std::map<unsigned long long, AgentTrack> AgentTracks;
+typedef std::map<unsigned int, NodeName>         NodeNames;
+typedef std::map<std::string, unsigned int>      StackCounts;
+
+static const char* const g_Actions[MAXIMUM_NODEACTION_COUNT] =
+{
+  "construct", "execute", "destruct", "prune", "modify"
+};
+
+static const char* const g_Results[MAXIMUM_NODE_RETURN_COUNT] =
+{
+  "fail", "success", "working", "undefined"
+};
+
+void print_usage()
+{
+  fprintf( stdout, "calltree trace converter Version 0.1\n\n" );
+  fprintf( stdout, "Options:\n" );
+  fprintf( stdout, "\t-i\tTrace or sample dump to convert, written by ctr -r or -o. (required)\n" );
+  fprintf( stdout, "\t-m\tNode map of the traced program, written by ctc -m. (optional)\n" );
+  fprintf( stdout, "\t-o\tJSON or folded stack file to write. (optional, default is stdout)\n" );
+  fprintf( stdout, "\t-?\tPrint this message and exit.\n\n" );
+}
+
+static char* read_whole_file( const char* file_name, unsigned int* size )
+{
+  FILE* f = fopen( file_name, "rb" );
+  if( !f )
+    return 0x0;
+  fseek( f, 0, SEEK_END );
+  long s = ftell( f );
+  fseek( f, 0, SEEK_SET );
+  char* data = (char*)malloc( s > 0 ? s : 1 );
+  if( data && fread( data, 1, s, f ) != (size_t)s )
+  {
+    free( data );
+    data = 0x0;
+  }
+  fclose( f );
+  *size = (unsigned int)s;
+  return data;
+}
+
+static int read_dump( const char* data, unsigned int size, std::vector<TraceBlock>* out )
+{
+  unsigned int pos = 0;
+  while( pos < size )
+  {
+    TraceBlock b;
+    if( size - pos < sizeof(TraceDumpHeader) )
+      return -1;
+    memcpy( &b.m_Header, data + pos, sizeof(TraceDumpHeader) );
+    pos += sizeof(TraceDumpHeader);
+    if( b.m_Header.m_Magic != TRACE_DUMP_MAGIC || b.m_Header.m_Version != TRACE_DUMP_VERSION
+      || (size - pos) / sizeof(TraceEvent) < b.m_Header.m_Count )
+      return -1;
+    b.m_Events.resize( b.m_Header.m_Count );
+    if( b.m_Header.m_Count )
+      memcpy( &b.m_Events[0], data + pos, sizeof(TraceEvent) * b.m_Header.m_Count );
+    pos += sizeof(TraceEvent) * b.m_Header.m_Count;
+    out->push_back( b );
+  }
+  return 0;
+}
+
+static void name_nodes( const NodeMapHeader* m, NodeNames* names )
+{
+  const MapNode* n = get_map_nodes( m );
+  for( unsigned int i = 0; i < m->m_NC; ++i )
+  {
+    NodeName& nn = (*names)[n[i].m_Id];
+    nn.m_Name = get_map_string( m, n[i].m_Name );
+    nn.m_Line = n[i].m_Line;
+  }
+}
+
+static void print_string( FILE* f, const char* str )
+{
+  fputc( '"', f );
+  for( ; *str; ++str )
+  {
+    if( *str == '"' || *str == '\\' )
+      fputc( '\\', f );
+    if( (unsigned char)*str >= 0x20 )
+      fputc( *str, f );
+  }
+  fputc( '"', f );
+}
+
+static void print_name( FILE* f, const NodeNames& names, const TraceEvent& e )
+{
+  char buffer[64];
+  NodeNames::const_iterator it = names.find( e.m_Id );
+  std::string name;
+  if( it != names.end() )
+    name = it->second.m_Name;
+  else
+  {
+    sprintf( buffer, "node 0x%08x", e.m_Id );
+    name = buffer;
+  }
+  const unsigned int kind = e.m_Kind & TRACE_KIND_MASK;
+  const unsigned int action = e.m_Kind >> TRACE_ACTION_SHIFT;
+  if( (kind == E_TRACE_CALLBACK_BEGIN || kind == E_TRACE_CALLBACK_END)
+    && action < MAXIMUM_NODEACTION_COUNT )
+  {
+    name += " ";
+    name += g_Actions[action];
+  }
+  print_string( f, name.c_str() );
+}
+
+/*
+ * Writes one block's events, "first" is the earliest time stamp of the dump.
+ */
+static bool print_block( FILE* f, const TraceBlock& b, const NodeNames& names,
+  unsigned long long first, bool* comma )
+{
+  const TraceDumpHeader& h = b.m_Header;
+  const double scale = h.m_Frequency ? 1000000.0 / (double)h.m_Frequency : 1.0;
+  AgentTracks agents;
+
+  fprintf( f, "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+    "\"args\":{\"name\":\"thread %u\"}}", *comma ? "," : "", h.m_Thread, h.m_Thread );
+  *comma = true;
+
+  for( size_t i = 0; i < b.m_Events.size(); ++i )
+  {
+    const TraceEvent& e = b.m_Events[i];
+    AgentTracks::iterator it = agents.find( e.m_Agent );
+    if( it == agents.end() )
+    {
+      AgentTrack t;
+      t.m_Tid   = (unsigned int)agents.size();
+      t.m_Depth = 0;
+      it = agents.insert( AgentTracks::value_type( e.m_Agent, t ) ).first;
+      fprintf( f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+        "\"args\":{\"name\":\"agent %u (0x%llx)\"}}", h.m_Thread, t.m_Tid, t.m_Tid,
+        e.m_Agent );
+    }
+    AgentTrack& t = it->second;
+
+    const unsigned int kind = e.m_Kind & TRACE_KIND_MASK;
+    const bool begin = kind == E_TRACE_ENTER || kind == E_TRACE_CALLBACK_BEGIN;
+    if( !begin && t.m_Depth == 0 )
+      continue;
+    t.m_Depth += begin ? 1 : -1;
+
+    const double ts = (double)(e.m_Time - first) * scale;
+    fprintf( f, ",\n{\"name\":" );
+    print_name( f, names, e );
+    fprintf( f, ",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u,",
+      kind == E_TRACE_ENTER || kind == E_TRACE_EXIT ? "node" : "callback",
+      begin ? "B" : "E", ts, h.m_Thread, t.m_Tid );
+    NodeNames::const_iterator nn = names.find( e.m_Id );
+    if( begin && nn != names.end() )
+      fprintf( f, "\"args\":{\"id\":\"0x%08x\",\"line\":%u}}", e.m_Id, nn->second.m_Line );
+    else if( begin )
+      fprintf( f, "\"args\":{\"id\":\"0x%08x\"}}", e.m_Id );
+    else if( e.m_Result < MAXIMUM_NODE_RETURN_COUNT )
+      fprintf( f, "\"args\":{\"result\":\"%s\"}}", g_Results[e.m_Result] );
+    else
+      fprintf( f, "\"args\":{\"result\":%u}}", e.m_Result );
+  }
+  return !ferror( f );
+}
+
+/*
+ * The frames of the tree an instruction pointer of a sample is in, from the
+ * tree down to the node whose code was run. Empty for the code outside the
+ * trees.
+ */
+static std::string tree_frames( const NodeMapHeader* m, unsigned int ip )
+{
+  char buffer[64];
+  if( !m )
+  {
+    sprintf( buffer, "ip %u", ip );
+    return buffer;
+  }
+  const unsigned int o = ip ? get_map_owner( m, ip - 1 ) : MAP_NONE;
+  if( o == MAP_NONE )
+    return std::string();
+
+  const MapNode* n = get_map_nodes( m );
+  const unsigned int a = get_map_action( m, ip - 1 );
+  std::string frames = get_map_string( m, n[o].m_Name );
+  frames += " (";
+  frames += a < MAXIMUM_NODEACTION_COUNT ? g_Actions[a] : "unknown";
+  frames += ")";
+  for( unsigned int p = n[o].m_Parent; p != MAP_NONE; p = n[p].m_Parent )
+    frames = std::string( get_map_string( m, n[p].m_Name ) ) + ";" + frames;
+  return std::string( get_map_string( m, get_map_trees( m )[n[o].m_Tree].m_Name ) )
+    + ";" + frames;
+}
+
+static bool print_folded( FILE* f, const char* data, const NodeMapHeader* m,
+  unsigned int* dropped )
+{
+  SampleDumpHeader h;
+  memcpy( &h, data, sizeof(SampleDumpHeader) );
+  const Sample* s = (const Sample*)(data + sizeof(SampleDumpHeader));
+  StackCounts stacks;
+  for( unsigned int i = 0; i < h.m_Count; ++i )
+  {
+    std::string stack;
+    for( unsigned int d = s[i].m_Depth < MAX_SAMPLE_DEPTH ? s[i].m_Depth : MAX_SAMPLE_DEPTH; d > 0; --d )
+    {
+      std::string frames = tree_frames( m, s[i].m_IP[d - 1] );
+      if( frames.empty() )
+        continue;
+      if( !stack.empty() )
+        stack += ";";
+      stack += frames;
+    }
+    ++stacks[stack.empty() ? std::string( "(outside the trees)" ) : stack];
+  }
+  for( StackCounts::const_iterator it = stacks.begin(); it != stacks.end(); ++it )
+    fprintf( f, "%s %u\n", it->first.c_str(), it->second );
+  *dropped = h.m_Dropped;
+  return !ferror( f );
+}
+
+static bool is_sample_dump( const char* data, unsigned int size )
+{
+  SampleDumpHeader h;
+  if( size < sizeof(SampleDumpHeader) )
+    return false;
+  memcpy( &h, data, sizeof(SampleDumpHeader) );
+  return h.m_Magic == SAMPLE_DUMP_MAGIC && h.m_Version == SAMPLE_DUMP_VERSION
+    && (size - sizeof(SampleDumpHeader)) / sizeof(Sample) >= h.m_Count;
+}
+
+int main( int argc, char** argv )
+{
+  GetOptContext ctx;
+  init_getopt_context( &ctx );
+  char c;
+  char* inputFileName = 0x0;
+  char* mapFileName = 0x0;
+  char* outputFileName = 0x0;
+
+  while( (c = getopt( argc, argv, "?i:m:o:", &ctx )) != -1 )
+  {
+    switch( c )
+    {
+    case 'i':
+      inputFileName = ctx.optarg;
+      break;
+    case 'm':
+      mapFileName = ctx.optarg;
+      break;
+    case 'o':
+      outputFileName = ctx.optarg;
+      break;
+    case ':':
+      print_usage();
+      return -1;
+      break;
+    case '?':
+      print_usage();
+      return 0;
+      break;
+    }
+  }
+
+  if( !inputFileName )
+  {
+    fprintf( stderr, "error: No input file given.\n" );
+    return -1;
+  }
+
+  unsigned int size = 0;
+  char* data = read_whole_file( inputFileName, &size );
+  const bool samples = data && is_sample_dump( data, size );
+  std::vector<TraceBlock> blocks;
+  if( !data || (!samples && read_dump( data, size, &blocks ) != 0) )
+  {
+    fprintf( stderr, "error: %s is not a trace or sample dump.\n", inputFileName );
+    free( data );
+    return -2;
+  }
+
+  NodeNames names;
+  char* map = 0x0;
+  const NodeMapHeader* m = 0x0;
+  if( mapFileName )
+  {
+    unsigned int map_size = 0;
+    map = read_whole_file( mapFileName, &map_size );
+    m = map ? check_node_map( map, map_size, 0x0 ) : 0x0;
+    if( !m )
+    {
+      fprintf( stderr, "error: %s is not a node map.\n", mapFileName );
+      free( data );
+      free( map );
+      return -3;
+    }
+    name_nodes( m, &names );
+  }
+
+  unsigned long long first = ~0ull;
+  unsigned int lost = 0;
+  for( size_t i = 0; i < blocks.size(); ++i )
+  {
+    lost += blocks[i].m_Header.m_Lost;
+    if( !blocks[i].m_Events.empty() && blocks[i].m_Events[0].m_Time < first )
+      first = blocks[i].m_Events[0].m_Time;
+  }
+
+  FILE* f = outputFileName ? fopen( outputFileName, "w" ) : stdout;
+  if( !f )
+  {
+    fprintf( stderr, "error: Unable to open output file %s for writing.\n", outputFileName );
+    free( data );
+    free( map );
+    return -4;
+  }
+
+  bool ok = true;
+  unsigned int dropped = 0;
+  if( samples )
+    ok = print_folded( f, data, m, &dropped );
+  else
+  {
+    bool comma = false;
+    fprintf( f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+    for( size_t i = 0; ok && i < blocks.size(); ++i )
+      ok = print_block( f, blocks[i], names, first, &comma );
+    fprintf( f, "\n]}\n" );
+    ok = ok && !ferror( f );
+  }
+  if( outputFileName )
+    fclose( f );
+  free( data );
+  free( map );
+
+  if( !ok )
+  {
+    fprintf( stderr, "error: Failed to write output file %s.\n",
+      outputFileName ? outputFileName : "stdout" );
+    return -5;
+  }
+  if( lost )
+    fprintf( stderr, "warning: %u events were lost before the dump was made.\n", lost );
+  if( dropped )
+    fprintf( stderr, "warning: %u samples did not fit in the buffer.\n", dropped );
+  return 0;
+}
@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_ARCHIVE_H_
+#define CALLBACK_ARCHIVE_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * Archives hold many compiled programs in one file, so all of them can be
+ * mapped at once and shared between processes. The file is an ArchiveHeader,
+ * then m_Count ArchiveEntries, then the programs. Every program starts on an
+ * ARCHIVE_ALIGNMENT boundary and is used in place, as CallbackProgram's
+ * m_Program, straight from the mapping.
+ *
+ * The header is stamped with ARCHIVE_MAGIC and ARCHIVE_VERSION and holds the
+ * checksum of the entries, each entry holds the checksum of its program. All
+ * of it is in the byte order of the target; ctc writes archives with -r.
+ */
+const unsigned int ARCHIVE_MAGIC     = 0x52415443; // "CTAR"
+const unsigned int ARCHIVE_VERSION   = 1;
+const unsigned int ARCHIVE_ALIGNMENT = 4096;
+const unsigned int ARCHIVE_NAME_SIZE = 48;
+
+struct ArchiveHeader
+{
+  unsigned int m_Magic;
+  unsigned int m_Version;
+  unsigned int m_Count;    // Number of programs
+  unsigned int m_Size;     // Size of the whole file
+  unsigned int m_Checksum; // archive_checksum of the entries
+};
+
+struct ArchiveEntry
+{
+  char         m_Name[ARCHIVE_NAME_SIZE]; // Null terminated
+  unsigned int m_Offset;   // From the start of the file, ARCHIVE_ALIGNMENT aligned
+  unsigned int m_Size;
+  unsigned int m_Checksum; // archive_checksum of the program
+  unsigned int m_Pad;
+};
+
+struct Archive;
+
+/*
+ * The checksum used for the entries and the programs, 32 bit FNV-1a.
+ */
+unsigned int archive_checksum( const void* data, unsigned int size );
+
+/*
+ * Maps the archive at "path" read-only. Returns null if it can not be opened
+ * or is not an archive of this version, or if the entries do not match their
+ * checksum or point outside the file. The programs are not read until used,
+ * see verify_archive.
+ */
+Archive* open_archive( const char* path );
+void close_archive( Archive* a );
+
+/*
+ * Checks every program against its checksum, which reads the whole archive.
+ * Returns the index of the first broken program or -1 if all are fine.
+ */
+int verify_archive( Archive* a );
+
+unsigned int get_archive_count( Archive* a );
+const char* get_archive_name( Archive* a, unsigned int index );
+
+/*
+ * The program at "index", ready to be put in CallbackProgram::m_Program. It
+ * stays valid until the archive is closed and must not be written to. Null if
+ * it fails check_program.
+ */
+void* get_archive_program( Archive* a, unsigned int index );
+
+/*
+ * The index of the program called "name", or -1 if there is none.
+ */
+int find_archive_program( Archive* a, const char* name );
+
+}
+
+#endif /* CALLBACK_ARCHIVE_H_ */
@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_BREAKPOINTS_H_
+#define CALLBACK_BREAKPOINTS_H_
+
+#include <callback/callback.h>
+#include <callback/instructions.h>
+#include <callback/nodemap.h>
+
+namespace callback
+{
+
+/*
+ * Breakpoints stop agents when the code of a node's action starts, without
+ * compiling the program again. The first breakpoint set makes a copy of the
+ * program, and each breakpoint replaces the first instruction of the node's
+ * code in the copy with INST_BREAKPOINT, at the entry the node map (ctc -m)
+ * gives for it. The program itself is never changed.
+ *
+ * Agents run with the copy in m_Program have the same bss layout and can
+ * move between the two between runs. When one gets to a breakpoint, its
+ * DebugHandler (if it has one) is given the node with E_BREAKPOINT set in the
+ * flags and m_IP pointing at the instruction, and then the instruction that
+ * was replaced is run. Nothing else is added to the code, agents that do not
+ * get to a breakpoint run as fast as with the program, natively too if
+ * E_CALLBACK_JIT is set.
+ *
+ * The copy has E_PROGRAM_BREAKPOINTS set in its header and knows its
+ * breakpoints, nothing is shared between the breakpoints of different
+ * copies. Breakpoints must only be set and cleared while no agent is running
+ * the copy. The C++ code ctc -c writes can not have breakpoints.
+ */
+struct Breakpoints;
+
+/*
+ * Breakpoints for "program" at the nodes of "map". Returns null if the map
+ * does not belong to the program.
+ */
+Breakpoints* create_breakpoints( void* program, const NodeMapHeader* map );
+void destroy_breakpoints( Breakpoints* bp );
+
+/*
+ * Sets a breakpoint at the start of the "action" code (ACT_CONSTRUCT,
+ * ACT_EXECUTE or ACT_DESTRUCT) of the node with the id "id". Returns false if
+ * there is no such node or code, or the copy of the program can not be made.
+ * Setting a breakpoint that is already set does nothing.
+ */
+bool set_breakpoint( Breakpoints* bp, unsigned int id, NodeAction action );
+
+/*
+ * Clears the breakpoint, putting the instruction back. Returns false if it
+ * was not set.
+ */
+bool clear_breakpoint( Breakpoints* bp, unsigned int id, NodeAction action );
+
+/*
+ * The copy of the program with the breakpoints in it. Until the first
+ * breakpoint is set there is no copy and this is the program itself.
+ */
+void* get_breakpoint_program( Breakpoints* bp );
+
+}
+
+#endif /* CALLBACK_BREAKPOINTS_H_ */
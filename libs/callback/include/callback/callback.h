@@ -26,6 +26,11 @@ enum InstructionSet
   INST_CALL_DEST_FUN, /* Make destruction callback                                */
   INST_CALL_PRUN_FUN, /* Make prune callback                                      */
   INST_CALL_MODI_FUN, /* Make modify callback                                     */
+  INST_FUSE_CONS_FUN, /* Construction callback m_A1, with B (m_A2) and D (m_A3)   */
+  INST_FUSE_EXEC_FUN, /* Execution callback m_A1, with B (m_A2) and D (m_A3)      */
+  INST_FUSE_DEST_FUN, /* Destruction callback m_A1, with B (m_A2) and D (m_A3)    */
+  INST_FUSE_PRUN_FUN, /* Prune callback m_A1, with B (m_A2) and D (m_A3)          */
+  INST_FUSE_MODI_FUN, /* Modify callback m_A1, with B (m_A2) and D (m_A3)         */
   INST_JABC_R_EQUA_C, /* Set IP to m_A1 when RE == m_A2                           */
   INST_JABC_R_DIFF_C, /* Set IP to m_A1 when RE != m_A2                           */
   INST_JABC_C_EQUA_B, /* Set IP to m_A1 when m_A2 == *m_A3                        */
@@ -47,21 +52,54 @@ enum InstructionSet
   INST__STORE_C_IN_B, /* Set *m_A1 to m_A2                                        */
   INST__STORE_B_IN_B, /* Set *m_A1 to *m_A2                                       */
   INST__STORE_C_IN_R, /* Set RE to m_A1                                           */
-  INST_STORE_PD_IN_B, /* Set B (m_A1) to pointer to D (m_A2)                      */
-  INST_STORE_PB_IN_R, /* Set R (m_A1) to pointer to B (m_A2)                      */
+  INST_STORE_PD_IN_B, /* Set B (m_A1) to the data offset m_A2                    */
+  INST_STORE_PB_IN_R, /* Set R (m_A1) to the bss offset of B (m_A2)               */
   INST__INC_BSSVALUE, /* Set *m_A1 += m_A2                                        */
   INST__DEC_BSSVALUE, /* Set *m_A1 -= m_A2                                        */
   INST__SET_REGISTRY, /* Set register m_A1 to the joined value of M_A2 & m_A3     */
-  INST_LOAD_REGISTRY, /* Set register m_A1 to data address of the joined value of M_A2 & m_A3 */
+  INST_LOAD_REGISTRY, /* Set register m_A1 to the data offset joined from M_A2 & m_A3 */
 
   INST_SCRIPT_C, /* */
   INST_SCRIPT_R, /* */
+  INST_SCRIPT_A, /* Set *m_A1 to a frame from the frame pool, if it is zero    */
+  INST_SCRIPT_P, /* Call m_A1 in the pooled frame *m_A2 with the command m_A3 */
+  INST_SCRIPT_F, /* Give the frame *m_A1 back to the frame pool, zero it      */
+  INST_COUNT_NODE, /* Count node B (m_A1, past the BssHeader) as CountMode m_A2  */
+  INST_TRACE_NODE, /* Trace event m_A1 of the node id joined from m_A2 & m_A3    */
+  INST_BREAKPOINT, /* Stop at a breakpoint, then run the instruction it replaced */
 
   INST_______SUSPEND, /* Halt execution                                           */
   MAXIMUM_INSTRUCTION_COUNT
 };
 
 typedef unsigned short VMIType;
+typedef unsigned int   WideVMIType;
+
+/*
+ * Operand value meaning "no operand", used by the fused callback instructions
+ * when a node has no bss or no variables.
+ */
+const VMIType     NO_OPERAND      = 0xffff;
+const WideVMIType WIDE_NO_OPERAND = 0xffffffff;
+
+/*
+ * Programs keep no pointers in the bss or the registers, only offsets, so an
+ * agent's bss can be copied or moved freely between runs. Pointers are made
+ * when a callback is called:
+ *
+ *  - A variable list is a count followed by one data section offset per
+ *    variable. It is in the data section, shared by all agents, and is passed
+ *    to callbacks as an array of pointers to the variables. It holds at most
+ *    MAX_CALLBACK_VARIABLES.
+ *  - Registers that refer to the bss hold the offset from the start of the
+ *    BssHeader, so zero means null.
+ *  - The variable list register of a callback and the debug registers hold
+ *    data section offsets.
+ *  - Frames from a frame pool are referred to by their offset in the pool,
+ *    with the top bit set. Agents using them are not self contained, their
+ *    bss can be moved but not copied.
+ */
+const unsigned int MAX_CALLBACK_VARIABLES = 32;
 
 struct Instruction
 {
@@ -71,28 +109,76 @@ struct Instruction
   VMIType m_A3;
 };
 
+/*
+ * The same instructions with 32 bit operands, for programs with more than
+ * 64K instructions or bss or data offsets past 64K. A program uses one or the
+ * other, as told by E_PROGRAM_WIDE; ctc only writes wide programs when the
+ * operands do not fit in an Instruction.
+ */
+struct WideInstruction
+{
+  WideVMIType m_I;
+  WideVMIType m_A1;
+  WideVMIType m_A2;
+  WideVMIType m_A3;
+};
+
+enum ProgramFlags
+{
+  E_PROGRAM_WIDE        = 1 << 0, // Made of WideInstructions
+  E_PROGRAM_COMPACT     = 1 << 1, // Compact encoded instructions, see compact.h
+  E_PROGRAM_BREAKPOINTS = 1 << 2  // The copy of a program with breakpoints, see breakpoints.h
+};
+
+/*
+ * Programs start with PROGRAM_MAGIC and the PROGRAM_VERSION they were
+ * compiled for. The version changes whenever the instruction set or the
+ * header does, as programs of another version decode to the wrong
+ * instructions.
+ */
+const unsigned int PROGRAM_MAGIC   = 0x47525043; // "CPRG"
+const unsigned int PROGRAM_VERSION = 2;
+
 struct ProgramHeader
 {
+  unsigned int m_Magic;
+  unsigned int m_Version;
   unsigned int m_IC; // Instruction COUNT
   unsigned int m_DS; // Data SIZE
   unsigned int m_BS; // .bss SIZE
+  unsigned int m_CC; // Callback COUNT
+  unsigned int m_CT; // Callback id TABLE, offset into the data section
+  unsigned int m_FS; // Pooled frame SIZE, zero if no tree is called in one
+  unsigned int m_FC; // Pooled frame COUNT, the most an agent can hold at once
+  unsigned int m_PF; // Program FLAGS, ProgramFlags bits
+  unsigned int m_CB; // Compact code BYTES, zero unless E_PROGRAM_COMPACT
+  unsigned int m_EC; // Entry point COUNT, zero unless linked by ctc -k
+  unsigned int m_ET; // Entry point TABLE, offset into the data section
+  unsigned int m_NC; // Counted node COUNT, zero unless ctc counts nodes
+  unsigned int m_NB; // Node counter block, bss offset from the BssHeader
+  unsigned int m_NS; // Node counter SIZE in bytes, of each node
+  unsigned int m_NT; // Node id TABLE of the counters, offset into the data section
+  unsigned int m_DC; // Debug scope COUNT, zero unless ctc was given debug_info
+  unsigned int m_DT; // Debug scope TABLE, offset into the data section
 };
 
 struct BssHeader
 {
   unsigned int m_IC; // Instruction Counter
   unsigned int m_IP; // Instruction Pointer
+  unsigned int m_FP; // Frame Pointer, offset of the current frame in .bss or the frame pool
   unsigned int m_RE; // Return value register
   unsigned int m_R[5]; // Program registers
 };
 
 struct CallFrame
 {
-  char* m_Bss;
-  int   m_IP;
+  unsigned int m_FP; // Frame Pointer of the caller
+  int          m_IP;
 };
 
 struct CallbackProgram;
+struct FramePool;
 
 enum DebugFlagBits
 {
@@ -100,7 +186,8 @@ enum DebugFlagBits
   E_STANDARD_NODE  = 1 << 4, // 1 bit
   E_COMPOSITE_NODE = 1 << 5, // 1 bit
   E_ENTER_SCOPE    = 1 << 6, // 1 bit
-  E_EXIT_SCOPE     = 1 << 7  // 1 bit
+  E_EXIT_SCOPE     = 1 << 7, // 1 bit
+  E_BREAKPOINT     = 1 << 8  // 1 bit, see breakpoints.h
 };
 
 bool act_flag_set( unsigned int, unsigned int );
@@ -118,11 +205,55 @@ struct DebugInformation
   unsigned int m_LineNo;
 };
 
+/*
+ * The node scopes a program compiled with debug_info enters and leaves are
+ * kept out of its code, in a table of m_DC DebugScopes sorted on m_IP,
+ * followed by a bitmap with one bit per instruction, set for the instructions
+ * that have scopes. A program run without a DebugHandler never looks at them.
+ * With one, the scopes of an instruction are passed to it in table order just
+ * before the instruction is executed, with m_IP of the BssHeader pointing at
+ * it. Such runs are always interpreted.
+ *
+ * Code that jumps to the first instruction of a node's code from within it
+ * has already entered the node, and code that jumps to the instruction after
+ * a node's code from outside it never was in the node, so a scope is only
+ * passed on if the instruction run before (the tree call, for a tree that
+ * returns) is outside of the code of the scope when entering it and inside of
+ * it when leaving it.
+ */
+struct DebugScope
+{
+  unsigned int m_IP;     // m_Begin when the scope is entered, m_End when it is left
+  unsigned int m_Begin;  // The code of the node's action, from m_Begin up to m_End
+  unsigned int m_End;
+  unsigned int m_NodeId;
+  unsigned int m_Flags;  // DebugFlagBits
+  unsigned int m_LineNo;
+  unsigned int m_Action; // Name of the action, offset into the data section
+  unsigned int m_Name;   // Name of the node, offset into the data section
+};
+
 typedef unsigned int (*CallbackHandler)( unsigned int id, unsigned int action, void* bss,
   void** data, void* user_data );
 typedef void (*DebugHandler)( CallbackProgram* cp, DebugInformation* di,
   BssHeader*, void* user_data );
 
+enum CallbackFlags
+{
+  E_CALLBACK_JIT = 1 << 0  /* Run the program as native code, see jit_compile */
+};
+
+/*
+ * If m_Table is set, callback number N of the program is made through
+ * m_Table[N] instead of m_Callback. The table must have one non-null entry
+ * per callback in the program; see get_callback_count and get_callback_id.
+ *
+ * m_Flags holds CallbackFlags bits.
+ *
+ * m_Frames is where the trees the program calls in pooled frames get their
+ * frames, see frames.h. An agent must always be run with the same pool. It
+ * can be null for programs that do not use one.
+ */
 struct CallbackProgram
 {
   void* m_Program;
@@ -130,10 +261,109 @@ struct CallbackProgram
   void* m_UserData;
   CallbackHandler m_Callback;
   DebugHandler m_Debug;
+  const CallbackHandler* m_Table;
+  unsigned int m_Flags;
+  FramePool* m_Frames;
 };
 
+/*
+ * A set of agents that all run the same program. The bss blocks are laid out
+ * back to back, m_Stride bytes apart, and m_UserData holds one user data
+ * pointer per agent (or is null, in which case callbacks get null).
+ */
+struct CallbackBatch
+{
+  void* m_Program;
+  void* m_bss;
+  void** m_UserData;
+  unsigned int m_Stride;
+  unsigned int m_Count;
+  CallbackHandler m_Callback;
+  DebugHandler m_Debug;
+  const CallbackHandler* m_Table;
+  unsigned int m_Flags;
+  FramePool* m_Frames;
+};
+
+/*
+ * True if the "size" bytes at "program" are a program of this version whose
+ * code and data fit in them, with no flags but E_PROGRAM_WIDE and
+ * E_PROGRAM_COMPACT. Programs read from files must be checked before they are
+ * run, run_program does not look.
+ */
+bool check_program( const void* program, unsigned int size );
+
 int run_program( CallbackProgram* info );
 
+/*
+ * Makes the debug callbacks of the "count" debug scopes "scopes", of a program
+ * with the data section "data", that are passed going from instruction "from"
+ * to instruction m_IP of the BssHeader of "info". What a debugged run does
+ * between two instructions, for the C++ code ctc -c writes.
+ */
+void call_debug_scopes( CallbackProgram* info, const DebugScope* scopes, unsigned int count,
+  const char* data, unsigned int from );
+
+enum RunStatus
+{
+  E_RUN_FINISHED, /* The program ran until it suspended                   */
+  E_RUN_YIELDED   /* The instruction budget ran out                       */
+};
+
+/*
+ * Like run_program, but executes at most "budget" instructions. If the budget
+ * runs out the program stops between two instructions and the next call, to
+ * either function, resumes exactly where it stopped. The return value of the
+ * tree is in the m_RE member of the BssHeader once it has finished. Budgeted
+ * runs are always interpreted.
+ */
+RunStatus run_program_budget( CallbackProgram* info, unsigned int budget );
+
+/*
+ * Runs every agent in the batch once, in order. Each agent's return value is
+ * left in the m_RE member of its BssHeader.
+ */
+void run_programs( CallbackBatch* batch );
+
+/*
+ * The callbacks a program makes are numbered densely from zero. These return
+ * the number of callbacks and the user-facing id of callback number "index",
+ * for building a table to put in CallbackProgram::m_Table.
+ */
+unsigned int get_callback_count( void* program );
+unsigned int get_callback_id( void* program, unsigned int index );
+
+/*
+ * Programs linked from several units by ctc -k have an entry point per unit,
+ * named after the unit. An agent runs entry point zero unless another one is
+ * picked for its bss with set_entry_point, which must be done before the
+ * agent's first run or once its tree has finished. Programs that are not
+ * linked have no entry points.
+ */
+unsigned int get_entry_count( void* program );
+const char* get_entry_name( void* program, unsigned int index );
+
+/*
+ * The index of the entry point called "name", or -1 if there is none.
+ */
+int find_entry_point( void* program, const char* name );
+void set_entry_point( CallbackProgram* info, unsigned int index );
+
+/*
+ * Translates a program to native code, for runs with E_CALLBACK_JIT set. The
+ * first such run compiles the program if this has not been called, which is
+ * not safe while other threads are running programs; call it when loading a
+ * program that is run on many threads. Returns false where there is no JIT
+ * (there is one for x86-64 with GCC) or the program calls trees in pooled
+ * frames, runs with the flag are interpreted then.
+ */
+bool jit_compile( void* program );
+
+/*
+ * Frees the native code of a program. Call it before freeing the program.
+ */
+void jit_release( void* program );
+
 }
 
 #endif /* CALLBACK_PROGRAM_H_ */
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_COMPACT_H_
+#define CALLBACK_COMPACT_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * The compact encoding of a program, E_PROGRAM_COMPACT. An instruction is
+ * one opcode byte followed by only the operands the instruction uses, each
+ * as a variable width integer: seven bits per byte, low bits first, the top
+ * bit set on all bytes but the last. Operands are stored plus one so that
+ * WIDE_NO_OPERAND is a single zero byte.
+ *
+ * The code section of a compact program is a table with the byte offset in
+ * the encoded code of every COMPACT_STRIDE'th instruction, one unsigned int
+ * each, followed by the ProgramHeader::m_CB bytes of encoded code padded to
+ * four bytes. The instruction pointer is still an instruction index; the
+ * table is only read when a program jumps or resumes, which then skips
+ * forward from the instruction in the table before it.
+ */
+
+const unsigned int COMPACT_STRIDE = 8;
+
+/*
+ * Entries in the offset table of a program of "ic" instructions.
+ */
+inline unsigned int compact_table_count( unsigned int ic )
+{
+  return ic / COMPACT_STRIDE + (ic % COMPACT_STRIDE != 0 ? 1 : 0);
+}
+
+/*
+ * The longest an encoded instruction can be, in bytes.
+ */
+const unsigned int COMPACT_MAX_SIZE = 16;
+
+/*
+ * How many of m_A1, m_A2 and m_A3 each instruction uses, in that order.
+ */
+extern const unsigned char g_CompactOperands[MAXIMUM_INSTRUCTION_COUNT];
+
+/*
+ * Encodes "inst" at "out", which must have room for COMPACT_MAX_SIZE bytes.
+ * Returns the number of bytes written.
+ */
+unsigned int compact_encode( const WideInstruction& inst, unsigned char* out );
+
+inline WideVMIType compact_operand( const unsigned char** in )
+{
+  const unsigned char* p = *in;
+  unsigned char b = *p++;
+  WideVMIType v = b;
+  //Most operands are a single byte
+  if( b & 0x80 )
+  {
+    v &= 0x7f;
+    unsigned int shift = 7;
+    do
+    {
+      b = *p++;
+      v |= ((WideVMIType)(b & 0x7f)) << shift;
+      shift += 7;
+    }
+    while( b & 0x80 );
+  }
+  *in = p;
+  return v - 1;
+}
+
+/*
+ * Decodes the instruction at "in" into "out", operands it does not use are
+ * zero. Returns where the next instruction starts.
+ */
+inline const unsigned char* compact_decode( const unsigned char* in, WideInstruction* out )
+{
+  const unsigned int op = *in++;
+  const unsigned int n  = g_CompactOperands[op];
+  out->m_I  = op;
+  out->m_A1 = n > 0 ? compact_operand( &in ) : 0;
+  out->m_A2 = n > 1 ? compact_operand( &in ) : 0;
+  out->m_A3 = n > 2 ? compact_operand( &in ) : 0;
+  return in;
+}
+
+/*
+ * Skips the operands of an "op" instruction, "in" is just past its opcode.
+ */
+inline const unsigned char* compact_skip( const unsigned char* in, unsigned int op )
+{
+  for( unsigned int n = g_CompactOperands[op]; n != 0; )
+  {
+    if( (*in++ & 0x80) == 0 )
+      --n;
+  }
+  return in;
+}
+
+}
+
+#endif /* CALLBACK_COMPACT_H_ */
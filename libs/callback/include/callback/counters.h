@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_COUNTERS_H_
+#define CALLBACK_COUNTERS_H_
+
+#include <callback/callback.h>
+#include <callback/platform.h>
+
+namespace callback
+{
+
+/*
+ * Programs compiled with the option (node_counters 1) keep counters for
+ * every node in the bss of each agent: how many times the node's execute
+ * code was entered and how many times it returned fail, success and working.
+ * A node that is working is entered again on each run it continues in. With
+ * (node_counters 2) the cycles spent in the execute code are counted too;
+ * they are read from the time stamp counter where there is one (x86 with GCC
+ * or MSVC) and stay zero elsewhere. Time spent outside the program while it
+ * is stopped by run_program_budget is counted, and a tree that calls itself
+ * counts the cycles of the innermost call only.
+ *
+ * The counters are zero in a new bss block and wrap at 2^32, except the cycle
+ * count. Reloading an agent (reload.h) starts its counters over.
+ */
+struct NodeCounters
+{
+  unsigned int m_Enter;     // Execute code entered
+  unsigned int m_Result[3]; // Returned E_NODE_FAIL, E_NODE_SUCCESS and E_NODE_WORKING
+  unsigned int m_Start;     // Time stamp when last entered, (node_counters 2) only
+  unsigned int m_Cycles[2]; // Low and high word of the cycles, (node_counters 2) only
+};
+
+/*
+ * Bytes of counters per node, without and with cycles.
+ */
+const unsigned int NODE_COUNTER_SIZE = sizeof(unsigned int) * 4;
+const unsigned int NODE_CYCLE_SIZE   = sizeof(NodeCounters);
+
+/*
+ * The m_A2 of INST_COUNT_NODE, E_COUNT_CYCLES is added to both when the node
+ * is timed.
+ */
+enum CountMode
+{
+  E_COUNT_ENTER  = 0,     // At the first instruction of the execute code
+  E_COUNT_RESULT = 1,     // After the last, where it returns with RE set
+  E_COUNT_CYCLES = 1 << 1
+};
+
+/*
+ * What INST_COUNT_NODE does, "re" is the return value register.
+ */
+inline void count_node( NodeCounters* c, unsigned int mode, unsigned int re )
+{
+  if( (mode & E_COUNT_RESULT) == 0 )
+  {
+    ++c->m_Enter;
+    if( mode & E_COUNT_CYCLES )
+      c->m_Start = (unsigned int)read_time_stamp();
+    return;
+  }
+  if( re < 3 )
+    ++c->m_Result[re];
+  if( mode & E_COUNT_CYCLES )
+  {
+    const unsigned int low = c->m_Cycles[0];
+    c->m_Cycles[0] += (unsigned int)read_time_stamp() - c->m_Start;
+    if( c->m_Cycles[0] < low )
+      ++c->m_Cycles[1];
+  }
+}
+
+/*
+ * Where the counters are in the bss of an agent. Programs compiled to C++ by
+ * ctc -c have a layout named after the function, <function>_counters.
+ */
+struct CounterLayout
+{
+  unsigned int        m_Count; // Counted nodes
+  unsigned int        m_Block; // bss offset of the first node's counters, from the BssHeader
+  unsigned int        m_Size;  // NODE_COUNTER_SIZE or NODE_CYCLE_SIZE
+  const unsigned int* m_Ids;   // The node id of each, as given to the debug handler
+};
+
+/*
+ * Fills "cl" in for "program". Returns false if the program has no counters.
+ */
+bool get_counter_layout( void* program, CounterLayout* cl );
+
+/*
+ * Counters summed over agents, one per counted node.
+ */
+struct NodeCounts
+{
+  unsigned long long m_Enter;
+  unsigned long long m_Result[3];
+  unsigned long long m_Cycles;
+};
+
+/*
+ * Adds the counters of the agent with the bss "bss" to "counts", which has
+ * room for m_Count nodes. Zero "counts" first to read a single agent.
+ */
+void add_node_counts( const CounterLayout* cl, const void* bss, NodeCounts* counts );
+
+/*
+ * Adds the counters of every agent in the batch to "counts".
+ */
+void add_batch_counts( const CounterLayout* cl, const CallbackBatch* batch,
+  NodeCounts* counts );
+
+/*
+ * Zeroes the counters of the agent with the bss "bss". The agent may be
+ * stopped part way through a run by run_program_budget.
+ */
+void clear_node_counters( const CounterLayout* cl, void* bss );
+
+}
+
+#endif /* CALLBACK_COUNTERS_H_ */
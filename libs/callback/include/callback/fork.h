@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_FORK_H_
+#define CALLBACK_FORK_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * An arena of bss blocks for agents that can be forked, to run a copy of an
+ * agent ahead speculatively and then either throw the copy away or make it
+ * the agent's new state. Each agent has room for one fork.
+ *
+ * A fork shares the agent's bss pages until it writes to them, so forking a
+ * range of agents costs one mapping rather than a copy, and a commit only
+ * copies the pages a fork changed. Every bss block takes whole pages, so this
+ * pays off for agents with a sizable bss. Sharing needs Linux, elsewhere
+ * forks are plain copies.
+ *
+ * An agent must not be run, or its bss changed, while it has a fork. Its
+ * pages are shared with it. Ranges of agents that go past the last agent of
+ * the arena are rejected: fork_agents returns null and the others do nothing.
+ */
+struct ForkArena;
+
+/*
+ * An arena of "agents" zeroed bss blocks for "program". Null if the program
+ * calls trees in pooled frames, see frames.h.
+ */
+ForkArena* create_fork_arena( void* program, unsigned int agents );
+void destroy_fork_arena( ForkArena* fa );
+
+/*
+ * The bss block of an agent. Both the agents' and the forks' blocks are
+ * get_fork_stride bytes apart, for running them as a CallbackBatch.
+ */
+void* get_agent_bss( ForkArena* fa, unsigned int agent );
+unsigned int get_fork_stride( ForkArena* fa );
+
+/*
+ * Forks "count" agents from "first" on, replacing any forks they had, and
+ * returns the bss block of the first fork, or null on failure. The forks are
+ * run like any agents.
+ */
+void* fork_agents( ForkArena* fa, unsigned int first, unsigned int count );
+
+/*
+ * Copies the state of the forks to their agents and frees the forks. Returns
+ * the number of pages copied.
+ */
+unsigned int commit_forks( ForkArena* fa, unsigned int first, unsigned int count );
+
+/*
+ * Frees the forks, leaving their agents as they were.
+ */
+void discard_forks( ForkArena* fa, unsigned int first, unsigned int count );
+
+}
+
+#endif /* CALLBACK_FORK_H_ */
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+
+#ifndef CALLBACK_FRAMES_H_
+#define CALLBACK_FRAMES_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * Frames for the trees a program calls with (tree 'name ((pooled true))).
+ * Such a call holds a frame from the pool from when the tree is constructed
+ * until it is destructed, and only a handle to it in the agent's bss. Agents
+ * that spend most of their time outside a large tree then only pay for the
+ * frame while they are in it.
+ *
+ * A pool can be shared by any number of agents running the same program, on
+ * any thread. It has room for get_frame_count frames per agent, so it never
+ * runs dry; where the system allows it memory is only committed for frames
+ * that have been used. If a tree can not get a frame anyway it fails.
+ */
+
+/*
+ * A pool for "agents" agents running "program". Null if the program calls
+ * no trees in pooled frames.
+ */
+FramePool* create_frame_pool( void* program, unsigned int agents );
+void destroy_frame_pool( FramePool* fp );
+
+/*
+ * Gives back every frame, for when all agents using the pool are reset.
+ */
+void reset_frame_pool( FramePool* fp );
+
+/*
+ * The number of frames currently held by agents.
+ */
+unsigned int get_frames_in_use( FramePool* fp );
+
+/*
+ * The size of a pooled frame of "program", and the most frames one agent can
+ * hold at once. Both are zero if the program has no pooled calls.
+ */
+unsigned int get_frame_size( void* program );
+unsigned int get_frame_count( void* program );
+
+}
+
+#endif /* CALLBACK_FRAMES_H_ */
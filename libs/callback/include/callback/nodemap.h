@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_NODEMAP_H_
+#define CALLBACK_NODEMAP_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * A node map describes the nodes of a compiled program: where each one keeps
+ * its state in the bss, where its code starts and which node every
+ * instruction belongs to. It is written next to the program by ctc -m and is
+ * not needed to run it.
+ *
+ * The map is a NodeMapHeader, then m_TC MapTrees, m_NC MapNodes, m_SC
+ * MapSlots, one node index per instruction of the program (MAP_NONE for the
+ * code that is not any node's), one NodeAction per instruction for the part
+ * of its node's code it is in (MAP_NONE wherever the node index is MAP_NONE)
+ * and m_SS bytes of null terminated strings. All of it is 32 bit words in the
+ * byte order of the target. Nodes are listed tree by tree, each tree in depth
+ * first order, so the children of a node follow it and a node's subtree ends
+ * at the first node that is not below it.
+ */
+const unsigned int NODE_MAP_MAGIC   = 0x504d4e43; // "CNMP"
+const unsigned int NODE_MAP_VERSION = 2;
+const unsigned int MAP_NONE         = 0xffffffff;
+
+struct NodeMapHeader
+{
+  unsigned int m_Magic;
+  unsigned int m_Version;
+  unsigned int m_IC; // Instruction COUNT of the program
+  unsigned int m_BS; // .bss SIZE of the program
+  unsigned int m_TC; // Tree COUNT, "main" first
+  unsigned int m_NC; // Node COUNT
+  unsigned int m_SC; // Slot COUNT
+  unsigned int m_SS; // String SIZE in bytes
+};
+
+/*
+ * The frame of "main" starts at MAP_MAIN_FRAME in the bss, after the state of
+ * the program (MAP_MAIN_STATE) and the call frame of the main tree.
+ */
+const unsigned int MAP_MAIN_STATE = 0;
+const unsigned int MAP_MAIN_FRAME = sizeof(int) + sizeof(CallFrame);
+
+struct MapTree
+{
+  unsigned int m_Name;  // String offset
+  unsigned int m_Root;  // Node index
+  unsigned int m_First; // First instruction
+};
+
+enum MapNodeType
+{
+  E_MAP_SEQUENCE,
+  E_MAP_SELECTOR,
+  E_MAP_PARALLEL,
+  E_MAP_DYN_SELECTOR,
+  E_MAP_SUCCEED,
+  E_MAP_FAIL,
+  E_MAP_WORK,
+  E_MAP_TREE,
+  E_MAP_ACTION,
+  E_MAP_DECORATOR
+};
+
+/*
+ * Which children of a running node are running too, and how it restarts.
+ */
+enum MapNodeFlags
+{
+  E_MAP_LIVE_ALL     = 1 << 0, // All of them
+  E_MAP_LIVE_ENTRY   = 1 << 1, // The one whose execute code starts at the IP in slot 0
+  E_MAP_LIVE_STATE   = 1 << 2, // Child N if word N of slot 1 is not E_NODE_UNDEFINED
+  E_MAP_RESTARTABLE  = 1 << 3  // Setting the slots to m_Reset is the same as constructing it
+};
+
+struct MapNode
+{
+  unsigned int m_Key;       // Stays the same when other parts of the tree are edited
+  unsigned int m_Signature; // Changes with the code and bss layout of the node
+  unsigned int m_Id;        // Node id, as given to the debug handler
+  unsigned int m_Type;      // MapNodeType
+  unsigned int m_Flags;     // MapNodeFlags
+  unsigned int m_Name;      // String offset, the action, decorator or tree name
+  unsigned int m_Line;
+  unsigned int m_Parent;    // Node index, MAP_NONE for the root of a tree
+  unsigned int m_Tree;      // Tree index
+  unsigned int m_Callee;    // Tree index of the tree called in slot 0, or MAP_NONE
+  unsigned int m_Entry[3];  // First instruction of the construct, execute and destruct code
+  unsigned int m_Slot;      // First slot
+  unsigned int m_SlotCount;
+};
+
+enum MapSlotKind
+{
+  E_MAP_SLOT_CODE,     // Instruction pointers, or m_Reset for none
+  E_MAP_SLOT_STATE,    // Values set by the node's code
+  E_MAP_SLOT_CALLBACK, // Bss of an action or decorator callback
+  E_MAP_SLOT_FRAME,    // The CallFrame of a tree call, only used during a run
+  E_MAP_SLOT_POOLED    // The handle of a frame from a frame pool
+};
+
+/*
+ * Bss a node keeps between runs. The offset is from the start of the frame of
+ * the tree the node is in.
+ */
+struct MapSlot
+{
+  unsigned int m_Offset;
+  unsigned int m_Size;
+  unsigned int m_Kind;  // MapSlotKind
+  unsigned int m_Reset; // Every word of the slot holds this once the node is constructed
+};
+
+/*
+ * Checks that "map" is a node map of this version, "size" bytes long, made for
+ * "program" (when it is set). Returns the map or null.
+ */
+const NodeMapHeader* check_node_map( const void* map, unsigned int size,
+  void* program );
+
+const MapTree* get_map_trees( const NodeMapHeader* m );
+const MapNode* get_map_nodes( const NodeMapHeader* m );
+const MapSlot* get_map_slots( const NodeMapHeader* m );
+const char* get_map_string( const NodeMapHeader* m, unsigned int offset );
+
+/*
+ * The index of the node instruction "ip" belongs to, or MAP_NONE.
+ */
+unsigned int get_map_owner( const NodeMapHeader* m, unsigned int ip );
+
+/*
+ * The NodeAction of the code instruction "ip" is part of, or MAP_NONE.
+ */
+unsigned int get_map_action( const NodeMapHeader* m, unsigned int ip );
+
+/*
+ * The index of the node with the id "id", or MAP_NONE.
+ */
+unsigned int find_map_node( const NodeMapHeader* m, unsigned int id );
+
+}
+
+#endif /* CALLBACK_NODEMAP_H_ */
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_PLATFORM_H_
+#define CALLBACK_PLATFORM_H_
+
+/*
+ * The compiler specific bits the callback and scheduler libraries share:
+ * THREAD_LOCAL, a spin lock and the time stamp counter. Not part of the
+ * interface of either, the inline functions of counters.h and trace.h use
+ * the time stamp counter.
+ */
+
+#if defined(MSVC)
+
+#include <intrin.h>
+
+#define THREAD_LOCAL __declspec(thread)
+
+namespace callback
+{
+
+typedef volatile long SpinLock;
+
+inline void spin_lock( SpinLock* l )
+{
+  while( _InterlockedExchange( l, 1 ) != 0 )
+    _mm_pause();
+}
+
+inline void spin_unlock( SpinLock* l )
+{
+  _InterlockedExchange( l, 0 );
+}
+
+}
+
+#elif defined(GCC)
+
+#define THREAD_LOCAL __thread
+
+namespace callback
+{
+
+typedef volatile int SpinLock;
+
+inline void spin_lock( SpinLock* l )
+{
+  while( __sync_lock_test_and_set( l, 1 ) != 0 )
+  {
+    while( *l != 0 )
+      ;
+  }
+}
+
+inline void spin_unlock( SpinLock* l )
+{
+  __sync_lock_release( l );
+}
+
+}
+
+#else
+#error "Compiler not supported."
+#endif
+
+namespace callback
+{
+
+/*
+ * The time stamp counter, zero where there is none (only x86 has one).
+ */
+inline unsigned long long read_time_stamp()
+{
+#if defined(GCC) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#elif defined(MSVC) && (defined(_M_X64) || defined(_M_IX86))
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+}
+
+#endif /* CALLBACK_PLATFORM_H_ */
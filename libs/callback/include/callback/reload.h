@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_RELOAD_H_
+#define CALLBACK_RELOAD_H_
+
+#include <callback/callback.h>
+#include <callback/nodemap.h>
+
+namespace callback
+{
+
+/*
+ * Reloading moves running agents to a program compiled from edited trees,
+ * keeping what they were doing. The node maps of both programs (ctc -m) are
+ * matched once, in a ReloadPlan, which then moves any number of agents.
+ *
+ * Nodes are matched by their place in the tree. The running nodes of an agent
+ * keep their bss if their code and layout are the same in both programs,
+ * with the instruction pointers they hold moved to the new code. A running
+ * node that changed is restarted: the closest sequence, selector or dynamic
+ * selector above it (or the node itself, if it is one of those and only its
+ * children changed) starts over from its first child. Nodes that are not
+ * running take no part, they are constructed before they run again. The
+ * nodes that are restarted are not destructed. If there is no node to
+ * restart, the agent is reset and starts over at the next run.
+ *
+ * Agents must be between runs; agents stopped by run_program_budget part
+ * way through a run are reset. Programs that call trees in pooled frames can
+ * not be reloaded, see frames.h.
+ */
+struct ReloadPlan;
+
+/*
+ * Matches the nodes of the two programs. Returns null if a map does not
+ * belong to its program or a program uses pooled frames. A plan is used by
+ * one thread at a time.
+ */
+ReloadPlan* create_reload( void* from, const NodeMapHeader* from_map,
+  void* to, const NodeMapHeader* to_map );
+void destroy_reload( ReloadPlan* rp );
+
+enum ReloadResult
+{
+  E_RELOAD_MIGRATED, /* All running nodes kept their state                  */
+  E_RELOAD_RESTARTED,/* Some nodes were restarted                           */
+  E_RELOAD_RESET     /* The agent starts over                               */
+};
+
+/*
+ * Writes the state the agent with the bss "from_bss" has in the new program
+ * to "to_bss", which may be the same block if it is large enough for both.
+ */
+ReloadResult reload_agent( ReloadPlan* rp, const void* from_bss, void* to_bss );
+
+/*
+ * Reloads every agent of the batch into blocks "stride" bytes apart starting
+ * at "bss", which may be the batch's own blocks if the stride stays the same,
+ * and points the batch at them and the new program. Returns the number of
+ * agents that were reset.
+ */
+unsigned int reload_batch( ReloadPlan* rp, CallbackBatch* batch, void* bss,
+  unsigned int stride );
+
+}
+
+#endif /* CALLBACK_RELOAD_H_ */
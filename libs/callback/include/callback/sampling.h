@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_SAMPLING_H_
+#define CALLBACK_SAMPLING_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * While sampling is on, a profiling timer (SIGPROF, Linux only) interrupts
+ * the threads of the process as they use the CPU and records what program
+ * each one is running, if any: the agent, its instruction pointer and the
+ * instruction pointers the trees it is in return to. With the node map of the
+ * program these turn into stacks of trees and nodes, which ctt writes as
+ * folded stacks for flame graphs.
+ *
+ * Programs need no option for this, any program run by this library can be
+ * sampled (the C++ code ctc -c writes can not). Running a program keeps a
+ * pointer to it in a thread local variable, tree calls keep the frame pointer
+ * of the BssHeader up to date and the JIT writes the instruction pointer
+ * before each callback; nothing else is done until a sample is taken.
+ */
+const unsigned int MAX_SAMPLE_DEPTH = 15;
+
+struct Sample
+{
+  unsigned long long m_Agent; // Address of the agent's bss
+  unsigned int m_Depth;       // Instruction pointers in m_IP
+  // The instruction after the one being run, then the instruction each of
+  // the tree calls it is in returns to, innermost first. The outermost calls
+  // are cut when there are more than MAX_SAMPLE_DEPTH.
+  unsigned int m_IP[MAX_SAMPLE_DEPTH];
+};
+
+struct SampleBuffer;
+
+/*
+ * A buffer for the first "samples" samples taken into it. Null if it can not
+ * be allocated.
+ */
+SampleBuffer* create_sample_buffer( unsigned int samples );
+void destroy_sample_buffer( SampleBuffer* sb );
+
+/*
+ * Starts sampling into "sb" every "interval" microseconds of CPU time used by
+ * the process. Returns false if sampling is already on or is not supported.
+ * The SIGPROF handler of the process is replaced until stop_sampling.
+ */
+bool start_sampling( SampleBuffer* sb, unsigned int interval );
+
+/*
+ * Stops sampling. Once it returns no more samples are written to the buffer.
+ */
+void stop_sampling();
+
+/*
+ * The samples in the buffer, and how many did not fit in it. Only valid while
+ * the buffer is not being sampled into.
+ */
+unsigned int get_sample_count( const SampleBuffer* sb );
+const Sample* get_samples( const SampleBuffer* sb );
+unsigned int get_samples_dropped( const SampleBuffer* sb );
+
+/*
+ * Fills "s" with what the calling thread is running. Returns false if it is
+ * not running a program. Safe to call from signal handlers.
+ */
+bool take_sample( Sample* s );
+
+/*
+ * The program the calling thread is running, innermost if a callback runs
+ * another, or null.
+ */
+CallbackProgram* get_running_program();
+
+/*
+ * A sample dump is a SampleDumpHeader followed by m_Count Samples, in the
+ * byte order of the machine that took them. ctt turns them into folded stacks.
+ */
+const unsigned int SAMPLE_DUMP_MAGIC   = 0x50534354; // "TCSP"
+const unsigned int SAMPLE_DUMP_VERSION = 1;
+
+struct SampleDumpHeader
+{
+  unsigned int m_Magic;
+  unsigned int m_Version;
+  unsigned int m_Count;    // Samples in the dump
+  unsigned int m_Dropped;  // Taken when the buffer was full
+  unsigned int m_Interval; // Microseconds of CPU time between samples
+  unsigned int m_Pad;
+};
+
+}
+
+#endif /* CALLBACK_SAMPLING_H_ */
@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_SNAPSHOT_H_
+#define CALLBACK_SNAPSHOT_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * Snapshots of agent state, for rollback and save games. A snapshot holds the
+ * BssHeader and the bss of one or more agents with runs of zero words left
+ * out. The registers are left out too when the agent is between runs, as
+ * they are always loaded before they are used. The bss holds no pointers, so
+ * a snapshot can be loaded into any bss block for the same program, but it is
+ * stored in the byte order of the host.
+ *
+ * Snapshots are stamped with SNAPSHOT_VERSION and with the instruction count
+ * and bss size of the program, and loading one that does not match fails.
+ * Snapshot buffers and bss blocks must be 4 byte aligned. Programs that call
+ * trees in pooled frames can not be snapshot, see frames.h.
+ */
+const unsigned int SNAPSHOT_VERSION = 1;
+
+/*
+ * The largest number of bytes a snapshot of "count" agents can take.
+ */
+unsigned int get_snapshot_bound( void* program, unsigned int count );
+
+/*
+ * Writes a snapshot of the agent in "info" (m_Program and m_bss are used) to
+ * "buffer". Returns the number of bytes written or -1 if it did not fit.
+ */
+int save_snapshot( CallbackProgram* info, void* buffer, unsigned int size );
+
+/*
+ * Restores the agent in "info" from a snapshot. Returns the number of bytes
+ * read or -1 if the snapshot is truncated, of another version or program,
+ * or of more than one agent.
+ */
+int load_snapshot( CallbackProgram* info, const void* buffer, unsigned int size );
+
+/*
+ * Like the above, for every agent in a batch at once.
+ */
+int save_snapshots( CallbackBatch* batch, void* buffer, unsigned int size );
+int load_snapshots( CallbackBatch* batch, const void* buffer, unsigned int size );
+
+}
+
+#endif /* CALLBACK_SNAPSHOT_H_ */
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_TRACE_H_
+#define CALLBACK_TRACE_H_
+
+#include <callback/callback.h>
+#include <callback/platform.h>
+
+namespace callback
+{
+
+/*
+ * Programs compiled with the option (node_trace 1) record an event when the
+ * execute code of a node is entered and left, and before and after each of
+ * its callbacks. The events go to the trace buffer of the thread running the
+ * program, threads without one skip them. Only that thread writes to the
+ * buffer, so recording takes no locks; it is a ring that keeps the newest
+ * events and it can be read by other threads while it is being written.
+ *
+ * Times are read from the time stamp counter where there is one (x86 with GCC
+ * or MSVC) and are zero elsewhere.
+ */
+enum TraceEventKind
+{
+  E_TRACE_ENTER,          // Execute code of the node entered
+  E_TRACE_EXIT,           // Left, with the result of the node in m_Result
+  E_TRACE_CALLBACK_BEGIN, // Before a callback of the node
+  E_TRACE_CALLBACK_END    // After it, with what it returned in m_Result
+};
+
+/*
+ * The m_A1 of INST_TRACE_NODE and the m_Kind of an event is the kind, with the
+ * NodeAction of callback events in the bits above it.
+ */
+const unsigned int TRACE_KIND_MASK    = 0xf;
+const unsigned int TRACE_ACTION_SHIFT = 4;
+
+struct TraceEvent
+{
+  unsigned long long m_Time;   // Time stamp counter
+  unsigned long long m_Agent;  // Address of the agent's bss
+  unsigned int       m_Id;     // Node id, as given to the debug handler
+  unsigned short     m_Kind;   // TraceEventKind and action
+  unsigned short     m_Result; // The return value register
+};
+
+struct TraceBuffer;
+
+/*
+ * A buffer that keeps the last "events" events, rounded up to a power of two.
+ * Returns null if it can not be allocated.
+ */
+TraceBuffer* create_trace_buffer( unsigned int events );
+void destroy_trace_buffer( TraceBuffer* tb );
+
+/*
+ * Sets the buffer the calling thread records to and returns the one it had.
+ * Null turns tracing off for the thread. A buffer may only be set on one
+ * thread at a time.
+ */
+TraceBuffer* set_trace_buffer( TraceBuffer* tb );
+TraceBuffer* get_trace_buffer();
+
+/*
+ * What INST_TRACE_NODE does, "re" is the return value register.
+ */
+void trace_node( BssHeader* bh, unsigned int id, unsigned int kind, unsigned int re );
+
+/*
+ * Copies up to "max" of the events recorded since "*cursor" to "out", oldest
+ * first, and moves "*cursor" past them. Events that were overwritten before
+ * they could be copied are skipped and added to "*lost", if it is set. May be
+ * called from any thread. A new reader starts with a cursor of zero.
+ */
+unsigned int read_trace( TraceBuffer* tb, unsigned int* cursor, TraceEvent* out,
+  unsigned int max, unsigned int* lost );
+
+/*
+ * A trace dump is any number of blocks, each a TraceDumpHeader followed by
+ * m_Count TraceEvents of one thread, in the byte order of the machine that
+ * recorded them. ctt turns dumps into JSON for chrome://tracing and Perfetto.
+ */
+const unsigned int TRACE_DUMP_MAGIC   = 0x52544354; // "TCTR"
+const unsigned int TRACE_DUMP_VERSION = 1;
+
+struct TraceDumpHeader
+{
+  unsigned int       m_Magic;
+  unsigned int       m_Version;
+  unsigned int       m_Thread;    // Any number, events of a thread are in order
+  unsigned int       m_Count;     // Events in the block
+  unsigned int       m_Lost;      // Overwritten before they were read
+  unsigned int       m_Pad;
+  unsigned long long m_Frequency; // Time stamp counter ticks per second, zero if unknown
+};
+
+}
+
+#endif /* CALLBACK_TRACE_H_ */
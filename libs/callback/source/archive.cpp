@@ -0,0 +1,222 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/archive.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(LINUX)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+#if defined(MSVC)
+  #include <windows.h>
+#endif
+
+namespace callback
+{
+
+/*
+ * Where there is no way to map files the archive is read into memory.
+ */
+struct Archive
+{
+  const char*         m_Memory;
+  unsigned int        m_Size;
+  const ArchiveEntry* m_Entries;
+  unsigned int        m_Count;
+#if defined(MSVC)
+  HANDLE              m_File;
+  HANDLE              m_Mapping;
+#endif
+};
+
+unsigned int archive_checksum( const void* data, unsigned int size )
+{
+  const unsigned char* p = (const unsigned char*)data;
+  unsigned int h = 2166136261u;
+  for( unsigned int i = 0; i < size; ++i )
+  {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static bool map_archive( Archive* a, const char* path )
+{
+#if defined(LINUX)
+  int fd = open( path, O_RDONLY );
+  if( fd < 0 )
+    return false;
+  struct stat st;
+  void* m = MAP_FAILED;
+  if( fstat( fd, &st ) == 0 && st.st_size >= (off_t)sizeof(ArchiveHeader) )
+  {
+    a->m_Size = (unsigned int)st.st_size;
+    m = mmap( 0x0, a->m_Size, PROT_READ, MAP_SHARED, fd, 0 );
+  }
+  //The mapping keeps the file
+  close( fd );
+  if( m == MAP_FAILED )
+    return false;
+  a->m_Memory = (const char*)m;
+  return true;
+#elif defined(MSVC)
+  a->m_File = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, 0x0,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0x0 );
+  if( a->m_File == INVALID_HANDLE_VALUE )
+    return false;
+  a->m_Size = GetFileSize( a->m_File, 0x0 );
+  a->m_Mapping = 0x0;
+  if( a->m_Size != INVALID_FILE_SIZE && a->m_Size >= sizeof(ArchiveHeader) )
+    a->m_Mapping = CreateFileMappingA( a->m_File, 0x0, PAGE_READONLY, 0, 0, 0x0 );
+  if( a->m_Mapping )
+    a->m_Memory = (const char*)MapViewOfFile( a->m_Mapping, FILE_MAP_READ, 0, 0, 0 );
+  if( !a->m_Memory )
+  {
+    if( a->m_Mapping )
+      CloseHandle( a->m_Mapping );
+    CloseHandle( a->m_File );
+    return false;
+  }
+  return true;
+#else
+  FILE* f = fopen( path, "rb" );
+  if( !f )
+    return false;
+  fseek( f, 0, SEEK_END );
+  a->m_Size = (unsigned int)ftell( f );
+  fseek( f, 0, SEEK_SET );
+  char* m = 0x0;
+  if( a->m_Size >= sizeof(ArchiveHeader) )
+    m = (char*)malloc( a->m_Size );
+  if( m && fread( m, 1, a->m_Size, f ) != a->m_Size )
+  {
+    free( m );
+    m = 0x0;
+  }
+  fclose( f );
+  a->m_Memory = m;
+  return m != 0x0;
+#endif
+}
+
+static void unmap_archive( Archive* a )
+{
+#if defined(LINUX)
+  munmap( (void*)a->m_Memory, a->m_Size );
+#elif defined(MSVC)
+  UnmapViewOfFile( a->m_Memory );
+  CloseHandle( a->m_Mapping );
+  CloseHandle( a->m_File );
+#else
+  free( (void*)a->m_Memory );
+#endif
+}
+
+static bool valid_archive( const Archive* a )
+{
+  const ArchiveHeader* h = (const ArchiveHeader*)a->m_Memory;
+  if( h->m_Magic != ARCHIVE_MAGIC || h->m_Version != ARCHIVE_VERSION
+    || h->m_Size != a->m_Size )
+    return false;
+
+  const unsigned int index = sizeof(ArchiveHeader) + sizeof(ArchiveEntry) * h->m_Count;
+  if( h->m_Count > a->m_Size / sizeof(ArchiveEntry) || index > a->m_Size )
+    return false;
+  if( archive_checksum( h + 1, index - sizeof(ArchiveHeader) ) != h->m_Checksum )
+    return false;
+
+  const ArchiveEntry* e = (const ArchiveEntry*)(h + 1);
+  for( unsigned int i = 0; i < h->m_Count; ++i )
+  {
+    if( e[i].m_Offset % ARCHIVE_ALIGNMENT != 0 || e[i].m_Offset < index
+      || e[i].m_Offset > a->m_Size || e[i].m_Size > a->m_Size - e[i].m_Offset
+      || e[i].m_Size < sizeof(ProgramHeader)
+      || e[i].m_Name[ARCHIVE_NAME_SIZE - 1] != 0 )
+      return false;
+  }
+  return true;
+}
+
+Archive* open_archive( const char* path )
+{
+  Archive* a = new Archive;
+  memset( a, 0, sizeof(Archive) );
+  if( !map_archive( a, path ) )
+  {
+    delete a;
+    return 0x0;
+  }
+  if( !valid_archive( a ) )
+  {
+    unmap_archive( a );
+    delete a;
+    return 0x0;
+  }
+  a->m_Count   = ((const ArchiveHeader*)a->m_Memory)->m_Count;
+  a->m_Entries = (const ArchiveEntry*)(a->m_Memory + sizeof(ArchiveHeader));
+  return a;
+}
+
+void close_archive( Archive* a )
+{
+  if( !a )
+    return;
+  unmap_archive( a );
+  delete a;
+}
+
+int verify_archive( Archive* a )
+{
+  for( unsigned int i = 0; i < a->m_Count; ++i )
+  {
+    const ArchiveEntry& e = a->m_Entries[i];
+    if( archive_checksum( a->m_Memory + e.m_Offset, e.m_Size ) != e.m_Checksum )
+      return (int)i;
+  }
+  return -1;
+}
+
+unsigned int get_archive_count( Archive* a )
+{
+  return a->m_Count;
+}
+
+const char* get_archive_name( Archive* a, unsigned int index )
+{
+  return a->m_Entries[index].m_Name;
+}
+
+void* get_archive_program( Archive* a, unsigned int index )
+{
+  const ArchiveEntry& e = a->m_Entries[index];
+  void* program = (void*)(a->m_Memory + e.m_Offset);
+  return check_program( program, e.m_Size ) ? program : 0x0;
+}
+
+int find_archive_program( Archive* a, const char* name )
+{
+  for( unsigned int i = 0; i < a->m_Count; ++i )
+  {
+    if( strcmp( a->m_Entries[i].m_Name, name ) == 0 )
+      return (int)i;
+  }
+  return -1;
+}
+
+}
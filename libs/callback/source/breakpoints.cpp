@@ -0,0 +1,279 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/breakpoints.h>
+#include <callback/compact.h>
+
+#include "resolve.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace callback
+{
+
+struct Breakpoint
+{
+  unsigned int    m_Id;
+  unsigned int    m_Action;
+  unsigned int    m_Node; // Index in the node map
+  unsigned int    m_IP;
+  WideInstruction m_Replaced;
+};
+
+struct Breakpoints
+{
+  void*                m_Program;
+  const NodeMapHeader* m_Map;
+  char*                m_Copy;
+  Breakpoint*          m_Set;
+  unsigned int         m_Count;
+  unsigned int         m_Capacity;
+};
+
+/*
+ * The copy has E_PROGRAM_BREAKPOINTS set and its Breakpoints just in front of
+ * it, where an agent that gets to a breakpoint or the JIT finds them. Nothing
+ * is shared between the copies of different Breakpoints.
+ */
+const unsigned int COPY_PREFIX = 16;
+
+static const char* const g_ActionNames[3] =
+{
+  "CONSTRUCT",
+  "EXECUTE",
+  "DESTRUCT"
+};
+
+static Breakpoints* find_copy( const void* program )
+{
+  if( (((const ProgramHeader*)program)->m_PF & E_PROGRAM_BREAKPOINTS) == 0 )
+    return 0x0;
+  return *((Breakpoints* const*)program - 1);
+}
+
+static unsigned int program_size( const ProgramHeader* ph )
+{
+  return sizeof(ProgramHeader) + get_code_size( ph ) + ph->m_DS;
+}
+
+/*
+ * Where the opcode of instruction "ip" is, and the instruction as it is in
+ * "program". Only the opcode is replaced by a breakpoint, so compact code
+ * keeps its offsets.
+ */
+static char* opcode_at( char* program, unsigned int ip, WideInstruction* wi )
+{
+  const ProgramHeader* ph = (const ProgramHeader*)program;
+  char* code = program + sizeof(ProgramHeader);
+  if( ph->m_PF & E_PROGRAM_COMPACT )
+  {
+    const unsigned int* offsets = (const unsigned int*)code;
+    const unsigned char* at = compact_seek( ph, offsets,
+      (const unsigned char*)(offsets + compact_table_count( ph->m_IC )), ip );
+    compact_decode( at, wi );
+    return (char*)at;
+  }
+  if( ph->m_PF & E_PROGRAM_WIDE )
+  {
+    WideInstruction* i = (WideInstruction*)code + ip;
+    *wi = *i;
+    return (char*)&i->m_I;
+  }
+  Instruction* i = (Instruction*)code + ip;
+  wi->m_I  = i->m_I;
+  wi->m_A1 = i->m_A1;
+  wi->m_A2 = i->m_A2;
+  wi->m_A3 = i->m_A3;
+  return (char*)&i->m_I;
+}
+
+/*
+ * Writes "opcode" over the opcode of instruction "ip" of the copy, which is
+ * where it is in the program.
+ */
+static void patch_opcode( Breakpoints* bp, unsigned int ip, unsigned int opcode )
+{
+  const ProgramHeader* ph = (const ProgramHeader*)bp->m_Copy;
+  WideInstruction wi;
+  char* at = bp->m_Copy + (opcode_at( (char*)bp->m_Program, ip, &wi ) - (char*)bp->m_Program);
+  if( ph->m_PF & E_PROGRAM_COMPACT )
+    *(unsigned char*)at = (unsigned char)opcode;
+  else if( ph->m_PF & E_PROGRAM_WIDE )
+    *(WideVMIType*)at = opcode;
+  else
+    *(VMIType*)at = (VMIType)opcode;
+}
+
+static bool ip_has_breakpoint( const Breakpoints* bp, unsigned int ip )
+{
+  for( unsigned int i = 0; i < bp->m_Count; ++i )
+  {
+    if( bp->m_Set[i].m_IP == ip )
+      return true;
+  }
+  return false;
+}
+
+static Breakpoint* find_set( Breakpoints* bp, unsigned int id, unsigned int action )
+{
+  for( unsigned int i = 0; i < bp->m_Count; ++i )
+  {
+    if( bp->m_Set[i].m_Id == id && bp->m_Set[i].m_Action == action )
+      return &bp->m_Set[i];
+  }
+  return 0x0;
+}
+
+/*
+ * The copy is made the first time a breakpoint is set and lives as long as
+ * the breakpoints do, agents may be left pointing at it.
+ */
+static bool make_copy( Breakpoints* bp )
+{
+  if( bp->m_Copy )
+    return true;
+  const unsigned int size = program_size( (const ProgramHeader*)bp->m_Program );
+  char* block = (char*)malloc( COPY_PREFIX + size );
+  if( !block )
+    return false;
+  bp->m_Copy = block + COPY_PREFIX;
+  memcpy( bp->m_Copy, bp->m_Program, size );
+  *((Breakpoints**)bp->m_Copy - 1) = bp;
+  ((ProgramHeader*)bp->m_Copy)->m_PF |= E_PROGRAM_BREAKPOINTS;
+  return true;
+}
+
+Breakpoints* create_breakpoints( void* program, const NodeMapHeader* map )
+{
+  const ProgramHeader* ph = (const ProgramHeader*)program;
+  if( !program || !map || ph->m_IC != map->m_IC || ph->m_BS != map->m_BS )
+    return 0x0;
+  Breakpoints* bp = (Breakpoints*)malloc( sizeof(Breakpoints) );
+  if( !bp )
+    return 0x0;
+  memset( bp, 0, sizeof(Breakpoints) );
+  bp->m_Program = program;
+  bp->m_Map     = map;
+  return bp;
+}
+
+void destroy_breakpoints( Breakpoints* bp )
+{
+  if( !bp )
+    return;
+  if( bp->m_Copy )
+  {
+    jit_release( bp->m_Copy );
+    free( bp->m_Copy - COPY_PREFIX );
+  }
+  free( bp->m_Set );
+  free( bp );
+}
+
+bool set_breakpoint( Breakpoints* bp, unsigned int id, NodeAction action )
+{
+  if( action > ACT_DESTRUCT )
+    return false;
+  if( find_set( bp, id, action ) )
+    return true;
+  const unsigned int node = find_map_node( bp->m_Map, id );
+  if( node == MAP_NONE )
+    return false;
+  const unsigned int ip = get_map_nodes( bp->m_Map )[node].m_Entry[action];
+  if( ip >= bp->m_Map->m_IC || !make_copy( bp ) )
+    return false;
+
+  if( bp->m_Count == bp->m_Capacity )
+  {
+    const unsigned int capacity = bp->m_Capacity ? bp->m_Capacity * 2 : 8;
+    Breakpoint* set = (Breakpoint*)realloc( bp->m_Set, sizeof(Breakpoint) * capacity );
+    if( !set )
+      return false;
+    bp->m_Set      = set;
+    bp->m_Capacity = capacity;
+  }
+
+  Breakpoint& b = bp->m_Set[bp->m_Count];
+  b.m_Id     = id;
+  b.m_Action = action;
+  b.m_Node   = node;
+  b.m_IP     = ip;
+  opcode_at( (char*)bp->m_Program, ip, &b.m_Replaced );
+  if( !ip_has_breakpoint( bp, ip ) )
+  {
+    patch_opcode( bp, ip, INST_BREAKPOINT );
+    jit_release( bp->m_Copy );
+  }
+  ++bp->m_Count;
+  return true;
+}
+
+bool clear_breakpoint( Breakpoints* bp, unsigned int id, NodeAction action )
+{
+  Breakpoint* b = find_set( bp, id, action );
+  if( !b )
+    return false;
+  const unsigned int ip = b->m_IP;
+  *b = bp->m_Set[--bp->m_Count];
+  if( !ip_has_breakpoint( bp, ip ) )
+  {
+    WideInstruction wi;
+    opcode_at( (char*)bp->m_Program, ip, &wi );
+    patch_opcode( bp, ip, wi.m_I );
+    jit_release( bp->m_Copy );
+  }
+  return true;
+}
+
+void* get_breakpoint_program( Breakpoints* bp )
+{
+  return bp->m_Copy ? bp->m_Copy : bp->m_Program;
+}
+
+const WideInstruction* find_breakpoint( const void* program, unsigned int ip )
+{
+  Breakpoints* bp = find_copy( program );
+  if( !bp )
+    return 0x0;
+  for( unsigned int i = 0; i < bp->m_Count; ++i )
+  {
+    if( bp->m_Set[i].m_IP == ip )
+      return &bp->m_Set[i].m_Replaced;
+  }
+  return 0x0;
+}
+
+void call_breakpoints( CallbackProgram* info, const void* program )
+{
+  Breakpoints* bp = find_copy( program );
+  if( !bp || !info->m_Debug )
+    return;
+  BssHeader* bh = (BssHeader*)info->m_bss;
+  const MapNode* nodes = get_map_nodes( bp->m_Map );
+  for( unsigned int i = 0; i < bp->m_Count; ++i )
+  {
+    const Breakpoint& b = bp->m_Set[i];
+    if( b.m_IP != bh->m_IP )
+      continue;
+    const MapNode& n = nodes[b.m_Node];
+    const bool composite = n.m_Type <= E_MAP_DYN_SELECTOR;
+    DebugInformation di;
+    di.m_Action = g_ActionNames[b.m_Action];
+    di.m_Name   = get_map_string( bp->m_Map, n.m_Name );
+    di.m_NodeId = b.m_Id;
+    di.m_Flags  = b.m_Action | E_BREAKPOINT | (composite ? E_COMPOSITE_NODE : E_STANDARD_NODE);
+    di.m_LineNo = n.m_Line;
+    info->m_Debug( info, &di, bh, info->m_UserData );
+  }
+}
+
+}
@@ -11,10 +11,28 @@
 
 #include <callback/callback.h>
 #include <callback/instructions.h>
+#include <callback/compact.h>
+#include <callback/counters.h>
+#include <callback/trace.h>
+#include <callback/sampling.h>
+#include <callback/platform.h>
+
+#include "jit.h"
+#include "resolve.h"
+
+#include <string.h>
 
 namespace callback
 {
 
+//What the thread is running, for the sampler
+static THREAD_LOCAL CallbackProgram* g_Running = 0x0;
+
+CallbackProgram* get_running_program()
+{
+  return g_Running;
+}
+
 bool act_flag_set( unsigned int f, unsigned int a )
 {
   return ((unsigned int)(f & 0x000f)) == a;
@@ -49,185 +67,779 @@ bool ent_flag_set( unsigned int f )
   #define CHECKED_IP_ADDITION( X ) { bh->m_IP += X; }
 #endif
 
+/*
+ * Instruction dispatch.
+ *
+ * With GCC we use "labels as values" to build a direct-threaded interpreter,
+ * every handler ends with its own indirect jump to the next handler. That
+ * gives the branch predictor one jump site per instruction instead of the
+ * single shared jump of a switch. Define CALLBACK_SWITCH_DISPATCH to force
+ * the portable switch based dispatch.
+ */
 
-int run_program( CallbackProgram* info )
+#if defined(GCC) && !defined(CALLBACK_SWITCH_DISPATCH)
+  #define CALLBACK_THREADED_DISPATCH
+#endif
+
+#if defined(GCC)
+  #define CALLBACK_PREFETCH( X ) __builtin_prefetch( (X) )
+#else
+  #define CALLBACK_PREFETCH( X )
+#endif
+
+/*
+ * When DEBUGGED, pass the debug scopes of an instruction to the debug handler
+ * before it is executed, unless it is the first of the run; a run that is
+ * resumed has done so before it stopped. When BUDGETED, stop at the
+ * instruction boundary once the budget is spent.
+ */
+#define VM_FETCH() { if( DEBUGGED ) { \
+    if( from != NO_IP && has_debug_scopes( scope_bits, bh->m_IP ) ) { \
+      call_debug_scopes( info, debug_scopes( pi ), pi.m_Header->m_DC, data, from ); } \
+    from = bh->m_IP; } \
+  if( BUDGETED ) { if( budget == 0 ) goto yield; --budget; } \
+  inst = code.Fetch( bh->m_IP ); ++bh->m_IP; ++bh->m_IC; }
+
+/*
+ * Operand decoding for the fused callback instructions. m_A1 is the callback
+ * index, the callback's memory is a bss offset and its variable list a data
+ * section offset, with NO_OPERAND (WIDE_NO_OPERAND) meaning a null pointer.
+ */
+static inline bool no_operand( VMIType x )
+{
+  return x == NO_OPERAND;
+}
+
+static inline bool no_operand( WideVMIType x )
+{
+  return x == WIDE_NO_OPERAND;
+}
+
+#define FUSED_BSS( X ) (no_operand( X ) ? 0x0 : (void*)&(bss[(X)]))
+#define FUSED_VARS( X ) (no_operand( X ) ? 0x0 : resolve_variables( &(data[(X)]), data, vars ))
+#define FUSED_CALL( ACTION ) (tab ? tab[inst->m_A1] : ch)( ids[inst->m_A1], \
+  (ACTION), FUSED_BSS( inst->m_A2 ), FUSED_VARS( inst->m_A3 ), \
+  info->m_UserData )
+
+/*
+ * Operand decoding for the register based callback instructions. The memory
+ * register holds a bss offset and the variable register a data section
+ * offset, as loaded by INST_LOAD_REGISTRY.
+ */
+#define REGISTER_VARS( X ) (bh->m_R[(X)] ? resolve_variables( \
+  &(data[bh->m_R[(X)]]), data, vars ) : 0x0)
+#define REGISTER_CALL( ACTION ) ch( bh->m_R[inst->m_A1], (ACTION), \
+  resolve_register( bh, pool, bh->m_R[inst->m_A2] ), REGISTER_VARS( inst->m_A3 ), \
+  info->m_UserData )
+
+/*
+ * The address of the frame at frame pointer X, in the bss or the frame pool.
+ */
+#define FRAME_ADDRESS( X ) (((X) & POOLED_FRAME) ? pool + ((X) & ~POOLED_FRAME) : base + (X))
+
+#if defined(CALLBACK_THREADED_DISPATCH)
+  #define VM_BEGIN() VM_FETCH() goto *s_Dispatch[inst->m_I];
+  #define VM_CASE( X ) L_##X:
+  #define VM_NEXT() VM_FETCH() goto *s_Dispatch[inst->m_I];
+  #define VM_DISPATCH() goto *s_Dispatch[inst->m_I];
+  #define VM_END()
+#else
+  #define VM_BEGIN() start: VM_FETCH() dispatch: switch( inst->m_I ) {
+  #define VM_CASE( X ) case X:
+  #define VM_NEXT() goto start;
+  #define VM_DISPATCH() goto dispatch;
+  #define VM_END() } goto start;
+#endif
+
+/*
+ * The parts of a program image that are the same for every agent running it.
+ */
+struct ProgramImage
+{
+  ProgramHeader* m_Header;
+  char*          m_Inst;  // Instructions, WideInstructions or compact code
+  char*          m_Data;
+  unsigned int*  m_Ids;
+};
+
+unsigned int get_code_size( const ProgramHeader* ph )
+{
+  if( ph->m_PF & E_PROGRAM_COMPACT )
+    return compact_table_count( ph->m_IC ) * sizeof(unsigned int) + ((ph->m_CB + 3) & ~3);
+  if( ph->m_PF & E_PROGRAM_WIDE )
+    return ph->m_IC * sizeof(WideInstruction);
+  return ph->m_IC * sizeof(Instruction);
+}
+
+static void decode_image( void* program, ProgramImage* pi )
+{
+  pi->m_Header = (ProgramHeader*)(program);
+  pi->m_Inst   = (char*)(program) + sizeof(ProgramHeader);
+  pi->m_Data   = pi->m_Inst + get_code_size( pi->m_Header );
+  pi->m_Ids    = (unsigned int*)(pi->m_Data + pi->m_Header->m_CT);
+}
+
+// No instruction has been run yet
+static const unsigned int NO_IP = 0xffffffff;
+
+static inline const DebugScope* debug_scopes( const ProgramImage& pi )
+{
+  return (const DebugScope*)(pi.m_Data + pi.m_Header->m_DT);
+}
+
+static inline const unsigned int* debug_scope_bits( const ProgramImage& pi )
+{
+  return (const unsigned int*)(debug_scopes( pi ) + pi.m_Header->m_DC);
+}
+
+static inline bool has_debug_scopes( const unsigned int* bits, unsigned int ip )
 {
-  ProgramHeader* ph = (ProgramHeader*)(info->m_Program);
-  Instruction* i = (Instruction*)((char*)(info->m_Program)
-      + sizeof(ProgramHeader));
-  char* bss = (char*)(info->m_bss) + sizeof(BssHeader);
-  char* data = ((char*)(i)) + (sizeof(Instruction) * ph->m_IC);
+  return ((bits[ip >> 5] >> (ip & 31)) & 1) != 0;
+}
+
+/*
+ * True if the run must pass the program's debug scopes to a debug handler.
+ */
+static inline bool debugged( const CallbackProgram* info, const ProgramHeader* ph )
+{
+  return info->m_Debug != 0x0 && ph->m_DC != 0;
+}
+
+/*
+ * Instruction fetch for programs of Instructions or WideInstructions.
+ */
+template<typename INST>
+struct ArrayCode
+{
+  typedef INST Inst;
+
+  ArrayCode( const ProgramImage& pi )
+    : m_Inst( (const INST*)pi.m_Inst )
+  {}
+
+  inline const INST* Fetch( unsigned int ip )
+  {
+    return &m_Inst[ip];
+  }
+
+  inline void Jumped()
+  {
+  }
+
+  const INST* m_Inst;
+};
+
+const unsigned char* compact_seek( const ProgramHeader* ph, const unsigned int* offsets,
+  const unsigned char* code, unsigned int ip )
+{
+  const unsigned char* pc = code + offsets[ip / COMPACT_STRIDE];
+  for( unsigned int at = ip - ip % COMPACT_STRIDE; at != ip; ++at )
+  {
+    unsigned int op = *pc++;
+    if( op == INST_BREAKPOINT )
+    {
+      const WideInstruction* w = find_breakpoint( ph, at );
+      op = w ? w->m_I : INST_BREAKPOINT;
+    }
+    pc = compact_skip( pc, op );
+  }
+  return pc;
+}
+
+/*
+ * Instruction fetch for compact programs. Instructions are decoded one at a
+ * time, in order, and the offset table is only read when the instruction
+ * pointer is not the one after the last fetched.
+ */
+struct CompactCode
+{
+  typedef WideInstruction Inst;
+
+  CompactCode( const ProgramImage& pi )
+    : m_Header( pi.m_Header )
+    , m_Offsets( (const unsigned int*)pi.m_Inst )
+    , m_Code( (const unsigned char*)(m_Offsets + compact_table_count( pi.m_Header->m_IC )) )
+    , m_PC( m_Code )
+    , m_Next( 0xffffffff )
+  {}
+
+  inline const WideInstruction* Fetch( unsigned int ip )
+  {
+    if( ip != m_Next )
+      m_PC = compact_seek( m_Header, m_Offsets, m_Code, ip );
+    m_PC   = compact_decode( m_PC, &m_Decoded );
+    m_Next = ip + 1;
+    return &m_Decoded;
+  }
+
+  // The next fetch is not where the last one ended
+  inline void Jumped()
+  {
+    m_Next = 0xffffffff;
+  }
+
+  const ProgramHeader* m_Header;
+  const unsigned int*  m_Offsets;
+  const unsigned char* m_Code;
+  const unsigned char* m_PC;
+  unsigned int         m_Next;
+  WideInstruction      m_Decoded;
+};
+
+/*
+ * Runs until the program suspends, or until "budget" instructions have been
+ * executed if BUDGETED. Returns true if the program suspended. CODE fetches
+ * the instructions in the program's format. DEBUGGED runs make the debug
+ * callbacks of the program's debug scopes.
+ */
+template<bool BUDGETED, bool DEBUGGED, typename CODE>
+static bool interpret( CallbackProgram* info, const ProgramImage& pi, unsigned int budget )
+{
+#ifdef SPU
+  ProgramHeader* ph = pi.m_Header;
+#endif
+  CODE code( pi );
+  char* data = pi.m_Data;
+  const unsigned int* ids = pi.m_Ids;
   BssHeader* bh = (BssHeader*)info->m_bss;
+  char* const base = (char*)(info->m_bss) + sizeof(BssHeader);
+  char* const pool = get_frame_memory( info->m_Frames );
+  unsigned int fp = bh->m_FP;
+  char* bss = FRAME_ADDRESS( fp );
   CallbackHandler ch = info->m_Callback;
-  DebugHandler dh = info->m_Debug;
+  const CallbackHandler* tab = info->m_Table;
+  const unsigned int* scope_bits = DEBUGGED ? debug_scope_bits( pi ) : 0x0;
+  unsigned int from = NO_IP; // The instruction run before, when DEBUGGED
+  const typename CODE::Inst* inst;
+  typename CODE::Inst replaced; // Of a breakpoint, see breakpoints.h
+  void* vars[MAX_CALLBACK_VARIABLES];
 
-  start:
-  const Instruction& inst = i[bh->m_IP];
-  ++bh->m_IP;
-  ++bh->m_IC;
-  switch( inst.m_I )
+#if defined(CALLBACK_THREADED_DISPATCH)
+  /* Must be kept in the same order as InstructionSet */
+  static const void* const s_Dispatch[MAXIMUM_INSTRUCTION_COUNT] =
   {
-  case INST_CALL_DEBUG_FN:
-    if( dh )
-      dh( info, (DebugInformation*)bh->m_R, bh, info->m_UserData );
-    break;
-  case INST_CALL_CONS_FUN:
-    ch( bh->m_R[inst.m_A1], ACT_CONSTRUCT, (void*)bh->m_R[inst.m_A2],
-      (void**)bh->m_R[inst.m_A3], info->m_UserData );
-    bh->m_R[inst.m_A1] = 0;
-    bh->m_R[inst.m_A2] = 0;
-    bh->m_R[inst.m_A3] = 0;
-    break;
-  case INST_CALL_EXEC_FUN:
-    bh->m_RE = ch( bh->m_R[inst.m_A1], ACT_EXECUTE, (void*)bh->m_R[inst.m_A2],
-      (void**)bh->m_R[inst.m_A3], info->m_UserData );
-    bh->m_R[inst.m_A1] = 0;
-    bh->m_R[inst.m_A2] = 0;
-    bh->m_R[inst.m_A3] = 0;
-    break;
-  case INST_CALL_DEST_FUN:
-    ch( bh->m_R[inst.m_A1], ACT_DESTRUCT, (void*)bh->m_R[inst.m_A2],
-      (void**)bh->m_R[inst.m_A3], info->m_UserData );
-    bh->m_R[inst.m_A1] = 0;
-    bh->m_R[inst.m_A2] = 0;
-    bh->m_R[inst.m_A3] = 0;
-    break;
-
-  case INST_CALL_PRUN_FUN:
-    bh->m_RE = ch( bh->m_R[inst.m_A1], ACT_PRUNE, (void*)bh->m_R[inst.m_A2],
-      (void**)bh->m_R[inst.m_A3], info->m_UserData );
-    bh->m_R[inst.m_A1] = 0;
-    bh->m_R[inst.m_A2] = 0;
-    bh->m_R[inst.m_A3] = 0;
-    break;
-  case INST_CALL_MODI_FUN:
-    bh->m_RE = ch( bh->m_R[inst.m_A1], ACT_MODIFY, (void*)bh->m_R[inst.m_A2],
-      (void**)bh->m_R[inst.m_A3], info->m_UserData );
-    bh->m_R[inst.m_A1] = 0;
-    bh->m_R[inst.m_A2] = 0;
-    bh->m_R[inst.m_A3] = 0;
-    break;
-  case INST_JABC_R_EQUA_C:
-    if( bh->m_RE == inst.m_A2 )
-      CHECKED_IP_ASSIGNMENT( inst.m_A1 );
-    break;
-  case INST_JABC_R_DIFF_C:
-    if( bh->m_RE != inst.m_A2 )
-      CHECKED_IP_ASSIGNMENT( inst.m_A1 );
-    break;
-  case INST_JABC_C_EQUA_B:
-    if( inst.m_A2 == *((int*)&(bss[inst.m_A3])) )
-      CHECKED_IP_ASSIGNMENT( inst.m_A1 );
-    break;
-  case INST_JABC_C_DIFF_B:
-    if( inst.m_A2 != *((int*)&(bss[inst.m_A3])) )
-      CHECKED_IP_ASSIGNMENT( inst.m_A1 );
-    break;
-  case INST_JABB_C_EQUA_B:
-    if( inst.m_A2 == *((int*)&(bss[inst.m_A3])) )
-      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst.m_A1])) );
-    break;
-  case INST_JABB_C_DIFF_B:
-    if( inst.m_A2 != *((int*)&(bss[inst.m_A3])) )
-      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst.m_A1])) );
-    break;
-  case INST_JABB_B_EQUA_B:
-    if( *((int*)&(bss[inst.m_A2])) == *((int*)&(bss[inst.m_A3])) )
-      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst.m_A1])) );
-    break;
-  case INST_JABB_B_DIFF_B:
-    if( *((int*)&(bss[inst.m_A2])) != *((int*)&(bss[inst.m_A3])) )
-      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst.m_A1])) );
-    break;
-  case INST_JABC_CONSTANT:
-    CHECKED_IP_ASSIGNMENT( inst.m_A1 );
-    break;
-  case INST_JREC_CONSTANT:
-    CHECKED_IP_ADDITION( inst.m_A1 );
-    break;
-  case INST_JABB_BSSVALUE:
-    CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst.m_A1])) );
-    break;
-  case INST_JREB_BSSVALUE:
-    CHECKED_IP_ADDITION( *((int*)&(bss[inst.m_A1])) );
-    break;
-  case INST_JABC_S_C_IN_B:
-    CHECKED_IP_ASSIGNMENT( inst.m_A1 );
-    *((int*)&(bss[inst.m_A2])) = inst.m_A3;
-    break;
-  case INST_JREC_S_C_IN_B:
-    CHECKED_IP_ADDITION( inst.m_A1 );
-    *((int*)&(bss[inst.m_A2])) = inst.m_A3;
-    break;
-  case INST_JABB_S_C_IN_B:
-    CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst.m_A1])) );
-    *((int*)&(bss[inst.m_A2])) = inst.m_A3;
-    break;
-  case INST_JREB_S_C_IN_B:
-    CHECKED_IP_ADDITION( *((int*)&(bss[inst.m_A1])) );
-    *((int*)&(bss[inst.m_A2])) = inst.m_A3;
-    break;
-  case INST__STORE_R_IN_B:
-    *((int*)&(bss[inst.m_A1])) = bh->m_RE;
-    break;
-  case INST__STORE_B_IN_R:
-    bh->m_RE = *((int*)&(bss[inst.m_A1]));
-    break;
-  case INST__STORE_C_IN_B:
-    *((int*)&(bss[inst.m_A1])) = (((int)inst.m_A3)<<16) | ((int)inst.m_A2);
-    break;
-  case INST__STORE_B_IN_B:
-    *((int*)&(bss[inst.m_A1])) = *((int*)&(bss[inst.m_A2]));
-    break;
-  case INST__STORE_C_IN_R:
-    bh->m_RE = inst.m_A1;
-    break;
-  case INST_STORE_PD_IN_B:
-    *(int*)(&bss[inst.m_A1]) = (int)(&data[inst.m_A2]);
-    break;
-  case INST_STORE_PB_IN_R:
-    bh->m_R[inst.m_A1] = (int)(&bss[inst.m_A2]);
-    break;
-  case INST__INC_BSSVALUE:
-    *((int*)&(bss[inst.m_A1])) += inst.m_A2;
-    break;
-  case INST__DEC_BSSVALUE:
-    *((int*)&(bss[inst.m_A1])) += inst.m_A2;
-    break;
-  case INST__SET_REGISTRY:
-    bh->m_R[inst.m_A1] = (((int)inst.m_A2) << 16) + inst.m_A3;
-    break;
-  case INST_LOAD_REGISTRY:
+    &&L_INST_CALL_DEBUG_FN,
+    &&L_INST_CALL_CONS_FUN,
+    &&L_INST_CALL_EXEC_FUN,
+    &&L_INST_CALL_DEST_FUN,
+    &&L_INST_CALL_PRUN_FUN,
+    &&L_INST_CALL_MODI_FUN,
+    &&L_INST_FUSE_CONS_FUN,
+    &&L_INST_FUSE_EXEC_FUN,
+    &&L_INST_FUSE_DEST_FUN,
+    &&L_INST_FUSE_PRUN_FUN,
+    &&L_INST_FUSE_MODI_FUN,
+    &&L_INST_JABC_R_EQUA_C,
+    &&L_INST_JABC_R_DIFF_C,
+    &&L_INST_JABC_C_EQUA_B,
+    &&L_INST_JABC_C_DIFF_B,
+    &&L_INST_JABB_C_EQUA_B,
+    &&L_INST_JABB_C_DIFF_B,
+    &&L_INST_JABB_B_EQUA_B,
+    &&L_INST_JABB_B_DIFF_B,
+    &&L_INST_JABC_CONSTANT,
+    &&L_INST_JREC_CONSTANT,
+    &&L_INST_JABB_BSSVALUE,
+    &&L_INST_JREB_BSSVALUE,
+    &&L_INST_JABC_S_C_IN_B,
+    &&L_INST_JREC_S_C_IN_B,
+    &&L_INST_JABB_S_C_IN_B,
+    &&L_INST_JREB_S_C_IN_B,
+    &&L_INST__STORE_R_IN_B,
+    &&L_INST__STORE_B_IN_R,
+    &&L_INST__STORE_C_IN_B,
+    &&L_INST__STORE_B_IN_B,
+    &&L_INST__STORE_C_IN_R,
+    &&L_INST_STORE_PD_IN_B,
+    &&L_INST_STORE_PB_IN_R,
+    &&L_INST__INC_BSSVALUE,
+    &&L_INST__DEC_BSSVALUE,
+    &&L_INST__SET_REGISTRY,
+    &&L_INST_LOAD_REGISTRY,
+    &&L_INST_SCRIPT_C,
+    &&L_INST_SCRIPT_R,
+    &&L_INST_SCRIPT_A,
+    &&L_INST_SCRIPT_P,
+    &&L_INST_SCRIPT_F,
+    &&L_INST_COUNT_NODE,
+    &&L_INST_TRACE_NODE,
+    &&L_INST_BREAKPOINT,
+    &&L_INST_______SUSPEND
+  };
+#endif
+
+  VM_BEGIN()
+  VM_CASE( INST_CALL_DEBUG_FN )
+    call_debug( info, bh, data );
+    VM_NEXT()
+  VM_CASE( INST_CALL_CONS_FUN )
+    REGISTER_CALL( ACT_CONSTRUCT );
+    bh->m_R[inst->m_A1] = 0;
+    bh->m_R[inst->m_A2] = 0;
+    bh->m_R[inst->m_A3] = 0;
+    VM_NEXT()
+  VM_CASE( INST_CALL_EXEC_FUN )
+    bh->m_RE = REGISTER_CALL( ACT_EXECUTE );
+    bh->m_R[inst->m_A1] = 0;
+    bh->m_R[inst->m_A2] = 0;
+    bh->m_R[inst->m_A3] = 0;
+    VM_NEXT()
+  VM_CASE( INST_CALL_DEST_FUN )
+    REGISTER_CALL( ACT_DESTRUCT );
+    bh->m_R[inst->m_A1] = 0;
+    bh->m_R[inst->m_A2] = 0;
+    bh->m_R[inst->m_A3] = 0;
+    VM_NEXT()
+
+  VM_CASE( INST_CALL_PRUN_FUN )
+    bh->m_RE = REGISTER_CALL( ACT_PRUNE );
+    bh->m_R[inst->m_A1] = 0;
+    bh->m_R[inst->m_A2] = 0;
+    bh->m_R[inst->m_A3] = 0;
+    VM_NEXT()
+  VM_CASE( INST_CALL_MODI_FUN )
+    bh->m_RE = REGISTER_CALL( ACT_MODIFY );
+    bh->m_R[inst->m_A1] = 0;
+    bh->m_R[inst->m_A2] = 0;
+    bh->m_R[inst->m_A3] = 0;
+    VM_NEXT()
+  VM_CASE( INST_FUSE_CONS_FUN )
+    FUSED_CALL( ACT_CONSTRUCT );
+    VM_NEXT()
+  VM_CASE( INST_FUSE_EXEC_FUN )
+    bh->m_RE = FUSED_CALL( ACT_EXECUTE );
+    VM_NEXT()
+  VM_CASE( INST_FUSE_DEST_FUN )
+    FUSED_CALL( ACT_DESTRUCT );
+    VM_NEXT()
+  VM_CASE( INST_FUSE_PRUN_FUN )
+    bh->m_RE = FUSED_CALL( ACT_PRUNE );
+    VM_NEXT()
+  VM_CASE( INST_FUSE_MODI_FUN )
+    bh->m_RE = FUSED_CALL( ACT_MODIFY );
+    VM_NEXT()
+  VM_CASE( INST_JABC_R_EQUA_C )
+    if( bh->m_RE == inst->m_A2 )
+      CHECKED_IP_ASSIGNMENT( inst->m_A1 );
+    VM_NEXT()
+  VM_CASE( INST_JABC_R_DIFF_C )
+    if( bh->m_RE != inst->m_A2 )
+      CHECKED_IP_ASSIGNMENT( inst->m_A1 );
+    VM_NEXT()
+  VM_CASE( INST_JABC_C_EQUA_B )
+    if( (int)inst->m_A2 == *((int*)&(bss[inst->m_A3])) )
+      CHECKED_IP_ASSIGNMENT( inst->m_A1 );
+    VM_NEXT()
+  VM_CASE( INST_JABC_C_DIFF_B )
+    if( (int)inst->m_A2 != *((int*)&(bss[inst->m_A3])) )
+      CHECKED_IP_ASSIGNMENT( inst->m_A1 );
+    VM_NEXT()
+  VM_CASE( INST_JABB_C_EQUA_B )
+    if( (int)inst->m_A2 == *((int*)&(bss[inst->m_A3])) )
+      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst->m_A1])) );
+    VM_NEXT()
+  VM_CASE( INST_JABB_C_DIFF_B )
+    if( (int)inst->m_A2 != *((int*)&(bss[inst->m_A3])) )
+      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst->m_A1])) );
+    VM_NEXT()
+  VM_CASE( INST_JABB_B_EQUA_B )
+    if( *((int*)&(bss[inst->m_A2])) == *((int*)&(bss[inst->m_A3])) )
+      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst->m_A1])) );
+    VM_NEXT()
+  VM_CASE( INST_JABB_B_DIFF_B )
+    if( *((int*)&(bss[inst->m_A2])) != *((int*)&(bss[inst->m_A3])) )
+      CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst->m_A1])) );
+    VM_NEXT()
+  VM_CASE( INST_JABC_CONSTANT )
+    CHECKED_IP_ASSIGNMENT( inst->m_A1 );
+    VM_NEXT()
+  VM_CASE( INST_JREC_CONSTANT )
+    CHECKED_IP_ADDITION( inst->m_A1 );
+    VM_NEXT()
+  VM_CASE( INST_JABB_BSSVALUE )
+    CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst->m_A1])) );
+    VM_NEXT()
+  VM_CASE( INST_JREB_BSSVALUE )
+    CHECKED_IP_ADDITION( *((int*)&(bss[inst->m_A1])) );
+    VM_NEXT()
+  VM_CASE( INST_JABC_S_C_IN_B )
+    CHECKED_IP_ASSIGNMENT( inst->m_A1 );
+    *((int*)&(bss[inst->m_A2])) = inst->m_A3;
+    VM_NEXT()
+  VM_CASE( INST_JREC_S_C_IN_B )
+    CHECKED_IP_ADDITION( inst->m_A1 );
+    *((int*)&(bss[inst->m_A2])) = inst->m_A3;
+    VM_NEXT()
+  VM_CASE( INST_JABB_S_C_IN_B )
+    CHECKED_IP_ASSIGNMENT( *((int*)&(bss[inst->m_A1])) );
+    *((int*)&(bss[inst->m_A2])) = inst->m_A3;
+    VM_NEXT()
+  VM_CASE( INST_JREB_S_C_IN_B )
+    CHECKED_IP_ADDITION( *((int*)&(bss[inst->m_A1])) );
+    *((int*)&(bss[inst->m_A2])) = inst->m_A3;
+    VM_NEXT()
+  VM_CASE( INST__STORE_R_IN_B )
+    *((int*)&(bss[inst->m_A1])) = bh->m_RE;
+    VM_NEXT()
+  VM_CASE( INST__STORE_B_IN_R )
+    bh->m_RE = *((int*)&(bss[inst->m_A1]));
+    VM_NEXT()
+  VM_CASE( INST__STORE_C_IN_B )
+    *((int*)&(bss[inst->m_A1])) = (((int)inst->m_A3)<<16) | ((int)inst->m_A2);
+    VM_NEXT()
+  VM_CASE( INST__STORE_B_IN_B )
+    *((int*)&(bss[inst->m_A1])) = *((int*)&(bss[inst->m_A2]));
+    VM_NEXT()
+  VM_CASE( INST__STORE_C_IN_R )
+    bh->m_RE = inst->m_A1;
+    VM_NEXT()
+  VM_CASE( INST_STORE_PD_IN_B )
+    *((unsigned int*)&(bss[inst->m_A1])) = inst->m_A2;
+    VM_NEXT()
+  VM_CASE( INST_STORE_PB_IN_R )
+    if( fp & POOLED_FRAME )
+      bh->m_R[inst->m_A1] = fp + inst->m_A2;
+    else
+      bh->m_R[inst->m_A1] = (unsigned int)(&bss[inst->m_A2] - (char*)bh);
+    VM_NEXT()
+  VM_CASE( INST__INC_BSSVALUE )
+    *((int*)&(bss[inst->m_A1])) += inst->m_A2;
+    VM_NEXT()
+  VM_CASE( INST__DEC_BSSVALUE )
+    *((int*)&(bss[inst->m_A1])) += inst->m_A2;
+    VM_NEXT()
+  VM_CASE( INST__SET_REGISTRY )
+    bh->m_R[inst->m_A1] = (((int)inst->m_A2) << 16) + inst->m_A3;
+    VM_NEXT()
+  VM_CASE( INST_LOAD_REGISTRY )
     {
-      int d = (((int)inst.m_A2) << 16) + ((int)inst.m_A3);
-      bh->m_R[inst.m_A1] = (int)(&data[d]);
+      bh->m_R[inst->m_A1] = (((unsigned int)inst->m_A2) << 16) + inst->m_A3;
     }
-    break;
-  case INST_SCRIPT_C:
+    VM_NEXT()
+  VM_CASE( INST_SCRIPT_C )
     {
-      CallFrame* f = (CallFrame*)(bss+inst.m_A2);
-      f->m_Bss = bss;
+      CallFrame* f = (CallFrame*)(bss+inst->m_A2);
+      f->m_FP  = fp;
       f->m_IP  = bh->m_IP;
+      fp += inst->m_A2 + sizeof(CallFrame);
+      bh->m_FP = fp;
       bss = (char*)(f + 1);
-      CHECKED_IP_ASSIGNMENT( inst.m_A1 );
+      CHECKED_IP_ASSIGNMENT( inst->m_A1 );
     }
-    break;
-  case INST_SCRIPT_R:
+    VM_NEXT()
+  VM_CASE( INST_SCRIPT_R )
     {
       CallFrame* f = (CallFrame*)(bss - sizeof(CallFrame));
-      bss = f->m_Bss;
+      fp  = f->m_FP;
+      bh->m_FP = fp;
+      bss = FRAME_ADDRESS( fp );
       CHECKED_IP_ASSIGNMENT( f->m_IP )
+      //Debug scopes see the return as the tree call
+      if( DEBUGGED )
+        from = bh->m_IP - 1;
+    }
+    VM_NEXT()
+  VM_CASE( INST_SCRIPT_A )
+    {
+      unsigned int* slot = (unsigned int*)&(bss[inst->m_A1]);
+      if( *slot == 0 )
+        *slot = take_frame( info->m_Frames );
     }
-    break;
-  case INST_______SUSPEND:
+    VM_NEXT()
+  VM_CASE( INST_SCRIPT_P )
+    {
+      const unsigned int pf = *((unsigned int*)&(bss[inst->m_A2]));
+      if( pf == 0 )
+      {
+        //The pool ran dry when the tree was constructed
+        bh->m_RE = E_NODE_FAIL;
+        VM_NEXT()
+      }
+      CallFrame* f = (CallFrame*)FRAME_ADDRESS( pf );
+      f->m_FP  = fp;
+      f->m_IP  = bh->m_IP;
+      fp  = pf + sizeof(CallFrame);
+      bh->m_FP = fp;
+      bss = (char*)(f + 1);
+      *((int*)bss) = inst->m_A3;
+      CHECKED_IP_ASSIGNMENT( inst->m_A1 );
+    }
+    VM_NEXT()
+  VM_CASE( INST_SCRIPT_F )
+    {
+      unsigned int* slot = (unsigned int*)&(bss[inst->m_A1]);
+      if( *slot != 0 )
+        give_frame( info->m_Frames, *slot );
+      *slot = 0;
+    }
+    VM_NEXT()
+  VM_CASE( INST_COUNT_NODE )
+    count_node( (NodeCounters*)&(base[inst->m_A1]), inst->m_A2, bh->m_RE );
+    VM_NEXT()
+  VM_CASE( INST_TRACE_NODE )
+    trace_node( bh, (((unsigned int)inst->m_A2) << 16) + inst->m_A3, inst->m_A1, bh->m_RE );
+    VM_NEXT()
+  VM_CASE( INST_BREAKPOINT )
+    {
+      //Stopped at as the instruction it replaced, which then runs in its place
+      --bh->m_IP;
+      --bh->m_IC;
+      call_breakpoints( info, pi.m_Header );
+      const WideInstruction* w = find_breakpoint( pi.m_Header, bh->m_IP );
+      ++bh->m_IP;
+      ++bh->m_IC;
+      //A copy whose breakpoints are gone can not go on
+      if( !w )
+      {
+        CHECKED_IP_ASSIGNMENT( 0 );
+        goto exit;
+      }
+      replaced.m_I  = w->m_I;
+      replaced.m_A1 = w->m_A1;
+      replaced.m_A2 = w->m_A2;
+      replaced.m_A3 = w->m_A3;
+      inst = &replaced;
+      code.Jumped();
+    }
+    VM_DISPATCH()
+  VM_CASE( INST_______SUSPEND )
     CHECKED_IP_ASSIGNMENT( 0 );
     goto exit;
-    break;
-  }
-  goto start;
+  VM_END()
+  yield:
+  //Remember which frame we stopped in, the next run resumes there
+  bh->m_FP = fp;
+  return false;
+
   exit:
+  bh->m_FP = 0;
+  return true;
+}
 
-  return bh->m_RE;
+template<bool BUDGETED, bool DEBUGGED>
+static bool interpret_image( CallbackProgram* info, const ProgramImage& pi, unsigned int budget )
+{
+  const unsigned int flags = pi.m_Header->m_PF;
+  if( flags & E_PROGRAM_COMPACT )
+    return interpret<BUDGETED, DEBUGGED, CompactCode>( info, pi, budget );
+  if( flags & E_PROGRAM_WIDE )
+    return interpret<BUDGETED, DEBUGGED, ArrayCode<WideInstruction> >( info, pi, budget );
+  return interpret<BUDGETED, DEBUGGED, ArrayCode<Instruction> >( info, pi, budget );
+}
+
+template<bool BUDGETED>
+static bool execute( CallbackProgram* info, const ProgramImage& pi, unsigned int budget )
+{
+  if( debugged( info, pi.m_Header ) )
+    return interpret_image<BUDGETED, true>( info, pi, budget );
+  return interpret_image<BUDGETED, false>( info, pi, budget );
+}
+
+bool check_program( const void* program, unsigned int size )
+{
+  const ProgramHeader* ph = (const ProgramHeader*)program;
+  if( !program || size < sizeof(ProgramHeader) || ph->m_Magic != PROGRAM_MAGIC
+    || ph->m_Version != PROGRAM_VERSION )
+    return false;
+  //E_PROGRAM_BREAKPOINTS is only ever set in memory, by breakpoints.cpp
+  if( ph->m_PF & ~(unsigned int)(E_PROGRAM_WIDE | E_PROGRAM_COMPACT) )
+    return false;
+  //Summed wider than the counts, which could overflow it
+  const unsigned long long code = (ph->m_PF & E_PROGRAM_COMPACT)
+    ? compact_table_count( ph->m_IC ) * (unsigned long long)sizeof(unsigned int)
+      + ((ph->m_CB + 3ull) & ~3ull)
+    : ph->m_IC * (unsigned long long)((ph->m_PF & E_PROGRAM_WIDE)
+      ? sizeof(WideInstruction) : sizeof(Instruction));
+  return sizeof(ProgramHeader) + code + ph->m_DS <= size;
+}
+
+int run_program( CallbackProgram* info )
+{
+  CallbackProgram* const caller = g_Running;
+  g_Running = info;
+
+  JitCode* jc = 0x0;
+  if( (info->m_Flags & E_CALLBACK_JIT) && !debugged( info, (ProgramHeader*)info->m_Program ) )
+    jc = jit_find( info->m_Program );
+  if( jc )
+    jit_execute( jc, info );
+  else
+  {
+    ProgramImage pi;
+    decode_image( info->m_Program, &pi );
+    execute<false>( info, pi, 0 );
+  }
+
+  g_Running = caller;
+  return ((BssHeader*)info->m_bss)->m_RE;
+}
+
+RunStatus run_program_budget( CallbackProgram* info, unsigned int budget )
+{
+  CallbackProgram* const caller = g_Running;
+  g_Running = info;
+  ProgramImage pi;
+  decode_image( info->m_Program, &pi );
+  const bool finished = execute<true>( info, pi, budget );
+  g_Running = caller;
+  return finished ? E_RUN_FINISHED : E_RUN_YIELDED;
+}
+
+void run_programs( CallbackBatch* batch )
+{
+  if( batch->m_Count == 0 )
+    return;
+
+  ProgramImage pi;
+  decode_image( batch->m_Program, &pi );
+
+  CallbackProgram cp;
+  cp.m_Program  = batch->m_Program;
+  cp.m_Callback = batch->m_Callback;
+  cp.m_Debug    = batch->m_Debug;
+  cp.m_Table    = batch->m_Table;
+  cp.m_Flags    = batch->m_Flags;
+  cp.m_Frames   = batch->m_Frames;
+  cp.m_UserData = 0x0;
+
+  JitCode* jc = 0x0;
+  if( (batch->m_Flags & E_CALLBACK_JIT) && !debugged( &cp, pi.m_Header ) )
+    jc = jit_find( batch->m_Program );
+
+  CallbackProgram* const caller = g_Running;
+  g_Running = &cp;
+
+  char* bss = (char*)batch->m_bss;
+  const unsigned int last = batch->m_Count - 1;
+  for( unsigned int a = 0; a <= last; ++a, bss += batch->m_Stride )
+  {
+    if( a != last )
+    {
+      //Start pulling in the next agent's header and first state while this one runs
+      CALLBACK_PREFETCH( bss + batch->m_Stride );
+      CALLBACK_PREFETCH( bss + batch->m_Stride + sizeof(BssHeader) );
+    }
+    cp.m_bss = bss;
+    if( batch->m_UserData )
+      cp.m_UserData = batch->m_UserData[a];
+    if( jc )
+      jit_execute( jc, &cp );
+    else
+      execute<false>( &cp, pi, 0 );
+  }
+  g_Running = caller;
+}
+
+void call_debug_scopes( CallbackProgram* info, const DebugScope* scopes, unsigned int count,
+  const char* data, unsigned int from )
+{
+  BssHeader* bh = (BssHeader*)info->m_bss;
+  const unsigned int ip = bh->m_IP;
+  unsigned int lo = 0, hi = count;
+  while( lo < hi )
+  {
+    const unsigned int mid = (lo + hi) / 2;
+    if( scopes[mid].m_IP < ip )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  DebugInformation di;
+  for( const DebugScope* s = scopes + lo; s != scopes + count && s->m_IP == ip; ++s )
+  {
+    const bool inside = from >= s->m_Begin && from < s->m_End;
+    if( (s->m_Flags & E_ENTER_SCOPE) ? inside : (!inside && s->m_Begin != s->m_End) )
+      continue;
+    di.m_Action = data + s->m_Action;
+    di.m_Name   = data + s->m_Name;
+    di.m_NodeId = s->m_NodeId;
+    di.m_Flags  = s->m_Flags;
+    di.m_LineNo = s->m_LineNo;
+    info->m_Debug( info, &di, bh, info->m_UserData );
+  }
+}
+
+void** resolve_variables( const char* list, char* data, void** vars )
+{
+  const unsigned int* l = (const unsigned int*)list;
+  for( unsigned int v = 0; v < l[0]; ++v )
+    vars[v] = data + l[v + 1];
+  return vars;
+}
+
+void* resolve_register( BssHeader* bh, char* pool, unsigned int r )
+{
+  if( r & POOLED_FRAME )
+    return pool + (r & ~POOLED_FRAME);
+  return r ? (void*)((char*)bh + r) : 0x0;
+}
+
+void call_debug( CallbackProgram* info, BssHeader* bh, char* data )
+{
+  if( !info->m_Debug )
+    return;
+  DebugInformation di;
+  di.m_Action = data + bh->m_R[0];
+  di.m_Name   = data + bh->m_R[1];
+  di.m_NodeId = bh->m_R[2];
+  di.m_Flags  = bh->m_R[3];
+  di.m_LineNo = bh->m_R[4];
+  info->m_Debug( info, &di, bh, info->m_UserData );
+}
+
+unsigned int get_callback_count( void* program )
+{
+  return ((ProgramHeader*)program)->m_CC;
+}
+
+unsigned int get_callback_id( void* program, unsigned int index )
+{
+  ProgramImage pi;
+  decode_image( program, &pi );
+  return pi.m_Ids[index];
+}
+
+/*
+ * The entry point table is the bss offset of the agent's entry point, then
+ * the data offset of the name and the first instruction of every entry point.
+ * The code at instruction zero jumps to the instruction in the bss, or to
+ * entry point zero while it is not set.
+ */
+static const unsigned int* entry_table( void* program )
+{
+  ProgramImage pi;
+  decode_image( program, &pi );
+  return (const unsigned int*)(pi.m_Data + pi.m_Header->m_ET);
+}
+
+unsigned int get_entry_count( void* program )
+{
+  return ((ProgramHeader*)program)->m_EC;
+}
+
+const char* get_entry_name( void* program, unsigned int index )
+{
+  ProgramImage pi;
+  decode_image( program, &pi );
+  return pi.m_Data + entry_table( program )[1 + index * 2];
+}
+
+int find_entry_point( void* program, const char* name )
+{
+  const unsigned int count = get_entry_count( program );
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    if( strcmp( get_entry_name( program, i ), name ) == 0 )
+      return (int)i;
+  }
+  return -1;
+}
+
+void set_entry_point( CallbackProgram* info, unsigned int index )
+{
+  const unsigned int* t = entry_table( info->m_Program );
+  char* base = (char*)(info->m_bss) + sizeof(BssHeader);
+  *(unsigned int*)(base + t[0]) = t[2 + index * 2];
 }
 
 }
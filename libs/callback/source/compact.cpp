@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/compact.h>
+
+namespace callback
+{
+
+/* Must be kept in the same order as InstructionSet */
+const unsigned char g_CompactOperands[MAXIMUM_INSTRUCTION_COUNT] =
+{
+  0, /* INST_CALL_DEBUG_FN */
+  3, /* INST_CALL_CONS_FUN */
+  3, /* INST_CALL_EXEC_FUN */
+  3, /* INST_CALL_DEST_FUN */
+  3, /* INST_CALL_PRUN_FUN */
+  3, /* INST_CALL_MODI_FUN */
+  3, /* INST_FUSE_CONS_FUN */
+  3, /* INST_FUSE_EXEC_FUN */
+  3, /* INST_FUSE_DEST_FUN */
+  3, /* INST_FUSE_PRUN_FUN */
+  3, /* INST_FUSE_MODI_FUN */
+  2, /* INST_JABC_R_EQUA_C */
+  2, /* INST_JABC_R_DIFF_C */
+  3, /* INST_JABC_C_EQUA_B */
+  3, /* INST_JABC_C_DIFF_B */
+  3, /* INST_JABB_C_EQUA_B */
+  3, /* INST_JABB_C_DIFF_B */
+  3, /* INST_JABB_B_EQUA_B */
+  3, /* INST_JABB_B_DIFF_B */
+  1, /* INST_JABC_CONSTANT */
+  1, /* INST_JREC_CONSTANT */
+  1, /* INST_JABB_BSSVALUE */
+  1, /* INST_JREB_BSSVALUE */
+  3, /* INST_JABC_S_C_IN_B */
+  3, /* INST_JREC_S_C_IN_B */
+  3, /* INST_JABB_S_C_IN_B */
+  3, /* INST_JREB_S_C_IN_B */
+  1, /* INST__STORE_R_IN_B */
+  1, /* INST__STORE_B_IN_R */
+  3, /* INST__STORE_C_IN_B */
+  2, /* INST__STORE_B_IN_B */
+  1, /* INST__STORE_C_IN_R */
+  2, /* INST_STORE_PD_IN_B */
+  2, /* INST_STORE_PB_IN_R */
+  2, /* INST__INC_BSSVALUE */
+  2, /* INST__DEC_BSSVALUE */
+  3, /* INST__SET_REGISTRY */
+  3, /* INST_LOAD_REGISTRY */
+  2, /* INST_SCRIPT_C */
+  0, /* INST_SCRIPT_R */
+  1, /* INST_SCRIPT_A */
+  3, /* INST_SCRIPT_P */
+  1, /* INST_SCRIPT_F */
+  2, /* INST_COUNT_NODE */
+  3, /* INST_TRACE_NODE */
+  0, /* INST_BREAKPOINT */
+  0  /* INST_______SUSPEND */
+};
+
+static unsigned char* encode_operand( WideVMIType v, unsigned char* out )
+{
+  v += 1;
+  while( v >= 0x80 )
+  {
+    *out++ = (unsigned char)((v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  *out++ = (unsigned char)v;
+  return out;
+}
+
+unsigned int compact_encode( const WideInstruction& inst, unsigned char* out )
+{
+  unsigned char* p = out;
+  const unsigned int n = g_CompactOperands[inst.m_I];
+  *p++ = (unsigned char)inst.m_I;
+  if( n > 0 )
+    p = encode_operand( inst.m_A1, p );
+  if( n > 1 )
+    p = encode_operand( inst.m_A2, p );
+  if( n > 2 )
+    p = encode_operand( inst.m_A3, p );
+  return (unsigned int)(p - out);
+}
+
+}
@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/counters.h>
+
+#include "resolve.h"
+
+namespace callback
+{
+
+bool get_counter_layout( void* program, CounterLayout* cl )
+{
+  const ProgramHeader* ph = (const ProgramHeader*)program;
+  if( ph->m_NC == 0 )
+    return false;
+  const char* data = (const char*)program + sizeof(ProgramHeader) + get_code_size( ph );
+  cl->m_Count = ph->m_NC;
+  cl->m_Block = ph->m_NB;
+  cl->m_Size  = ph->m_NS;
+  cl->m_Ids   = (const unsigned int*)(data + ph->m_NT);
+  return true;
+}
+
+static const NodeCounters* node_counters( const CounterLayout* cl, const void* bss,
+  unsigned int i )
+{
+  return (const NodeCounters*)((const char*)bss + sizeof(BssHeader) + cl->m_Block
+    + i * cl->m_Size);
+}
+
+void add_node_counts( const CounterLayout* cl, const void* bss, NodeCounts* counts )
+{
+  const bool cycles = cl->m_Size >= NODE_CYCLE_SIZE;
+  for( unsigned int i = 0; i < cl->m_Count; ++i )
+  {
+    const NodeCounters* c = node_counters( cl, bss, i );
+    NodeCounts* n = counts + i;
+    n->m_Enter     += c->m_Enter;
+    n->m_Result[0] += c->m_Result[0];
+    n->m_Result[1] += c->m_Result[1];
+    n->m_Result[2] += c->m_Result[2];
+    if( cycles )
+      n->m_Cycles += ((unsigned long long)c->m_Cycles[1] << 32) + c->m_Cycles[0];
+  }
+}
+
+void add_batch_counts( const CounterLayout* cl, const CallbackBatch* batch,
+  NodeCounts* counts )
+{
+  const char* bss = (const char*)batch->m_bss;
+  for( unsigned int a = 0; a < batch->m_Count; ++a, bss += batch->m_Stride )
+    add_node_counts( cl, bss, counts );
+}
+
+void clear_node_counters( const CounterLayout* cl, void* bss )
+{
+  const bool cycles = cl->m_Size >= NODE_CYCLE_SIZE;
+  for( unsigned int i = 0; i < cl->m_Count; ++i )
+  {
+    NodeCounters* c = (NodeCounters*)node_counters( cl, bss, i );
+    c->m_Enter     = 0;
+    c->m_Result[0] = 0;
+    c->m_Result[1] = 0;
+    c->m_Result[2] = 0;
+    //The start stays, nodes that are running still time their run
+    if( cycles )
+    {
+      c->m_Cycles[0] = 0;
+      c->m_Cycles[1] = 0;
+    }
+  }
+}
+
+}
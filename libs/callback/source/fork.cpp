@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/fork.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(LINUX)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define CALLBACK_FORK_SHARED
+#endif
+
+namespace callback
+{
+
+/*
+ * With CALLBACK_FORK_SHARED the agents' bss blocks live in a memory file that
+ * is mapped shared. Forking maps the agents' part of the file privately over
+ * their forks' blocks, which the kernel then copies page by page as the forks
+ * write to them. Freeing forks maps fresh inaccessible memory over them.
+ *
+ * Without it, or if the memory file can not be made, both are plain memory
+ * and forks are copies.
+ */
+
+struct ForkArena
+{
+  char*        m_Agents;
+  char*        m_Forks;
+  unsigned int m_AgentCount;
+  unsigned int m_BssSize;
+  unsigned int m_Stride;
+  unsigned int m_PageSize;
+  int          m_File;   // Memory file, -1 when forks are copies
+};
+
+#if defined(CALLBACK_FORK_SHARED)
+
+static bool create_shared( ForkArena* fa )
+{
+  size_t size = (size_t)fa->m_Stride * fa->m_AgentCount;
+
+  fa->m_File = memfd_create( "calltree-fork", MFD_CLOEXEC );
+  if( fa->m_File < 0 )
+    return false;
+
+  void* a = MAP_FAILED;
+  void* f = MAP_FAILED;
+  if( ftruncate( fa->m_File, size ) == 0 )
+  {
+    a = mmap( 0x0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fa->m_File, 0 );
+    f = mmap( 0x0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+  }
+
+  if( a == MAP_FAILED || f == MAP_FAILED )
+  {
+    if( a != MAP_FAILED )
+      munmap( a, size );
+    if( f != MAP_FAILED )
+      munmap( f, size );
+    close( fa->m_File );
+    fa->m_File = -1;
+    return false;
+  }
+
+  fa->m_Agents = (char*)a;
+  fa->m_Forks  = (char*)f;
+  return true;
+}
+
+static void destroy_shared( ForkArena* fa )
+{
+  size_t size = (size_t)fa->m_Stride * fa->m_AgentCount;
+  munmap( fa->m_Agents, size );
+  munmap( fa->m_Forks, size );
+  close( fa->m_File );
+}
+
+static bool map_forks( ForkArena* fa, unsigned int first, unsigned int count )
+{
+  void* m = mmap( fa->m_Forks + ((size_t)fa->m_Stride * first),
+    (size_t)fa->m_Stride * count, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+    fa->m_File, (off_t)fa->m_Stride * first );
+  return m != MAP_FAILED;
+}
+
+static void unmap_forks( ForkArena* fa, unsigned int first, unsigned int count )
+{
+  mmap( fa->m_Forks + ((size_t)fa->m_Stride * first), (size_t)fa->m_Stride * count,
+    PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0 );
+}
+
+static unsigned int get_page_size()
+{
+  return (unsigned int)sysconf( _SC_PAGESIZE );
+}
+
+#else
+
+static bool create_shared( ForkArena* )
+{
+  return false;
+}
+
+static void destroy_shared( ForkArena* )
+{
+}
+
+static bool map_forks( ForkArena*, unsigned int, unsigned int )
+{
+  return false;
+}
+
+static void unmap_forks( ForkArena*, unsigned int, unsigned int )
+{
+}
+
+static unsigned int get_page_size()
+{
+  return 4096;
+}
+
+#endif
+
+ForkArena* create_fork_arena( void* program, unsigned int agents )
+{
+  //Forks would share the agents' pooled frames
+  if( ((ProgramHeader*)program)->m_FS != 0 )
+    return 0x0;
+
+  ForkArena* fa = (ForkArena*)malloc( sizeof(ForkArena) );
+  if( !fa )
+    return 0x0;
+
+  fa->m_AgentCount = agents ? agents : 1;
+  fa->m_BssSize    = ((ProgramHeader*)program)->m_BS;
+  fa->m_PageSize   = get_page_size();
+  fa->m_Stride     = (fa->m_BssSize + fa->m_PageSize - 1) & ~(fa->m_PageSize - 1);
+  if( fa->m_Stride == 0 )
+    fa->m_Stride = fa->m_PageSize;
+  fa->m_File       = -1;
+
+  if( !create_shared( fa ) )
+  {
+    fa->m_Agents = (char*)calloc( fa->m_AgentCount, fa->m_Stride );
+    fa->m_Forks  = (char*)malloc( (size_t)fa->m_Stride * fa->m_AgentCount );
+    if( !fa->m_Agents || !fa->m_Forks )
+    {
+      free( fa->m_Agents );
+      free( fa->m_Forks );
+      free( fa );
+      return 0x0;
+    }
+  }
+  return fa;
+}
+
+void destroy_fork_arena( ForkArena* fa )
+{
+  if( !fa )
+    return;
+  if( fa->m_File >= 0 )
+  {
+    destroy_shared( fa );
+  }
+  else
+  {
+    free( fa->m_Agents );
+    free( fa->m_Forks );
+  }
+  free( fa );
+}
+
+void* get_agent_bss( ForkArena* fa, unsigned int agent )
+{
+  return fa->m_Agents + ((size_t)fa->m_Stride * agent);
+}
+
+unsigned int get_fork_stride( ForkArena* fa )
+{
+  return fa->m_Stride;
+}
+
+/*
+ * Ranges past the last agent would map forks over whatever follows the arena.
+ */
+static bool valid_range( const ForkArena* fa, unsigned int first, unsigned int count )
+{
+  return first <= fa->m_AgentCount && count <= fa->m_AgentCount - first;
+}
+
+void* fork_agents( ForkArena* fa, unsigned int first, unsigned int count )
+{
+  if( !valid_range( fa, first, count ) )
+    return 0x0;
+  char* fork = fa->m_Forks + ((size_t)fa->m_Stride * first);
+  if( fa->m_File >= 0 )
+  {
+    if( !map_forks( fa, first, count ) )
+      return 0x0;
+  }
+  else
+  {
+    for( unsigned int a = first; a < first + count; ++a )
+      memcpy( fa->m_Forks + ((size_t)fa->m_Stride * a), get_agent_bss( fa, a ),
+        fa->m_BssSize );
+  }
+  return fork;
+}
+
+unsigned int commit_forks( ForkArena* fa, unsigned int first, unsigned int count )
+{
+  if( !valid_range( fa, first, count ) )
+    return 0;
+  //Pages a fork never wrote to are the agent's own, and compare equal
+  unsigned int copied = 0;
+  for( unsigned int a = first; a < first + count; ++a )
+  {
+    char* to = (char*)get_agent_bss( fa, a );
+    const char* from = fa->m_Forks + ((size_t)fa->m_Stride * a);
+    for( unsigned int p = 0; p < fa->m_BssSize; p += fa->m_PageSize )
+    {
+      unsigned int n = fa->m_BssSize - p;
+      if( n > fa->m_PageSize )
+        n = fa->m_PageSize;
+      if( memcmp( to + p, from + p, n ) != 0 )
+      {
+        memcpy( to + p, from + p, n );
+        ++copied;
+      }
+    }
+  }
+
+  discard_forks( fa, first, count );
+  return copied;
+}
+
+void discard_forks( ForkArena* fa, unsigned int first, unsigned int count )
+{
+  if( fa->m_File >= 0 && valid_range( fa, first, count ) )
+    unmap_forks( fa, first, count );
+}
+
+}
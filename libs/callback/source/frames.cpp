@@ -0,0 +1,178 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+
+#include <callback/frames.h>
+#include <callback/platform.h>
+
+#include "resolve.h"
+
+#include <stdlib.h>
+
+#if defined(LINUX)
+  #include <sys/mman.h>
+  #define CALLBACK_FRAMES_MAPPED
+#endif
+
+namespace callback
+{
+
+/*
+ * The frames are one block of memory that is never moved, so frame handles
+ * and the pointers callbacks get into frames stay valid. Frames that have
+ * been given back are reused first, the high water mark tells where the
+ * never used ones start.
+ */
+struct FramePool
+{
+  char*          m_Memory;
+  unsigned int   m_FrameSize;
+  unsigned int   m_Capacity;
+  unsigned int   m_HighWater;
+  unsigned int   m_FreeCount;
+  unsigned int*  m_Free;
+  SpinLock       m_Lock;
+};
+
+static void lock_pool( FramePool* fp )
+{
+  spin_lock( &fp->m_Lock );
+}
+
+static void unlock_pool( FramePool* fp )
+{
+  spin_unlock( &fp->m_Lock );
+}
+
+static size_t memory_size( FramePool* fp )
+{
+  return (size_t)fp->m_FrameSize * fp->m_Capacity;
+}
+
+FramePool* create_frame_pool( void* program, unsigned int agents )
+{
+  const unsigned int size  = get_frame_size( program );
+  const unsigned int count = get_frame_count( program ) * agents;
+  if( size == 0 || count == 0 )
+    return 0x0;
+
+  //Keep every frame 8 byte aligned, and the handles clear of the top bit
+  const unsigned int stride = (size + 7) & ~7;
+  if( (unsigned long long)stride * count >= POOLED_FRAME )
+    return 0x0;
+
+  FramePool* fp = (FramePool*)malloc( sizeof(FramePool) );
+  if( !fp )
+    return 0x0;
+  fp->m_FrameSize = stride;
+  fp->m_Capacity  = count;
+  fp->m_HighWater = 0;
+  fp->m_FreeCount = 0;
+  fp->m_Lock      = 0;
+  fp->m_Free      = (unsigned int*)malloc( sizeof(unsigned int) * count );
+
+#if defined(CALLBACK_FRAMES_MAPPED)
+  void* m = mmap( 0x0, memory_size( fp ), PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+  fp->m_Memory = m == MAP_FAILED ? 0x0 : (char*)m;
+#else
+  fp->m_Memory = (char*)malloc( memory_size( fp ) );
+#endif
+
+  if( !fp->m_Free || !fp->m_Memory )
+  {
+    destroy_frame_pool( fp );
+    return 0x0;
+  }
+  return fp;
+}
+
+void destroy_frame_pool( FramePool* fp )
+{
+  if( !fp )
+    return;
+#if defined(CALLBACK_FRAMES_MAPPED)
+  if( fp->m_Memory )
+    munmap( fp->m_Memory, memory_size( fp ) );
+#else
+  free( fp->m_Memory );
+#endif
+  free( fp->m_Free );
+  free( fp );
+}
+
+void reset_frame_pool( FramePool* fp )
+{
+  if( !fp )
+    return;
+  lock_pool( fp );
+#if defined(CALLBACK_FRAMES_MAPPED)
+  //Hand the used pages back to the system too
+  madvise( fp->m_Memory, (size_t)fp->m_FrameSize * fp->m_HighWater, MADV_DONTNEED );
+#endif
+  fp->m_HighWater = 0;
+  fp->m_FreeCount = 0;
+  unlock_pool( fp );
+}
+
+unsigned int get_frames_in_use( FramePool* fp )
+{
+  if( !fp )
+    return 0;
+  lock_pool( fp );
+  unsigned int r = fp->m_HighWater - fp->m_FreeCount;
+  unlock_pool( fp );
+  return r;
+}
+
+unsigned int get_frame_size( void* program )
+{
+  return ((ProgramHeader*)program)->m_FS;
+}
+
+unsigned int get_frame_count( void* program )
+{
+  return ((ProgramHeader*)program)->m_FC;
+}
+
+char* get_frame_memory( FramePool* fp )
+{
+  return fp ? fp->m_Memory : 0x0;
+}
+
+unsigned int take_frame( FramePool* fp )
+{
+  if( !fp )
+    return 0;
+  unsigned int r = 0;
+  lock_pool( fp );
+  if( fp->m_FreeCount != 0 )
+    r = fp->m_Free[--fp->m_FreeCount];
+  else if( fp->m_HighWater != fp->m_Capacity )
+    r = fp->m_HighWater++;
+  else
+    r = fp->m_Capacity;
+  unlock_pool( fp );
+  if( r == fp->m_Capacity )
+    return 0;
+  return POOLED_FRAME | (r * fp->m_FrameSize);
+}
+
+void give_frame( FramePool* fp, unsigned int frame )
+{
+  if( !fp )
+    return;
+  lock_pool( fp );
+  fp->m_Free[fp->m_FreeCount++] = (frame & ~POOLED_FRAME) / fp->m_FrameSize;
+  unlock_pool( fp );
+}
+
+}
@@ -0,0 +1,931 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/callback.h>
+#include <callback/instructions.h>
+#include <callback/compact.h>
+#include <callback/counters.h>
+#include <callback/trace.h>
+
+#include "jit.h"
+#include "resolve.h"
+
+#if defined(GCC) && defined(__x86_64__)
+  #define CALLBACK_JIT_X64
+#endif
+
+#if defined(CALLBACK_JIT_X64)
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#if !defined(MAP_ANONYMOUS)
+  #define MAP_ANONYMOUS MAP_ANON
+#endif
+
+namespace callback
+{
+
+/*
+ * Each instruction is translated on its own, in order, so instruction N starts
+ * at m_Table[N]. While running, the registers hold:
+ *
+ *   rbx  BssHeader*
+ *   rbp  m_IC
+ *   r12  current bss frame
+ *   r13  CallbackProgram*
+ *   r14  data section
+ *   r15  m_RE
+ *
+ * Constant jumps are direct jumps, jumps through the bss load the new
+ * instruction pointer in ecx and go through m_Table. m_IC, m_RE and m_IP are
+ * written back to the BssHeader before debug callbacks and at exit. For the
+ * sampler (sampling.h) m_IP is also written before the other callbacks, and
+ * m_IP and m_FP as trees are called and return. Variable
+ * lists are resolved into the stack frame, which has room for
+ * MAX_CALLBACK_VARIABLES pointers at rsp.
+ */
+
+typedef void (*JitEntry)( CallbackProgram* info, BssHeader* bh, char* bss,
+  char* data, const void* start );
+
+struct JitCode
+{
+  JitCode*       m_Next;
+  void*          m_Program;
+  unsigned char* m_Code;
+  size_t         m_CodeSize;
+  const void**   m_Table;
+  unsigned int   m_Count;
+  char*          m_Data;
+};
+
+const unsigned int JIT_CACHE_SIZE = 64;
+
+//Keeps rsp 16 byte aligned at calls, after the six pushes
+const unsigned int JIT_STACK_SIZE = 8 + sizeof(void*) * MAX_CALLBACK_VARIABLES;
+
+static JitCode* s_Cache[JIT_CACHE_SIZE];
+
+enum Registers
+{
+  RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+  R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+enum Conditions
+{
+  CC_AE = 0x3,
+  CC_E  = 0x4,
+  CC_NE = 0x5
+};
+
+enum JumpTargets
+{
+  JT_EXIT     = -1,
+  JT_DISPATCH = -2
+};
+
+struct Fixup
+{
+  unsigned int m_Pos;    // Of the rel32
+  int          m_Target; // Instruction or JumpTargets
+};
+
+struct Emitter
+{
+  unsigned char* m_Code;
+  unsigned int   m_Size;
+  unsigned int   m_Capacity;
+  Fixup*         m_Fixups;
+  unsigned int   m_FixupCount;
+  unsigned int   m_FixupCapacity;
+  unsigned int*  m_Offsets;
+  unsigned int   m_Exit;
+  unsigned int   m_Dispatch;
+  unsigned int   m_NoOperand; // NO_OPERAND of the program's instruction format
+  bool           m_Failed;
+};
+
+static void emit8( Emitter* e, unsigned int v )
+{
+  if( e->m_Size == e->m_Capacity )
+  {
+    unsigned int c = e->m_Capacity ? e->m_Capacity * 2 : 4096;
+    unsigned char* n = (unsigned char*)realloc( e->m_Code, c );
+    if( !n )
+    {
+      e->m_Failed = true;
+      e->m_Size = 0;
+      return;
+    }
+    e->m_Code = n;
+    e->m_Capacity = c;
+  }
+  e->m_Code[e->m_Size++] = (unsigned char)v;
+}
+
+static void emit32( Emitter* e, unsigned int v )
+{
+  emit8( e, v );
+  emit8( e, v >> 8 );
+  emit8( e, v >> 16 );
+  emit8( e, v >> 24 );
+}
+
+static void emit64( Emitter* e, unsigned long long v )
+{
+  emit32( e, (unsigned int)v );
+  emit32( e, (unsigned int)(v >> 32) );
+}
+
+static void emit_rex( Emitter* e, bool w, int reg, int rm )
+{
+  unsigned int rex = 0x40;
+  if( w )
+    rex |= 0x08;
+  if( reg >= R8 )
+    rex |= 0x04;
+  if( rm >= R8 )
+    rex |= 0x01;
+  if( rex != 0x40 )
+    emit8( e, rex );
+}
+
+/*
+ * "reg" is a register or the /digit of the opcode. Memory operands always use
+ * a 32 bit displacement.
+ */
+static void emit_mem( Emitter* e, bool w, unsigned int op, int reg, int base, int disp )
+{
+  emit_rex( e, w, reg, base );
+  emit8( e, op );
+  emit8( e, 0x80 | ((reg & 7) << 3) | (base & 7) );
+  if( (base & 7) == RSP )
+    emit8( e, 0x24 );
+  emit32( e, (unsigned int)disp );
+}
+
+static void emit_reg( Emitter* e, bool w, unsigned int op, int reg, int rm )
+{
+  emit_rex( e, w, reg, rm );
+  emit8( e, op );
+  emit8( e, 0xc0 | ((reg & 7) << 3) | (rm & 7) );
+}
+
+static void load32( Emitter* e, int reg, int base, int disp )
+{
+  emit_mem( e, false, 0x8b, reg, base, disp );
+}
+
+static void store32( Emitter* e, int base, int disp, int reg )
+{
+  emit_mem( e, false, 0x89, reg, base, disp );
+}
+
+static void load64( Emitter* e, int reg, int base, int disp )
+{
+  emit_mem( e, true, 0x8b, reg, base, disp );
+}
+
+static void lea64( Emitter* e, int reg, int base, int disp )
+{
+  emit_mem( e, true, 0x8d, reg, base, disp );
+}
+
+static void store_imm32( Emitter* e, int base, int disp, unsigned int v )
+{
+  emit_mem( e, false, 0xc7, 0, base, disp );
+  emit32( e, v );
+}
+
+static void cmp_mem_imm32( Emitter* e, int base, int disp, unsigned int v )
+{
+  emit_mem( e, false, 0x81, 7, base, disp );
+  emit32( e, v );
+}
+
+static void add_mem_imm32( Emitter* e, int base, int disp, unsigned int v )
+{
+  emit_mem( e, false, 0x81, 0, base, disp );
+  emit32( e, v );
+}
+
+static void cmp_reg_imm32( Emitter* e, int reg, unsigned int v )
+{
+  emit_reg( e, false, 0x81, 7, reg );
+  emit32( e, v );
+}
+
+static void add_reg_imm32( Emitter* e, int reg, unsigned int v )
+{
+  emit_reg( e, false, 0x81, 0, reg );
+  emit32( e, v );
+}
+
+static void mov_imm32( Emitter* e, int reg, unsigned int v )
+{
+  emit_rex( e, false, 0, reg );
+  emit8( e, 0xb8 + (reg & 7) );
+  emit32( e, v );
+}
+
+static void mov_imm64( Emitter* e, int reg, unsigned long long v )
+{
+  emit_rex( e, true, 0, reg );
+  emit8( e, 0xb8 + (reg & 7) );
+  emit64( e, v );
+}
+
+static void mov_reg32( Emitter* e, int dst, int src )
+{
+  emit_reg( e, false, 0x89, src, dst );
+}
+
+static void mov_reg64( Emitter* e, int dst, int src )
+{
+  emit_reg( e, true, 0x89, src, dst );
+}
+
+static void push( Emitter* e, int reg )
+{
+  emit_rex( e, false, 0, reg );
+  emit8( e, 0x50 + (reg & 7) );
+}
+
+static void pop( Emitter* e, int reg )
+{
+  emit_rex( e, false, 0, reg );
+  emit8( e, 0x58 + (reg & 7) );
+}
+
+static void call_reg( Emitter* e, int reg )
+{
+  emit_reg( e, false, 0xff, 2, reg );
+}
+
+static void jump_to( Emitter* e, int target )
+{
+  if( e->m_FixupCount == e->m_FixupCapacity )
+  {
+    unsigned int c = e->m_FixupCapacity ? e->m_FixupCapacity * 2 : 256;
+    Fixup* n = (Fixup*)realloc( e->m_Fixups, sizeof(Fixup) * c );
+    if( !n )
+    {
+      e->m_Failed = true;
+      e->m_FixupCount = 0;
+      return;
+    }
+    e->m_Fixups = n;
+    e->m_FixupCapacity = c;
+  }
+  e->m_Fixups[e->m_FixupCount].m_Pos    = e->m_Size;
+  e->m_Fixups[e->m_FixupCount].m_Target = target;
+  ++e->m_FixupCount;
+  emit32( e, 0 );
+}
+
+static void jmp( Emitter* e, int target )
+{
+  emit8( e, 0xe9 );
+  jump_to( e, target );
+}
+
+static void jcc( Emitter* e, unsigned int cc, int target )
+{
+  emit8( e, 0x0f );
+  emit8( e, 0x80 | cc );
+  jump_to( e, target );
+}
+
+/*
+ * A constant jump. Targets outside the program end the run.
+ */
+static void jmp_ip( Emitter* e, unsigned int ip, unsigned int count )
+{
+  jmp( e, ip < count ? (int)ip : JT_EXIT );
+}
+
+static void jcc_ip( Emitter* e, unsigned int cc, unsigned int ip, unsigned int count )
+{
+  jcc( e, cc, ip < count ? (int)ip : JT_EXIT );
+}
+
+/*
+ * A short forward jump over code emitted next, patched with patch_short.
+ */
+static unsigned int jcc_short( Emitter* e, unsigned int op )
+{
+  emit8( e, op );
+  emit8( e, 0 );
+  return e->m_Size;
+}
+
+static void patch_short( Emitter* e, unsigned int pos )
+{
+  if( !e->m_Failed )
+    e->m_Code[pos - 1] = (unsigned char)(e->m_Size - pos);
+}
+
+static const int BH_IC = offsetof( BssHeader, m_IC );
+static const int BH_IP = offsetof( BssHeader, m_IP );
+static const int BH_FP = offsetof( BssHeader, m_FP );
+static const int BH_RE = offsetof( BssHeader, m_RE );
+static const int BH_R  = offsetof( BssHeader, m_R );
+
+static const int CP_USERDATA = offsetof( CallbackProgram, m_UserData );
+static const int CP_CALLBACK = offsetof( CallbackProgram, m_Callback );
+static const int CP_DEBUG    = offsetof( CallbackProgram, m_Debug );
+static const int CP_TABLE    = offsetof( CallbackProgram, m_Table );
+
+static const int CF_FP  = offsetof( CallFrame, m_FP );
+static const int CF_IP  = offsetof( CallFrame, m_IP );
+static const int CF_SIZE = sizeof( CallFrame );
+
+static void call_abs( Emitter* e, const void* function )
+{
+  mov_imm64( e, RAX, (unsigned long long)(size_t)function );
+  call_reg( e, RAX );
+}
+
+/*
+ * The register based calls are not made by ctc any more, these are kept
+ * simple and done in C.
+ */
+static unsigned int register_call( CallbackProgram* info, BssHeader* bh, char* data,
+  unsigned int action, unsigned int regs )
+{
+  const unsigned int r1 = regs & 0xff;
+  const unsigned int r2 = (regs >> 8) & 0xff;
+  const unsigned int r3 = (regs >> 16) & 0xff;
+  void* vars[MAX_CALLBACK_VARIABLES];
+  void** v = 0x0;
+  if( bh->m_R[r3] )
+    v = resolve_variables( &(data[bh->m_R[r3]]), data, vars );
+  unsigned int r = info->m_Callback( bh->m_R[r1], action,
+    resolve_register( bh, 0x0, bh->m_R[r2] ), v, info->m_UserData );
+  bh->m_R[r1] = 0;
+  bh->m_R[r2] = 0;
+  bh->m_R[r3] = 0;
+  return r;
+}
+
+static void emit_user_call( Emitter* e, const WideInstruction& inst, unsigned int id,
+  NodeAction action, bool sets_return )
+{
+  if( inst.m_A3 != e->m_NoOperand )
+  {
+    lea64( e, RDI, R14, inst.m_A3 );
+    mov_reg64( e, RSI, R14 );
+    mov_reg64( e, RDX, RSP );
+    call_abs( e, (const void*)&resolve_variables );
+  }
+
+  //rax = tab ? tab[index] : ch
+  load64( e, RAX, R13, CP_TABLE );
+  emit_reg( e, true, 0x85, RAX, RAX );
+  unsigned int no_table = jcc_short( e, 0x74 );
+  load64( e, RAX, RAX, inst.m_A1 * sizeof(CallbackHandler) );
+  unsigned int done = jcc_short( e, 0xeb );
+  patch_short( e, no_table );
+  load64( e, RAX, R13, CP_CALLBACK );
+  patch_short( e, done );
+
+  mov_imm32( e, RDI, id );
+  mov_imm32( e, RSI, action );
+  if( inst.m_A2 == e->m_NoOperand )
+    emit_reg( e, false, 0x31, RDX, RDX );
+  else
+    lea64( e, RDX, R12, inst.m_A2 );
+  if( inst.m_A3 == e->m_NoOperand )
+    emit_reg( e, false, 0x31, RCX, RCX );
+  else
+    mov_reg64( e, RCX, RSP );
+  load64( e, R8, R13, CP_USERDATA );
+  call_reg( e, RAX );
+  if( sets_return )
+    mov_reg32( e, R15, RAX );
+}
+
+static void emit_register_call( Emitter* e, const WideInstruction& inst,
+  NodeAction action, bool sets_return )
+{
+  mov_reg64( e, RDI, R13 );
+  mov_reg64( e, RSI, RBX );
+  mov_reg64( e, RDX, R14 );
+  mov_imm32( e, RCX, action );
+  mov_imm32( e, R8, inst.m_A1 | (inst.m_A2 << 8) | (inst.m_A3 << 16) );
+  call_abs( e, (const void*)&register_call );
+  if( sets_return )
+    mov_reg32( e, R15, RAX );
+}
+
+static void emit_instruction( Emitter* e, const WideInstruction& inst, unsigned int g,
+  unsigned int count, const unsigned int* ids )
+{
+  const unsigned int next = g + 1;
+
+  //inc ebp
+  emit8( e, 0xff );
+  emit8( e, 0xc5 );
+
+  if( inst.m_I >= INST_CALL_CONS_FUN && inst.m_I <= INST_FUSE_MODI_FUN )
+    store_imm32( e, RBX, BH_IP, next );
+
+  switch( inst.m_I )
+  {
+  case INST_CALL_DEBUG_FN:
+    {
+      load64( e, RAX, R13, CP_DEBUG );
+      emit_reg( e, true, 0x85, RAX, RAX );
+      emit8( e, 0x0f );
+      emit8( e, 0x84 );
+      emit32( e, 0 );
+      unsigned int skip = e->m_Size;
+      store_imm32( e, RBX, BH_IP, next );
+      store32( e, RBX, BH_IC, RBP );
+      store32( e, RBX, BH_RE, R15 );
+      mov_reg64( e, RDI, R13 );
+      mov_reg64( e, RSI, RBX );
+      mov_reg64( e, RDX, R14 );
+      call_abs( e, (const void*)&call_debug );
+      load32( e, R15, RBX, BH_RE );
+      if( !e->m_Failed )
+      {
+        unsigned int rel = e->m_Size - skip;
+        memcpy( &e->m_Code[skip - 4], &rel, 4 );
+      }
+    }
+    break;
+  case INST_CALL_CONS_FUN:
+    emit_register_call( e, inst, ACT_CONSTRUCT, false );
+    break;
+  case INST_CALL_EXEC_FUN:
+    emit_register_call( e, inst, ACT_EXECUTE, true );
+    break;
+  case INST_CALL_DEST_FUN:
+    emit_register_call( e, inst, ACT_DESTRUCT, false );
+    break;
+  case INST_CALL_PRUN_FUN:
+    emit_register_call( e, inst, ACT_PRUNE, true );
+    break;
+  case INST_CALL_MODI_FUN:
+    emit_register_call( e, inst, ACT_MODIFY, true );
+    break;
+  case INST_FUSE_CONS_FUN:
+    emit_user_call( e, inst, ids[inst.m_A1], ACT_CONSTRUCT, false );
+    break;
+  case INST_FUSE_EXEC_FUN:
+    emit_user_call( e, inst, ids[inst.m_A1], ACT_EXECUTE, true );
+    break;
+  case INST_FUSE_DEST_FUN:
+    emit_user_call( e, inst, ids[inst.m_A1], ACT_DESTRUCT, false );
+    break;
+  case INST_FUSE_PRUN_FUN:
+    emit_user_call( e, inst, ids[inst.m_A1], ACT_PRUNE, true );
+    break;
+  case INST_FUSE_MODI_FUN:
+    emit_user_call( e, inst, ids[inst.m_A1], ACT_MODIFY, true );
+    break;
+  case INST_JABC_R_EQUA_C:
+    cmp_reg_imm32( e, R15, inst.m_A2 );
+    jcc_ip( e, CC_E, inst.m_A1, count );
+    break;
+  case INST_JABC_R_DIFF_C:
+    cmp_reg_imm32( e, R15, inst.m_A2 );
+    jcc_ip( e, CC_NE, inst.m_A1, count );
+    break;
+  case INST_JABC_C_EQUA_B:
+    cmp_mem_imm32( e, R12, inst.m_A3, inst.m_A2 );
+    jcc_ip( e, CC_E, inst.m_A1, count );
+    break;
+  case INST_JABC_C_DIFF_B:
+    cmp_mem_imm32( e, R12, inst.m_A3, inst.m_A2 );
+    jcc_ip( e, CC_NE, inst.m_A1, count );
+    break;
+  case INST_JABB_C_EQUA_B:
+    load32( e, RCX, R12, inst.m_A1 );
+    cmp_mem_imm32( e, R12, inst.m_A3, inst.m_A2 );
+    jcc( e, CC_E, JT_DISPATCH );
+    break;
+  case INST_JABB_C_DIFF_B:
+    load32( e, RCX, R12, inst.m_A1 );
+    cmp_mem_imm32( e, R12, inst.m_A3, inst.m_A2 );
+    jcc( e, CC_NE, JT_DISPATCH );
+    break;
+  case INST_JABB_B_EQUA_B:
+  case INST_JABB_B_DIFF_B:
+    load32( e, RCX, R12, inst.m_A1 );
+    load32( e, RAX, R12, inst.m_A2 );
+    emit_mem( e, false, 0x3b, RAX, R12, inst.m_A3 );
+    jcc( e, inst.m_I == INST_JABB_B_EQUA_B ? CC_E : CC_NE, JT_DISPATCH );
+    break;
+  case INST_JABC_CONSTANT:
+    jmp_ip( e, inst.m_A1, count );
+    break;
+  case INST_JREC_CONSTANT:
+    jmp_ip( e, next + inst.m_A1, count );
+    break;
+  case INST_JABB_BSSVALUE:
+    load32( e, RCX, R12, inst.m_A1 );
+    jmp( e, JT_DISPATCH );
+    break;
+  case INST_JREB_BSSVALUE:
+    load32( e, RCX, R12, inst.m_A1 );
+    add_reg_imm32( e, RCX, next );
+    jmp( e, JT_DISPATCH );
+    break;
+  case INST_JABC_S_C_IN_B:
+    store_imm32( e, R12, inst.m_A2, inst.m_A3 );
+    jmp_ip( e, inst.m_A1, count );
+    break;
+  case INST_JREC_S_C_IN_B:
+    store_imm32( e, R12, inst.m_A2, inst.m_A3 );
+    jmp_ip( e, next + inst.m_A1, count );
+    break;
+  case INST_JABB_S_C_IN_B:
+    load32( e, RCX, R12, inst.m_A1 );
+    store_imm32( e, R12, inst.m_A2, inst.m_A3 );
+    jmp( e, JT_DISPATCH );
+    break;
+  case INST_JREB_S_C_IN_B:
+    load32( e, RCX, R12, inst.m_A1 );
+    add_reg_imm32( e, RCX, next );
+    store_imm32( e, R12, inst.m_A2, inst.m_A3 );
+    jmp( e, JT_DISPATCH );
+    break;
+  case INST__STORE_R_IN_B:
+    store32( e, R12, inst.m_A1, R15 );
+    break;
+  case INST__STORE_B_IN_R:
+    load32( e, R15, R12, inst.m_A1 );
+    break;
+  case INST__STORE_C_IN_B:
+    store_imm32( e, R12, inst.m_A1,
+      (((unsigned int)inst.m_A3) << 16) | ((unsigned int)inst.m_A2) );
+    break;
+  case INST__STORE_B_IN_B:
+    load32( e, RAX, R12, inst.m_A2 );
+    store32( e, R12, inst.m_A1, RAX );
+    break;
+  case INST__STORE_C_IN_R:
+    mov_imm32( e, R15, inst.m_A1 );
+    break;
+  case INST_STORE_PD_IN_B:
+    store_imm32( e, R12, inst.m_A1, inst.m_A2 );
+    break;
+  case INST_STORE_PB_IN_R:
+    //Offset from the BssHeader
+    lea64( e, RAX, R12, inst.m_A2 );
+    emit_reg( e, true, 0x29, RBX, RAX );
+    store32( e, RBX, BH_R + inst.m_A1 * 4, RAX );
+    break;
+  case INST__INC_BSSVALUE:
+  case INST__DEC_BSSVALUE:
+    //The interpreter adds for both
+    add_mem_imm32( e, R12, inst.m_A1, inst.m_A2 );
+    break;
+  case INST__SET_REGISTRY:
+    store_imm32( e, RBX, BH_R + inst.m_A1 * 4,
+      (((unsigned int)inst.m_A2) << 16) + inst.m_A3 );
+    break;
+  case INST_LOAD_REGISTRY:
+    store_imm32( e, RBX, BH_R + inst.m_A1 * 4,
+      (((unsigned int)inst.m_A2) << 16) + inst.m_A3 );
+    break;
+  case INST_SCRIPT_C:
+    //The caller's frame as an offset, like BssHeader::m_FP
+    lea64( e, RAX, R12, inst.m_A2 );
+    mov_reg64( e, RDX, R12 );
+    emit_reg( e, true, 0x29, RBX, RDX );
+    add_reg_imm32( e, RDX, (unsigned int)-(int)sizeof(BssHeader) );
+    store32( e, RAX, CF_FP, RDX );
+    store_imm32( e, RAX, CF_IP, next );
+    lea64( e, R12, RAX, CF_SIZE );
+    add_reg_imm32( e, RDX, inst.m_A2 + CF_SIZE );
+    store32( e, RBX, BH_FP, RDX );
+    store_imm32( e, RBX, BH_IP, inst.m_A1 );
+    jmp_ip( e, inst.m_A1, count );
+    break;
+  case INST_SCRIPT_R:
+    load32( e, RCX, R12, CF_IP - CF_SIZE );
+    load32( e, RAX, R12, CF_FP - CF_SIZE );
+    store32( e, RBX, BH_IP, RCX );
+    store32( e, RBX, BH_FP, RAX );
+    lea64( e, R12, RBX, sizeof(BssHeader) );
+    emit_reg( e, true, 0x01, RAX, R12 );
+    jmp( e, JT_DISPATCH );
+    break;
+  case INST_COUNT_NODE:
+    if( inst.m_A2 & E_COUNT_CYCLES )
+    {
+      lea64( e, RDI, RBX, sizeof(BssHeader) + inst.m_A1 );
+      mov_imm32( e, RSI, inst.m_A2 );
+      mov_reg32( e, RDX, R15 );
+      call_abs( e, (const void*)&count_node );
+    }
+    else if( inst.m_A2 & E_COUNT_RESULT )
+    {
+      cmp_reg_imm32( e, R15, 3 );
+      unsigned int skip = jcc_short( e, 0x73 );
+      //add dword [rbx + r15 * 4 + m_Result], 1
+      emit8( e, 0x42 );
+      emit8( e, 0x83 );
+      emit8( e, 0x84 );
+      emit8( e, 0xbb );
+      emit32( e, sizeof(BssHeader) + inst.m_A1 + offsetof( NodeCounters, m_Result ) );
+      emit8( e, 1 );
+      patch_short( e, skip );
+    }
+    else
+      add_mem_imm32( e, RBX, sizeof(BssHeader) + inst.m_A1, 1 );
+    break;
+  case INST_TRACE_NODE:
+    mov_reg64( e, RDI, RBX );
+    mov_imm32( e, RSI, (((unsigned int)inst.m_A2) << 16) + inst.m_A3 );
+    mov_imm32( e, RDX, inst.m_A1 );
+    mov_reg32( e, RCX, R15 );
+    call_abs( e, (const void*)&trace_node );
+    break;
+  case INST_______SUSPEND:
+    jmp( e, JT_EXIT );
+    break;
+  default:
+    e->m_Failed = true;
+    break;
+  }
+}
+
+/*
+ * What INST_BREAKPOINT does before the instruction it replaced is compiled in
+ * its place, see breakpoints.h.
+ */
+static void emit_breakpoint( Emitter* e, const void* program, unsigned int g )
+{
+  store_imm32( e, RBX, BH_IP, g );
+  store32( e, RBX, BH_IC, RBP );
+  store32( e, RBX, BH_RE, R15 );
+  mov_reg64( e, RDI, R13 );
+  mov_imm64( e, RSI, (unsigned long long)(size_t)program );
+  call_abs( e, (const void*)&call_breakpoints );
+  load32( e, R15, RBX, BH_RE );
+}
+
+/*
+ * The instructions are compiled in their wide form, whatever the program's.
+ */
+static void widen( const Instruction& i, WideInstruction* w )
+{
+  w->m_I  = i.m_I;
+  w->m_A1 = i.m_A1;
+  w->m_A2 = i.m_A2;
+  w->m_A3 = i.m_A3;
+}
+
+static JitCode* compile( void* program )
+{
+  ProgramHeader* ph  = (ProgramHeader*)program;
+  const bool wide    = (ph->m_PF & E_PROGRAM_WIDE) != 0;
+  const bool compact = (ph->m_PF & E_PROGRAM_COMPACT) != 0;
+  char* inst         = (char*)program + sizeof(ProgramHeader);
+  char* data         = inst + get_code_size( ph );
+  unsigned int* ids  = (unsigned int*)(data + ph->m_CT);
+  const unsigned int count = ph->m_IC;
+
+  //Frames from a frame pool are left to the interpreter
+  if( count == 0 || ph->m_FS != 0 )
+    return 0x0;
+
+  Emitter e;
+  memset( &e, 0, sizeof(Emitter) );
+  e.m_NoOperand = (wide || compact) ? WIDE_NO_OPERAND : NO_OPERAND;
+  e.m_Offsets = (unsigned int*)malloc( sizeof(unsigned int) * count );
+  const void** table = (const void**)malloc( sizeof(void*) * count );
+  if( !e.m_Offsets || !table )
+    e.m_Failed = true;
+
+  //Entry, called as JitEntry
+  push( &e, RBX );
+  push( &e, RBP );
+  push( &e, R12 );
+  push( &e, R13 );
+  push( &e, R14 );
+  push( &e, R15 );
+  emit8( &e, 0x48 ); emit8( &e, 0x81 ); emit8( &e, 0xec ); emit32( &e, JIT_STACK_SIZE );
+  mov_reg64( &e, R13, RDI );
+  mov_reg64( &e, RBX, RSI );
+  mov_reg64( &e, R12, RDX );
+  mov_reg64( &e, R14, RCX );
+  load32( &e, RBP, RBX, BH_IC );
+  load32( &e, R15, RBX, BH_RE );
+  emit_reg( &e, false, 0xff, 4, R8 );
+
+  //Jumps through the bss, ip in ecx
+  e.m_Dispatch = e.m_Size;
+  cmp_reg_imm32( &e, RCX, count );
+  jcc( &e, CC_AE, JT_EXIT );
+  mov_imm64( &e, RAX, (unsigned long long)(size_t)table );
+  emit8( &e, 0xff ); emit8( &e, 0x24 ); emit8( &e, 0xc8 );
+
+  //Suspend
+  e.m_Exit = e.m_Size;
+  store32( &e, RBX, BH_IC, RBP );
+  store32( &e, RBX, BH_RE, R15 );
+  store_imm32( &e, RBX, BH_IP, 0 );
+  store_imm32( &e, RBX, BH_FP, 0 );
+  emit8( &e, 0x48 ); emit8( &e, 0x81 ); emit8( &e, 0xc4 ); emit32( &e, JIT_STACK_SIZE );
+  pop( &e, R15 );
+  pop( &e, R14 );
+  pop( &e, R13 );
+  pop( &e, R12 );
+  pop( &e, RBP );
+  pop( &e, RBX );
+  emit8( &e, 0xc3 );
+
+  //Compact code is decoded in order, the offset table is not needed
+  const unsigned char* pc = (const unsigned char*)(inst
+    + sizeof(unsigned int) * compact_table_count( count ));
+  for( unsigned int g = 0; g < count && !e.m_Failed; ++g )
+  {
+    WideInstruction wi;
+    if( compact )
+      pc = compact_decode( pc, &wi );
+    else if( wide )
+      wi = ((WideInstruction*)inst)[g];
+    else
+      widen( ((Instruction*)inst)[g], &wi );
+    e.m_Offsets[g] = e.m_Size;
+    if( wi.m_I == INST_BREAKPOINT )
+    {
+      const WideInstruction* replaced = find_breakpoint( program, g );
+      if( !replaced )
+      {
+        e.m_Failed = true;
+        break;
+      }
+      emit_breakpoint( &e, program, g );
+      wi = *replaced;
+      //Only the opcode was replaced, the operands are still to be skipped
+      if( compact )
+        pc = compact_skip( pc, wi.m_I );
+    }
+    emit_instruction( &e, wi, g, count, ids );
+  }
+
+  for( unsigned int i = 0; i < e.m_FixupCount && !e.m_Failed; ++i )
+  {
+    const Fixup& f = e.m_Fixups[i];
+    unsigned int to = e.m_Exit;
+    if( f.m_Target == JT_DISPATCH )
+      to = e.m_Dispatch;
+    else if( f.m_Target >= 0 )
+      to = e.m_Offsets[f.m_Target];
+    int rel = (int)to - (int)(f.m_Pos + 4);
+    memcpy( &e.m_Code[f.m_Pos], &rel, 4 );
+  }
+
+  unsigned char* code = 0x0;
+  if( !e.m_Failed )
+  {
+    void* m = mmap( 0x0, e.m_Size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( m != MAP_FAILED )
+    {
+      code = (unsigned char*)m;
+      memcpy( code, e.m_Code, e.m_Size );
+      if( mprotect( code, e.m_Size, PROT_READ | PROT_EXEC ) != 0 )
+      {
+        munmap( code, e.m_Size );
+        code = 0x0;
+      }
+    }
+  }
+
+  JitCode* jc = 0x0;
+  if( code )
+    jc = (JitCode*)malloc( sizeof(JitCode) );
+
+  if( jc )
+  {
+    for( unsigned int g = 0; g < count; ++g )
+      table[g] = code + e.m_Offsets[g];
+    jc->m_Next     = 0x0;
+    jc->m_Program  = program;
+    jc->m_Code     = code;
+    jc->m_CodeSize = e.m_Size;
+    jc->m_Table    = table;
+    jc->m_Count    = count;
+    jc->m_Data     = data;
+  }
+  else
+  {
+    if( code )
+      munmap( code, e.m_Size );
+    free( table );
+  }
+
+  free( e.m_Code );
+  free( e.m_Fixups );
+  free( e.m_Offsets );
+  return jc;
+}
+
+static unsigned int cache_slot( void* program )
+{
+  return (unsigned int)(((size_t)program >> 4) % JIT_CACHE_SIZE);
+}
+
+static JitCode* cache_find( void* program )
+{
+  JitCode* jc = s_Cache[cache_slot( program )];
+  while( jc && jc->m_Program != program )
+    jc = jc->m_Next;
+  return jc;
+}
+
+JitCode* jit_find( void* program )
+{
+  JitCode* jc = cache_find( program );
+  if( jc )
+    return jc;
+  if( !jit_compile( program ) )
+    return 0x0;
+  return cache_find( program );
+}
+
+void jit_execute( JitCode* jc, CallbackProgram* info )
+{
+  BssHeader* bh = (BssHeader*)info->m_bss;
+  char* bss = (char*)(info->m_bss) + sizeof(BssHeader) + bh->m_FP;
+  const void* start = bh->m_IP < jc->m_Count ? jc->m_Table[bh->m_IP] : jc->m_Table[0];
+  ((JitEntry)(size_t)jc->m_Code)( info, bh, bss, jc->m_Data, start );
+}
+
+bool jit_compile( void* program )
+{
+  if( cache_find( program ) )
+    return true;
+
+  JitCode* jc = compile( program );
+  if( !jc )
+    return false;
+
+  unsigned int slot = cache_slot( program );
+  jc->m_Next = s_Cache[slot];
+  s_Cache[slot] = jc;
+  return true;
+}
+
+void jit_release( void* program )
+{
+  JitCode** it = &s_Cache[cache_slot( program )];
+  while( *it && (*it)->m_Program != program )
+    it = &(*it)->m_Next;
+  if( !*it )
+    return;
+
+  JitCode* jc = *it;
+  *it = jc->m_Next;
+  munmap( jc->m_Code, jc->m_CodeSize );
+  free( jc->m_Table );
+  free( jc );
+}
+
+}
+
+#else
+
+namespace callback
+{
+
+JitCode* jit_find( void* program )
+{
+  return 0x0;
+}
+
+void jit_execute( JitCode* jc, CallbackProgram* info )
+{
+}
+
+bool jit_compile( void* program )
+{
+  return false;
+}
+
+void jit_release( void* program )
+{
+}
+
+}
+
+#endif
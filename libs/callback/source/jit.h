@@ -0,0 +1,35 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_JIT_H_
+#define CALLBACK_JIT_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+struct JitCode;
+
+/*
+ * The native code of a program, compiling it on first use. Null if there is
+ * no JIT for this platform.
+ */
+JitCode* jit_find( void* program );
+
+/*
+ * Runs the program until it suspends, like the interpreter would.
+ */
+void jit_execute( JitCode* jc, CallbackProgram* info );
+
+}
+
+#endif /* CALLBACK_JIT_H_ */
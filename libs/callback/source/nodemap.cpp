@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/nodemap.h>
+#include <callback/instructions.h>
+
+namespace callback
+{
+
+static const unsigned int* map_owners( const NodeMapHeader* m )
+{
+  return (const unsigned int*)(get_map_slots( m ) + m->m_SC);
+}
+
+static const unsigned int* map_actions( const NodeMapHeader* m )
+{
+  return map_owners( m ) + m->m_IC;
+}
+
+static unsigned int map_size( const NodeMapHeader* h )
+{
+  return sizeof(NodeMapHeader) + sizeof(MapTree) * h->m_TC + sizeof(MapNode) * h->m_NC
+    + sizeof(MapSlot) * h->m_SC + sizeof(unsigned int) * 2 * h->m_IC + h->m_SS;
+}
+
+/*
+ * Every index in the map points inside it, so the rest of the library can use
+ * it without checks.
+ */
+static bool valid_map( const NodeMapHeader* m )
+{
+  const MapTree* t = get_map_trees( m );
+  for( unsigned int i = 0; i < m->m_TC; ++i )
+  {
+    if( t[i].m_Root >= m->m_NC || t[i].m_Name >= m->m_SS )
+      return false;
+  }
+  const MapNode* n = get_map_nodes( m );
+  for( unsigned int i = 0; i < m->m_NC; ++i )
+  {
+    if( (n[i].m_Parent != MAP_NONE && n[i].m_Parent >= i) || n[i].m_Tree >= m->m_TC
+      || (n[i].m_Callee != MAP_NONE && n[i].m_Callee >= m->m_TC)
+      || n[i].m_Slot > m->m_SC || n[i].m_SlotCount > m->m_SC - n[i].m_Slot
+      || n[i].m_Name >= m->m_SS )
+      return false;
+  }
+  const MapSlot* s = get_map_slots( m );
+  for( unsigned int i = 0; i < m->m_SC; ++i )
+  {
+    if( s[i].m_Offset > m->m_BS || s[i].m_Size > m->m_BS - s[i].m_Offset )
+      return false;
+  }
+  const unsigned int* o = map_owners( m );
+  const unsigned int* a = map_actions( m );
+  for( unsigned int i = 0; i < m->m_IC; ++i )
+  {
+    if( o[i] != MAP_NONE && o[i] >= m->m_NC )
+      return false;
+    if( (o[i] == MAP_NONE) != (a[i] == MAP_NONE) || (a[i] != MAP_NONE && a[i] > ACT_DESTRUCT) )
+      return false;
+  }
+  return m->m_SS == 0 || get_map_string( m, 0 )[m->m_SS - 1] == 0;
+}
+
+const NodeMapHeader* check_node_map( const void* map, unsigned int size,
+  void* program )
+{
+  const NodeMapHeader* m = (const NodeMapHeader*)map;
+  if( !m || size < sizeof(NodeMapHeader) || m->m_Magic != NODE_MAP_MAGIC
+    || m->m_Version != NODE_MAP_VERSION )
+    return 0x0;
+  //Guard the size sum against counts that overflow it
+  if( m->m_TC > size || m->m_NC > size || m->m_SC > size || m->m_IC > size
+    || m->m_SS > size || map_size( m ) != size )
+    return 0x0;
+  if( program )
+  {
+    ProgramHeader* ph = (ProgramHeader*)program;
+    if( ph->m_IC != m->m_IC || ph->m_BS != m->m_BS )
+      return 0x0;
+  }
+  return valid_map( m ) ? m : 0x0;
+}
+
+const MapTree* get_map_trees( const NodeMapHeader* m )
+{
+  return (const MapTree*)(m + 1);
+}
+
+const MapNode* get_map_nodes( const NodeMapHeader* m )
+{
+  return (const MapNode*)(get_map_trees( m ) + m->m_TC);
+}
+
+const MapSlot* get_map_slots( const NodeMapHeader* m )
+{
+  return (const MapSlot*)(get_map_nodes( m ) + m->m_NC);
+}
+
+const char* get_map_string( const NodeMapHeader* m, unsigned int offset )
+{
+  return (const char*)(map_actions( m ) + m->m_IC) + offset;
+}
+
+unsigned int get_map_owner( const NodeMapHeader* m, unsigned int ip )
+{
+  if( ip >= m->m_IC )
+    return MAP_NONE;
+  return map_owners( m )[ip];
+}
+
+unsigned int get_map_action( const NodeMapHeader* m, unsigned int ip )
+{
+  if( ip >= m->m_IC )
+    return MAP_NONE;
+  return map_actions( m )[ip];
+}
+
+unsigned int find_map_node( const NodeMapHeader* m, unsigned int id )
+{
+  const MapNode* n = get_map_nodes( m );
+  for( unsigned int i = 0; i < m->m_NC; ++i )
+  {
+    if( n[i].m_Id == id )
+      return i;
+  }
+  return MAP_NONE;
+}
+
+}
@@ -0,0 +1,488 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/reload.h>
+#include <callback/instructions.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace callback
+{
+
+enum ReloadMatch
+{
+  E_MATCH_NONE,      // Not in the new program
+  E_MATCH_CHANGED,   // Its code or layout changed
+  E_MATCH_RESTART,   // Changed, but can be restarted in place
+  E_MATCH_IDENTICAL
+};
+
+/*
+ * A node as it is placed in the bss, once for every frame its tree is
+ * called in. Instances are in depth first order, like the nodes.
+ */
+struct ReloadInstance
+{
+  unsigned int m_From;     // Node in the old map
+  unsigned int m_To;       // Node in the new map, or MAP_NONE
+  unsigned int m_FromBase; // Frame offsets in the old and the new bss
+  unsigned int m_ToBase;
+  unsigned int m_Parent;   // Instance, MAP_NONE for the root of "main"
+  unsigned int m_Child;    // Which child of the parent's node it is
+  unsigned int m_End;      // The first instance that is not below it
+  unsigned int m_Match;    // ReloadMatch
+};
+
+struct ReloadPlan
+{
+  void*                m_Program; // The new one
+  const NodeMapHeader* m_From;
+  const NodeMapHeader* m_To;
+  unsigned int*        m_IP;    // New instruction for each old one, or MAP_NONE
+  ReloadInstance*      m_Instances;
+  unsigned int         m_Count;
+  unsigned int         m_Capacity;
+  unsigned char*       m_Live;  // Instances running in the agent being reloaded
+  char*                m_Scratch;
+};
+
+static unsigned int subtree_end( const NodeMapHeader* m, unsigned int n )
+{
+  const MapNode* nodes = get_map_nodes( m );
+  unsigned int e = n + 1;
+  while( e < m->m_NC && nodes[e].m_Parent != MAP_NONE && nodes[e].m_Parent >= n )
+    ++e;
+  return e;
+}
+
+static bool same_slots( const ReloadPlan* rp, const MapNode& f, const MapNode& t )
+{
+  if( f.m_SlotCount != t.m_SlotCount )
+    return false;
+  const MapSlot* fs = get_map_slots( rp->m_From ) + f.m_Slot;
+  const MapSlot* ts = get_map_slots( rp->m_To ) + t.m_Slot;
+  for( unsigned int i = 0; i < f.m_SlotCount; ++i )
+  {
+    //Code slots reset to the "none" of the instruction format, which may differ
+    if( fs[i].m_Size != ts[i].m_Size || fs[i].m_Kind != ts[i].m_Kind
+      || (fs[i].m_Kind != E_MAP_SLOT_CODE && fs[i].m_Reset != ts[i].m_Reset) )
+      return false;
+  }
+  return true;
+}
+
+static unsigned int match( const ReloadPlan* rp, unsigned int from, unsigned int to )
+{
+  if( to == MAP_NONE )
+    return E_MATCH_NONE;
+  const MapNode& f = get_map_nodes( rp->m_From )[from];
+  const MapNode& t = get_map_nodes( rp->m_To )[to];
+  if( f.m_Signature == t.m_Signature && f.m_Type == t.m_Type && same_slots( rp, f, t ) )
+    return E_MATCH_IDENTICAL;
+  if( f.m_Type == t.m_Type && (t.m_Flags & E_MAP_RESTARTABLE) && same_slots( rp, f, t ) )
+    return E_MATCH_RESTART;
+  return E_MATCH_CHANGED;
+}
+
+/*
+ * The child of new node "to" with the same key as old node "from".
+ */
+static unsigned int find_child( const ReloadPlan* rp, unsigned int to, unsigned int from )
+{
+  const MapNode* nodes = get_map_nodes( rp->m_To );
+  const unsigned int key = get_map_nodes( rp->m_From )[from].m_Key;
+  const unsigned int e = subtree_end( rp->m_To, to );
+  for( unsigned int c = to + 1; c < e; ++c )
+  {
+    if( nodes[c].m_Parent == to && nodes[c].m_Key == key )
+      return c;
+  }
+  return MAP_NONE;
+}
+
+/*
+ * The frame of a tree called by a node starts after the CallFrame in slot 0.
+ */
+static unsigned int callee_frame( const NodeMapHeader* m, const MapNode& n, unsigned int base )
+{
+  return base + get_map_slots( m )[n.m_Slot].m_Offset + sizeof(CallFrame);
+}
+
+static bool add_instances( ReloadPlan* rp, unsigned int from, unsigned int to,
+  unsigned int from_base, unsigned int to_base, unsigned int parent, unsigned int child )
+{
+  if( rp->m_Count == rp->m_Capacity )
+  {
+    unsigned int c = rp->m_Capacity ? rp->m_Capacity * 2 : 64;
+    ReloadInstance* ri = (ReloadInstance*)realloc( rp->m_Instances, sizeof(ReloadInstance) * c );
+    if( !ri )
+      return false;
+    rp->m_Instances = ri;
+    rp->m_Capacity  = c;
+  }
+  const unsigned int index = rp->m_Count++;
+  ReloadInstance* ri = rp->m_Instances + index;
+  ri->m_From     = from;
+  ri->m_To       = to;
+  ri->m_FromBase = from_base;
+  ri->m_ToBase   = to_base;
+  ri->m_Parent   = parent;
+  ri->m_Child    = child;
+  ri->m_Match    = match( rp, from, to );
+
+  //Only the children of nodes that kept their state can keep theirs
+  if( ri->m_Match == E_MATCH_IDENTICAL )
+  {
+    const MapNode* fn = get_map_nodes( rp->m_From );
+    const MapNode* tn = get_map_nodes( rp->m_To );
+    const unsigned int e = subtree_end( rp->m_From, from );
+    unsigned int k = 0;
+    for( unsigned int c = from + 1; c < e; ++c )
+    {
+      if( fn[c].m_Parent != from )
+        continue;
+      if( !add_instances( rp, c, find_child( rp, to, c ), from_base, to_base, index, k++ ) )
+        return false;
+    }
+    if( fn[from].m_Callee != MAP_NONE && tn[to].m_Callee != MAP_NONE )
+    {
+      const unsigned int fr = get_map_trees( rp->m_From )[fn[from].m_Callee].m_Root;
+      const unsigned int tr = get_map_trees( rp->m_To )[tn[to].m_Callee].m_Root;
+      if( !add_instances( rp, fr, fn[fr].m_Key == tn[tr].m_Key ? tr : MAP_NONE,
+        callee_frame( rp->m_From, fn[from], from_base ),
+        callee_frame( rp->m_To, tn[to], to_base ), index, 0 ) )
+        return false;
+    }
+  }
+  rp->m_Instances[index].m_End = rp->m_Count;
+  return true;
+}
+
+/*
+ * Old instructions of nodes that kept their code map to the instruction in
+ * the same place of the new code of the node. The first instruction of the
+ * construct, execute and destruct code of any node that is still there maps
+ * to the new one, for the instruction pointers its parent holds.
+ */
+static bool map_instructions( ReloadPlan* rp )
+{
+  const unsigned int fc = rp->m_From->m_IC, tc = rp->m_To->m_IC;
+  const unsigned int fn = rp->m_From->m_NC, tn = rp->m_To->m_NC;
+  unsigned int* node_to  = (unsigned int*)malloc( sizeof(unsigned int) * (fn + 1) );
+  unsigned int* same     = (unsigned int*)malloc( sizeof(unsigned int) * (fn + 1) );
+  unsigned int* seen     = (unsigned int*)malloc( sizeof(unsigned int) * (fn + 1) );
+  unsigned int* first    = (unsigned int*)malloc( sizeof(unsigned int) * (tn + 1) );
+  unsigned int* by_node  = (unsigned int*)malloc( sizeof(unsigned int) * (tc + 1) );
+  rp->m_IP = (unsigned int*)malloc( sizeof(unsigned int) * (fc + 1) );
+  bool ok = node_to && same && seen && first && by_node && rp->m_IP;
+  if( ok )
+  {
+    for( unsigned int i = 0; i < fn; ++i )
+    {
+      node_to[i] = MAP_NONE;
+      same[i]    = 0;
+      seen[i]    = 0;
+    }
+    for( unsigned int i = 0; i < rp->m_Count; ++i )
+    {
+      const ReloadInstance& ri = rp->m_Instances[i];
+      if( ri.m_To == MAP_NONE || node_to[ri.m_From] != MAP_NONE )
+        continue;
+      node_to[ri.m_From] = ri.m_To;
+      same[ri.m_From]    = ri.m_Match == E_MATCH_IDENTICAL;
+    }
+
+    //The new instructions of each node, in order
+    for( unsigned int i = 0; i <= tn; ++i )
+      first[i] = 0;
+    for( unsigned int i = 0; i < tc; ++i )
+    {
+      unsigned int o = get_map_owner( rp->m_To, i );
+      if( o != MAP_NONE )
+        ++first[o + 1];
+    }
+    for( unsigned int i = 0; i < tn; ++i )
+      first[i + 1] += first[i];
+    for( unsigned int i = 0; i < tc; ++i )
+    {
+      unsigned int o = get_map_owner( rp->m_To, i );
+      if( o != MAP_NONE )
+        by_node[first[o]++] = i;
+    }
+    for( unsigned int i = tn; i > 0; --i )
+      first[i] = first[i - 1];
+    first[0] = 0;
+
+    for( unsigned int i = 0; i < fc; ++i )
+    {
+      rp->m_IP[i] = MAP_NONE;
+      unsigned int o = get_map_owner( rp->m_From, i );
+      if( o == MAP_NONE )
+        continue;
+      unsigned int nth = seen[o]++;
+      unsigned int t = node_to[o];
+      if( t != MAP_NONE && same[o] && first[t] + nth < first[t + 1] )
+        rp->m_IP[i] = by_node[first[t] + nth];
+    }
+    const MapNode* fnodes = get_map_nodes( rp->m_From );
+    const MapNode* tnodes = get_map_nodes( rp->m_To );
+    for( unsigned int i = 0; i < fn; ++i )
+    {
+      if( node_to[i] == MAP_NONE )
+        continue;
+      for( unsigned int a = 0; a < 3; ++a )
+      {
+        unsigned int e = fnodes[i].m_Entry[a];
+        if( e < fc && rp->m_IP[e] == MAP_NONE )
+          rp->m_IP[e] = tnodes[node_to[i]].m_Entry[a];
+      }
+    }
+  }
+  free( node_to );
+  free( same );
+  free( seen );
+  free( first );
+  free( by_node );
+  return ok;
+}
+
+ReloadPlan* create_reload( void* from, const NodeMapHeader* from_map,
+  void* to, const NodeMapHeader* to_map )
+{
+  ProgramHeader* fh = (ProgramHeader*)from;
+  ProgramHeader* th = (ProgramHeader*)to;
+  if( !fh || !th || !from_map || !to_map || fh->m_FS != 0 || th->m_FS != 0
+    || fh->m_IC != from_map->m_IC || fh->m_BS != from_map->m_BS
+    || th->m_IC != to_map->m_IC || th->m_BS != to_map->m_BS
+    || from_map->m_TC == 0 || to_map->m_TC == 0 )
+    return 0x0;
+
+  ReloadPlan* rp = (ReloadPlan*)malloc( sizeof(ReloadPlan) );
+  if( !rp )
+    return 0x0;
+  memset( rp, 0, sizeof(ReloadPlan) );
+  rp->m_Program = to;
+  rp->m_From    = from_map;
+  rp->m_To      = to_map;
+
+  const unsigned int fr = get_map_trees( from_map )[0].m_Root;
+  const unsigned int tr = get_map_trees( to_map )[0].m_Root;
+  const bool same_root = get_map_nodes( from_map )[fr].m_Key == get_map_nodes( to_map )[tr].m_Key;
+  bool ok = add_instances( rp, fr, same_root ? tr : MAP_NONE, MAP_MAIN_FRAME,
+    MAP_MAIN_FRAME, MAP_NONE, 0 ) && map_instructions( rp );
+  if( ok )
+  {
+    rp->m_Live    = (unsigned char*)malloc( rp->m_Count + 1 );
+    rp->m_Scratch = (char*)malloc( from_map->m_BS );
+    ok = rp->m_Live && rp->m_Scratch;
+  }
+  if( !ok )
+  {
+    destroy_reload( rp );
+    return 0x0;
+  }
+  return rp;
+}
+
+void destroy_reload( ReloadPlan* rp )
+{
+  if( !rp )
+    return;
+  free( rp->m_IP );
+  free( rp->m_Instances );
+  free( rp->m_Live );
+  free( rp->m_Scratch );
+  free( rp );
+}
+
+static unsigned int word( const char* bss, unsigned int offset )
+{
+  return *(const unsigned int*)(bss + offset);
+}
+
+/*
+ * True if the child in instance "ri" runs, when its parent does.
+ */
+static bool child_live( const ReloadPlan* rp, const char* bss, const ReloadInstance& ri )
+{
+  const ReloadInstance& pi = rp->m_Instances[ri.m_Parent];
+  const MapNode& p = get_map_nodes( rp->m_From )[pi.m_From];
+  const MapSlot* s = get_map_slots( rp->m_From ) + p.m_Slot;
+  if( p.m_Flags & E_MAP_LIVE_ALL )
+    return true;
+  if( (p.m_Flags & E_MAP_LIVE_ENTRY) && p.m_SlotCount > 0 )
+    return word( bss, pi.m_FromBase + s[0].m_Offset )
+      == get_map_nodes( rp->m_From )[ri.m_From].m_Entry[ACT_EXECUTE];
+  if( (p.m_Flags & E_MAP_LIVE_STATE) && p.m_SlotCount > 1
+    && (ri.m_Child + 1) * sizeof(int) <= s[1].m_Size )
+    return word( bss, pi.m_FromBase + s[1].m_Offset + ri.m_Child * sizeof(int) )
+      != E_NODE_UNDEFINED;
+  return false;
+}
+
+/*
+ * Puts the new slots of the instance in the state its construction leaves.
+ */
+static void restart( const ReloadPlan* rp, char* bss, const ReloadInstance& ri )
+{
+  const MapNode& n = get_map_nodes( rp->m_To )[ri.m_To];
+  const MapSlot* s = get_map_slots( rp->m_To ) + n.m_Slot;
+  for( unsigned int i = 0; i < n.m_SlotCount; ++i )
+  {
+    unsigned int* w = (unsigned int*)(bss + ri.m_ToBase + s[i].m_Offset);
+    for( unsigned int j = 0; j < s[i].m_Size / sizeof(int); ++j )
+      w[j] = s[i].m_Reset;
+  }
+}
+
+/*
+ * Restarts the closest instance from "i" up that can be. Its children stop
+ * counting as running. Returns false if there is none.
+ */
+static bool restart_above( ReloadPlan* rp, char* bss, unsigned int i )
+{
+  for( ; i != MAP_NONE; i = rp->m_Instances[i].m_Parent )
+  {
+    const ReloadInstance& ri = rp->m_Instances[i];
+    if( ri.m_To == MAP_NONE || ri.m_Match < E_MATCH_RESTART
+      || !(get_map_nodes( rp->m_To )[ri.m_To].m_Flags & E_MAP_RESTARTABLE) )
+      continue;
+    restart( rp, bss, ri );
+    rp->m_Live[i] = 0;
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Copies the slots of an instance that kept its layout. Returns false if an
+ * instruction pointer it holds is in code that is gone.
+ */
+static bool move_slots( const ReloadPlan* rp, const char* from, char* to,
+  const ReloadInstance& ri )
+{
+  const MapNode& fn = get_map_nodes( rp->m_From )[ri.m_From];
+  const MapNode& tn = get_map_nodes( rp->m_To )[ri.m_To];
+  const MapSlot* fs = get_map_slots( rp->m_From ) + fn.m_Slot;
+  const MapSlot* ts = get_map_slots( rp->m_To ) + tn.m_Slot;
+  bool ok = true;
+  for( unsigned int i = 0; i < fn.m_SlotCount; ++i )
+  {
+    const char* f = from + ri.m_FromBase + fs[i].m_Offset;
+    char* t = to + ri.m_ToBase + ts[i].m_Offset;
+    switch( fs[i].m_Kind )
+    {
+    case E_MAP_SLOT_CODE:
+      for( unsigned int j = 0; j < fs[i].m_Size / sizeof(int); ++j )
+      {
+        //The reset value marks a slot that holds no instruction pointer
+        unsigned int ip = ((const unsigned int*)f)[j];
+        if( ip == fs[i].m_Reset )
+          ip = ts[i].m_Reset;
+        else
+        {
+          ip = ip < rp->m_From->m_IC ? rp->m_IP[ip] : MAP_NONE;
+          ok = ok && ip != MAP_NONE;
+        }
+        ((unsigned int*)t)[j] = ip;
+      }
+      break;
+    case E_MAP_SLOT_STATE:
+    case E_MAP_SLOT_CALLBACK:
+      memcpy( t, f, fs[i].m_Size );
+      break;
+    default:
+      break;
+    }
+  }
+  return ok;
+}
+
+/*
+ * Clears the agent, so the new program constructs "main" at the next run.
+ */
+static ReloadResult reset( const ReloadPlan* rp, void* to_bss )
+{
+  memset( to_bss, 0, rp->m_To->m_BS );
+  return E_RELOAD_RESET;
+}
+
+ReloadResult reload_agent( ReloadPlan* rp, const void* from_bss, void* to_bss )
+{
+  memcpy( rp->m_Scratch, from_bss, rp->m_From->m_BS );
+  memset( to_bss, 0, rp->m_To->m_BS );
+
+  //Agents in the middle of a run start over
+  const BssHeader* fh = (const BssHeader*)rp->m_Scratch;
+  if( fh->m_IP != 0 )
+    return reset( rp, to_bss );
+  memcpy( to_bss, fh, sizeof(BssHeader) );
+
+  const char* from = rp->m_Scratch + sizeof(BssHeader);
+  char* to = (char*)to_bss + sizeof(BssHeader);
+  const unsigned int state = word( from, MAP_MAIN_STATE );
+  *(unsigned int*)(to + MAP_MAIN_STATE) = state;
+  if( state != E_NODE_WORKING )
+    return E_RELOAD_MIGRATED;
+
+  bool restarted = false;
+  unsigned int i = 0;
+  while( i < rp->m_Count )
+  {
+    const ReloadInstance& ri = rp->m_Instances[i];
+    rp->m_Live[i] = 0;
+    if( ri.m_Parent != MAP_NONE && (!rp->m_Live[ri.m_Parent] || !child_live( rp, from, ri )) )
+    {
+      i = ri.m_End;
+      continue;
+    }
+    if( ri.m_Match == E_MATCH_IDENTICAL )
+    {
+      rp->m_Live[i] = 1;
+      if( !move_slots( rp, from, to, ri ) )
+      {
+        if( !restart_above( rp, to, i ) )
+          return reset( rp, to_bss );
+        rp->m_Live[i] = 0;
+        restarted = true;
+      }
+      ++i;
+      continue;
+    }
+    if( ri.m_Match == E_MATCH_RESTART )
+      restart( rp, to, ri );
+    else if( !restart_above( rp, to, ri.m_Parent ) )
+      return reset( rp, to_bss );
+    restarted = true;
+    i = ri.m_End;
+  }
+  return restarted ? E_RELOAD_RESTARTED : E_RELOAD_MIGRATED;
+}
+
+unsigned int reload_batch( ReloadPlan* rp, CallbackBatch* batch, void* bss,
+  unsigned int stride )
+{
+  unsigned int reset = 0;
+  for( unsigned int i = 0; i < batch->m_Count; ++i )
+  {
+    const char* f = (const char*)batch->m_bss + (size_t)batch->m_Stride * i;
+    char* t = (char*)bss + (size_t)stride * i;
+    if( reload_agent( rp, f, t ) == E_RELOAD_RESET )
+      ++reset;
+  }
+  batch->m_Program = rp->m_Program;
+  batch->m_bss     = bss;
+  batch->m_Stride  = stride;
+  return reset;
+}
+
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_RESOLVE_H_
+#define CALLBACK_RESOLVE_H_
+
+#include <callback/callback.h>
+
+namespace callback
+{
+
+/*
+ * Turns the variable list at "list" into pointers into the data section,
+ * stored in "vars" which must hold MAX_CALLBACK_VARIABLES. Returns "vars".
+ */
+void** resolve_variables( const char* list, char* data, void** vars );
+
+/*
+ * The size of the code between the ProgramHeader and the data section, for
+ * any of the instruction formats.
+ */
+unsigned int get_code_size( const ProgramHeader* ph );
+
+/*
+ * Where instruction "ip" of a compact program starts, "offsets" is its offset
+ * table and "code" the encoded code after it. The opcodes of a breakpoint
+ * copy skipped on the way are those of the instructions they replaced.
+ */
+const unsigned char* compact_seek( const ProgramHeader* ph, const unsigned int* offsets,
+  const unsigned char* code, unsigned int ip );
+
+/*
+ * Frames taken from a frame pool are referred to by their offset in the
+ * pool's memory with this bit set, in frame pointers and in registers.
+ */
+const unsigned int POOLED_FRAME = 0x80000000;
+
+/*
+ * The pointer for a register that refers to the bss or to a frame in "pool",
+ * the memory of the agent's frame pool. Null if it is zero.
+ */
+void* resolve_register( BssHeader* bh, char* pool, unsigned int r );
+
+/*
+ * The memory of a frame pool, null if there is no pool. It never moves.
+ */
+char* get_frame_memory( FramePool* fp );
+
+/*
+ * Takes a frame from the pool, returns it with POOLED_FRAME set or zero if
+ * the pool is empty or null.
+ */
+unsigned int take_frame( FramePool* fp );
+
+/*
+ * Gives a frame from take_frame back to the pool.
+ */
+void give_frame( FramePool* fp, unsigned int frame );
+
+/*
+ * Makes the debug callback, if there is one, with the debug registers turned
+ * into a DebugInformation.
+ */
+void call_debug( CallbackProgram* info, BssHeader* bh, char* data );
+
+/*
+ * The instruction the breakpoint at "ip" of "program" replaced, null if there
+ * is none. See breakpoints.h.
+ */
+const WideInstruction* find_breakpoint( const void* program, unsigned int ip );
+
+/*
+ * Passes the breakpoints at m_IP of the BssHeader of "info", of the copy of a
+ * program "program", to the debug handler if there is one.
+ */
+void call_breakpoints( CallbackProgram* info, const void* program );
+
+}
+
+#endif /* CALLBACK_RESOLVE_H_ */
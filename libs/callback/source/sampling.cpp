@@ -0,0 +1,202 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/sampling.h>
+
+#include "resolve.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(LINUX) && defined(GCC)
+  #include <signal.h>
+  #include <sys/time.h>
+  #define CALLBACK_SAMPLING_SIGPROF
+#endif
+
+namespace callback
+{
+
+/*
+ * Samples are claimed with an atomic add on m_Taken, so any number of threads
+ * can be interrupted at once.
+ */
+struct SampleBuffer
+{
+  Sample*               m_Samples;
+  unsigned int          m_Size;
+  volatile unsigned int m_Taken;
+};
+
+SampleBuffer* create_sample_buffer( unsigned int samples )
+{
+  SampleBuffer* sb = (SampleBuffer*)malloc( sizeof(SampleBuffer) );
+  if( !sb )
+    return 0x0;
+  sb->m_Samples = (Sample*)malloc( sizeof(Sample) * (samples ? samples : 1) );
+  if( !sb->m_Samples )
+  {
+    free( sb );
+    return 0x0;
+  }
+  sb->m_Size  = samples;
+  sb->m_Taken = 0;
+  return sb;
+}
+
+void destroy_sample_buffer( SampleBuffer* sb )
+{
+  if( !sb )
+    return;
+  free( sb->m_Samples );
+  free( sb );
+}
+
+unsigned int get_sample_count( const SampleBuffer* sb )
+{
+  return sb->m_Taken < sb->m_Size ? sb->m_Taken : sb->m_Size;
+}
+
+const Sample* get_samples( const SampleBuffer* sb )
+{
+  return sb->m_Samples;
+}
+
+unsigned int get_samples_dropped( const SampleBuffer* sb )
+{
+  return sb->m_Taken - get_sample_count( sb );
+}
+
+/*
+ * The CallFrame of a tree call is just before the frame of the called tree.
+ * Frame pointers are checked against the bss so a sample taken while one is
+ * being changed can not read outside of it.
+ */
+bool take_sample( Sample* s )
+{
+  CallbackProgram* cp = get_running_program();
+  if( !cp )
+    return false;
+  BssHeader* bh = (BssHeader*)cp->m_bss;
+  const ProgramHeader* ph = (const ProgramHeader*)cp->m_Program;
+  char* const base = (char*)bh + sizeof(BssHeader);
+  char* const pool = get_frame_memory( cp->m_Frames );
+
+  s->m_Agent = (unsigned long long)(size_t)bh;
+  s->m_IP[0] = bh->m_IP;
+  unsigned int depth = 1;
+  unsigned int fp = bh->m_FP;
+  while( fp != 0 && depth < MAX_SAMPLE_DEPTH )
+  {
+    const CallFrame* f;
+    if( fp & POOLED_FRAME )
+    {
+      if( !pool || (fp & ~POOLED_FRAME) < sizeof(CallFrame) )
+        break;
+      f = (const CallFrame*)(pool + (fp & ~POOLED_FRAME)) - 1;
+    }
+    else
+    {
+      if( fp < sizeof(CallFrame) || fp > ph->m_BS - sizeof(BssHeader) )
+        break;
+      f = (const CallFrame*)(base + fp) - 1;
+    }
+    s->m_IP[depth++] = (unsigned int)f->m_IP;
+    fp = f->m_FP;
+  }
+  s->m_Depth = depth;
+  return true;
+}
+
+#if defined(CALLBACK_SAMPLING_SIGPROF)
+
+static SampleBuffer* volatile g_Sampling = 0x0;
+static volatile unsigned int  g_InHandler = 0;
+static struct sigaction       g_OldAction;
+
+static void on_sigprof( int )
+{
+  //Counted before the buffer is looked at, stop_sampling waits for it
+  __sync_fetch_and_add( &g_InHandler, 1 );
+  SampleBuffer* sb = g_Sampling;
+  Sample s;
+  if( sb && take_sample( &s ) )
+  {
+    const unsigned int i = __sync_fetch_and_add( &sb->m_Taken, 1 );
+    if( i < sb->m_Size )
+      sb->m_Samples[i] = s;
+  }
+  __sync_fetch_and_sub( &g_InHandler, 1 );
+}
+
+bool start_sampling( SampleBuffer* sb, unsigned int interval )
+{
+  if( !sb || g_Sampling || interval == 0 )
+    return false;
+  struct sigaction sa;
+  memset( &sa, 0, sizeof(sa) );
+  sa.sa_handler = &on_sigprof;
+  sa.sa_flags   = SA_RESTART;
+  sigemptyset( &sa.sa_mask );
+  if( sigaction( SIGPROF, &sa, &g_OldAction ) != 0 )
+    return false;
+  __sync_synchronize();
+  g_Sampling = sb;
+  __sync_synchronize();
+
+  struct itimerval t;
+  t.it_interval.tv_sec  = interval / 1000000;
+  t.it_interval.tv_usec = interval % 1000000;
+  t.it_value = t.it_interval;
+  if( setitimer( ITIMER_PROF, &t, 0x0 ) != 0 )
+  {
+    g_Sampling = 0x0;
+    sigaction( SIGPROF, &g_OldAction, 0x0 );
+    return false;
+  }
+  return true;
+}
+
+void stop_sampling()
+{
+  SampleBuffer* sb = g_Sampling;
+  if( !sb )
+    return;
+  struct itimerval t;
+  memset( &t, 0, sizeof(t) );
+  setitimer( ITIMER_PROF, &t, 0x0 );
+  g_Sampling = 0x0;
+  __sync_synchronize();
+  //Handlers that got the buffer before it was cleared finish their sample
+  while( g_InHandler != 0 )
+    __sync_synchronize();
+  //A signal that is still pending must not end the process
+  struct sigaction sa;
+  memset( &sa, 0, sizeof(sa) );
+  sa.sa_handler = SIG_IGN;
+  sigemptyset( &sa.sa_mask );
+  sigaction( SIGPROF, g_OldAction.sa_handler == SIG_DFL ? &sa : &g_OldAction, 0x0 );
+}
+
+#else
+
+bool start_sampling( SampleBuffer*, unsigned int )
+{
+  return false;
+}
+
+void stop_sampling()
+{
+}
+
+#endif
+
+}
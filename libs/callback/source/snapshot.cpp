@@ -0,0 +1,268 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/snapshot.h>
+
+#include <string.h>
+
+namespace callback
+{
+
+/*
+ * A snapshot is a SnapshotHeader followed by one record per agent:
+ *
+ *   m_IC, m_IP, m_FP, m_RE   of the BssHeader
+ *   m_R[5]                   only if m_IP is not zero
+ *   runs                     covering the bss after the BssHeader, word by word
+ *   tail                     one word holding the last bss bytes, if the bss
+ *                            is not a whole number of words
+ *
+ * Each run is a word holding a count of zero words in the high half and a
+ * count of literal words in the low half, followed by the literal words.
+ */
+
+const unsigned int SNAPSHOT_MAGIC = 0x50414e53; // "SNAP"
+const unsigned int SNAPSHOT_RUN_MAX = 0xffff;
+
+struct SnapshotHeader
+{
+  unsigned int m_Magic;
+  unsigned int m_Version;
+  unsigned int m_IC;    // Instruction count of the program
+  unsigned int m_BS;    // .bss size of the program
+  unsigned int m_Count; // Agents
+};
+
+struct SnapshotLayout
+{
+  unsigned int m_IC;
+  unsigned int m_BS;
+  unsigned int m_Words; // Whole words after the BssHeader
+  unsigned int m_Tail;  // Bytes after those
+};
+
+static void get_layout( void* program, SnapshotLayout* sl )
+{
+  ProgramHeader* ph = (ProgramHeader*)program;
+  unsigned int body = ph->m_BS > sizeof(BssHeader) ? ph->m_BS - sizeof(BssHeader) : 0;
+  sl->m_IC    = ph->m_IC;
+  sl->m_BS    = ph->m_BS;
+  sl->m_Words = body / sizeof(unsigned int);
+  sl->m_Tail  = body % sizeof(unsigned int);
+}
+
+static unsigned int get_agent_bound( const SnapshotLayout& sl )
+{
+  //Every run covers at least one word
+  unsigned int words = 4 + 5 + (2 * sl.m_Words) + 1;
+  if( sl.m_Tail )
+    ++words;
+  return words * sizeof(unsigned int);
+}
+
+static unsigned int* save_agent( const SnapshotLayout& sl, const char* bss,
+  unsigned int* out, unsigned int* end )
+{
+  const BssHeader* bh = (const BssHeader*)bss;
+  const unsigned int header = bh->m_IP != 0 ? 9 : 4;
+  if( out + header > end )
+    return 0x0;
+  *out++ = bh->m_IC;
+  *out++ = bh->m_IP;
+  *out++ = bh->m_FP;
+  *out++ = bh->m_RE;
+  if( bh->m_IP != 0 )
+  {
+    for( unsigned int r = 0; r < 5; ++r )
+      *out++ = bh->m_R[r];
+  }
+
+  const unsigned int* w = (const unsigned int*)(bss + sizeof(BssHeader));
+  const unsigned int words = sl.m_Words;
+  unsigned int i = 0;
+  while( i < words )
+  {
+    unsigned int z = 0;
+    while( i + z < words && z < SNAPSHOT_RUN_MAX && w[i + z] == 0 )
+      ++z;
+    i += z;
+
+    //Single zero words are kept in the literals, they cost a word either way
+    unsigned int l = 0;
+    while( i + l < words && l < SNAPSHOT_RUN_MAX
+      && (w[i + l] != 0 || (i + l + 1 < words && w[i + l + 1] != 0)) )
+      ++l;
+
+    if( out + 1 + l > end )
+      return 0x0;
+    *out++ = (z << 16) | l;
+    memcpy( out, w + i, l * sizeof(unsigned int) );
+    out += l;
+    i += l;
+  }
+
+  if( sl.m_Tail )
+  {
+    if( out + 1 > end )
+      return 0x0;
+    *out = 0;
+    memcpy( out, w + words, sl.m_Tail );
+    ++out;
+  }
+  return out;
+}
+
+static const unsigned int* load_agent( const SnapshotLayout& sl, char* bss,
+  const unsigned int* in, const unsigned int* end )
+{
+  BssHeader* bh = (BssHeader*)bss;
+  if( in + 4 > end )
+    return 0x0;
+  bh->m_IC = *in++;
+  bh->m_IP = *in++;
+  bh->m_FP = *in++;
+  bh->m_RE = *in++;
+  if( bh->m_IP != 0 )
+  {
+    if( in + 5 > end )
+      return 0x0;
+    for( unsigned int r = 0; r < 5; ++r )
+      bh->m_R[r] = *in++;
+  }
+  else
+  {
+    for( unsigned int r = 0; r < 5; ++r )
+      bh->m_R[r] = 0;
+  }
+
+  unsigned int* w = (unsigned int*)(bss + sizeof(BssHeader));
+  const unsigned int words = sl.m_Words;
+  unsigned int i = 0;
+  while( i < words )
+  {
+    if( in >= end )
+      return 0x0;
+    unsigned int z = *in >> 16;
+    unsigned int l = *in & 0xffff;
+    ++in;
+    if( z + l == 0 || z + l > words - i || in + l > end )
+      return 0x0;
+    memset( w + i, 0, z * sizeof(unsigned int) );
+    i += z;
+    memcpy( w + i, in, l * sizeof(unsigned int) );
+    i += l;
+    in += l;
+  }
+
+  if( sl.m_Tail )
+  {
+    if( in >= end )
+      return 0x0;
+    memcpy( w + words, in, sl.m_Tail );
+    ++in;
+  }
+  return in;
+}
+
+static unsigned int* save_header( const SnapshotLayout& sl, unsigned int count,
+  void* buffer, unsigned int size )
+{
+  if( size < sizeof(SnapshotHeader) )
+    return 0x0;
+  SnapshotHeader* sh = (SnapshotHeader*)buffer;
+  sh->m_Magic   = SNAPSHOT_MAGIC;
+  sh->m_Version = SNAPSHOT_VERSION;
+  sh->m_IC      = sl.m_IC;
+  sh->m_BS      = sl.m_BS;
+  sh->m_Count   = count;
+  return (unsigned int*)(sh + 1);
+}
+
+static const unsigned int* load_header( const SnapshotLayout& sl, unsigned int count,
+  const void* buffer, unsigned int size )
+{
+  if( size < sizeof(SnapshotHeader) )
+    return 0x0;
+  const SnapshotHeader* sh = (const SnapshotHeader*)buffer;
+  if( sh->m_Magic != SNAPSHOT_MAGIC || sh->m_Version != SNAPSHOT_VERSION
+    || sh->m_IC != sl.m_IC || sh->m_BS != sl.m_BS || sh->m_Count != count )
+    return 0x0;
+  return (const unsigned int*)(sh + 1);
+}
+
+unsigned int get_snapshot_bound( void* program, unsigned int count )
+{
+  SnapshotLayout sl;
+  get_layout( program, &sl );
+  return sizeof(SnapshotHeader) + (get_agent_bound( sl ) * count);
+}
+
+int save_snapshot( CallbackProgram* info, void* buffer, unsigned int size )
+{
+  CallbackBatch batch;
+  memset( &batch, 0, sizeof(CallbackBatch) );
+  batch.m_Program = info->m_Program;
+  batch.m_bss     = info->m_bss;
+  batch.m_Count   = 1;
+  return save_snapshots( &batch, buffer, size );
+}
+
+int load_snapshot( CallbackProgram* info, const void* buffer, unsigned int size )
+{
+  CallbackBatch batch;
+  memset( &batch, 0, sizeof(CallbackBatch) );
+  batch.m_Program = info->m_Program;
+  batch.m_bss     = info->m_bss;
+  batch.m_Count   = 1;
+  return load_snapshots( &batch, buffer, size );
+}
+
+int save_snapshots( CallbackBatch* batch, void* buffer, unsigned int size )
+{
+  //Frames from a frame pool are not in the bss
+  if( ((ProgramHeader*)batch->m_Program)->m_FS != 0 )
+    return -1;
+
+  SnapshotLayout sl;
+  get_layout( batch->m_Program, &sl );
+
+  unsigned int* out = save_header( sl, batch->m_Count, buffer, size );
+  unsigned int* end = (unsigned int*)((char*)buffer + (size & ~3u));
+  const char* bss = (const char*)batch->m_bss;
+  for( unsigned int a = 0; a < batch->m_Count && out; ++a, bss += batch->m_Stride )
+    out = save_agent( sl, bss, out, end );
+
+  if( !out )
+    return -1;
+  return (int)((char*)out - (char*)buffer);
+}
+
+int load_snapshots( CallbackBatch* batch, const void* buffer, unsigned int size )
+{
+  //Frames from a frame pool are not in the bss
+  if( ((ProgramHeader*)batch->m_Program)->m_FS != 0 )
+    return -1;
+
+  SnapshotLayout sl;
+  get_layout( batch->m_Program, &sl );
+
+  const unsigned int* in = load_header( sl, batch->m_Count, buffer, size );
+  const unsigned int* end = (const unsigned int*)((const char*)buffer + (size & ~3u));
+  char* bss = (char*)batch->m_bss;
+  for( unsigned int a = 0; a < batch->m_Count && in; ++a, bss += batch->m_Stride )
+    in = load_agent( sl, bss, in, end );
+
+  if( !in )
+    return -1;
+  return (int)((const char*)in - (const char*)buffer);
+}
+
+}
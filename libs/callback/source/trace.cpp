@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <callback/trace.h>
+#include <callback/platform.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(MSVC)
+  #define TRACE_BARRIER() _ReadWriteBarrier()
+#elif defined(GCC)
+  #if defined(__x86_64__) || defined(__i386__)
+    //Stores are not reordered with stores, nor loads with loads, on x86
+    #define TRACE_BARRIER() __asm__ __volatile__( "" ::: "memory" )
+  #else
+    #define TRACE_BARRIER() __sync_synchronize()
+  #endif
+#else
+  #error "Compiler not supported."
+#endif
+
+namespace callback
+{
+
+/*
+ * Event N is written to m_Events[N & m_Mask] before m_Write is set to N + 1.
+ * The slot of event N - m_Mask - 1 may be half written by the time a reader
+ * sees m_Write at N, so at most m_Mask events can be read whole.
+ */
+struct TraceBuffer
+{
+  TraceEvent*           m_Events;
+  unsigned int          m_Mask;
+  volatile unsigned int m_Write; // Events recorded, wraps at 2^32
+};
+
+static THREAD_LOCAL TraceBuffer* g_TraceBuffer = 0x0;
+
+TraceBuffer* create_trace_buffer( unsigned int events )
+{
+  unsigned int size = 2;
+  while( size < events && size < 0x80000000 )
+    size <<= 1;
+  TraceBuffer* tb = (TraceBuffer*)malloc( sizeof(TraceBuffer) );
+  if( !tb )
+    return 0x0;
+  tb->m_Events = (TraceEvent*)malloc( sizeof(TraceEvent) * size );
+  if( !tb->m_Events )
+  {
+    free( tb );
+    return 0x0;
+  }
+  tb->m_Mask  = size - 1;
+  tb->m_Write = 0;
+  return tb;
+}
+
+void destroy_trace_buffer( TraceBuffer* tb )
+{
+  if( !tb )
+    return;
+  free( tb->m_Events );
+  free( tb );
+}
+
+TraceBuffer* set_trace_buffer( TraceBuffer* tb )
+{
+  TraceBuffer* old = g_TraceBuffer;
+  g_TraceBuffer = tb;
+  return old;
+}
+
+TraceBuffer* get_trace_buffer()
+{
+  return g_TraceBuffer;
+}
+
+void trace_node( BssHeader* bh, unsigned int id, unsigned int kind, unsigned int re )
+{
+  TraceBuffer* tb = g_TraceBuffer;
+  if( !tb )
+    return;
+  const unsigned int w = tb->m_Write;
+  TraceEvent* e = tb->m_Events + (w & tb->m_Mask);
+  e->m_Time   = read_time_stamp();
+  e->m_Agent  = (unsigned long long)(size_t)bh;
+  e->m_Id     = id;
+  e->m_Kind   = (unsigned short)kind;
+  e->m_Result = (unsigned short)re;
+  TRACE_BARRIER();
+  tb->m_Write = w + 1;
+}
+
+unsigned int read_trace( TraceBuffer* tb, unsigned int* cursor, TraceEvent* out,
+  unsigned int max, unsigned int* lost )
+{
+  const unsigned int keep = tb->m_Mask;
+  const unsigned int write = tb->m_Write;
+  TRACE_BARRIER();
+
+  unsigned int first = *cursor;
+  if( write - first > keep )
+    first = write - keep;
+  unsigned int count = write - first;
+  if( count > max )
+    count = max;
+  for( unsigned int i = 0; i < count; ++i )
+    out[i] = tb->m_Events[(first + i) & tb->m_Mask];
+  TRACE_BARRIER();
+
+  //The ones the writer got to while they were copied can not be trusted
+  const unsigned int now = tb->m_Write;
+  unsigned int skip = 0;
+  if( now - first > keep )
+    skip = now - keep - first;
+  if( skip > count )
+    skip = count;
+  if( skip )
+    memmove( out, out + skip, sizeof(TraceEvent) * (count - skip) );
+
+  if( lost )
+    *lost += (first - *cursor) + skip;
+  *cursor = first + count;
+  return count - skip;
+}
+
+}
@@ -0,0 +1,1021 @@
+/*
+ * This file is auto generated by ctc from native_test.bts.
+ * Manual edits will be lost when regenerated.
+ */
+
+#include <callback/callback.h>
+#include <callback/instructions.h>
+#include <callback/counters.h>
+
+#include <stddef.h>
+
+using namespace callback;
+
+extern const unsigned int native_test_bss_size = 396;
+
+static const unsigned int s_native_test_CounterIds[] =
+{
+  0x00000010u, 0x00000005u, 0x0000000du, 0x00000007u, 0x00000006u, 0x0000000bu, 0x00000008u, 0x00000009u,
+  0x0000000au, 0x0000000cu, 0x0000000eu, 0x0000000fu, 0x00000004u, 0x00000000u, 0x00000002u, 0x00000001u,
+  0x00000003u,
+};
+
+extern const CounterLayout native_test_counters =
+{
+  17, 88, 16, s_native_test_CounterIds
+};
+
+static inline void** resolve_variables( const char* list, char* data, void** vars )
+{
+  const unsigned int* l = (const unsigned int*)list;
+  for( unsigned int v = 0; v < l[0]; ++v )
+    vars[v] = data + l[v + 1];
+  return vars;
+}
+
+static inline void* resolve_register( BssHeader* bh, unsigned int r )
+{
+  return r ? (void*)((char*)bh + r) : 0x0;
+}
+
+static union
+{
+  unsigned char m_Bytes[3240];
+  double m_Align;
+} s_native_test_Data =
+{
+  {
+    0x73,0x74,0x61,0x72,0x74,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x0b,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x10,0x00,0x00,0x00,
+    0x64,0x6f,0x6e,0x65,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x20,0x00,0x00,0x00,
+    0x07,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x30,0x00,0x00,0x00,
+    0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x00,0x00,0x00,0x40,0x00,0x00,0x00,
+    0x44,0x45,0x53,0x54,0x52,0x55,0x43,0x54,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x53,0x65,0x71,0x75,0x65,0x6e,0x63,0x65,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x43,0x4f,0x4e,0x53,0x54,0x52,0x55,0x43,0x54,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x45,0x58,0x45,0x43,0x55,0x54,0x45,0x00,0x61,0x63,0x74,0x5f,0x70,0x72,0x69,0x6e,
+    0x74,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x44,0x79,0x6e,0x61,0x6d,0x69,0x63,0x20,
+    0x53,0x65,0x6c,0x65,0x63,0x74,0x6f,0x72,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x64,0x65,0x63,0x5f,0x70,0x72,0x75,0x6e,0x65,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x77,0x6f,0x72,0x6b,0x65,0x72,0x00,0x00,0x50,0x52,0x55,0x4e,0x45,0x00,0x00,0x00,
+    0x53,0x65,0x6c,0x65,0x63,0x74,0x6f,0x72,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x61,0x63,0x74,0x5f,0x63,0x68,0x65,0x63,0x6b,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x61,0x63,0x74,0x5f,0x76,0x61,0x6c,0x75,0x65,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x50,0x61,0x72,0x61,0x6c,0x6c,0x65,0x6c,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x64,0x65,0x63,0x5f,0x6d,0x6f,0x64,0x69,0x66,0x79,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x4d,0x4f,0x44,0x49,0x46,0x59,0x00,0x00,0x02,0x00,0x00,0x00,0x64,0x00,0x00,0x00,
+    0x01,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x65,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x10,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x12,0x00,0x00,0x00,0x10,0x00,0x00,0x00,
+    0x52,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x60,0x00,0x00,0x00,
+    0x12,0x00,0x00,0x00,0x10,0x00,0x00,0x00,0x12,0x00,0x00,0x00,0x10,0x00,0x00,0x00,
+    0x92,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x60,0x00,0x00,0x00,
+    0x13,0x00,0x00,0x00,0x13,0x00,0x00,0x00,0x15,0x00,0x00,0x00,0x10,0x00,0x00,0x00,
+    0x50,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x60,0x00,0x00,0x00,
+    0x15,0x00,0x00,0x00,0x13,0x00,0x00,0x00,0x15,0x00,0x00,0x00,0x10,0x00,0x00,0x00,
+    0x90,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x60,0x00,0x00,0x00,
+    0x17,0x00,0x00,0x00,0x17,0x00,0x00,0x00,0xac,0x00,0x00,0x00,0x10,0x00,0x00,0x00,
+    0x51,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x60,0x00,0x00,0x00,
+    0x18,0x00,0x00,0x00,0x18,0x00,0x00,0x00,0x18,0x00,0x00,0x00,0x05,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x32,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0x18,0x00,0x00,0x00,0x18,0x00,0x00,0x00,0x18,0x00,0x00,0x00,0x05,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x32,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0x1a,0x00,0x00,0x00,0x1a,0x00,0x00,0x00,0x1b,0x00,0x00,0x00,0x05,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x32,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0x1b,0x00,0x00,0x00,0x1a,0x00,0x00,0x00,0x1b,0x00,0x00,0x00,0x05,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x32,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0x20,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x24,0x00,0x00,0x00,0x0d,0x00,0x00,0x00,
+    0x50,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x98,0x00,0x00,0x00,
+    0x24,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x24,0x00,0x00,0x00,0x0d,0x00,0x00,0x00,
+    0x90,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x98,0x00,0x00,0x00,
+    0x26,0x00,0x00,0x00,0x26,0x00,0x00,0x00,0x89,0x00,0x00,0x00,0x0d,0x00,0x00,0x00,
+    0x51,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x98,0x00,0x00,0x00,
+    0x3c,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x3c,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x06,0x00,0x00,0x00,
+    0x60,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x3e,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x06,0x00,0x00,0x00,
+    0xa0,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x3e,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x46,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x41,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x43,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0xc8,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x41,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x83,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0xc8,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x43,0x00,0x00,0x00,0x43,0x00,0x00,0x00,0x45,0x00,0x00,0x00,0x06,0x00,0x00,0x00,
+    0x61,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x45,0x00,0x00,0x00,0x43,0x00,0x00,0x00,0x45,0x00,0x00,0x00,0x06,0x00,0x00,0x00,
+    0xa1,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x46,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x46,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x4a,0x00,0x00,0x00,0x4a,0x00,0x00,0x00,0x4c,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x4a,0x00,0x00,0x00,0x4a,0x00,0x00,0x00,0x4c,0x00,0x00,0x00,0x06,0x00,0x00,0x00,
+    0x62,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x4c,0x00,0x00,0x00,0x4a,0x00,0x00,0x00,0x4c,0x00,0x00,0x00,0x06,0x00,0x00,0x00,
+    0xa2,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x4c,0x00,0x00,0x00,0x4a,0x00,0x00,0x00,0x4c,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x34,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xb0,0x00,0x00,0x00,
+    0x4e,0x00,0x00,0x00,0x4e,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,
+    0x50,0x00,0x00,0x00,0x39,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xd0,0x00,0x00,0x00,
+    0x50,0x00,0x00,0x00,0x4e,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,
+    0x90,0x00,0x00,0x00,0x39,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xd0,0x00,0x00,0x00,
+    0x52,0x00,0x00,0x00,0x52,0x00,0x00,0x00,0x73,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,
+    0x51,0x00,0x00,0x00,0x39,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xd0,0x00,0x00,0x00,
+    0x53,0x00,0x00,0x00,0x53,0x00,0x00,0x00,0x53,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x36,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0x53,0x00,0x00,0x00,0x53,0x00,0x00,0x00,0x53,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x36,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0x55,0x00,0x00,0x00,0x55,0x00,0x00,0x00,0x56,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x36,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0x56,0x00,0x00,0x00,0x55,0x00,0x00,0x00,0x56,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x36,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0x63,0x00,0x00,0x00,0x63,0x00,0x00,0x00,0x64,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0x64,0x00,0x00,0x00,0x63,0x00,0x00,0x00,0x64,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0x66,0x00,0x00,0x00,0x66,0x00,0x00,0x00,0x67,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0x67,0x00,0x00,0x00,0x66,0x00,0x00,0x00,0x67,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0x6d,0x00,0x00,0x00,0x6d,0x00,0x00,0x00,0x6d,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x36,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0x6d,0x00,0x00,0x00,0x6d,0x00,0x00,0x00,0x6d,0x00,0x00,0x00,0x08,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x36,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0x6f,0x00,0x00,0x00,0x6f,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0x70,0x00,0x00,0x00,0x6f,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x0a,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x38,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0x73,0x00,0x00,0x00,0x52,0x00,0x00,0x00,0x73,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,
+    0x91,0x00,0x00,0x00,0x39,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xd0,0x00,0x00,0x00,
+    0x77,0x00,0x00,0x00,0x77,0x00,0x00,0x00,0x79,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,
+    0x52,0x00,0x00,0x00,0x39,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xd0,0x00,0x00,0x00,
+    0x79,0x00,0x00,0x00,0x77,0x00,0x00,0x00,0x79,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,
+    0x92,0x00,0x00,0x00,0x39,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xd0,0x00,0x00,0x00,
+    0x89,0x00,0x00,0x00,0x26,0x00,0x00,0x00,0x89,0x00,0x00,0x00,0x0d,0x00,0x00,0x00,
+    0x91,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x98,0x00,0x00,0x00,
+    0x8e,0x00,0x00,0x00,0x8e,0x00,0x00,0x00,0x90,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,
+    0x60,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x90,0x00,0x00,0x00,0x8e,0x00,0x00,0x00,0x90,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,
+    0xa0,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x92,0x00,0x00,0x00,0x92,0x00,0x00,0x00,0x94,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,
+    0x61,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x94,0x00,0x00,0x00,0x92,0x00,0x00,0x00,0x94,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,
+    0xa1,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0x99,0x00,0x00,0x00,0x99,0x00,0x00,0x00,0x99,0x00,0x00,0x00,0x0f,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x3f,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0x99,0x00,0x00,0x00,0x99,0x00,0x00,0x00,0x99,0x00,0x00,0x00,0x0f,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x3f,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0x9b,0x00,0x00,0x00,0x9b,0x00,0x00,0x00,0x9c,0x00,0x00,0x00,0x0f,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x3f,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0x9c,0x00,0x00,0x00,0x9b,0x00,0x00,0x00,0x9c,0x00,0x00,0x00,0x0f,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x3f,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0xa2,0x00,0x00,0x00,0xa2,0x00,0x00,0x00,0xa2,0x00,0x00,0x00,0x05,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x32,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0xa2,0x00,0x00,0x00,0xa2,0x00,0x00,0x00,0xa2,0x00,0x00,0x00,0x05,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x32,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0xa3,0x00,0x00,0x00,0xa3,0x00,0x00,0x00,0xa5,0x00,0x00,0x00,0x0d,0x00,0x00,0x00,
+    0x52,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x98,0x00,0x00,0x00,
+    0xa5,0x00,0x00,0x00,0xa3,0x00,0x00,0x00,0xa5,0x00,0x00,0x00,0x0d,0x00,0x00,0x00,
+    0x92,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x98,0x00,0x00,0x00,
+    0xa6,0x00,0x00,0x00,0xa6,0x00,0x00,0x00,0xa8,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,
+    0x62,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0xa8,0x00,0x00,0x00,0xa6,0x00,0x00,0x00,0xa8,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,
+    0xa2,0x00,0x00,0x00,0x3e,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xc0,0x00,0x00,0x00,
+    0xa9,0x00,0x00,0x00,0xa9,0x00,0x00,0x00,0xa9,0x00,0x00,0x00,0x0f,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x3f,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0xa9,0x00,0x00,0x00,0xa9,0x00,0x00,0x00,0xa9,0x00,0x00,0x00,0x0f,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x3f,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x88,0x00,0x00,0x00,
+    0xac,0x00,0x00,0x00,0x17,0x00,0x00,0x00,0xac,0x00,0x00,0x00,0x10,0x00,0x00,0x00,
+    0x91,0x00,0x00,0x00,0x40,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x60,0x00,0x00,0x00,
+    0xb3,0x00,0x00,0x00,0xb3,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+    0x52,0x00,0x00,0x00,0x2b,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x00,0x01,0x00,0x00,
+    0xb3,0x00,0x00,0x00,0xb3,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0xb4,0x00,0x00,0x00,0xb3,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+    0x42,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x82,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xb4,0x00,0x00,0x00,0xb3,0x00,0x00,0x00,0xb4,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+    0x92,0x00,0x00,0x00,0x2b,0x00,0x00,0x00,0x50,0x00,0x00,0x00,0x00,0x01,0x00,0x00,
+    0xb5,0x00,0x00,0x00,0xb5,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+    0x50,0x00,0x00,0x00,0x2b,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x00,0x01,0x00,0x00,
+    0xb5,0x00,0x00,0x00,0xb5,0x00,0x00,0x00,0xb6,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0xb6,0x00,0x00,0x00,0xb5,0x00,0x00,0x00,0xb6,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0xb6,0x00,0x00,0x00,0xb6,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xb7,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+    0x40,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0xb7,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0xb7,0x00,0x00,0x00,0xb6,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x80,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xb7,0x00,0x00,0x00,0xb5,0x00,0x00,0x00,0xb7,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+    0x90,0x00,0x00,0x00,0x2b,0x00,0x00,0x00,0x70,0x00,0x00,0x00,0x00,0x01,0x00,0x00,
+    0xb9,0x00,0x00,0x00,0xb9,0x00,0x00,0x00,0xd3,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+    0x51,0x00,0x00,0x00,0x2b,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x00,0x01,0x00,0x00,
+    0xbb,0x00,0x00,0x00,0xbb,0x00,0x00,0x00,0xbc,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0xbc,0x00,0x00,0x00,0xbb,0x00,0x00,0x00,0xbc,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x28,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xf0,0x00,0x00,0x00,
+    0xc1,0x00,0x00,0x00,0xc1,0x00,0x00,0x00,0xc6,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xc2,0x00,0x00,0x00,0xc2,0x00,0x00,0x00,0xc3,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+    0x41,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0xc3,0x00,0x00,0x00,0xc2,0x00,0x00,0x00,0xc3,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0xe0,0x00,0x00,0x00,
+    0xc4,0x00,0x00,0x00,0xc4,0x00,0x00,0x00,0xc6,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x44,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x20,0x01,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xc6,0x00,0x00,0x00,0xc4,0x00,0x00,0x00,0xc6,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x84,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x20,0x01,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xc6,0x00,0x00,0x00,0xc1,0x00,0x00,0x00,0xc6,0x00,0x00,0x00,0x02,0x00,0x00,0x00,
+    0x81,0x00,0x00,0x00,0x29,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x10,0x01,0x00,0x00,
+    0xd3,0x00,0x00,0x00,0xb9,0x00,0x00,0x00,0xd3,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+    0x91,0x00,0x00,0x00,0x2b,0x00,0x00,0x00,0x80,0x00,0x00,0x00,0x00,0x01,0x00,0x00,
+    0x00,0x00,0xad,0x0d,0x51,0x00,0x00,0x50,0x6b,0x54,0x6d,0x00,0xd8,0xa0,0x89,0x02,
+    0x00,0x42,0x15,0x1a,0x6c,0x13,0xf8,0x1a,0x5e,0x00,0x08,0x00,0x00,0x00,0x00,0x00,
+    0x10,0x00,0x00,0x00,0x05,0x00,0x00,0x00,0x0d,0x00,0x00,0x00,0x07,0x00,0x00,0x00,
+    0x06,0x00,0x00,0x00,0x0b,0x00,0x00,0x00,0x08,0x00,0x00,0x00,0x09,0x00,0x00,0x00,
+    0x0a,0x00,0x00,0x00,0x0c,0x00,0x00,0x00,0x0e,0x00,0x00,0x00,0x0f,0x00,0x00,0x00,
+    0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+    0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+  }
+};
+
+static void native_test_execute( CallbackProgram* info )
+{
+  char* data = (char*)s_native_test_Data.m_Bytes;
+  BssHeader* bh = (BssHeader*)info->m_bss;
+  char* const base = (char*)(info->m_bss) + sizeof(BssHeader);
+  char* bss = base + bh->m_FP;
+  CallbackHandler ch = info->m_Callback;
+  DebugHandler dh = info->m_Debug;
+  const CallbackHandler* tab = info->m_Table;
+  unsigned int ic = bh->m_IC;
+  unsigned int ip = bh->m_IP;
+  void* vars[MAX_CALLBACK_VARIABLES];
+  (void)data; (void)ch; (void)dh; (void)tab; (void)vars;
+  const DebugScope* scopes = (const DebugScope*)(data + 320);
+  unsigned int from = 0xffffffffu;
+
+  if( ip == 0 )
+    goto L_0000;
+
+dispatch:
+  if( dh && from != 0xffffffffu ) { bh->m_IP = ip; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, from ); }
+  switch( ip )
+  {
+  case 0x0000: goto L_0000;
+  case 0x0001: goto L_0001;
+  case 0x0002: goto L_0002;
+  case 0x0003: goto L_0003;
+  case 0x0004: goto L_0004;
+  case 0x0005: goto L_0005;
+  case 0x0006: goto L_0006;
+  case 0x0007: goto L_0007;
+  case 0x0008: goto L_0008;
+  case 0x0009: goto L_0009;
+  case 0x000a: goto L_000a;
+  case 0x000b: goto L_000b;
+  case 0x000c: goto L_000c;
+  case 0x000d: goto L_000d;
+  case 0x000e: goto L_000e;
+  case 0x000f: goto L_000f;
+  case 0x0010: goto L_0010;
+  case 0x0011: goto L_0011;
+  case 0x0012: goto L_0012;
+  case 0x0013: goto L_0013;
+  case 0x0014: goto L_0014;
+  case 0x0015: goto L_0015;
+  case 0x0016: goto L_0016;
+  case 0x0017: goto L_0017;
+  case 0x0018: goto L_0018;
+  case 0x0019: goto L_0019;
+  case 0x001a: goto L_001a;
+  case 0x001b: goto L_001b;
+  case 0x001c: goto L_001c;
+  case 0x001d: goto L_001d;
+  case 0x001e: goto L_001e;
+  case 0x001f: goto L_001f;
+  case 0x0020: goto L_0020;
+  case 0x0021: goto L_0021;
+  case 0x0022: goto L_0022;
+  case 0x0023: goto L_0023;
+  case 0x0024: goto L_0024;
+  case 0x0025: goto L_0025;
+  case 0x0026: goto L_0026;
+  case 0x0027: goto L_0027;
+  case 0x0028: goto L_0028;
+  case 0x0029: goto L_0029;
+  case 0x002a: goto L_002a;
+  case 0x002b: goto L_002b;
+  case 0x002c: goto L_002c;
+  case 0x002d: goto L_002d;
+  case 0x002e: goto L_002e;
+  case 0x002f: goto L_002f;
+  case 0x0030: goto L_0030;
+  case 0x0031: goto L_0031;
+  case 0x0032: goto L_0032;
+  case 0x0033: goto L_0033;
+  case 0x0034: goto L_0034;
+  case 0x0035: goto L_0035;
+  case 0x0036: goto L_0036;
+  case 0x0037: goto L_0037;
+  case 0x0038: goto L_0038;
+  case 0x0039: goto L_0039;
+  case 0x003a: goto L_003a;
+  case 0x003b: goto L_003b;
+  case 0x003c: goto L_003c;
+  case 0x003d: goto L_003d;
+  case 0x003e: goto L_003e;
+  case 0x003f: goto L_003f;
+  case 0x0040: goto L_0040;
+  case 0x0041: goto L_0041;
+  case 0x0042: goto L_0042;
+  case 0x0043: goto L_0043;
+  case 0x0044: goto L_0044;
+  case 0x0045: goto L_0045;
+  case 0x0046: goto L_0046;
+  case 0x0047: goto L_0047;
+  case 0x0048: goto L_0048;
+  case 0x0049: goto L_0049;
+  case 0x004a: goto L_004a;
+  case 0x004b: goto L_004b;
+  case 0x004c: goto L_004c;
+  case 0x004d: goto L_004d;
+  case 0x004e: goto L_004e;
+  case 0x004f: goto L_004f;
+  case 0x0050: goto L_0050;
+  case 0x0051: goto L_0051;
+  case 0x0052: goto L_0052;
+  case 0x0053: goto L_0053;
+  case 0x0054: goto L_0054;
+  case 0x0055: goto L_0055;
+  case 0x0056: goto L_0056;
+  case 0x0057: goto L_0057;
+  case 0x0058: goto L_0058;
+  case 0x0059: goto L_0059;
+  case 0x005a: goto L_005a;
+  case 0x005b: goto L_005b;
+  case 0x005c: goto L_005c;
+  case 0x005d: goto L_005d;
+  case 0x005e: goto L_005e;
+  case 0x005f: goto L_005f;
+  case 0x0060: goto L_0060;
+  case 0x0061: goto L_0061;
+  case 0x0062: goto L_0062;
+  case 0x0063: goto L_0063;
+  case 0x0064: goto L_0064;
+  case 0x0065: goto L_0065;
+  case 0x0066: goto L_0066;
+  case 0x0067: goto L_0067;
+  case 0x0068: goto L_0068;
+  case 0x0069: goto L_0069;
+  case 0x006a: goto L_006a;
+  case 0x006b: goto L_006b;
+  case 0x006c: goto L_006c;
+  case 0x006d: goto L_006d;
+  case 0x006e: goto L_006e;
+  case 0x006f: goto L_006f;
+  case 0x0070: goto L_0070;
+  case 0x0071: goto L_0071;
+  case 0x0072: goto L_0072;
+  case 0x0073: goto L_0073;
+  case 0x0074: goto L_0074;
+  case 0x0075: goto L_0075;
+  case 0x0076: goto L_0076;
+  case 0x0077: goto L_0077;
+  case 0x0078: goto L_0078;
+  case 0x0079: goto L_0079;
+  case 0x007a: goto L_007a;
+  case 0x007b: goto L_007b;
+  case 0x007c: goto L_007c;
+  case 0x007d: goto L_007d;
+  case 0x007e: goto L_007e;
+  case 0x007f: goto L_007f;
+  case 0x0080: goto L_0080;
+  case 0x0081: goto L_0081;
+  case 0x0082: goto L_0082;
+  case 0x0083: goto L_0083;
+  case 0x0084: goto L_0084;
+  case 0x0085: goto L_0085;
+  case 0x0086: goto L_0086;
+  case 0x0087: goto L_0087;
+  case 0x0088: goto L_0088;
+  case 0x0089: goto L_0089;
+  case 0x008a: goto L_008a;
+  case 0x008b: goto L_008b;
+  case 0x008c: goto L_008c;
+  case 0x008d: goto L_008d;
+  case 0x008e: goto L_008e;
+  case 0x008f: goto L_008f;
+  case 0x0090: goto L_0090;
+  case 0x0091: goto L_0091;
+  case 0x0092: goto L_0092;
+  case 0x0093: goto L_0093;
+  case 0x0094: goto L_0094;
+  case 0x0095: goto L_0095;
+  case 0x0096: goto L_0096;
+  case 0x0097: goto L_0097;
+  case 0x0098: goto L_0098;
+  case 0x0099: goto L_0099;
+  case 0x009a: goto L_009a;
+  case 0x009b: goto L_009b;
+  case 0x009c: goto L_009c;
+  case 0x009d: goto L_009d;
+  case 0x009e: goto L_009e;
+  case 0x009f: goto L_009f;
+  case 0x00a0: goto L_00a0;
+  case 0x00a1: goto L_00a1;
+  case 0x00a2: goto L_00a2;
+  case 0x00a3: goto L_00a3;
+  case 0x00a4: goto L_00a4;
+  case 0x00a5: goto L_00a5;
+  case 0x00a6: goto L_00a6;
+  case 0x00a7: goto L_00a7;
+  case 0x00a8: goto L_00a8;
+  case 0x00a9: goto L_00a9;
+  case 0x00aa: goto L_00aa;
+  case 0x00ab: goto L_00ab;
+  case 0x00ac: goto L_00ac;
+  case 0x00ad: goto L_00ad;
+  case 0x00ae: goto L_00ae;
+  case 0x00af: goto L_00af;
+  case 0x00b0: goto L_00b0;
+  case 0x00b1: goto L_00b1;
+  case 0x00b2: goto L_00b2;
+  case 0x00b3: goto L_00b3;
+  case 0x00b4: goto L_00b4;
+  case 0x00b5: goto L_00b5;
+  case 0x00b6: goto L_00b6;
+  case 0x00b7: goto L_00b7;
+  case 0x00b8: goto L_00b8;
+  case 0x00b9: goto L_00b9;
+  case 0x00ba: goto L_00ba;
+  case 0x00bb: goto L_00bb;
+  case 0x00bc: goto L_00bc;
+  case 0x00bd: goto L_00bd;
+  case 0x00be: goto L_00be;
+  case 0x00bf: goto L_00bf;
+  case 0x00c0: goto L_00c0;
+  case 0x00c1: goto L_00c1;
+  case 0x00c2: goto L_00c2;
+  case 0x00c3: goto L_00c3;
+  case 0x00c4: goto L_00c4;
+  case 0x00c5: goto L_00c5;
+  case 0x00c6: goto L_00c6;
+  case 0x00c7: goto L_00c7;
+  case 0x00c8: goto L_00c8;
+  case 0x00c9: goto L_00c9;
+  case 0x00ca: goto L_00ca;
+  case 0x00cb: goto L_00cb;
+  case 0x00cc: goto L_00cc;
+  case 0x00cd: goto L_00cd;
+  case 0x00ce: goto L_00ce;
+  case 0x00cf: goto L_00cf;
+  case 0x00d0: goto L_00d0;
+  case 0x00d1: goto L_00d1;
+  case 0x00d2: goto L_00d2;
+  case 0x00d3: goto L_00d3;
+  case 0x00d4: goto L_00d4;
+  }
+  goto exit;
+
+  //__entry_stub
+L_0000: ++ic; // INST_JABC_C_EQUA_B 0x0003 0x0002 0x0000
+  if( 2 == *((int*)&(bss[0])) ) goto L_0003;
+L_0001: ++ic; // INST__STORE_C_IN_B 0x000c 0x0000 0x0000
+  *((int*)&(bss[12])) = (int)0x00000000;
+L_0002: ++ic; // INST_SCRIPT_C 0x000b 0x0004 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 4); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x0003; bss = (char*)(fr + 1); } goto L_000b;
+L_0003: ++ic; // INST__STORE_C_IN_B 0x000c 0x0001 0x0000
+  *((int*)&(bss[12])) = (int)0x00000001;
+L_0004: ++ic; // INST_SCRIPT_C 0x000b 0x0004 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 4); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x0005; bss = (char*)(fr + 1); } goto L_000b;
+L_0005: ++ic; // INST__STORE_R_IN_B 0x0000 0x0000 0x0000
+  *((int*)&(bss[0])) = bh->m_RE;
+L_0006: ++ic; // INST_JABC_R_EQUA_C 0x000a 0x0002 0x0000
+  if( bh->m_RE == 2u ) goto L_000a;
+L_0007: ++ic; // INST__STORE_C_IN_B 0x000c 0x0002 0x0000
+  *((int*)&(bss[12])) = (int)0x00000002;
+L_0008: ++ic; // INST_SCRIPT_C 0x000b 0x0004 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 4); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x0009; bss = (char*)(fr + 1); } goto L_000b;
+L_0009: ++ic; // INST__STORE_C_IN_B 0x0000 0x0003 0x0000
+  *((int*)&(bss[0])) = (int)0x00000003;
+L_000a: ++ic; // INST_______SUSPEND 0x0000 0x0000 0x0000
+  goto exit;
+
+  //main
+L_000b: ++ic; // INST_JABC_C_EQUA_B 0x0016 0x0001 0x0000
+  if( 1 == *((int*)&(bss[0])) ) goto L_0016;
+L_000c: ++ic; // INST_JABC_C_EQUA_B 0x0013 0x0000 0x0000
+  if( 0 == *((int*)&(bss[0])) ) { if( dh ) { bh->m_IP = 0x0013; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x000c ); } goto L_0013; }
+L_000d: ++ic; // INST_JABC_C_EQUA_B 0x0010 0x0002 0x0000
+  if( 2 == *((int*)&(bss[0])) ) { if( dh ) { bh->m_IP = 0x0010; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x000d ); } goto L_0010; }
+L_000e: ++ic; // INST__STORE_C_IN_R 0x0003 0x0000 0x0000
+  bh->m_RE = 3u;
+L_000f: ++ic; // INST_JABC_CONSTANT 0x00ad 0x0000 0x0000
+  goto L_00ad;
+  if( dh ) { bh->m_IP = 0x0010; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x000f ); } 
+L_0010: ++ic; // INST_JABC_C_EQUA_B 0x0012 0xffff 0x0004
+  if( 65535 == *((int*)&(bss[4])) ) { if( dh ) { bh->m_IP = 0x0012; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0010 ); } goto L_0012; }
+L_0011: ++ic; // INST_JABB_S_C_IN_B 0x0004 0x0004 0x0012
+  ip = *((int*)&(bss[4])); *((int*)&(bss[4])) = 18; from = 0x0011; goto dispatch;
+  if( dh ) { bh->m_IP = 0x0012; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0011 ); } 
+L_0012: ++ic; // INST_JABC_CONSTANT 0x00ad 0x0000 0x0000
+  goto L_00ad;
+  if( dh ) { bh->m_IP = 0x0013; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0012 ); } 
+L_0013: ++ic; // INST__STORE_C_IN_B 0x0004 0xffff 0x0000
+  *((int*)&(bss[4])) = (int)0x0000ffff;
+L_0014: ++ic; // INST__STORE_C_IN_B 0x0008 0xffff 0x0000
+  *((int*)&(bss[8])) = (int)0x0000ffff;
+  if( dh ) { bh->m_IP = 0x0015; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0014 ); } 
+L_0015: ++ic; // INST_JABC_CONSTANT 0x00ad 0x0000 0x0000
+  goto L_00ad;
+L_0016: ++ic; // INST_COUNT_NODE 0x0058 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 88), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0017; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0016 ); } 
+L_0017: ++ic; // INST_JABB_C_DIFF_B 0x0008 0xffff 0x0008
+  if( 65535 != *((int*)&(bss[8])) ) { ip = *((int*)&(bss[8])); from = 0x0017; goto dispatch; }
+  if( dh ) { bh->m_IP = 0x0018; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0017 ); } 
+L_0018: ++ic; // INST__STORE_C_IN_B 0x0008 0x0019 0x0000
+  *((int*)&(bss[8])) = (int)0x00000019;
+L_0019: ++ic; // INST_COUNT_NODE 0x0068 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 104), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x001a; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0019 ); } 
+L_001a: ++ic; // INST_FUSE_EXEC_FUN 0x0003 0xffff 0x0008
+  bh->m_RE = (tab ? tab[3] : ch)( 0x00000003, ACT_EXECUTE, 0x0, resolve_variables( &(data[8]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x001b; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x001a ); } 
+L_001b: ++ic; // INST_COUNT_NODE 0x0068 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 104), 1u, bh->m_RE );
+L_001c: ++ic; // INST__STORE_C_IN_B 0x0004 0x00a2 0x0000
+  *((int*)&(bss[4])) = (int)0x000000a2;
+L_001d: ++ic; // INST_JABC_R_EQUA_C 0x00ac 0x0002 0x0000
+  if( bh->m_RE == 2u ) { if( dh ) { bh->m_IP = 0x00ac; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x001d ); } goto L_00ac; }
+L_001e: ++ic; // INST_JABC_S_C_IN_B 0x00a2 0x0004 0x001f
+  *((int*)&(bss[4])) = 31; { if( dh ) { bh->m_IP = 0x00a2; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x001e ); } goto L_00a2; }
+L_001f: ++ic; // INST_JABC_R_DIFF_C 0x00aa 0x0001 0x0000
+  if( bh->m_RE != 1u ) goto L_00aa;
+  if( dh ) { bh->m_IP = 0x0020; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x001f ); } 
+L_0020: ++ic; // INST__STORE_C_IN_B 0x0010 0x0003 0x0000
+  *((int*)&(bss[16])) = (int)0x00000003;
+L_0021: ++ic; // INST__STORE_C_IN_B 0x0014 0x0003 0x0000
+  *((int*)&(bss[20])) = (int)0x00000003;
+L_0022: ++ic; // INST__STORE_C_IN_B 0x0018 0x0003 0x0000
+  *((int*)&(bss[24])) = (int)0x00000003;
+L_0023: ++ic; // INST__STORE_C_IN_B 0x000c 0xffff 0x0000
+  *((int*)&(bss[12])) = (int)0x0000ffff;
+  if( dh ) { bh->m_IP = 0x0024; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0023 ); } 
+L_0024: ++ic; // INST__STORE_C_IN_B 0x0008 0x0025 0x0000
+  *((int*)&(bss[8])) = (int)0x00000025;
+L_0025: ++ic; // INST_COUNT_NODE 0x0078 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 120), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0026; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0025 ); } 
+L_0026: ++ic; // INST__STORE_C_IN_B 0x0048 0x0028 0x0000
+  *((int*)&(bss[72])) = (int)0x00000028;
+L_0027: ++ic; // INST_JABC_C_EQUA_B 0x003c 0x0003 0x0010
+  if( 3 == *((int*)&(bss[16])) ) { if( dh ) { bh->m_IP = 0x003c; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0027 ); } goto L_003c; }
+L_0028: ++ic; // INST__STORE_C_IN_B 0x0044 0x0049 0x0000
+  *((int*)&(bss[68])) = (int)0x00000049;
+L_0029: ++ic; // INST_JABC_S_C_IN_B 0x003f 0x0048 0x002a
+  *((int*)&(bss[72])) = 42; goto L_003f;
+L_002a: ++ic; // INST_JABC_R_EQUA_C 0x0084 0x0002 0x0000
+  if( bh->m_RE == 2u ) goto L_0084;
+L_002b: ++ic; // INST_JABC_S_C_IN_B 0x0049 0x0048 0x002c
+  *((int*)&(bss[72])) = 44; goto L_0049;
+L_002c: ++ic; // INST_JABC_R_EQUA_C 0x0084 0x0001 0x0000
+  if( bh->m_RE == 1u ) goto L_0084;
+L_002d: ++ic; // INST__STORE_C_IN_B 0x0048 0x002f 0x0000
+  *((int*)&(bss[72])) = (int)0x0000002f;
+L_002e: ++ic; // INST_JABC_C_EQUA_B 0x004e 0x0003 0x0014
+  if( 3 == *((int*)&(bss[20])) ) { if( dh ) { bh->m_IP = 0x004e; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x002e ); } goto L_004e; }
+L_002f: ++ic; // INST__STORE_C_IN_B 0x0044 0x0076 0x0000
+  *((int*)&(bss[68])) = (int)0x00000076;
+L_0030: ++ic; // INST_JABC_S_C_IN_B 0x0051 0x0048 0x0031
+  *((int*)&(bss[72])) = 49; goto L_0051;
+L_0031: ++ic; // INST_JABC_R_EQUA_C 0x0084 0x0002 0x0000
+  if( bh->m_RE == 2u ) goto L_0084;
+L_0032: ++ic; // INST_JABC_S_C_IN_B 0x0076 0x0048 0x0033
+  *((int*)&(bss[72])) = 51; goto L_0076;
+L_0033: ++ic; // INST_JABC_R_EQUA_C 0x0084 0x0001 0x0000
+  if( bh->m_RE == 1u ) goto L_0084;
+L_0034: ++ic; // INST__STORE_C_IN_B 0x0048 0x0036 0x0000
+  *((int*)&(bss[72])) = (int)0x00000036;
+L_0035: ++ic; // INST_JABC_C_EQUA_B 0x007b 0x0003 0x0018
+  if( 3 == *((int*)&(bss[24])) ) goto L_007b;
+L_0036: ++ic; // INST__STORE_C_IN_B 0x0044 0x0081 0x0000
+  *((int*)&(bss[68])) = (int)0x00000081;
+L_0037: ++ic; // INST_JABC_S_C_IN_B 0x007c 0x0048 0x0038
+  *((int*)&(bss[72])) = 56; goto L_007c;
+L_0038: ++ic; // INST_JABC_R_EQUA_C 0x0084 0x0002 0x0000
+  if( bh->m_RE == 2u ) goto L_0084;
+L_0039: ++ic; // INST_JABC_S_C_IN_B 0x0081 0x0048 0x003a
+  *((int*)&(bss[72])) = 58; goto L_0081;
+L_003a: ++ic; // INST_JABC_R_EQUA_C 0x0084 0x0001 0x0000
+  if( bh->m_RE == 1u ) goto L_0084;
+L_003b: ++ic; // INST_JABC_CONSTANT 0x0089 0x0000 0x0000
+  { if( dh ) { bh->m_IP = 0x0089; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x003b ); } goto L_0089; }
+  if( dh ) { bh->m_IP = 0x003c; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x003b ); } 
+L_003c: ++ic; // INST__STORE_C_IN_B 0x0024 0x0000 0x0000
+  *((int*)&(bss[36])) = (int)0x00000000;
+L_003d: ++ic; // INST_SCRIPT_C 0x00ae 0x001c 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 28); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x003e; bss = (char*)(fr + 1); } goto L_00ae;
+  if( dh ) { bh->m_IP = 0x003e; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x003d ); } 
+L_003e: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x003e; goto dispatch;
+L_003f: ++ic; // INST_COUNT_NODE 0x0088 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 136), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0040; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x003f ); } 
+L_0040: ++ic; // INST_FUSE_PRUN_FUN 0x0004 0xffff 0xffff
+  bh->m_RE = (tab ? tab[4] : ch)( 0x00000065, ACT_PRUNE, 0x0, (void**)0x0, info->m_UserData );
+  if( dh ) { bh->m_IP = 0x0041; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0040 ); } 
+L_0041: ++ic; // INST_JABC_R_DIFF_C 0x0046 0x0001 0x0000
+  if( bh->m_RE != 1u ) { if( dh ) { bh->m_IP = 0x0046; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0041 ); } goto L_0046; }
+L_0042: ++ic; // INST_COUNT_NODE 0x0098 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 152), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0043; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0042 ); } 
+L_0043: ++ic; // INST__STORE_C_IN_B 0x0024 0x0001 0x0000
+  *((int*)&(bss[36])) = (int)0x00000001;
+L_0044: ++ic; // INST_SCRIPT_C 0x00ae 0x001c 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 28); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x0045; bss = (char*)(fr + 1); } goto L_00ae;
+  if( dh ) { bh->m_IP = 0x0045; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0044 ); } 
+L_0045: ++ic; // INST_COUNT_NODE 0x0098 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 152), 1u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0046; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0045 ); } 
+L_0046: ++ic; // INST_COUNT_NODE 0x0088 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 136), 1u, bh->m_RE );
+L_0047: ++ic; // INST__STORE_R_IN_B 0x0010 0x0000 0x0000
+  *((int*)&(bss[16])) = bh->m_RE;
+L_0048: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x0048; goto dispatch;
+L_0049: ++ic; // INST_JABC_C_EQUA_B 0x004d 0x0003 0x0010
+  if( 3 == *((int*)&(bss[16])) ) goto L_004d;
+  if( dh ) { bh->m_IP = 0x004a; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0049 ); } 
+L_004a: ++ic; // INST__STORE_C_IN_B 0x0024 0x0002 0x0000
+  *((int*)&(bss[36])) = (int)0x00000002;
+L_004b: ++ic; // INST_SCRIPT_C 0x00ae 0x001c 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 28); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x004c; bss = (char*)(fr + 1); } goto L_00ae;
+  if( dh ) { bh->m_IP = 0x004c; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x004b ); } 
+L_004c: ++ic; // INST__STORE_C_IN_B 0x0010 0x0003 0x0000
+  *((int*)&(bss[16])) = (int)0x00000003;
+L_004d: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x004d; goto dispatch;
+  if( dh ) { bh->m_IP = 0x004e; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x004d ); } 
+L_004e: ++ic; // INST__STORE_C_IN_B 0x003c 0xffff 0x0000
+  *((int*)&(bss[60])) = (int)0x0000ffff;
+L_004f: ++ic; // INST__STORE_C_IN_B 0x0038 0xffff 0x0000
+  *((int*)&(bss[56])) = (int)0x0000ffff;
+  if( dh ) { bh->m_IP = 0x0050; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x004f ); } 
+L_0050: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x0050; goto dispatch;
+L_0051: ++ic; // INST_COUNT_NODE 0x00a8 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 168), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0052; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0051 ); } 
+L_0052: ++ic; // INST_JABB_C_DIFF_B 0x003c 0xffff 0x003c
+  if( 65535 != *((int*)&(bss[60])) ) { ip = *((int*)&(bss[60])); from = 0x0052; goto dispatch; }
+  if( dh ) { bh->m_IP = 0x0053; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0052 ); } 
+L_0053: ++ic; // INST__STORE_C_IN_B 0x003c 0x0054 0x0000
+  *((int*)&(bss[60])) = (int)0x00000054;
+L_0054: ++ic; // INST_COUNT_NODE 0x00b8 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 184), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0055; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0054 ); } 
+L_0055: ++ic; // INST_FUSE_EXEC_FUN 0x0002 0xffff 0xffff
+  bh->m_RE = (tab ? tab[2] : ch)( 0x00000001, ACT_EXECUTE, 0x0, (void**)0x0, info->m_UserData );
+  if( dh ) { bh->m_IP = 0x0056; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0055 ); } 
+L_0056: ++ic; // INST_COUNT_NODE 0x00b8 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 184), 1u, bh->m_RE );
+L_0057: ++ic; // INST__STORE_C_IN_B 0x0038 0x006d 0x0000
+  *((int*)&(bss[56])) = (int)0x0000006d;
+L_0058: ++ic; // INST_JABC_R_EQUA_C 0x0073 0x0002 0x0000
+  if( bh->m_RE == 2u ) { if( dh ) { bh->m_IP = 0x0073; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0058 ); } goto L_0073; }
+L_0059: ++ic; // INST_JABC_S_C_IN_B 0x006d 0x0038 0x005a
+  *((int*)&(bss[56])) = 90; { if( dh ) { bh->m_IP = 0x006d; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0059 ); } goto L_006d; }
+L_005a: ++ic; // INST_JABC_R_EQUA_C 0x0071 0x0001 0x0000
+  if( bh->m_RE == 1u ) goto L_0071;
+L_005b: ++ic; // INST__STORE_C_IN_B 0x003c 0x005c 0x0000
+  *((int*)&(bss[60])) = (int)0x0000005c;
+L_005c: ++ic; // INST_COUNT_NODE 0x00c8 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 200), 0u, bh->m_RE );
+L_005d: ++ic; // INST__STORE_C_IN_R 0x0000 0x0000 0x0000
+  bh->m_RE = 0u;
+L_005e: ++ic; // INST_COUNT_NODE 0x00c8 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 200), 1u, bh->m_RE );
+L_005f: ++ic; // INST__STORE_C_IN_B 0x0038 0x006e 0x0000
+  *((int*)&(bss[56])) = (int)0x0000006e;
+L_0060: ++ic; // INST_JABC_R_EQUA_C 0x0073 0x0002 0x0000
+  if( bh->m_RE == 2u ) { if( dh ) { bh->m_IP = 0x0073; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0060 ); } goto L_0073; }
+L_0061: ++ic; // INST_JABC_S_C_IN_B 0x006e 0x0038 0x0062
+  *((int*)&(bss[56])) = 98; goto L_006e;
+L_0062: ++ic; // INST_JABC_R_EQUA_C 0x0071 0x0001 0x0000
+  if( bh->m_RE == 1u ) goto L_0071;
+  if( dh ) { bh->m_IP = 0x0063; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0062 ); } 
+L_0063: ++ic; // INST_FUSE_CONS_FUN 0x0000 0x0040 0x0018
+  (tab ? tab[0] : ch)( 0x00000002, ACT_CONSTRUCT, (void*)&(bss[64]), resolve_variables( &(data[24]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x0064; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0063 ); } 
+L_0064: ++ic; // INST__STORE_C_IN_B 0x003c 0x0065 0x0000
+  *((int*)&(bss[60])) = (int)0x00000065;
+L_0065: ++ic; // INST_COUNT_NODE 0x00d8 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 216), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0066; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0065 ); } 
+L_0066: ++ic; // INST_FUSE_EXEC_FUN 0x0000 0x0040 0x0018
+  bh->m_RE = (tab ? tab[0] : ch)( 0x00000002, ACT_EXECUTE, (void*)&(bss[64]), resolve_variables( &(data[24]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x0067; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0066 ); } 
+L_0067: ++ic; // INST_COUNT_NODE 0x00d8 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 216), 1u, bh->m_RE );
+L_0068: ++ic; // INST__STORE_C_IN_B 0x0038 0x006f 0x0000
+  *((int*)&(bss[56])) = (int)0x0000006f;
+L_0069: ++ic; // INST_JABC_R_EQUA_C 0x0073 0x0002 0x0000
+  if( bh->m_RE == 2u ) { if( dh ) { bh->m_IP = 0x0073; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0069 ); } goto L_0073; }
+L_006a: ++ic; // INST_JABC_S_C_IN_B 0x006f 0x0038 0x006b
+  *((int*)&(bss[56])) = 107; { if( dh ) { bh->m_IP = 0x006f; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x006a ); } goto L_006f; }
+L_006b: ++ic; // INST_JABC_R_EQUA_C 0x0071 0x0001 0x0000
+  if( bh->m_RE == 1u ) goto L_0071;
+L_006c: ++ic; // INST_JABC_CONSTANT 0x0072 0x0000 0x0000
+  goto L_0072;
+  if( dh ) { bh->m_IP = 0x006d; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x006c ); } 
+L_006d: ++ic; // INST_JABB_S_C_IN_B 0x0038 0x0038 0xffff
+  ip = *((int*)&(bss[56])); *((int*)&(bss[56])) = 65535; from = 0x006d; goto dispatch;
+L_006e: ++ic; // INST_JABB_S_C_IN_B 0x0038 0x0038 0xffff
+  ip = *((int*)&(bss[56])); *((int*)&(bss[56])) = 65535; from = 0x006e; goto dispatch;
+  if( dh ) { bh->m_IP = 0x006f; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x006e ); } 
+L_006f: ++ic; // INST_FUSE_DEST_FUN 0x0000 0x0040 0x0018
+  (tab ? tab[0] : ch)( 0x00000002, ACT_DESTRUCT, (void*)&(bss[64]), resolve_variables( &(data[24]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x0070; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x006f ); } 
+L_0070: ++ic; // INST_JABB_S_C_IN_B 0x0038 0x0038 0xffff
+  ip = *((int*)&(bss[56])); *((int*)&(bss[56])) = 65535; from = 0x0070; goto dispatch;
+L_0071: ++ic; // INST__STORE_C_IN_R 0x0001 0x0000 0x0000
+  bh->m_RE = 1u;
+L_0072: ++ic; // INST__STORE_C_IN_B 0x003c 0xffff 0x0000
+  *((int*)&(bss[60])) = (int)0x0000ffff;
+  if( dh ) { bh->m_IP = 0x0073; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0072 ); } 
+L_0073: ++ic; // INST_COUNT_NODE 0x00a8 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 168), 1u, bh->m_RE );
+L_0074: ++ic; // INST__STORE_R_IN_B 0x0014 0x0000 0x0000
+  *((int*)&(bss[20])) = bh->m_RE;
+L_0075: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x0075; goto dispatch;
+L_0076: ++ic; // INST_JABC_C_EQUA_B 0x007a 0x0003 0x0014
+  if( 3 == *((int*)&(bss[20])) ) goto L_007a;
+  if( dh ) { bh->m_IP = 0x0077; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0076 ); } 
+L_0077: ++ic; // INST_JABC_C_EQUA_B 0x0079 0xffff 0x0038
+  if( 65535 == *((int*)&(bss[56])) ) { if( dh ) { bh->m_IP = 0x0079; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0077 ); } goto L_0079; }
+L_0078: ++ic; // INST_JABB_S_C_IN_B 0x0038 0x0038 0x0079
+  ip = *((int*)&(bss[56])); *((int*)&(bss[56])) = 121; from = 0x0078; goto dispatch;
+  if( dh ) { bh->m_IP = 0x0079; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0078 ); } 
+L_0079: ++ic; // INST__STORE_C_IN_B 0x0014 0x0003 0x0000
+  *((int*)&(bss[20])) = (int)0x00000003;
+L_007a: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x007a; goto dispatch;
+L_007b: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x007b; goto dispatch;
+L_007c: ++ic; // INST_COUNT_NODE 0x00e8 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 232), 0u, bh->m_RE );
+L_007d: ++ic; // INST__STORE_C_IN_R 0x0001 0x0000 0x0000
+  bh->m_RE = 1u;
+L_007e: ++ic; // INST_COUNT_NODE 0x00e8 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 232), 1u, bh->m_RE );
+L_007f: ++ic; // INST__STORE_R_IN_B 0x0018 0x0000 0x0000
+  *((int*)&(bss[24])) = bh->m_RE;
+L_0080: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x0080; goto dispatch;
+L_0081: ++ic; // INST_JABC_C_EQUA_B 0x0083 0x0003 0x0018
+  if( 3 == *((int*)&(bss[24])) ) goto L_0083;
+L_0082: ++ic; // INST__STORE_C_IN_B 0x0018 0x0003 0x0000
+  *((int*)&(bss[24])) = (int)0x00000003;
+L_0083: ++ic; // INST_JABB_BSSVALUE 0x0048 0x0000 0x0000
+  ip = *((int*)&(bss[72])); from = 0x0083; goto dispatch;
+L_0084: ++ic; // INST_JABC_C_EQUA_B 0x0087 0xffff 0x000c
+  if( 65535 == *((int*)&(bss[12])) ) goto L_0087;
+L_0085: ++ic; // INST__STORE_C_IN_B 0x0048 0x0087 0x0000
+  *((int*)&(bss[72])) = (int)0x00000087;
+L_0086: ++ic; // INST_JABB_B_DIFF_B 0x000c 0x0044 0x000c
+  if( *((int*)&(bss[68])) != *((int*)&(bss[12])) ) { ip = *((int*)&(bss[12])); from = 0x0086; goto dispatch; }
+L_0087: ++ic; // INST__STORE_B_IN_B 0x000c 0x0044 0x0000
+  *((int*)&(bss[12])) = *((int*)&(bss[68]));
+L_0088: ++ic; // INST__STORE_C_IN_B 0x0044 0xffff 0x0000
+  *((int*)&(bss[68])) = (int)0x0000ffff;
+  if( dh ) { bh->m_IP = 0x0089; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0088 ); } 
+L_0089: ++ic; // INST_COUNT_NODE 0x0078 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 120), 1u, bh->m_RE );
+L_008a: ++ic; // INST__STORE_C_IN_B 0x0004 0x00a3 0x0000
+  *((int*)&(bss[4])) = (int)0x000000a3;
+L_008b: ++ic; // INST_JABC_R_EQUA_C 0x00ac 0x0002 0x0000
+  if( bh->m_RE == 2u ) { if( dh ) { bh->m_IP = 0x00ac; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x008b ); } goto L_00ac; }
+L_008c: ++ic; // INST_JABC_S_C_IN_B 0x00a3 0x0004 0x008d
+  *((int*)&(bss[4])) = 141; { if( dh ) { bh->m_IP = 0x00a3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x008c ); } goto L_00a3; }
+L_008d: ++ic; // INST_JABC_R_DIFF_C 0x00aa 0x0001 0x0000
+  if( bh->m_RE != 1u ) goto L_00aa;
+  if( dh ) { bh->m_IP = 0x008e; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x008d ); } 
+L_008e: ++ic; // INST__STORE_C_IN_B 0x0014 0x0000 0x0000
+  *((int*)&(bss[20])) = (int)0x00000000;
+L_008f: ++ic; // INST_SCRIPT_C 0x00ae 0x000c 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 12); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x0090; bss = (char*)(fr + 1); } goto L_00ae;
+  if( dh ) { bh->m_IP = 0x0090; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x008f ); } 
+L_0090: ++ic; // INST__STORE_C_IN_B 0x0008 0x0091 0x0000
+  *((int*)&(bss[8])) = (int)0x00000091;
+L_0091: ++ic; // INST_COUNT_NODE 0x00f8 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 248), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x0092; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0091 ); } 
+L_0092: ++ic; // INST__STORE_C_IN_B 0x0014 0x0001 0x0000
+  *((int*)&(bss[20])) = (int)0x00000001;
+L_0093: ++ic; // INST_SCRIPT_C 0x00ae 0x000c 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 12); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x0094; bss = (char*)(fr + 1); } goto L_00ae;
+  if( dh ) { bh->m_IP = 0x0094; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0093 ); } 
+L_0094: ++ic; // INST_COUNT_NODE 0x00f8 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 248), 1u, bh->m_RE );
+L_0095: ++ic; // INST__STORE_C_IN_B 0x0004 0x00a6 0x0000
+  *((int*)&(bss[4])) = (int)0x000000a6;
+L_0096: ++ic; // INST_JABC_R_EQUA_C 0x00ac 0x0002 0x0000
+  if( bh->m_RE == 2u ) { if( dh ) { bh->m_IP = 0x00ac; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0096 ); } goto L_00ac; }
+L_0097: ++ic; // INST_JABC_S_C_IN_B 0x00a6 0x0004 0x0098
+  *((int*)&(bss[4])) = 152; { if( dh ) { bh->m_IP = 0x00a6; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0097 ); } goto L_00a6; }
+L_0098: ++ic; // INST_JABC_R_DIFF_C 0x00aa 0x0001 0x0000
+  if( bh->m_RE != 1u ) goto L_00aa;
+  if( dh ) { bh->m_IP = 0x0099; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x0098 ); } 
+L_0099: ++ic; // INST__STORE_C_IN_B 0x0008 0x009a 0x0000
+  *((int*)&(bss[8])) = (int)0x0000009a;
+L_009a: ++ic; // INST_COUNT_NODE 0x0108 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 264), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x009b; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x009a ); } 
+L_009b: ++ic; // INST_FUSE_EXEC_FUN 0x0003 0xffff 0x0028
+  bh->m_RE = (tab ? tab[3] : ch)( 0x00000003, ACT_EXECUTE, 0x0, resolve_variables( &(data[40]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x009c; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x009b ); } 
+L_009c: ++ic; // INST_COUNT_NODE 0x0108 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 264), 1u, bh->m_RE );
+L_009d: ++ic; // INST__STORE_C_IN_B 0x0004 0x00a9 0x0000
+  *((int*)&(bss[4])) = (int)0x000000a9;
+L_009e: ++ic; // INST_JABC_R_EQUA_C 0x00ac 0x0002 0x0000
+  if( bh->m_RE == 2u ) { if( dh ) { bh->m_IP = 0x00ac; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x009e ); } goto L_00ac; }
+L_009f: ++ic; // INST_JABC_S_C_IN_B 0x00a9 0x0004 0x00a0
+  *((int*)&(bss[4])) = 160; { if( dh ) { bh->m_IP = 0x00a9; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x009f ); } goto L_00a9; }
+L_00a0: ++ic; // INST_JABC_R_DIFF_C 0x00aa 0x0001 0x0000
+  if( bh->m_RE != 1u ) goto L_00aa;
+L_00a1: ++ic; // INST_JABC_CONSTANT 0x00ab 0x0000 0x0000
+  goto L_00ab;
+  if( dh ) { bh->m_IP = 0x00a2; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00a1 ); } 
+L_00a2: ++ic; // INST_JABB_S_C_IN_B 0x0004 0x0004 0xffff
+  ip = *((int*)&(bss[4])); *((int*)&(bss[4])) = 65535; from = 0x00a2; goto dispatch;
+  if( dh ) { bh->m_IP = 0x00a3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00a2 ); } 
+L_00a3: ++ic; // INST__STORE_C_IN_B 0x0048 0x00a5 0x0000
+  *((int*)&(bss[72])) = (int)0x000000a5;
+L_00a4: ++ic; // INST_JABB_C_DIFF_B 0x000c 0xffff 0x000c
+  if( 65535 != *((int*)&(bss[12])) ) { ip = *((int*)&(bss[12])); from = 0x00a4; goto dispatch; }
+  if( dh ) { bh->m_IP = 0x00a5; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00a4 ); } 
+L_00a5: ++ic; // INST_JABB_S_C_IN_B 0x0004 0x0004 0xffff
+  ip = *((int*)&(bss[4])); *((int*)&(bss[4])) = 65535; from = 0x00a5; goto dispatch;
+  if( dh ) { bh->m_IP = 0x00a6; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00a5 ); } 
+L_00a6: ++ic; // INST__STORE_C_IN_B 0x0014 0x0002 0x0000
+  *((int*)&(bss[20])) = (int)0x00000002;
+L_00a7: ++ic; // INST_SCRIPT_C 0x00ae 0x000c 0x0000
+  { CallFrame* fr = (CallFrame*)(bss + 12); fr->m_FP = (unsigned int)(bss - base); fr->m_IP = 0x00a8; bss = (char*)(fr + 1); } goto L_00ae;
+  if( dh ) { bh->m_IP = 0x00a8; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00a7 ); } 
+L_00a8: ++ic; // INST_JABB_S_C_IN_B 0x0004 0x0004 0xffff
+  ip = *((int*)&(bss[4])); *((int*)&(bss[4])) = 65535; from = 0x00a8; goto dispatch;
+  if( dh ) { bh->m_IP = 0x00a9; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00a8 ); } 
+L_00a9: ++ic; // INST_JABB_S_C_IN_B 0x0004 0x0004 0xffff
+  ip = *((int*)&(bss[4])); *((int*)&(bss[4])) = 65535; from = 0x00a9; goto dispatch;
+L_00aa: ++ic; // INST__STORE_C_IN_R 0x0000 0x0000 0x0000
+  bh->m_RE = 0u;
+L_00ab: ++ic; // INST__STORE_C_IN_B 0x0008 0xffff 0x0000
+  *((int*)&(bss[8])) = (int)0x0000ffff;
+  if( dh ) { bh->m_IP = 0x00ac; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00ab ); } 
+L_00ac: ++ic; // INST_COUNT_NODE 0x0058 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 88), 1u, bh->m_RE );
+L_00ad: ++ic; // INST_SCRIPT_R 0x0000 0x0000 0x0000
+  { CallFrame* fr = (CallFrame*)(bss - sizeof(CallFrame)); bss = base + fr->m_FP; ip = fr->m_IP; } from = ip - 1; goto dispatch;
+
+  //worker
+L_00ae: ++ic; // INST_JABC_C_EQUA_B 0x00b8 0x0001 0x0000
+  if( 1 == *((int*)&(bss[0])) ) goto L_00b8;
+L_00af: ++ic; // INST_JABC_C_EQUA_B 0x00b5 0x0000 0x0000
+  if( 0 == *((int*)&(bss[0])) ) { if( dh ) { bh->m_IP = 0x00b5; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00af ); } goto L_00b5; }
+L_00b0: ++ic; // INST_JABC_C_EQUA_B 0x00b3 0x0002 0x0000
+  if( 2 == *((int*)&(bss[0])) ) { if( dh ) { bh->m_IP = 0x00b3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00b0 ); } goto L_00b3; }
+L_00b1: ++ic; // INST__STORE_C_IN_R 0x0003 0x0000 0x0000
+  bh->m_RE = 3u;
+L_00b2: ++ic; // INST_JABC_CONSTANT 0x00d4 0x0000 0x0000
+  goto L_00d4;
+  if( dh ) { bh->m_IP = 0x00b3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00b2 ); } 
+L_00b3: ++ic; // INST_FUSE_DEST_FUN 0x0000 0x0004 0x0038
+  (tab ? tab[0] : ch)( 0x00000002, ACT_DESTRUCT, (void*)&(bss[4]), resolve_variables( &(data[56]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x00b4; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00b3 ); } 
+L_00b4: ++ic; // INST_JABC_CONSTANT 0x00d4 0x0000 0x0000
+  goto L_00d4;
+  if( dh ) { bh->m_IP = 0x00b5; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00b4 ); } 
+L_00b5: ++ic; // INST_FUSE_CONS_FUN 0x0000 0x0004 0x0038
+  (tab ? tab[0] : ch)( 0x00000002, ACT_CONSTRUCT, (void*)&(bss[4]), resolve_variables( &(data[56]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x00b6; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00b5 ); } 
+L_00b6: ++ic; // INST_FUSE_CONS_FUN 0x0001 0x0008 0x0048
+  (tab ? tab[1] : ch)( 0x00000064, ACT_CONSTRUCT, (void*)&(bss[8]), resolve_variables( &(data[72]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x00b7; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00b6 ); } 
+L_00b7: ++ic; // INST_JABC_CONSTANT 0x00d4 0x0000 0x0000
+  goto L_00d4;
+L_00b8: ++ic; // INST_COUNT_NODE 0x0118 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 280), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x00b9; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00b8 ); } 
+L_00b9: ++ic; // INST__STORE_C_IN_B 0x0010 0x0000 0x0000
+  *((int*)&(bss[16])) = (int)0x00000000;
+L_00ba: ++ic; // INST_COUNT_NODE 0x0128 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 296), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x00bb; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00ba ); } 
+L_00bb: ++ic; // INST_FUSE_EXEC_FUN 0x0000 0x0004 0x0038
+  bh->m_RE = (tab ? tab[0] : ch)( 0x00000002, ACT_EXECUTE, (void*)&(bss[4]), resolve_variables( &(data[56]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x00bc; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00bb ); } 
+L_00bc: ++ic; // INST_COUNT_NODE 0x0128 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 296), 1u, bh->m_RE );
+L_00bd: ++ic; // INST_JABC_R_EQUA_C 0x00d3 0x0000 0x0000
+  if( bh->m_RE == 0u ) { if( dh ) { bh->m_IP = 0x00d3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00bd ); } goto L_00d3; }
+L_00be: ++ic; // INST_JABC_R_DIFF_C 0x00c0 0x0001 0x0000
+  if( bh->m_RE != 1u ) goto L_00c0;
+L_00bf: ++ic; // INST__INC_BSSVALUE 0x0010 0x0001 0x0000
+  *((int*)&(bss[16])) += 1;
+L_00c0: ++ic; // INST_COUNT_NODE 0x0138 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 312), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x00c1; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00c0 ); } 
+L_00c1: ++ic; // INST_COUNT_NODE 0x0148 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 328), 0u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x00c2; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00c1 ); } 
+L_00c2: ++ic; // INST_FUSE_EXEC_FUN 0x0002 0xffff 0xffff
+  bh->m_RE = (tab ? tab[2] : ch)( 0x00000001, ACT_EXECUTE, 0x0, (void**)0x0, info->m_UserData );
+  if( dh ) { bh->m_IP = 0x00c3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00c2 ); } 
+L_00c3: ++ic; // INST_COUNT_NODE 0x0148 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 328), 1u, bh->m_RE );
+  if( dh ) { bh->m_IP = 0x00c4; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00c3 ); } 
+L_00c4: ++ic; // INST__STORE_R_IN_B 0x000c 0x0000 0x0000
+  *((int*)&(bss[12])) = bh->m_RE;
+L_00c5: ++ic; // INST_FUSE_MODI_FUN 0x0001 0x0008 0x0048
+  bh->m_RE = (tab ? tab[1] : ch)( 0x00000064, ACT_MODIFY, (void*)&(bss[8]), resolve_variables( &(data[72]), data, vars ), info->m_UserData );
+  if( dh ) { bh->m_IP = 0x00c6; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00c5 ); } 
+L_00c6: ++ic; // INST_COUNT_NODE 0x0138 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 312), 1u, bh->m_RE );
+L_00c7: ++ic; // INST_JABC_R_EQUA_C 0x00d3 0x0000 0x0000
+  if( bh->m_RE == 0u ) { if( dh ) { bh->m_IP = 0x00d3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00c7 ); } goto L_00d3; }
+L_00c8: ++ic; // INST_JABC_R_DIFF_C 0x00ca 0x0001 0x0000
+  if( bh->m_RE != 1u ) goto L_00ca;
+L_00c9: ++ic; // INST__INC_BSSVALUE 0x0010 0x0001 0x0000
+  *((int*)&(bss[16])) += 1;
+L_00ca: ++ic; // INST_COUNT_NODE 0x0158 0x0000 0x0000
+  count_node( (NodeCounters*)(base + 344), 0u, bh->m_RE );
+L_00cb: ++ic; // INST__STORE_C_IN_R 0x0002 0x0000 0x0000
+  bh->m_RE = 2u;
+L_00cc: ++ic; // INST_COUNT_NODE 0x0158 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 344), 1u, bh->m_RE );
+L_00cd: ++ic; // INST_JABC_R_EQUA_C 0x00d3 0x0000 0x0000
+  if( bh->m_RE == 0u ) { if( dh ) { bh->m_IP = 0x00d3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00cd ); } goto L_00d3; }
+L_00ce: ++ic; // INST_JABC_R_DIFF_C 0x00d0 0x0001 0x0000
+  if( bh->m_RE != 1u ) goto L_00d0;
+L_00cf: ++ic; // INST__INC_BSSVALUE 0x0010 0x0001 0x0000
+  *((int*)&(bss[16])) += 1;
+L_00d0: ++ic; // INST__STORE_C_IN_R 0x0002 0x0000 0x0000
+  bh->m_RE = 2u;
+L_00d1: ++ic; // INST_JABC_C_DIFF_B 0x00d3 0x0003 0x0010
+  if( 3 != *((int*)&(bss[16])) ) { if( dh ) { bh->m_IP = 0x00d3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00d1 ); } goto L_00d3; }
+L_00d2: ++ic; // INST__STORE_C_IN_R 0x0001 0x0000 0x0000
+  bh->m_RE = 1u;
+  if( dh ) { bh->m_IP = 0x00d3; bh->m_IC = ic; call_debug_scopes( info, scopes, 88u, data, 0x00d2 ); } 
+L_00d3: ++ic; // INST_COUNT_NODE 0x0118 0x0001 0x0000
+  count_node( (NodeCounters*)(base + 280), 1u, bh->m_RE );
+L_00d4: ++ic; // INST_SCRIPT_R 0x0000 0x0000 0x0000
+  { CallFrame* fr = (CallFrame*)(bss - sizeof(CallFrame)); bss = base + fr->m_FP; ip = fr->m_IP; } from = ip - 1; goto dispatch;
+
+exit:
+  bh->m_IC = ic;
+  bh->m_IP = 0;
+  bh->m_FP = 0;
+}
+
+int native_test( CallbackProgram* info )
+{
+  native_test_execute( info );
+  return ((BssHeader*)info->m_bss)->m_RE;
+}
+
+void native_test_batch( CallbackBatch* batch )
+{
+  CallbackProgram cp;
+  cp.m_Program  = batch->m_Program;
+  cp.m_Callback = batch->m_Callback;
+  cp.m_Debug    = batch->m_Debug;
+  cp.m_Table    = batch->m_Table;
+  cp.m_Flags    = batch->m_Flags;
+  cp.m_Frames   = batch->m_Frames;
+  cp.m_UserData = 0x0;
+
+  char* bss = (char*)batch->m_bss;
+  for( unsigned int a = 0; a < batch->m_Count; ++a, bss += batch->m_Stride )
+  {
+    cp.m_bss = bss;
+    if( batch->m_UserData )
+      cp.m_UserData = batch->m_UserData[a];
+    native_test_execute( &cp );
+  }
+}
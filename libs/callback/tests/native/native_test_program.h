@@ -0,0 +1,165 @@
+/*
+ * This file is auto generated by regenerate.sh from native_test.bts.
+ * Manual edits will be lost when regenerated.
+ */
+
+static const unsigned int s_NativeTestProgram[] =
+{
+  0x47525043u, 0x00000002u, 0x000000d5u, 0x00000ca8u, 0x0000018cu, 0x00000005u, 0x00000128u, 0x00000000u,
+  0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000011u, 0x00000058u, 0x00000010u,
+  0x00000c60u, 0x00000058u, 0x00000140u, 0x0003000du, 0x00000002u, 0x000c001du, 0x00000000u, 0x000b0026u,
+  0x00000004u, 0x000c001du, 0x00000001u, 0x000b0026u, 0x00000004u, 0x0000001bu, 0x00000000u, 0x000a000bu,
+  0x00000002u, 0x000c001du, 0x00000002u, 0x000b0026u, 0x00000004u, 0x0000001du, 0x00000003u, 0x0000002eu,
+  0x00000000u, 0x0016000du, 0x00000001u, 0x0013000du, 0x00000000u, 0x0010000du, 0x00000002u, 0x0003001fu,
+  0x00000000u, 0x00ad0013u, 0x00000000u, 0x0012000du, 0x0004ffffu, 0x00040019u, 0x00120004u, 0x00ad0013u,
+  0x00000000u, 0x0004001du, 0x0000ffffu, 0x0008001du, 0x0000ffffu, 0x00ad0013u, 0x00000000u, 0x0058002bu,
+  0x00000000u, 0x00080010u, 0x0008ffffu, 0x0008001du, 0x00000019u, 0x0068002bu, 0x00000000u, 0x00030007u,
+  0x0008ffffu, 0x0068002bu, 0x00000001u, 0x0004001du, 0x000000a2u, 0x00ac000bu, 0x00000002u, 0x00a20017u,
+  0x001f0004u, 0x00aa000cu, 0x00000001u, 0x0010001du, 0x00000003u, 0x0014001du, 0x00000003u, 0x0018001du,
+  0x00000003u, 0x000c001du, 0x0000ffffu, 0x0008001du, 0x00000025u, 0x0078002bu, 0x00000000u, 0x0048001du,
+  0x00000028u, 0x003c000du, 0x00100003u, 0x0044001du, 0x00000049u, 0x003f0017u, 0x002a0048u, 0x0084000bu,
+  0x00000002u, 0x00490017u, 0x002c0048u, 0x0084000bu, 0x00000001u, 0x0048001du, 0x0000002fu, 0x004e000du,
+  0x00140003u, 0x0044001du, 0x00000076u, 0x00510017u, 0x00310048u, 0x0084000bu, 0x00000002u, 0x00760017u,
+  0x00330048u, 0x0084000bu, 0x00000001u, 0x0048001du, 0x00000036u, 0x007b000du, 0x00180003u, 0x0044001du,
+  0x00000081u, 0x007c0017u, 0x00380048u, 0x0084000bu, 0x00000002u, 0x00810017u, 0x003a0048u, 0x0084000bu,
+  0x00000001u, 0x00890013u, 0x00000000u, 0x0024001du, 0x00000000u, 0x00ae0026u, 0x0000001cu, 0x00480015u,
+  0x00000000u, 0x0088002bu, 0x00000000u, 0x00040009u, 0xffffffffu, 0x0046000cu, 0x00000001u, 0x0098002bu,
+  0x00000000u, 0x0024001du, 0x00000001u, 0x00ae0026u, 0x0000001cu, 0x0098002bu, 0x00000001u, 0x0088002bu,
+  0x00000001u, 0x0010001bu, 0x00000000u, 0x00480015u, 0x00000000u, 0x004d000du, 0x00100003u, 0x0024001du,
+  0x00000002u, 0x00ae0026u, 0x0000001cu, 0x0010001du, 0x00000003u, 0x00480015u, 0x00000000u, 0x003c001du,
+  0x0000ffffu, 0x0038001du, 0x0000ffffu, 0x00480015u, 0x00000000u, 0x00a8002bu, 0x00000000u, 0x003c0010u,
+  0x003cffffu, 0x003c001du, 0x00000054u, 0x00b8002bu, 0x00000000u, 0x00020007u, 0xffffffffu, 0x00b8002bu,
+  0x00000001u, 0x0038001du, 0x0000006du, 0x0073000bu, 0x00000002u, 0x006d0017u, 0x005a0038u, 0x0071000bu,
+  0x00000001u, 0x003c001du, 0x0000005cu, 0x00c8002bu, 0x00000000u, 0x0000001fu, 0x00000000u, 0x00c8002bu,
+  0x00000001u, 0x0038001du, 0x0000006eu, 0x0073000bu, 0x00000002u, 0x006e0017u, 0x00620038u, 0x0071000bu,
+  0x00000001u, 0x00000006u, 0x00180040u, 0x003c001du, 0x00000065u, 0x00d8002bu, 0x00000000u, 0x00000007u,
+  0x00180040u, 0x00d8002bu, 0x00000001u, 0x0038001du, 0x0000006fu, 0x0073000bu, 0x00000002u, 0x006f0017u,
+  0x006b0038u, 0x0071000bu, 0x00000001u, 0x00720013u, 0x00000000u, 0x00380019u, 0xffff0038u, 0x00380019u,
+  0xffff0038u, 0x00000008u, 0x00180040u, 0x00380019u, 0xffff0038u, 0x0001001fu, 0x00000000u, 0x003c001du,
+  0x0000ffffu, 0x00a8002bu, 0x00000001u, 0x0014001bu, 0x00000000u, 0x00480015u, 0x00000000u, 0x007a000du,
+  0x00140003u, 0x0079000du, 0x0038ffffu, 0x00380019u, 0x00790038u, 0x0014001du, 0x00000003u, 0x00480015u,
+  0x00000000u, 0x00480015u, 0x00000000u, 0x00e8002bu, 0x00000000u, 0x0001001fu, 0x00000000u, 0x00e8002bu,
+  0x00000001u, 0x0018001bu, 0x00000000u, 0x00480015u, 0x00000000u, 0x0083000du, 0x00180003u, 0x0018001du,
+  0x00000003u, 0x00480015u, 0x00000000u, 0x0087000du, 0x000cffffu, 0x0048001du, 0x00000087u, 0x000c0012u,
+  0x000c0044u, 0x000c001eu, 0x00000044u, 0x0044001du, 0x0000ffffu, 0x0078002bu, 0x00000001u, 0x0004001du,
+  0x000000a3u, 0x00ac000bu, 0x00000002u, 0x00a30017u, 0x008d0004u, 0x00aa000cu, 0x00000001u, 0x0014001du,
+  0x00000000u, 0x00ae0026u, 0x0000000cu, 0x0008001du, 0x00000091u, 0x00f8002bu, 0x00000000u, 0x0014001du,
+  0x00000001u, 0x00ae0026u, 0x0000000cu, 0x00f8002bu, 0x00000001u, 0x0004001du, 0x000000a6u, 0x00ac000bu,
+  0x00000002u, 0x00a60017u, 0x00980004u, 0x00aa000cu, 0x00000001u, 0x0008001du, 0x0000009au, 0x0108002bu,
+  0x00000000u, 0x00030007u, 0x0028ffffu, 0x0108002bu, 0x00000001u, 0x0004001du, 0x000000a9u, 0x00ac000bu,
+  0x00000002u, 0x00a90017u, 0x00a00004u, 0x00aa000cu, 0x00000001u, 0x00ab0013u, 0x00000000u, 0x00040019u,
+  0xffff0004u, 0x0048001du, 0x000000a5u, 0x000c0010u, 0x000cffffu, 0x00040019u, 0xffff0004u, 0x0014001du,
+  0x00000002u, 0x00ae0026u, 0x0000000cu, 0x00040019u, 0xffff0004u, 0x00040019u, 0xffff0004u, 0x0000001fu,
+  0x00000000u, 0x0008001du, 0x0000ffffu, 0x0058002bu, 0x00000001u, 0x00000027u, 0x00000000u, 0x00b8000du,
+  0x00000001u, 0x00b5000du, 0x00000000u, 0x00b3000du, 0x00000002u, 0x0003001fu, 0x00000000u, 0x00d40013u,
+  0x00000000u, 0x00000008u, 0x00380004u, 0x00d40013u, 0x00000000u, 0x00000006u, 0x00380004u, 0x00010006u,
+  0x00480008u, 0x00d40013u, 0x00000000u, 0x0118002bu, 0x00000000u, 0x0010001du, 0x00000000u, 0x0128002bu,
+  0x00000000u, 0x00000007u, 0x00380004u, 0x0128002bu, 0x00000001u, 0x00d3000bu, 0x00000000u, 0x00c0000cu,
+  0x00000001u, 0x00100022u, 0x00000001u, 0x0138002bu, 0x00000000u, 0x0148002bu, 0x00000000u, 0x00020007u,
+  0xffffffffu, 0x0148002bu, 0x00000001u, 0x000c001bu, 0x00000000u, 0x0001000au, 0x00480008u, 0x0138002bu,
+  0x00000001u, 0x00d3000bu, 0x00000000u, 0x00ca000cu, 0x00000001u, 0x00100022u, 0x00000001u, 0x0158002bu,
+  0x00000000u, 0x0002001fu, 0x00000000u, 0x0158002bu, 0x00000001u, 0x00d3000bu, 0x00000000u, 0x00d0000cu,
+  0x00000001u, 0x00100022u, 0x00000001u, 0x0002001fu, 0x00000000u, 0x00d3000eu, 0x00100003u, 0x0001001fu,
+  0x00000000u, 0x0118002bu, 0x00000001u, 0x00000027u, 0x00000000u, 0x72617473u, 0x00000074u, 0x00000001u,
+  0x00000000u, 0x0000000bu, 0x00000000u, 0x00000001u, 0x00000010u, 0x656e6f64u, 0x00000000u, 0x00000001u,
+  0x00000020u, 0x00000007u, 0x00000000u, 0x00000001u, 0x00000030u, 0x00000003u, 0x00000000u, 0x00000001u,
+  0x00000040u, 0x54534544u, 0x54435552u, 0x00000000u, 0x00000000u, 0x75716553u, 0x65636e65u, 0x00000000u,
+  0x00000000u, 0x534e4f43u, 0x43555254u, 0x00000054u, 0x00000000u, 0x43455845u, 0x00455455u, 0x5f746361u,
+  0x6e697270u, 0x00000074u, 0x00000000u, 0x616e7944u, 0x2063696du, 0x656c6553u, 0x726f7463u, 0x00000000u,
+  0x00000000u, 0x5f636564u, 0x6e757270u, 0x00000065u, 0x00000000u, 0x6b726f77u, 0x00007265u, 0x4e555250u,
+  0x00000045u, 0x656c6553u, 0x726f7463u, 0x00000000u, 0x00000000u, 0x5f746361u, 0x63656863u, 0x0000006bu,
+  0x00000000u, 0x5f746361u, 0x756c6176u, 0x00000065u, 0x00000000u, 0x61726150u, 0x6c656c6cu, 0x00000000u,
+  0x00000000u, 0x5f636564u, 0x69646f6du, 0x00007966u, 0x00000000u, 0x49444f4du, 0x00005946u, 0x00000002u,
+  0x00000064u, 0x00000001u, 0x00000003u, 0x00000065u, 0x00000000u, 0x00000010u, 0x00000010u, 0x00000012u,
+  0x00000010u, 0x00000052u, 0x00000040u, 0x00000050u, 0x00000060u, 0x00000012u, 0x00000010u, 0x00000012u,
+  0x00000010u, 0x00000092u, 0x00000040u, 0x00000050u, 0x00000060u, 0x00000013u, 0x00000013u, 0x00000015u,
+  0x00000010u, 0x00000050u, 0x00000040u, 0x00000070u, 0x00000060u, 0x00000015u, 0x00000013u, 0x00000015u,
+  0x00000010u, 0x00000090u, 0x00000040u, 0x00000070u, 0x00000060u, 0x00000017u, 0x00000017u, 0x000000acu,
+  0x00000010u, 0x00000051u, 0x00000040u, 0x00000080u, 0x00000060u, 0x00000018u, 0x00000018u, 0x00000018u,
+  0x00000005u, 0x00000040u, 0x00000032u, 0x00000070u, 0x00000088u, 0x00000018u, 0x00000018u, 0x00000018u,
+  0x00000005u, 0x00000080u, 0x00000032u, 0x00000070u, 0x00000088u, 0x0000001au, 0x0000001au, 0x0000001bu,
+  0x00000005u, 0x00000041u, 0x00000032u, 0x00000080u, 0x00000088u, 0x0000001bu, 0x0000001au, 0x0000001bu,
+  0x00000005u, 0x00000081u, 0x00000032u, 0x00000080u, 0x00000088u, 0x00000020u, 0x00000020u, 0x00000024u,
+  0x0000000du, 0x00000050u, 0x0000003cu, 0x00000070u, 0x00000098u, 0x00000024u, 0x00000020u, 0x00000024u,
+  0x0000000du, 0x00000090u, 0x0000003cu, 0x00000070u, 0x00000098u, 0x00000026u, 0x00000026u, 0x00000089u,
+  0x0000000du, 0x00000051u, 0x0000003cu, 0x00000080u, 0x00000098u, 0x0000003cu, 0x0000003cu, 0x0000003eu,
+  0x00000007u, 0x00000040u, 0x00000034u, 0x00000070u, 0x000000b0u, 0x0000003cu, 0x0000003cu, 0x0000003eu,
+  0x00000006u, 0x00000060u, 0x00000034u, 0x00000070u, 0x000000c0u, 0x0000003eu, 0x0000003cu, 0x0000003eu,
+  0x00000006u, 0x000000a0u, 0x00000034u, 0x00000070u, 0x000000c0u, 0x0000003eu, 0x0000003cu, 0x0000003eu,
+  0x00000007u, 0x00000080u, 0x00000034u, 0x00000070u, 0x000000b0u, 0x00000040u, 0x00000040u, 0x00000046u,
+  0x00000007u, 0x00000041u, 0x00000034u, 0x00000080u, 0x000000b0u, 0x00000040u, 0x00000040u, 0x00000041u,
+  0x00000007u, 0x00000043u, 0x00000034u, 0x000000c8u, 0x000000b0u, 0x00000041u, 0x00000040u, 0x00000041u,
+  0x00000007u, 0x00000083u, 0x00000034u, 0x000000c8u, 0x000000b0u, 0x00000043u, 0x00000043u, 0x00000045u,
+  0x00000006u, 0x00000061u, 0x00000034u, 0x00000080u, 0x000000c0u, 0x00000045u, 0x00000043u, 0x00000045u,
+  0x00000006u, 0x000000a1u, 0x00000034u, 0x00000080u, 0x000000c0u, 0x00000046u, 0x00000040u, 0x00000046u,
+  0x00000007u, 0x00000081u, 0x00000034u, 0x00000080u, 0x000000b0u, 0x0000004au, 0x0000004au, 0x0000004cu,
+  0x00000007u, 0x00000042u, 0x00000034u, 0x00000050u, 0x000000b0u, 0x0000004au, 0x0000004au, 0x0000004cu,
+  0x00000006u, 0x00000062u, 0x00000034u, 0x00000050u, 0x000000c0u, 0x0000004cu, 0x0000004au, 0x0000004cu,
+  0x00000006u, 0x000000a2u, 0x00000034u, 0x00000050u, 0x000000c0u, 0x0000004cu, 0x0000004au, 0x0000004cu,
+  0x00000007u, 0x00000082u, 0x00000034u, 0x00000050u, 0x000000b0u, 0x0000004eu, 0x0000004eu, 0x00000050u,
+  0x0000000bu, 0x00000050u, 0x00000039u, 0x00000070u, 0x000000d0u, 0x00000050u, 0x0000004eu, 0x00000050u,
+  0x0000000bu, 0x00000090u, 0x00000039u, 0x00000070u, 0x000000d0u, 0x00000052u, 0x00000052u, 0x00000073u,
+  0x0000000bu, 0x00000051u, 0x00000039u, 0x00000080u, 0x000000d0u, 0x00000053u, 0x00000053u, 0x00000053u,
+  0x00000008u, 0x00000040u, 0x00000036u, 0x00000070u, 0x000000e0u, 0x00000053u, 0x00000053u, 0x00000053u,
+  0x00000008u, 0x00000080u, 0x00000036u, 0x00000070u, 0x000000e0u, 0x00000055u, 0x00000055u, 0x00000056u,
+  0x00000008u, 0x00000041u, 0x00000036u, 0x00000080u, 0x000000e0u, 0x00000056u, 0x00000055u, 0x00000056u,
+  0x00000008u, 0x00000081u, 0x00000036u, 0x00000080u, 0x000000e0u, 0x00000063u, 0x00000063u, 0x00000064u,
+  0x0000000au, 0x00000040u, 0x00000038u, 0x00000070u, 0x000000f0u, 0x00000064u, 0x00000063u, 0x00000064u,
+  0x0000000au, 0x00000080u, 0x00000038u, 0x00000070u, 0x000000f0u, 0x00000066u, 0x00000066u, 0x00000067u,
+  0x0000000au, 0x00000041u, 0x00000038u, 0x00000080u, 0x000000f0u, 0x00000067u, 0x00000066u, 0x00000067u,
+  0x0000000au, 0x00000081u, 0x00000038u, 0x00000080u, 0x000000f0u, 0x0000006du, 0x0000006du, 0x0000006du,
+  0x00000008u, 0x00000042u, 0x00000036u, 0x00000050u, 0x000000e0u, 0x0000006du, 0x0000006du, 0x0000006du,
+  0x00000008u, 0x00000082u, 0x00000036u, 0x00000050u, 0x000000e0u, 0x0000006fu, 0x0000006fu, 0x00000070u,
+  0x0000000au, 0x00000042u, 0x00000038u, 0x00000050u, 0x000000f0u, 0x00000070u, 0x0000006fu, 0x00000070u,
+  0x0000000au, 0x00000082u, 0x00000038u, 0x00000050u, 0x000000f0u, 0x00000073u, 0x00000052u, 0x00000073u,
+  0x0000000bu, 0x00000091u, 0x00000039u, 0x00000080u, 0x000000d0u, 0x00000077u, 0x00000077u, 0x00000079u,
+  0x0000000bu, 0x00000052u, 0x00000039u, 0x00000050u, 0x000000d0u, 0x00000079u, 0x00000077u, 0x00000079u,
+  0x0000000bu, 0x00000092u, 0x00000039u, 0x00000050u, 0x000000d0u, 0x00000089u, 0x00000026u, 0x00000089u,
+  0x0000000du, 0x00000091u, 0x0000003cu, 0x00000080u, 0x00000098u, 0x0000008eu, 0x0000008eu, 0x00000090u,
+  0x0000000eu, 0x00000060u, 0x0000003eu, 0x00000070u, 0x000000c0u, 0x00000090u, 0x0000008eu, 0x00000090u,
+  0x0000000eu, 0x000000a0u, 0x0000003eu, 0x00000070u, 0x000000c0u, 0x00000092u, 0x00000092u, 0x00000094u,
+  0x0000000eu, 0x00000061u, 0x0000003eu, 0x00000080u, 0x000000c0u, 0x00000094u, 0x00000092u, 0x00000094u,
+  0x0000000eu, 0x000000a1u, 0x0000003eu, 0x00000080u, 0x000000c0u, 0x00000099u, 0x00000099u, 0x00000099u,
+  0x0000000fu, 0x00000040u, 0x0000003fu, 0x00000070u, 0x00000088u, 0x00000099u, 0x00000099u, 0x00000099u,
+  0x0000000fu, 0x00000080u, 0x0000003fu, 0x00000070u, 0x00000088u, 0x0000009bu, 0x0000009bu, 0x0000009cu,
+  0x0000000fu, 0x00000041u, 0x0000003fu, 0x00000080u, 0x00000088u, 0x0000009cu, 0x0000009bu, 0x0000009cu,
+  0x0000000fu, 0x00000081u, 0x0000003fu, 0x00000080u, 0x00000088u, 0x000000a2u, 0x000000a2u, 0x000000a2u,
+  0x00000005u, 0x00000042u, 0x00000032u, 0x00000050u, 0x00000088u, 0x000000a2u, 0x000000a2u, 0x000000a2u,
+  0x00000005u, 0x00000082u, 0x00000032u, 0x00000050u, 0x00000088u, 0x000000a3u, 0x000000a3u, 0x000000a5u,
+  0x0000000du, 0x00000052u, 0x0000003cu, 0x00000050u, 0x00000098u, 0x000000a5u, 0x000000a3u, 0x000000a5u,
+  0x0000000du, 0x00000092u, 0x0000003cu, 0x00000050u, 0x00000098u, 0x000000a6u, 0x000000a6u, 0x000000a8u,
+  0x0000000eu, 0x00000062u, 0x0000003eu, 0x00000050u, 0x000000c0u, 0x000000a8u, 0x000000a6u, 0x000000a8u,
+  0x0000000eu, 0x000000a2u, 0x0000003eu, 0x00000050u, 0x000000c0u, 0x000000a9u, 0x000000a9u, 0x000000a9u,
+  0x0000000fu, 0x00000042u, 0x0000003fu, 0x00000050u, 0x00000088u, 0x000000a9u, 0x000000a9u, 0x000000a9u,
+  0x0000000fu, 0x00000082u, 0x0000003fu, 0x00000050u, 0x00000088u, 0x000000acu, 0x00000017u, 0x000000acu,
+  0x00000010u, 0x00000091u, 0x00000040u, 0x00000080u, 0x00000060u, 0x000000b3u, 0x000000b3u, 0x000000b4u,
+  0x00000004u, 0x00000052u, 0x0000002bu, 0x00000050u, 0x00000100u, 0x000000b3u, 0x000000b3u, 0x000000b4u,
+  0x00000000u, 0x00000042u, 0x00000028u, 0x00000050u, 0x000000f0u, 0x000000b4u, 0x000000b3u, 0x000000b4u,
+  0x00000000u, 0x00000082u, 0x00000028u, 0x00000050u, 0x000000f0u, 0x000000b4u, 0x000000b4u, 0x000000b4u,
+  0x00000002u, 0x00000042u, 0x00000029u, 0x00000050u, 0x00000110u, 0x000000b4u, 0x000000b4u, 0x000000b4u,
+  0x00000001u, 0x00000042u, 0x00000029u, 0x00000050u, 0x000000e0u, 0x000000b4u, 0x000000b4u, 0x000000b4u,
+  0x00000001u, 0x00000082u, 0x00000029u, 0x00000050u, 0x000000e0u, 0x000000b4u, 0x000000b4u, 0x000000b4u,
+  0x00000002u, 0x00000082u, 0x00000029u, 0x00000050u, 0x00000110u, 0x000000b4u, 0x000000b3u, 0x000000b4u,
+  0x00000004u, 0x00000092u, 0x0000002bu, 0x00000050u, 0x00000100u, 0x000000b5u, 0x000000b5u, 0x000000b7u,
+  0x00000004u, 0x00000050u, 0x0000002bu, 0x00000070u, 0x00000100u, 0x000000b5u, 0x000000b5u, 0x000000b6u,
+  0x00000000u, 0x00000040u, 0x00000028u, 0x00000070u, 0x000000f0u, 0x000000b6u, 0x000000b5u, 0x000000b6u,
+  0x00000000u, 0x00000080u, 0x00000028u, 0x00000070u, 0x000000f0u, 0x000000b6u, 0x000000b6u, 0x000000b7u,
+  0x00000002u, 0x00000040u, 0x00000029u, 0x00000070u, 0x00000110u, 0x000000b7u, 0x000000b7u, 0x000000b7u,
+  0x00000001u, 0x00000040u, 0x00000029u, 0x00000070u, 0x000000e0u, 0x000000b7u, 0x000000b7u, 0x000000b7u,
+  0x00000001u, 0x00000080u, 0x00000029u, 0x00000070u, 0x000000e0u, 0x000000b7u, 0x000000b6u, 0x000000b7u,
+  0x00000002u, 0x00000080u, 0x00000029u, 0x00000070u, 0x00000110u, 0x000000b7u, 0x000000b5u, 0x000000b7u,
+  0x00000004u, 0x00000090u, 0x0000002bu, 0x00000070u, 0x00000100u, 0x000000b9u, 0x000000b9u, 0x000000d3u,
+  0x00000004u, 0x00000051u, 0x0000002bu, 0x00000080u, 0x00000100u, 0x000000bbu, 0x000000bbu, 0x000000bcu,
+  0x00000000u, 0x00000041u, 0x00000028u, 0x00000080u, 0x000000f0u, 0x000000bcu, 0x000000bbu, 0x000000bcu,
+  0x00000000u, 0x00000081u, 0x00000028u, 0x00000080u, 0x000000f0u, 0x000000c1u, 0x000000c1u, 0x000000c6u,
+  0x00000002u, 0x00000041u, 0x00000029u, 0x00000080u, 0x00000110u, 0x000000c2u, 0x000000c2u, 0x000000c3u,
+  0x00000001u, 0x00000041u, 0x00000029u, 0x00000080u, 0x000000e0u, 0x000000c3u, 0x000000c2u, 0x000000c3u,
+  0x00000001u, 0x00000081u, 0x00000029u, 0x00000080u, 0x000000e0u, 0x000000c4u, 0x000000c4u, 0x000000c6u,
+  0x00000002u, 0x00000044u, 0x00000029u, 0x00000120u, 0x00000110u, 0x000000c6u, 0x000000c4u, 0x000000c6u,
+  0x00000002u, 0x00000084u, 0x00000029u, 0x00000120u, 0x00000110u, 0x000000c6u, 0x000000c1u, 0x000000c6u,
+  0x00000002u, 0x00000081u, 0x00000029u, 0x00000080u, 0x00000110u, 0x000000d3u, 0x000000b9u, 0x000000d3u,
+  0x00000004u, 0x00000091u, 0x0000002bu, 0x00000080u, 0x00000100u, 0x0dad0000u, 0x50000051u, 0x006d546bu,
+  0x0289a0d8u, 0x1a154200u, 0x1af8136cu, 0x0008005eu, 0x00000000u, 0x00000010u, 0x00000005u, 0x0000000du,
+  0x00000007u, 0x00000006u, 0x0000000bu, 0x00000008u, 0x00000009u, 0x0000000au, 0x0000000cu, 0x0000000eu,
+  0x0000000fu, 0x00000004u, 0x00000000u, 0x00000002u, 0x00000001u, 0x00000003u, 0x00000000u,
+};
@@ -0,0 +1,32 @@
+#!/bin/sh
+#*******************************************************************************
+# Copyright (c) 2009-04-24 Joacim Jacobsson.
+# All rights reserved. This program and the accompanying materials
+# are made available under the terms of the Eclipse Public License v1.0
+# which accompanies this distribution, and is available at
+# http://www.eclipse.org/legal/epl-v10.html
+#
+# Contributors:
+#    Joacim Jacobsson - first implementation
+#*******************************************************************************
+
+# Compiles native_test.bts with the ctc given as the argument into the C++
+# code and the bytecode test_native.cpp runs against each other. The bytecode
+# is written as an array of little endian words.
+
+set -e
+CTC=${1:-ctc}
+cd "$(dirname "$0")"
+
+"$CTC" -i native_test.bts -o native_test.btc -c native_test.cpp
+
+{
+  printf '/*\n * This file is auto generated by regenerate.sh from native_test.bts.\n'
+  printf ' * Manual edits will be lost when regenerated.\n */\n\n'
+  printf 'static const unsigned int s_NativeTestProgram[] =\n{'
+  od -An -v -tx4 native_test.btc | tr -s ' ' '\n' | grep -v '^$' |
+    awk '{ printf( "%s0x%su,", (NR % 8) == 1 ? "\n  " : " ", $1 ) }'
+  printf '\n};\n'
+} > native_test_program.h
+
+rm native_test.btc
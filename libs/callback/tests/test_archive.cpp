@@ -0,0 +1,148 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/archive.h>
+
+#include <stdio.h>
+
+using namespace callback;
+
+static const char* const TEST_ARCHIVE = "test_archive.bta";
+
+/*
+ * Two copies of the test program, "first" and "second", the way ctc lays
+ * them out. "damage" flips a byte in the second program.
+ */
+static bool write_test_archive( const TestProgram& p, bool damage )
+{
+  const unsigned int count = 2;
+  static char file[ARCHIVE_ALIGNMENT * (count + 1)];
+  memset( file, 0, sizeof(file) );
+
+  ArchiveEntry* e = (ArchiveEntry*)(file + sizeof(ArchiveHeader));
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    strcpy( e[i].m_Name, i == 0 ? "first" : "second" );
+    e[i].m_Offset   = ARCHIVE_ALIGNMENT * (i + 1);
+    e[i].m_Size     = sizeof(TestProgram);
+    e[i].m_Checksum = archive_checksum( &p, sizeof(TestProgram) );
+    memcpy( file + e[i].m_Offset, &p, sizeof(TestProgram) );
+  }
+  if( damage )
+    file[e[1].m_Offset + sizeof(ProgramHeader)] ^= 1;
+
+  ArchiveHeader* h = (ArchiveHeader*)file;
+  h->m_Magic    = ARCHIVE_MAGIC;
+  h->m_Version  = ARCHIVE_VERSION;
+  h->m_Count    = count;
+  h->m_Size     = sizeof(file);
+  h->m_Checksum = archive_checksum( e, sizeof(ArchiveEntry) * count );
+
+  FILE* f = fopen( TEST_ARCHIVE, "wb" );
+  if( !f )
+    return false;
+  bool ok = fwrite( file, 1, sizeof(file), f ) == sizeof(file);
+  fclose( f );
+  return ok;
+}
+
+TEST( ArchiveRunsInPlace )
+{
+  static TestProgram p;
+  init_test_program( &p );
+  CHECK( write_test_archive( p, false ) );
+
+  Archive* a = open_archive( TEST_ARCHIVE );
+  CHECK( a != 0x0 );
+  if( !a )
+    return;
+
+  CHECK_EQUAL( 2u, get_archive_count( a ) );
+  CHECK( strcmp( get_archive_name( a, 1 ), "second" ) == 0 );
+  CHECK_EQUAL( 1, find_archive_program( a, "second" ) );
+  CHECK_EQUAL( -1, find_archive_program( a, "third" ) );
+  CHECK_EQUAL( -1, verify_archive( a ) );
+
+  void* program = get_archive_program( a, 1 );
+  CHECK_EQUAL( 0u, ((size_t)program) % ARCHIVE_ALIGNMENT );
+
+  CallbackProgram mcp, acp;
+  static TestRun mr, ar;
+  init_run( &mcp, &mr, &p, 0 );
+  init_run( &acp, &ar, &p, 0 );
+  acp.m_Program = program;
+
+  for( unsigned int f = 0; f < 10; ++f )
+    CHECK_EQUAL( run_program( &mcp ), run_program( &acp ) );
+  check_same( mr, ar );
+
+  close_archive( a );
+  remove( TEST_ARCHIVE );
+}
+
+TEST( ArchiveChecksums )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  //A damaged program is only found by verify_archive
+  CHECK( write_test_archive( p, true ) );
+  Archive* a = open_archive( TEST_ARCHIVE );
+  CHECK( a != 0x0 );
+  if( a )
+    CHECK_EQUAL( 1, verify_archive( a ) );
+  close_archive( a );
+
+  //Damaged entries are found when it is opened
+  FILE* f = fopen( TEST_ARCHIVE, "r+b" );
+  CHECK( f != 0x0 );
+  if( f )
+  {
+    fseek( f, sizeof(ArchiveHeader) + 1, SEEK_SET );
+    fputc( 'X', f );
+    fclose( f );
+  }
+  CHECK( open_archive( TEST_ARCHIVE ) == 0x0 );
+
+  CHECK( open_archive( "no_such_archive.bta" ) == 0x0 );
+  remove( TEST_ARCHIVE );
+}
+
+TEST( ArchivesOnlyGiveProgramsOfThisVersion )
+{
+  static TestProgram p;
+  init_test_program( &p );
+  CHECK( check_program( &p, sizeof(TestProgram) ) );
+  CHECK( !check_program( &p, sizeof(TestProgram) - 1 ) );
+
+  //Only breakpoints.h makes programs with E_PROGRAM_BREAKPOINTS
+  p.m_Header.m_PF = E_PROGRAM_BREAKPOINTS;
+  CHECK( !check_program( &p, sizeof(TestProgram) ) );
+  CHECK( write_test_archive( p, false ) );
+  Archive* b = open_archive( TEST_ARCHIVE );
+  CHECK( b != 0x0 );
+  if( b )
+    CHECK( get_archive_program( b, 0 ) == 0x0 );
+  close_archive( b );
+  p.m_Header.m_PF = 0;
+
+  p.m_Header.m_Version = PROGRAM_VERSION + 1;
+  CHECK( !check_program( &p, sizeof(TestProgram) ) );
+  CHECK( write_test_archive( p, false ) );
+  Archive* a = open_archive( TEST_ARCHIVE );
+  CHECK( a != 0x0 );
+  if( a )
+    CHECK( get_archive_program( a, 0 ) == 0x0 );
+  close_archive( a );
+  remove( TEST_ARCHIVE );
+}
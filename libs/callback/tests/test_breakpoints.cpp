@@ -0,0 +1,199 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/breakpoints.h>
+
+using namespace callback;
+
+/*
+ * A map of the test program with two nodes: "main", whose construct code is
+ * the first instruction, and "sub", whose execute code starts at the fused
+ * execute callback of the subroutine.
+ */
+const unsigned int BREAK_MAIN   = 100;
+const unsigned int BREAK_SUB    = 200;
+const unsigned int BREAK_SUB_IP = 13;
+
+struct BreakMap
+{
+  NodeMapHeader m_Header;
+  MapTree       m_Tree;
+  MapNode       m_Node[2];
+  unsigned int  m_Owner[TEST_INSTRUCTIONS];
+  unsigned int  m_Action[TEST_INSTRUCTIONS];
+  char          m_String[12];
+};
+
+static void init_break_map( BreakMap* m )
+{
+  memset( m, 0, sizeof(BreakMap) );
+  m->m_Header.m_Magic   = NODE_MAP_MAGIC;
+  m->m_Header.m_Version = NODE_MAP_VERSION;
+  m->m_Header.m_IC      = TEST_INSTRUCTIONS;
+  m->m_Header.m_BS      = TEST_BSS;
+  m->m_Header.m_TC      = 1;
+  m->m_Header.m_NC      = 2;
+  m->m_Header.m_SS      = sizeof(m->m_String);
+  strcpy( m->m_String, "main" );
+  strcpy( m->m_String + 5, "sub" );
+
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    MapNode& n = m->m_Node[i];
+    n.m_Type   = E_MAP_ACTION;
+    n.m_Parent = i == 0 ? MAP_NONE : 0;
+    n.m_Callee = MAP_NONE;
+    n.m_Line   = 10 + i;
+    for( unsigned int a = 0; a < 3; ++a )
+      n.m_Entry[a] = MAP_NONE;
+  }
+  m->m_Node[0].m_Id   = BREAK_MAIN;
+  m->m_Node[0].m_Type = E_MAP_SEQUENCE;
+  m->m_Node[0].m_Entry[ACT_CONSTRUCT] = 0;
+  m->m_Node[1].m_Id   = BREAK_SUB;
+  m->m_Node[1].m_Name = 5;
+  m->m_Node[1].m_Entry[ACT_EXECUTE] = BREAK_SUB_IP;
+
+  for( unsigned int i = 0; i < TEST_INSTRUCTIONS; ++i )
+  {
+    m->m_Owner[i]  = i < 7 ? 0 : 1;
+    m->m_Action[i] = ACT_EXECUTE;
+  }
+}
+
+static unsigned int g_BreakFlags;
+
+static void break_debug( CallbackProgram* cp, DebugInformation* di, BssHeader* bh,
+  void* user_data )
+{
+  if( di->m_Flags & E_BREAKPOINT )
+    g_BreakFlags = di->m_Flags;
+  test_debug( cp, di, bh, user_data );
+}
+
+/*
+ * The log of a run of the copy is that of a run of the program with the
+ * entries of the breakpoint at "ip" in it.
+ */
+static void check_stopped_at( const TestRun& program, const TestRun& copy, unsigned int ip,
+  unsigned int id )
+{
+  CHECK_EQUAL( program.m_Count + 5, copy.m_Count );
+  unsigned int at = 0;
+  while( at + 5 <= copy.m_Count && !(copy.m_Log[at + 1] == ip && copy.m_Log[at + 3] == id) )
+    ++at;
+  CHECK( at + 5 <= copy.m_Count );
+  if( at + 5 > copy.m_Count )
+    return;
+  CHECK( memcmp( program.m_Log, copy.m_Log, sizeof(unsigned int) * at ) == 0 );
+  CHECK( memcmp( program.m_Log + at, copy.m_Log + at + 5,
+    sizeof(unsigned int) * (program.m_Count - at) ) == 0 );
+  CHECK( memcmp( program.m_Base, copy.m_Base, TEST_BSS ) == 0 );
+}
+
+TEST( BreakpointsStopOnlyAgentsOfTheCopy )
+{
+  static TestProgram p, original;
+  init_test_program( &p );
+  init_test_program( &original );
+  static BreakMap m;
+  init_break_map( &m );
+
+  CHECK( !create_breakpoints( &p, 0x0 ) );
+  Breakpoints* bp = create_breakpoints( &p, (NodeMapHeader*)&m );
+  CHECK( bp );
+  if( !bp )
+    return;
+  CHECK( get_breakpoint_program( bp ) == &p );
+  CHECK( !set_breakpoint( bp, 300, ACT_EXECUTE ) );
+  CHECK( !set_breakpoint( bp, BREAK_SUB, ACT_DESTRUCT ) );
+  CHECK( !clear_breakpoint( bp, BREAK_SUB, ACT_EXECUTE ) );
+  CHECK( get_breakpoint_program( bp ) == &p );
+
+  CHECK( set_breakpoint( bp, BREAK_SUB, ACT_EXECUTE ) );
+  CHECK( set_breakpoint( bp, BREAK_SUB, ACT_EXECUTE ) );
+  void* copy = get_breakpoint_program( bp );
+  CHECK( copy != &p );
+  CHECK( memcmp( &p, &original, sizeof(TestProgram) ) == 0 );
+  CHECK( memcmp( copy, &p, sizeof(TestProgram) ) != 0 );
+
+  const unsigned int flags[2] = { 0, E_CALLBACK_JIT };
+  for( int f = 0; f < 2; ++f )
+  {
+    CallbackProgram a, b;
+    static TestRun r[2];
+    init_run( &a, r + 0, &p, flags[f] );
+    init_run( &b, r + 1, &p, flags[f] );
+    b.m_Program = copy;
+    b.m_Debug   = &break_debug;
+    g_BreakFlags = 0;
+    run_program( &a );
+    run_program( &b );
+    check_stopped_at( r[0], r[1], BREAK_SUB_IP, BREAK_SUB );
+    CHECK_EQUAL( (unsigned int)(E_BREAKPOINT | E_STANDARD_NODE | ACT_EXECUTE), g_BreakFlags );
+
+    //Without a debug handler the breakpoint is passed
+    b.m_Debug = 0x0;
+    a.m_Debug = 0x0;
+    r[0].m_Count = 0;
+    r[1].m_Count = 0;
+    run_program( &a );
+    run_program( &b );
+    check_same( r[0], r[1] );
+  }
+
+  //The copy differs from the program only by its flag once cleared
+  CHECK( clear_breakpoint( bp, BREAK_SUB, ACT_EXECUTE ) );
+  CHECK( ((ProgramHeader*)copy)->m_PF & E_PROGRAM_BREAKPOINTS );
+  ((ProgramHeader*)copy)->m_PF &= ~E_PROGRAM_BREAKPOINTS;
+  CHECK( memcmp( copy, &p, sizeof(TestProgram) ) == 0 );
+  ((ProgramHeader*)copy)->m_PF |= E_PROGRAM_BREAKPOINTS;
+  CHECK( get_breakpoint_program( bp ) == copy );
+  destroy_breakpoints( bp );
+}
+
+TEST( BreakpointsAreStoppedAtOnceByResumedRuns )
+{
+  static TestProgram p;
+  init_test_program( &p );
+  static BreakMap m;
+  init_break_map( &m );
+  Breakpoints* bp = create_breakpoints( &p, (NodeMapHeader*)&m );
+  CHECK( bp );
+  if( !bp )
+    return;
+  CHECK( set_breakpoint( bp, BREAK_MAIN, ACT_CONSTRUCT ) );
+  CHECK( set_breakpoint( bp, BREAK_SUB, ACT_EXECUTE ) );
+
+  CallbackProgram a, b;
+  static TestRun r[2];
+  init_run( &a, r + 0, &p, 0 );
+  init_run( &b, r + 1, &p, 0 );
+  a.m_Program = get_breakpoint_program( bp );
+  b.m_Program = get_breakpoint_program( bp );
+  a.m_Debug   = &break_debug;
+  b.m_Debug   = &break_debug;
+  for( int i = 0; i < 3; ++i )
+  {
+    run_program( &a );
+    while( run_program_budget( &b, 1 ) == E_RUN_YIELDED )
+      ;
+  }
+  check_same( r[0], r[1] );
+  //Stopped at before the first instruction of the run was executed
+  CHECK_EQUAL( 0u, r[0].m_Log[0] );
+  CHECK_EQUAL( 0u, r[0].m_Log[1] );
+  CHECK_EQUAL( BREAK_MAIN, r[0].m_Log[3] );
+  CHECK_EQUAL( 4u, r[0].m_Log[4] );
+  destroy_breakpoints( bp );
+}
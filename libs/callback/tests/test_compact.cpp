@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/compact.h>
+
+using namespace callback;
+
+TEST( CompactRoundTrip )
+{
+  const WideVMIType values[] = { 0, 1, 0x7e, 0x7f, 0x80, 0x3fff, 0x4000,
+    0xffff, 0x12345678, 0xfffffffe, WIDE_NO_OPERAND };
+  const unsigned int count = sizeof(values) / sizeof(values[0]);
+
+  for( unsigned int v = 0; v < count; ++v )
+  {
+    WideInstruction in, out;
+    in.m_I  = INST_JABC_S_C_IN_B;
+    in.m_A1 = values[v];
+    in.m_A2 = values[count - v - 1];
+    in.m_A3 = values[(v * 7) % count];
+
+    unsigned char b[COMPACT_MAX_SIZE];
+    unsigned int size = compact_encode( in, b );
+    CHECK( size <= COMPACT_MAX_SIZE );
+    CHECK( compact_decode( b, &out ) == b + size );
+    CHECK_EQUAL( in.m_I, out.m_I );
+    CHECK_EQUAL( in.m_A1, out.m_A1 );
+    CHECK_EQUAL( in.m_A2, out.m_A2 );
+    CHECK_EQUAL( in.m_A3, out.m_A3 );
+  }
+
+  //Only the operands the instruction uses are stored
+  WideInstruction s = { INST_______SUSPEND, 0, 0, 0 };
+  unsigned char b[COMPACT_MAX_SIZE];
+  CHECK_EQUAL( 1u, compact_encode( s, b ) );
+  WideInstruction n = { INST_FUSE_EXEC_FUN, 3, WIDE_NO_OPERAND, WIDE_NO_OPERAND };
+  CHECK_EQUAL( 4u, compact_encode( n, b ) );
+}
+
+TEST( CompactMatchesNarrow )
+{
+  static TestProgram p;
+  static BuiltProgram c;
+  init_test_program( &p );
+  build_test_program( &c, &p, E_PROGRAM_COMPACT );
+
+  CallbackProgram ncp, ccp;
+  static TestRun nr, cr;
+  init_run( &ncp, &nr, &p, 0 );
+  init_run( &ccp, &cr, &c, 0 );
+
+  //Budgeted runs stop and resume in the middle of the compact code
+  for( unsigned int f = 0; f < 10; ++f )
+  {
+    run_program( &ncp );
+    run_program_budget( &ccp, 3 + f );
+    run_program( &ccp );
+  }
+
+  CHECK( nr.m_Calls > 10 );
+  check_same( nr, cr );
+}
+
+TEST( CompactJitMatchesNarrow )
+{
+  static TestProgram p;
+  static BuiltProgram c;
+  init_test_program( &p );
+  build_test_program( &c, &p, E_PROGRAM_COMPACT );
+
+  CallbackProgram ncp, ccp;
+  static TestRun nr, cr;
+  init_run( &ncp, &nr, &p, 0 );
+  init_run( &ccp, &cr, &c, E_CALLBACK_JIT );
+
+  for( unsigned int f = 0; f < 10; ++f )
+    CHECK_EQUAL( run_program( &ncp ), run_program( &ccp ) );
+
+  check_same( nr, cr );
+  jit_release( &c );
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/counters.h>
+
+using namespace callback;
+
+const unsigned int COUNTED_BLOCK = 16;
+
+/*
+ * Node 10 with node 11 inside it, which makes one callback.
+ */
+static void init_counted_program( BuiltProgram* p, unsigned int cycles )
+{
+  ProgramBuilder b;
+  init_builder( &b );
+  b.m_Header.m_CC = 1;
+  b.m_Header.m_CT = add_word( &b, 3 );
+  b.m_Header.m_NC = 2;
+  b.m_Header.m_NB = COUNTED_BLOCK;
+  b.m_Header.m_NS = cycles ? NODE_CYCLE_SIZE : NODE_COUNTER_SIZE;
+  b.m_Header.m_NT = add_word( &b, 10 );
+  add_word( &b, 11 );
+
+  const unsigned int size = b.m_Header.m_NS;
+  add_instruction( &b, INST_COUNT_NODE, COUNTED_BLOCK, E_COUNT_ENTER | cycles, 0 );
+  add_instruction( &b, INST_COUNT_NODE, COUNTED_BLOCK + size, E_COUNT_ENTER | cycles, 0 );
+  add_instruction( &b, INST_FUSE_EXEC_FUN, 0, NO_OPERAND, NO_OPERAND );
+  add_instruction( &b, INST_COUNT_NODE, COUNTED_BLOCK + size, E_COUNT_RESULT | cycles, 0 );
+  add_instruction( &b, INST_COUNT_NODE, COUNTED_BLOCK, E_COUNT_RESULT | cycles, 0 );
+  add_instruction( &b, INST_______SUSPEND, 0, 0, 0 );
+  build_program( &b, p, 0 );
+}
+
+TEST( NodeCountersCountEveryResult )
+{
+  static BuiltProgram p;
+  init_counted_program( &p, 0 );
+
+  CounterLayout cl;
+  CHECK( get_counter_layout( &p, &cl ) );
+  CHECK_EQUAL( 2u, cl.m_Count );
+  CHECK_EQUAL( 11u, cl.m_Ids[1] );
+
+  CallbackProgram a, b;
+  static TestRun r[2];
+  init_run( &a, r + 0, &p, 0 );
+  init_run( &b, r + 1, &p, E_CALLBACK_JIT );
+  for( int i = 0; i < 9; ++i )
+  {
+    run_program( &a );
+    run_program( &b );
+  }
+  check_same( r[0], r[1] );
+
+  NodeCounts c[2];
+  memset( c, 0, sizeof(c) );
+  add_node_counts( &cl, r[0].m_Bss, c );
+  CHECK_EQUAL( 9ull, c[0].m_Enter );
+  CHECK_EQUAL( 9ull, c[0].m_Result[0] + c[0].m_Result[1] + c[0].m_Result[2] );
+  CHECK( c[0].m_Result[0] > 0 && c[0].m_Result[1] > 0 && c[0].m_Result[2] > 0 );
+  CHECK( memcmp( c + 0, c + 1, sizeof(NodeCounts) ) == 0 );
+
+  //Both agents, as a batch
+  CallbackBatch batch;
+  memset( &batch, 0, sizeof(batch) );
+  batch.m_Program = &p;
+  batch.m_bss     = r[0].m_Bss;
+  batch.m_Stride  = sizeof(TestRun);
+  batch.m_Count   = 2;
+  memset( c, 0, sizeof(c) );
+  add_batch_counts( &cl, &batch, c );
+  CHECK_EQUAL( 18ull, c[1].m_Enter );
+
+  clear_node_counters( &cl, r[0].m_Bss );
+  memset( c, 0, sizeof(c) );
+  add_node_counts( &cl, r[0].m_Bss, c );
+  CHECK_EQUAL( 0ull, c[0].m_Enter + c[0].m_Result[0] + c[0].m_Result[1] + c[0].m_Result[2] );
+
+  p.m_Header.m_NC = 0;
+  CHECK( !get_counter_layout( &p, &cl ) );
+}
+
+TEST( NodeCountersTimeNodes )
+{
+  static BuiltProgram p;
+  init_counted_program( &p, E_COUNT_CYCLES );
+
+  CounterLayout cl;
+  CHECK( get_counter_layout( &p, &cl ) );
+
+  CallbackProgram a;
+  static TestRun ra;
+  init_run( &a, &ra, &p, E_CALLBACK_JIT );
+  for( int i = 0; i < 3; ++i )
+    run_program( &a );
+
+  NodeCounts c[2];
+  memset( c, 0, sizeof(c) );
+  add_node_counts( &cl, ra.m_Bss, c );
+  CHECK_EQUAL( 3ull, c[1].m_Enter );
+  //The outer node's time includes the inner one's
+  CHECK( c[0].m_Cycles >= c[1].m_Cycles );
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+using namespace callback;
+
+const unsigned int SCOPED_NODE = 0x00120034;
+
+/*
+ * One node with one callback, its code is instruction 2. The first run falls
+ * into it, later runs jump past it from instruction 1.
+ */
+static void init_scoped_program( BuiltProgram* p )
+{
+  ProgramBuilder b;
+  init_builder( &b );
+  b.m_Header.m_CC = 1;
+  b.m_Header.m_CT = add_word( &b, 3 );
+  const unsigned int action = add_data( &b, "EXECUTE", 8 );
+  const unsigned int name   = add_data( &b, "node", 5 );
+
+  DebugScope scopes[2];
+  const unsigned int flags[2] = { E_ENTER_SCOPE, E_EXIT_SCOPE };
+  memset( scopes, 0, sizeof(scopes) );
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    DebugScope& s = scopes[i];
+    s.m_IP     = 2 + i;
+    s.m_Begin  = 2;
+    s.m_End    = 3;
+    s.m_NodeId = SCOPED_NODE;
+    s.m_Flags  = flags[i] | E_STANDARD_NODE | ACT_EXECUTE;
+    s.m_LineNo = 7;
+    s.m_Action = action;
+    s.m_Name   = name;
+  }
+  b.m_Header.m_DC = 2;
+  b.m_Header.m_DT = add_data( &b, scopes, sizeof(scopes) );
+  add_word( &b, (1 << 2) | (1 << 3) );
+
+  add_instruction( &b, INST__INC_BSSVALUE, 0, 1, 0 );
+  add_instruction( &b, INST_JABC_C_DIFF_B, 3, 1, 0 );
+  add_instruction( &b, INST_FUSE_EXEC_FUN, 0, NO_OPERAND, NO_OPERAND );
+  add_instruction( &b, INST_______SUSPEND, 0, 0, 0 );
+  build_program( &b, p, 0 );
+}
+
+static void scope_debug( CallbackProgram*, DebugInformation* di, BssHeader* bh,
+  void* user_data )
+{
+  TestRun* r = (TestRun*)user_data;
+  log_value( r, di->m_Flags );
+  log_value( r, bh->m_IP );
+  CHECK_EQUAL( SCOPED_NODE, di->m_NodeId );
+  CHECK_EQUAL( 7u, di->m_LineNo );
+  CHECK( strcmp( di->m_Action, "EXECUTE" ) == 0 );
+  CHECK( strcmp( di->m_Name, "node" ) == 0 );
+}
+
+TEST( DebugScopesAreOnlyPassedWhenDebugging )
+{
+  static BuiltProgram p;
+  init_scoped_program( &p );
+
+  const unsigned int flags[2] = { 0, E_CALLBACK_JIT };
+  for( int f = 0; f < 2; ++f )
+  {
+    CallbackProgram cp;
+    static TestRun r;
+    init_run( &cp, &r, &p, flags[f] );
+    cp.m_Debug = &scope_debug;
+    run_program( &cp );
+    //Into the node and out of it; jumping past it does neither
+    CHECK_EQUAL( 4u + 4u, r.m_Count );
+    CHECK_EQUAL( (unsigned int)(E_ENTER_SCOPE | E_STANDARD_NODE | ACT_EXECUTE), r.m_Log[0] );
+    CHECK_EQUAL( 2u, r.m_Log[1] );
+    CHECK_EQUAL( (unsigned int)(E_EXIT_SCOPE | E_STANDARD_NODE | ACT_EXECUTE), r.m_Log[6] );
+    CHECK_EQUAL( 3u, r.m_Log[7] );
+    run_program( &cp );
+    CHECK_EQUAL( 8u, r.m_Count );
+
+    //Without a debug handler the table is not looked at
+    cp.m_Debug = 0x0;
+    memset( r.m_Bss, 0, TEST_BSS );
+    r.m_Count = 0;
+    run_program( &cp );
+    CHECK_EQUAL( 4u, r.m_Count );
+  }
+}
+
+TEST( DebugScopesArePassedOnceByResumedRuns )
+{
+  static BuiltProgram p;
+  init_scoped_program( &p );
+
+  CallbackProgram a, b;
+  static TestRun r[2];
+  init_run( &a, r + 0, &p, 0 );
+  init_run( &b, r + 1, &p, 0 );
+  a.m_Debug = &scope_debug;
+  b.m_Debug = &scope_debug;
+  run_program( &a );
+  while( run_program_budget( &b, 1 ) == E_RUN_YIELDED )
+    ;
+  check_same( r[0], r[1] );
+}
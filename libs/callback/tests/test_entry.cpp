@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+using namespace callback;
+
+const unsigned int ENTRY_INSTRUCTIONS = 7;
+const unsigned int ENTRY_SLOT         = 8;
+
+/*
+ * Two entry points the way ctc -k links them, each making one callback.
+ */
+struct EntryProgram
+{
+  ProgramHeader m_Header;
+  Instruction   m_Inst[ENTRY_INSTRUCTIONS];
+  char          m_First[8];
+  char          m_Second[8];
+  unsigned int  m_Table[5];
+  unsigned int  m_Ids[2];
+};
+
+static void init_entry_program( EntryProgram* p )
+{
+  memset( p, 0, sizeof(EntryProgram) );
+  p->m_Header.m_IC = ENTRY_INSTRUCTIONS;
+  p->m_Header.m_DS = sizeof(EntryProgram) - sizeof(ProgramHeader)
+    - sizeof(Instruction) * ENTRY_INSTRUCTIONS;
+  p->m_Header.m_BS = TEST_BSS;
+  p->m_Header.m_CC = 2;
+  p->m_Header.m_CT = 36;
+  p->m_Header.m_EC = 2;
+  p->m_Header.m_ET = 16;
+  strcpy( p->m_First, "first" );
+  strcpy( p->m_Second, "second" );
+  p->m_Table[0] = ENTRY_SLOT;
+  p->m_Table[1] = 0;
+  p->m_Table[2] = 3;
+  p->m_Table[3] = 8;
+  p->m_Table[4] = 5;
+  p->m_Ids[0] = 5;
+  p->m_Ids[1] = 1234;
+
+  Instruction* i = p->m_Inst;
+  set_instruction( i++, INST_JABC_C_DIFF_B, 2, 0, ENTRY_SLOT );
+  set_instruction( i++, INST_JABC_CONSTANT, 3, 0, 0 );
+  set_instruction( i++, INST_JABB_BSSVALUE, ENTRY_SLOT, 0, 0 );
+  set_instruction( i++, INST_FUSE_EXEC_FUN, 0, NO_OPERAND, NO_OPERAND );
+  set_instruction( i++, INST_______SUSPEND, 0, 0, 0 );
+  set_instruction( i++, INST_FUSE_EXEC_FUN, 1, NO_OPERAND, NO_OPERAND );
+  set_instruction( i++, INST_______SUSPEND, 0, 0, 0 );
+}
+
+TEST( EntryPointNames )
+{
+  static EntryProgram p;
+  init_entry_program( &p );
+
+  CHECK_EQUAL( 2u, get_entry_count( &p ) );
+  CHECK( strcmp( get_entry_name( &p, 1 ), "second" ) == 0 );
+  CHECK_EQUAL( 0, find_entry_point( &p, "first" ) );
+  CHECK_EQUAL( 1, find_entry_point( &p, "second" ) );
+  CHECK_EQUAL( -1, find_entry_point( &p, "third" ) );
+
+  static TestProgram t;
+  init_test_program( &t );
+  CHECK_EQUAL( 0u, get_entry_count( &t ) );
+}
+
+TEST( EntryPointsRun )
+{
+  static EntryProgram p;
+  init_entry_program( &p );
+
+  //Entry point zero until another one is set, also when compiled
+  for( unsigned int flags = 0; flags <= E_CALLBACK_JIT; flags += E_CALLBACK_JIT )
+  {
+    CallbackProgram fcp, scp;
+    static TestRun fr, sr;
+    init_run( &fcp, &fr, &p, flags );
+    init_run( &scp, &sr, &p, flags );
+    fcp.m_Program = scp.m_Program = &p;
+    set_entry_point( &scp, 1 );
+
+    for( unsigned int f = 0; f < 3; ++f )
+    {
+      run_program( &fcp );
+      run_program( &scp );
+    }
+
+    CHECK_EQUAL( 3u, fr.m_Calls );
+    CHECK_EQUAL( 3u, sr.m_Calls );
+    CHECK_EQUAL( 5u, fr.m_Log[8] );
+    CHECK_EQUAL( 1234u, sr.m_Log[8] );
+    if( flags )
+      jit_release( &p );
+  }
+}
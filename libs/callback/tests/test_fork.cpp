@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/fork.h>
+
+using namespace callback;
+
+static void run_in( CallbackProgram* cp, TestRun* r, void* bss, unsigned int frames )
+{
+  cp->m_bss = bss;
+  r->m_Base = (char*)bss;
+  for( unsigned int f = 0; f < frames; ++f )
+    run_program( cp );
+}
+
+TEST( ForkLeavesAgentAlone )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  ForkArena* fa = create_fork_arena( &p, 2 );
+  CHECK( fa != 0x0 );
+
+  CallbackProgram cp;
+  static TestRun r;
+  init_run( &cp, &r, &p, 0 );
+  run_in( &cp, &r, get_agent_bss( fa, 1 ), 3 );
+
+  static char before[TEST_BSS];
+  memcpy( before, get_agent_bss( fa, 1 ), TEST_BSS );
+
+  void* fork = fork_agents( fa, 1, 1 );
+  CHECK( fork != 0x0 );
+  CHECK( memcmp( fork, before, TEST_BSS ) == 0 );
+
+  run_in( &cp, &r, fork, 4 );
+  CHECK( memcmp( fork, before, TEST_BSS ) != 0 );
+  CHECK( memcmp( get_agent_bss( fa, 1 ), before, TEST_BSS ) == 0 );
+
+  discard_forks( fa, 1, 1 );
+  CHECK( memcmp( get_agent_bss( fa, 1 ), before, TEST_BSS ) == 0 );
+
+  destroy_fork_arena( fa );
+}
+
+TEST( ForkCommits )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  ForkArena* fa = create_fork_arena( &p, 1 );
+
+  CallbackProgram cp, rcp;
+  static TestRun r, ref;
+  init_run( &cp, &r, &p, 0 );
+  init_run( &rcp, &ref, &p, 0 );
+  run_in( &cp, &r, get_agent_bss( fa, 0 ), 3 );
+  run_in( &rcp, &ref, ref.m_Bss, 3 );
+
+  void* fork = fork_agents( fa, 0, 1 );
+  run_in( &cp, &r, fork, 4 );
+  CHECK_EQUAL( 1u, commit_forks( fa, 0, 1 ) );
+
+  run_in( &cp, &r, get_agent_bss( fa, 0 ), 2 );
+  run_in( &rcp, &ref, ref.m_Bss, 6 );
+  check_same( ref, r );
+
+  destroy_fork_arena( fa );
+}
+
+TEST( ForkRange )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  ForkArena* fa = create_fork_arena( &p, 3 );
+  unsigned int stride = get_fork_stride( fa );
+  CHECK( fork_agents( fa, 2, 2 ) == 0x0 );
+  CHECK( fork_agents( fa, 4, 0 ) == 0x0 );
+  CHECK( fork_agents( fa, 1, 0xffffffff ) == 0x0 );
+  char* forks = (char*)fork_agents( fa, 0, 3 );
+  CHECK( forks != 0x0 );
+  CHECK_EQUAL( 0u, commit_forks( fa, 1, 3 ) );
+  discard_forks( fa, 3, 1 );
+
+  //Only the middle fork writes, only its agent changes on commit
+  CallbackProgram cp;
+  static TestRun r;
+  init_run( &cp, &r, &p, 0 );
+  run_in( &cp, &r, forks + stride, 2 );
+
+  static char before[TEST_BSS];
+  memcpy( before, forks + stride, TEST_BSS );
+  CHECK_EQUAL( 1u, commit_forks( fa, 0, 3 ) );
+  CHECK( memcmp( get_agent_bss( fa, 1 ), before, TEST_BSS ) == 0 );
+
+  //Forking again after a commit sees the new state
+  forks = (char*)fork_agents( fa, 1, 1 );
+  CHECK( forks != 0x0 );
+  CHECK( memcmp( forks, before, TEST_BSS ) == 0 );
+  CHECK_EQUAL( 0u, commit_forks( fa, 1, 1 ) );
+
+  destroy_fork_arena( fa );
+}
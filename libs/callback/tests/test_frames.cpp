@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+
+#include "test_program.h"
+
+#include <callback/frames.h>
+#include <callback/fork.h>
+#include <callback/snapshot.h>
+
+using namespace callback;
+
+/*
+ * A main part that calls a subroutine in a pooled frame, with the handle at
+ * bss offset 4, and a subroutine that makes one callback with the bss at
+ * offset 4 of its frame.
+ */
+static void init_pooled_program( BuiltProgram* p )
+{
+  ProgramBuilder b;
+  init_builder( &b );
+  b.m_Header.m_CC = 1;
+  b.m_Header.m_CT = add_word( &b, 7 );
+  b.m_Header.m_FS = sizeof(CallFrame) + 8;
+  b.m_Header.m_FC = 1;
+
+  add_instruction( &b, INST_SCRIPT_A, 4, 0, 0 );
+  add_instruction( &b, INST_SCRIPT_P, 5, 4, ACT_EXECUTE );
+  add_instruction( &b, INST__STORE_R_IN_B, 0, 0, 0 );
+  add_instruction( &b, INST_SCRIPT_F, 4, 0, 0 );
+  add_instruction( &b, INST_______SUSPEND, 0, 0, 0 );
+  add_instruction( &b, INST_FUSE_EXEC_FUN, 0, 4, NO_OPERAND );
+  add_instruction( &b, INST__STORE_C_IN_R, E_NODE_SUCCESS, 0, 0 );
+  add_instruction( &b, INST_SCRIPT_R, 0, 0, 0 );
+  build_program( &b, p, 0 );
+}
+
+static unsigned int frame_handle( const TestRun& r )
+{
+  return *(const unsigned int*)&(r.m_Bss[sizeof(BssHeader) + 4]);
+}
+
+TEST( PooledFrameIsHeldInsideTheTree )
+{
+  static BuiltProgram p;
+  init_pooled_program( &p );
+
+  FramePool* fp = create_frame_pool( &p, 2 );
+  CHECK( fp != 0x0 );
+
+  CallbackProgram cp;
+  static TestRun r;
+  init_run( &cp, &r, &p, E_CALLBACK_JIT );
+  cp.m_Frames = fp;
+
+  //Stop in the subroutine, with its frame taken from the pool
+  CHECK_EQUAL( E_RUN_YIELDED, run_program_budget( &cp, 3 ) );
+  CHECK_EQUAL( 1u, get_frames_in_use( fp ) );
+  CHECK( (frame_handle( r ) & 0x80000000) != 0 );
+  CHECK_EQUAL( 1u, r.m_Calls );
+
+  CHECK_EQUAL( (int)E_NODE_SUCCESS, run_program( &cp ) );
+  CHECK_EQUAL( 0u, get_frames_in_use( fp ) );
+  CHECK_EQUAL( 0u, frame_handle( r ) );
+
+  destroy_frame_pool( fp );
+}
+
+TEST( EmptyFramePoolFailsTheTree )
+{
+  static BuiltProgram p;
+  init_pooled_program( &p );
+
+  FramePool* fp = create_frame_pool( &p, 1 );
+
+  CallbackProgram cp, ocp;
+  static TestRun r, other;
+  init_run( &cp, &r, &p, 0 );
+  init_run( &ocp, &other, &p, 0 );
+  cp.m_Frames  = fp;
+  ocp.m_Frames = fp;
+
+  run_program_budget( &cp, 3 );
+  CHECK_EQUAL( (int)E_NODE_FAIL, run_program( &ocp ) );
+  CHECK_EQUAL( 0u, other.m_Calls );
+  CHECK_EQUAL( 1u, get_frames_in_use( fp ) );
+
+  //Frames given back are reused
+  run_program( &cp );
+  CHECK_EQUAL( (int)E_NODE_SUCCESS, run_program( &ocp ) );
+  CHECK_EQUAL( 0u, get_frames_in_use( fp ) );
+
+  destroy_frame_pool( fp );
+}
+
+TEST( PooledProgramsAreNotCopied )
+{
+  static BuiltProgram p;
+  init_pooled_program( &p );
+  static TestProgram tp;
+  init_test_program( &tp );
+
+  CHECK( create_frame_pool( &tp, 4 ) == 0x0 );
+  CHECK( create_fork_arena( &p, 4 ) == 0x0 );
+  CHECK( !jit_compile( &p ) );
+
+  CallbackProgram cp;
+  static TestRun r;
+  init_run( &cp, &r, &p, 0 );
+  unsigned int buffer[64];
+  CHECK_EQUAL( -1, save_snapshot( &cp, buffer, sizeof(buffer) ) );
+}
@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+using namespace callback;
+
+/*
+ * Differential tests, every run is made both with the interpreter and with
+ * E_CALLBACK_JIT set and the two must make the same callbacks and leave the
+ * same bss behind. Where there is no JIT both runs are interpreted.
+ */
+
+TEST( JitMatchesInterpreter )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  CallbackProgram icp, jcp;
+  static TestRun ir, jr;
+  init_run( &icp, &ir, &p, 0 );
+  init_run( &jcp, &jr, &p, E_CALLBACK_JIT );
+
+  for( unsigned int f = 0; f < 10; ++f )
+    CHECK_EQUAL( run_program( &icp ), run_program( &jcp ) );
+
+  CHECK( ir.m_Calls > 10 );
+  check_same( ir, jr );
+  jit_release( &p );
+}
+
+TEST( JitResumesBudgetedRuns )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  CallbackProgram icp, jcp;
+  static TestRun ir, jr;
+  init_run( &icp, &ir, &p, 0 );
+  init_run( &jcp, &jr, &p, E_CALLBACK_JIT );
+
+  //Stop the jitted agent inside the subroutine, then let the JIT finish
+  for( unsigned int f = 0; f < 10; ++f )
+  {
+    run_program( &icp );
+    run_program_budget( &jcp, 3 + f );
+    run_program( &jcp );
+  }
+
+  check_same( ir, jr );
+  jit_release( &p );
+}
+
+TEST( JitRunsBatches )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  const unsigned int agents = 4;
+  static TestRun ir[agents], jr[agents];
+  void* iud[agents];
+  void* jud[agents];
+  memset( ir, 0, sizeof(ir) );
+  memset( jr, 0, sizeof(jr) );
+  for( unsigned int a = 0; a < agents; ++a )
+  {
+    iud[a] = &ir[a];
+    jud[a] = &jr[a];
+    ir[a].m_Base  = ir[a].m_Bss;
+    jr[a].m_Base  = jr[a].m_Bss;
+    jr[a].m_Calls = ir[a].m_Calls = a;
+  }
+
+  CallbackBatch b;
+  memset( &b, 0, sizeof(CallbackBatch) );
+  b.m_Program  = &p;
+  b.m_Stride   = sizeof(TestRun);
+  b.m_Count    = agents;
+  b.m_Callback = &test_callback;
+
+  jit_compile( &p );
+  for( unsigned int f = 0; f < 10; ++f )
+  {
+    b.m_bss      = ir[0].m_Bss;
+    b.m_UserData = iud;
+    b.m_Flags    = 0;
+    run_programs( &b );
+    b.m_bss      = jr[0].m_Bss;
+    b.m_UserData = jud;
+    b.m_Flags    = E_CALLBACK_JIT;
+    run_programs( &b );
+  }
+
+  for( unsigned int a = 0; a < agents; ++a )
+    check_same( ir[a], jr[a] );
+  jit_release( &p );
+}
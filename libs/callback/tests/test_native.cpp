@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include "native/native_test_program.h"
+
+#include <callback/counters.h>
+
+using namespace callback;
+
+/*
+ * native/native_test.cpp is what ctc -c writes for native/native_test.bts,
+ * and s_NativeTestProgram the bytecode ctc writes for it.
+ */
+extern const unsigned int native_test_bss_size;
+extern const CounterLayout native_test_counters;
+int native_test( CallbackProgram* info );
+void native_test_batch( CallbackBatch* batch );
+
+const unsigned int NATIVE_BSS     = 512;
+const unsigned int NATIVE_TICKS   = 200;
+const unsigned int NATIVE_COUNTED = 32;
+
+struct NativeRun
+{
+  TestRun m_Run;
+  char    m_Bss[NATIVE_BSS];
+};
+
+static union
+{
+  unsigned int m_Words[sizeof(s_NativeTestProgram) / sizeof(unsigned int)];
+  double       m_Align;
+} s_Native;
+
+static void* native_program()
+{
+  memcpy( s_Native.m_Words, s_NativeTestProgram, sizeof(s_NativeTestProgram) );
+  return s_Native.m_Words;
+}
+
+static void init_native_run( CallbackProgram* cp, NativeRun* r, void* p )
+{
+  init_run( cp, &r->m_Run, p, 0 );
+  memset( r->m_Bss, 0, NATIVE_BSS );
+  r->m_Run.m_Base = r->m_Bss;
+  cp->m_bss = r->m_Bss;
+}
+
+static void check_same_native( const NativeRun& a, const NativeRun& b )
+{
+  CHECK( a.m_Run.m_Count < TEST_LOG );
+  CHECK_EQUAL( a.m_Run.m_Calls, b.m_Run.m_Calls );
+  CHECK_EQUAL( a.m_Run.m_Count, b.m_Run.m_Count );
+  CHECK( memcmp( a.m_Run.m_Log, b.m_Run.m_Log, sizeof(unsigned int) * a.m_Run.m_Count ) == 0 );
+  CHECK( memcmp( a.m_Bss, b.m_Bss, native_test_bss_size ) == 0 );
+}
+
+TEST( NativeCodeRunsLikeTheBytecode )
+{
+  void* p = native_program();
+  CHECK( check_program( p, sizeof(s_NativeTestProgram) ) );
+  CHECK_EQUAL( ((ProgramHeader*)p)->m_BS, native_test_bss_size );
+  CHECK( native_test_bss_size <= NATIVE_BSS );
+
+  CallbackProgram a, b;
+  static NativeRun r[2];
+  init_native_run( &a, r + 0, p );
+  init_native_run( &b, r + 1, p );
+  for( unsigned int t = 0; t < NATIVE_TICKS; ++t )
+  {
+    r[0].m_Run.m_Count = 0;
+    r[1].m_Run.m_Count = 0;
+    CHECK_EQUAL( run_program( &a ), native_test( &b ) );
+    check_same_native( r[0], r[1] );
+  }
+
+  //The C++ code's counter layout reads the same counts as the bytecode's
+  CounterLayout cl;
+  CHECK( get_counter_layout( p, &cl ) );
+  CHECK_EQUAL( cl.m_Count, native_test_counters.m_Count );
+  CHECK_EQUAL( cl.m_Block, native_test_counters.m_Block );
+  CHECK_EQUAL( cl.m_Size, native_test_counters.m_Size );
+  CHECK( memcmp( cl.m_Ids, native_test_counters.m_Ids, sizeof(unsigned int) * cl.m_Count ) == 0 );
+
+  static NodeCounts c[2][NATIVE_COUNTED];
+  CHECK( cl.m_Count <= NATIVE_COUNTED );
+  memset( c, 0, sizeof(c) );
+  add_node_counts( &cl, r[0].m_Bss, c[0] );
+  add_node_counts( &native_test_counters, r[1].m_Bss, c[1] );
+  CHECK( c[0][0].m_Enter > 0 );
+  CHECK( memcmp( c[0], c[1], sizeof(NodeCounts) * cl.m_Count ) == 0 );
+}
+
+TEST( NativeBatchRunsLikeTheBytecode )
+{
+  void* p = native_program();
+
+  CallbackProgram a[2], b[2];
+  static NativeRun r[4];
+  void* user_data[2];
+  for( int i = 0; i < 2; ++i )
+  {
+    init_native_run( a + i, r + i, p );
+    init_native_run( b + i, r + 2 + i, p );
+    user_data[i] = &r[2 + i].m_Run;
+  }
+  //The second agent starts a tick behind
+  run_program( a + 0 );
+  native_test( b + 0 );
+
+  CallbackBatch batch;
+  memset( &batch, 0, sizeof(batch) );
+  batch.m_Program  = p;
+  batch.m_bss      = r[2].m_Bss;
+  batch.m_UserData = user_data;
+  batch.m_Stride   = sizeof(NativeRun);
+  batch.m_Count    = 2;
+  batch.m_Callback = &test_callback;
+  batch.m_Debug    = &test_debug;
+  for( unsigned int t = 0; t < NATIVE_TICKS; ++t )
+  {
+    for( int i = 0; i < 4; ++i )
+      r[i].m_Run.m_Count = 0;
+    run_program( a + 0 );
+    run_program( a + 1 );
+    native_test_batch( &batch );
+    check_same_native( r[0], r[2] );
+    check_same_native( r[1], r[3] );
+  }
+}
@@ -0,0 +1,307 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef CALLBACK_TEST_PROGRAM_H_
+#define CALLBACK_TEST_PROGRAM_H_
+
+#include <UnitTest++.h>
+#include <callback/callback.h>
+#include <callback/instructions.h>
+#include <callback/compact.h>
+
+#include <string.h>
+
+/*
+ * A hand built program for comparing runs of the same agent made in different
+ * ways, and a run that logs every callback it gets.
+ */
+
+const unsigned int TEST_INSTRUCTIONS = 27;
+const unsigned int TEST_BSS          = 128;
+const unsigned int TEST_LOG          = 512;
+
+struct TestProgram
+{
+  callback::ProgramHeader m_Header;
+  callback::Instruction   m_Inst[TEST_INSTRUCTIONS];
+  int                     m_Value;
+  int                     m_Pad;
+  char                    m_Name[8];
+  unsigned int            m_List[2];
+  unsigned int            m_Ids[2];
+};
+
+struct TestRun
+{
+  char         m_Bss[TEST_BSS];
+  char*        m_Base; // Where the agent's bss is, m_Bss unless it was moved
+  unsigned int m_Log[TEST_LOG];
+  unsigned int m_Count;
+  unsigned int m_Calls;
+};
+
+static inline void log_value( TestRun* r, unsigned int v )
+{
+  if( r->m_Count < TEST_LOG )
+    r->m_Log[r->m_Count++] = v;
+}
+
+static inline unsigned int test_callback( unsigned int id, unsigned int action, void* bss,
+  void** data, void* user_data )
+{
+  TestRun* r = (TestRun*)user_data;
+  ++r->m_Calls;
+  log_value( r, id );
+  log_value( r, action );
+  log_value( r, bss ? (unsigned int)((char*)bss - r->m_Base) : 0xffffffff );
+  log_value( r, data ? *(int*)(data[0]) : 0xffffffff );
+  if( bss )
+    *(int*)bss += action + 1;
+  return (id + r->m_Calls * 7 + action) % 3;
+}
+
+static inline void test_debug( callback::CallbackProgram*, callback::DebugInformation* di,
+  callback::BssHeader* bh, void* user_data )
+{
+  TestRun* r = (TestRun*)user_data;
+  log_value( r, bh->m_IC );
+  log_value( r, bh->m_IP );
+  log_value( r, bh->m_RE );
+  log_value( r, di->m_NodeId );
+  log_value( r, (unsigned int)strlen( di->m_Name ) );
+}
+
+static inline void set_instruction( callback::Instruction* i, unsigned int inst,
+  unsigned int a1, unsigned int a2, unsigned int a3 )
+{
+  i->m_I  = (callback::VMIType)inst;
+  i->m_A1 = (callback::VMIType)a1;
+  i->m_A2 = (callback::VMIType)a2;
+  i->m_A3 = (callback::VMIType)a3;
+}
+
+/*
+ * A main part that constructs, calls a subroutine and destructs when it is
+ * done, and a subroutine that goes through most of the instruction set. The
+ * subroutine's frame starts at bss offset 8 and its callback's variable list
+ * is at data offset 16.
+ */
+static inline void init_test_program( TestProgram* p )
+{
+  using namespace callback;
+
+  memset( p, 0, sizeof(TestProgram) );
+  p->m_Header.m_Magic   = PROGRAM_MAGIC;
+  p->m_Header.m_Version = PROGRAM_VERSION;
+  p->m_Header.m_IC = TEST_INSTRUCTIONS;
+  p->m_Header.m_DS = sizeof(TestProgram) - sizeof(ProgramHeader)
+    - sizeof(Instruction) * TEST_INSTRUCTIONS;
+  p->m_Header.m_BS = TEST_BSS;
+  p->m_Header.m_CC = 2;
+  p->m_Header.m_CT = 24;
+  p->m_Value  = 42;
+  strcpy( p->m_Name, "name" );
+  p->m_List[0] = 1;
+  p->m_List[1] = 0;
+  p->m_Ids[0] = 5;
+  p->m_Ids[1] = 1234;
+
+  Instruction* i = p->m_Inst;
+  set_instruction( i++, INST_FUSE_CONS_FUN, 0, NO_OPERAND, NO_OPERAND );
+  set_instruction( i++, INST_SCRIPT_C, 7, 8, 0 );
+  set_instruction( i++, INST__STORE_R_IN_B, 0, 0, 0 );
+  set_instruction( i++, INST_JABC_R_EQUA_C, 6, E_NODE_WORKING, 0 );
+  set_instruction( i++, INST_FUSE_DEST_FUN, 0, 4, NO_OPERAND );
+  set_instruction( i++, INST__STORE_C_IN_R, E_NODE_SUCCESS, 0, 0 );
+  set_instruction( i++, INST_______SUSPEND, 0, 0, 0 );
+  set_instruction( i++, INST__INC_BSSVALUE, 0, 1, 0 );
+  set_instruction( i++, INST__STORE_C_IN_B, 8, 1, 0 );
+  set_instruction( i++, INST_STORE_PD_IN_B, 12, 0, 0 );
+  set_instruction( i++, INST__SET_REGISTRY, 2, 0, 77 );
+  set_instruction( i++, INST_LOAD_REGISTRY, 1, 0, 8 );
+  set_instruction( i++, INST_CALL_DEBUG_FN, 0, 0, 0 );
+  set_instruction( i++, INST_FUSE_EXEC_FUN, 1, 16, 16 );
+  set_instruction( i++, INST__STORE_R_IN_B, 20, 0, 0 );
+  set_instruction( i++, INST__STORE_C_IN_B, 24, 20, 0 );
+  set_instruction( i++, INST_JABB_C_EQUA_B, 24, E_NODE_WORKING, 20 );
+  set_instruction( i++, INST__STORE_B_IN_B, 28, 0, 0 );
+  set_instruction( i++, INST_JABB_B_EQUA_B, 24, 28, 0 );
+  set_instruction( i++, INST_FUSE_MODI_FUN, 1, 16, NO_OPERAND );
+  set_instruction( i++, INST_JREC_CONSTANT, 1, 0, 0 );
+  set_instruction( i++, INST__INC_BSSVALUE, 0, 100, 0 );
+  set_instruction( i++, INST__STORE_B_IN_R, 20, 0, 0 );
+  set_instruction( i++, INST_JABC_C_DIFF_B, 25, 3, 0 );
+  set_instruction( i++, INST_FUSE_MODI_FUN, 1, 16, NO_OPERAND );
+  set_instruction( i++, INST_JABC_S_C_IN_B, 26, 32, 9 );
+  set_instruction( i++, INST_SCRIPT_R, 0, 0, 0 );
+}
+
+static inline void init_run( callback::CallbackProgram* cp, TestRun* r, void* p,
+  unsigned int flags )
+{
+  memset( r, 0, sizeof(TestRun) );
+  memset( cp, 0, sizeof(callback::CallbackProgram) );
+  r->m_Base      = r->m_Bss;
+  cp->m_Program  = p;
+  cp->m_bss      = r->m_Bss;
+  cp->m_UserData = r;
+  cp->m_Callback = &test_callback;
+  cp->m_Debug    = &test_debug;
+  cp->m_Flags    = flags;
+}
+
+/*
+ * A program put together an instruction and a data word at a time, which
+ * build_program lays out in any of the instruction formats. Operands are
+ * given as for an Instruction, NO_OPERAND is widened for the other formats.
+ */
+const unsigned int BUILD_INSTRUCTIONS = 32;
+const unsigned int BUILD_DATA         = 64;
+
+struct ProgramBuilder
+{
+  callback::ProgramHeader   m_Header; // All but the counts and sizes build_program sets
+  callback::WideInstruction m_Inst[BUILD_INSTRUCTIONS];
+  unsigned int              m_Data[BUILD_DATA];
+  unsigned int              m_IC;
+  unsigned int              m_DS;     // Bytes of data
+};
+
+/*
+ * Room for any program a ProgramBuilder can build.
+ */
+union BuiltProgram
+{
+  callback::ProgramHeader m_Header;
+  unsigned int            m_Words[(sizeof(callback::ProgramHeader)
+    + sizeof(callback::WideInstruction) * BUILD_INSTRUCTIONS
+    + sizeof(unsigned int) * BUILD_DATA) / sizeof(unsigned int)];
+};
+
+static inline callback::WideVMIType widen( callback::VMIType v )
+{
+  return v == callback::NO_OPERAND ? callback::WIDE_NO_OPERAND : v;
+}
+
+static inline void init_builder( ProgramBuilder* b )
+{
+  memset( b, 0, sizeof(ProgramBuilder) );
+  b->m_Header.m_Magic   = callback::PROGRAM_MAGIC;
+  b->m_Header.m_Version = callback::PROGRAM_VERSION;
+  b->m_Header.m_BS      = TEST_BSS;
+}
+
+static inline void add_instruction( ProgramBuilder* b, unsigned int inst, unsigned int a1,
+  unsigned int a2, unsigned int a3 )
+{
+  callback::WideInstruction& i = b->m_Inst[b->m_IC++];
+  i.m_I  = inst;
+  i.m_A1 = a1;
+  i.m_A2 = a2;
+  i.m_A3 = a3;
+}
+
+/*
+ * Appends "size" bytes to the data section, padded to a word. Returns the
+ * data section offset they are at.
+ */
+static inline unsigned int add_data( ProgramBuilder* b, const void* data, unsigned int size )
+{
+  const unsigned int at = b->m_DS;
+  memcpy( (char*)b->m_Data + at, data, size );
+  b->m_DS = (at + size + 3) & ~3;
+  return at;
+}
+
+static inline unsigned int add_word( ProgramBuilder* b, unsigned int word )
+{
+  return add_data( b, &word, sizeof(word) );
+}
+
+/*
+ * Lays the program out in "out" with the instructions as Instructions,
+ * WideInstructions (E_PROGRAM_WIDE) or compact code (E_PROGRAM_COMPACT).
+ */
+static inline void build_program( const ProgramBuilder* b, BuiltProgram* out,
+  unsigned int format )
+{
+  using namespace callback;
+
+  memset( out, 0, sizeof(BuiltProgram) );
+  ProgramHeader* h = &out->m_Header;
+  *h = b->m_Header;
+  h->m_IC = b->m_IC;
+  h->m_DS = b->m_DS;
+  h->m_PF = format;
+  h->m_CB = 0;
+
+  char* code = (char*)(h + 1);
+  for( unsigned int i = 0; i < b->m_IC; ++i )
+  {
+    const WideInstruction& in = b->m_Inst[i];
+    WideInstruction w = { in.m_I, widen( (VMIType)in.m_A1 ), widen( (VMIType)in.m_A2 ),
+      widen( (VMIType)in.m_A3 ) };
+    if( format & E_PROGRAM_COMPACT )
+    {
+      unsigned int* offsets = (unsigned int*)code;
+      unsigned char* bytes = (unsigned char*)(offsets + compact_table_count( b->m_IC ));
+      if( i % COMPACT_STRIDE == 0 )
+        offsets[i / COMPACT_STRIDE] = h->m_CB;
+      h->m_CB += compact_encode( w, bytes + h->m_CB );
+    }
+    else if( format & E_PROGRAM_WIDE )
+      ((WideInstruction*)code)[i] = w;
+    else
+    {
+      Instruction& n = ((Instruction*)code)[i];
+      n.m_I  = (VMIType)in.m_I;
+      n.m_A1 = (VMIType)in.m_A1;
+      n.m_A2 = (VMIType)in.m_A2;
+      n.m_A3 = (VMIType)in.m_A3;
+    }
+  }
+  unsigned int size = b->m_IC * sizeof(Instruction);
+  if( format & E_PROGRAM_COMPACT )
+    size = compact_table_count( b->m_IC ) * sizeof(unsigned int) + ((h->m_CB + 3) & ~3);
+  else if( format & E_PROGRAM_WIDE )
+    size = b->m_IC * sizeof(WideInstruction);
+  memcpy( code + size, b->m_Data, b->m_DS );
+}
+
+/*
+ * The test program "p" in another instruction format.
+ */
+static inline void build_test_program( BuiltProgram* out, const TestProgram* p,
+  unsigned int format )
+{
+  ProgramBuilder b;
+  init_builder( &b );
+  b.m_Header = p->m_Header;
+  for( unsigned int i = 0; i < TEST_INSTRUCTIONS; ++i )
+  {
+    const callback::Instruction& n = p->m_Inst[i];
+    add_instruction( &b, n.m_I, n.m_A1, n.m_A2, n.m_A3 );
+  }
+  add_data( &b, &p->m_Value, p->m_Header.m_DS );
+  build_program( &b, out, format );
+}
+
+/*
+ * Both runs made the same callbacks and left the same bss behind.
+ */
+static inline void check_same( const TestRun& a, const TestRun& b )
+{
+  CHECK_EQUAL( a.m_Count, b.m_Count );
+  CHECK( memcmp( a.m_Log, b.m_Log, sizeof(unsigned int) * a.m_Count ) == 0 );
+  CHECK( memcmp( a.m_Base, b.m_Base, TEST_BSS ) == 0 );
+}
+
+#endif /* CALLBACK_TEST_PROGRAM_H_ */
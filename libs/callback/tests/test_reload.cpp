@@ -0,0 +1,272 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <UnitTest++.h>
+#include <callback/reload.h>
+#include <callback/instructions.h>
+
+#include <string.h>
+
+using namespace callback;
+
+/*
+ * A hand built map of "main" with a sequence of two actions, A and B, each
+ * with four bytes of bss. The sequence holds the instruction it re-enters at
+ * in slot 0.
+ */
+
+const unsigned int RELOAD_IC = 10;
+const unsigned int RELOAD_BS = sizeof(BssHeader) + 64;
+
+struct ReloadMap
+{
+  NodeMapHeader m_Header;
+  MapTree       m_Tree;
+  MapNode       m_Node[3];
+  MapSlot       m_Slot[4];
+  unsigned int  m_Owner[RELOAD_IC];
+  unsigned int  m_Action[RELOAD_IC];
+  char          m_String[8];
+};
+
+struct ReloadAgent
+{
+  BssHeader    m_Header;
+  unsigned int m_Word[16];
+};
+
+static void init_node( MapNode* n, unsigned int key, unsigned int type, unsigned int parent,
+  unsigned int entry, unsigned int slot, unsigned int count )
+{
+  memset( n, 0, sizeof(MapNode) );
+  n->m_Key       = key;
+  n->m_Signature = key * 3;
+  n->m_Type      = type;
+  n->m_Parent    = parent;
+  n->m_Callee    = MAP_NONE;
+  n->m_Entry[ACT_CONSTRUCT] = entry - 1;
+  n->m_Entry[ACT_EXECUTE]   = entry;
+  n->m_Entry[ACT_DESTRUCT]  = entry + 1;
+  n->m_Slot      = slot;
+  n->m_SlotCount = count;
+}
+
+static void init_slot( MapSlot* s, unsigned int offset, unsigned int kind, unsigned int reset )
+{
+  s->m_Offset = offset;
+  s->m_Size   = sizeof(int);
+  s->m_Kind   = kind;
+  s->m_Reset  = reset;
+}
+
+/*
+ * The code of A and B starts "shift" instructions later than in the original.
+ */
+static void init_map( ReloadMap* m, ProgramHeader* ph, unsigned int shift )
+{
+  memset( m, 0, sizeof(ReloadMap) );
+  m->m_Header.m_Magic   = NODE_MAP_MAGIC;
+  m->m_Header.m_Version = NODE_MAP_VERSION;
+  m->m_Header.m_IC      = RELOAD_IC;
+  m->m_Header.m_BS      = RELOAD_BS;
+  m->m_Header.m_TC      = 1;
+  m->m_Header.m_NC      = 3;
+  m->m_Header.m_SC      = 4;
+  m->m_Header.m_SS      = sizeof(m->m_String);
+  m->m_Tree.m_Root      = 0;
+  strcpy( m->m_String, "main" );
+
+  init_node( m->m_Node + 0, 10, E_MAP_SEQUENCE, MAP_NONE, 1, 0, 2 );
+  m->m_Node[0].m_Flags = E_MAP_LIVE_ENTRY | E_MAP_RESTARTABLE;
+  init_node( m->m_Node + 1, 11, E_MAP_ACTION, 0, 3 + shift, 2, 1 );
+  init_node( m->m_Node + 2, 12, E_MAP_ACTION, 0, 5 + shift, 3, 1 );
+  init_slot( m->m_Slot + 0, 4, E_MAP_SLOT_CODE, 0xffffffff );
+  init_slot( m->m_Slot + 1, 8, E_MAP_SLOT_CODE, 0xffffffff );
+  init_slot( m->m_Slot + 2, 12, E_MAP_SLOT_CALLBACK, 0 );
+  init_slot( m->m_Slot + 3, 16, E_MAP_SLOT_CALLBACK, 0 );
+
+  for( unsigned int i = 0; i < RELOAD_IC; ++i )
+    m->m_Owner[i] = MAP_NONE;
+  for( unsigned int i = 0; i < 3; ++i )
+    m->m_Owner[i] = 0;
+  for( unsigned int i = 0; i < 2; ++i )
+  {
+    m->m_Owner[3 + shift + i] = 1;
+    m->m_Owner[5 + shift + i] = 2;
+  }
+  m->m_Owner[7 + shift] = 0;
+  for( unsigned int i = 0; i < RELOAD_IC; ++i )
+    m->m_Action[i] = m->m_Owner[i] == MAP_NONE ? MAP_NONE : ACT_EXECUTE;
+
+  memset( ph, 0, sizeof(ProgramHeader) );
+  ph->m_IC = RELOAD_IC;
+  ph->m_BS = RELOAD_BS;
+}
+
+/*
+ * An agent between runs with B running.
+ */
+static void init_agent( ReloadAgent* a )
+{
+  memset( a, 0, sizeof(ReloadAgent) );
+  a->m_Header.m_IC = 5;
+  unsigned int* frame = a->m_Word + MAP_MAIN_FRAME / sizeof(int);
+  a->m_Word[MAP_MAIN_STATE] = E_NODE_WORKING;
+  frame[1] = 5;
+  frame[2] = 0xffffffff;
+  frame[3] = 100;
+  frame[4] = 200;
+}
+
+static unsigned int frame_word( const ReloadAgent& a, unsigned int i )
+{
+  return a.m_Word[MAP_MAIN_FRAME / sizeof(int) + i];
+}
+
+TEST( NodeMapIsChecked )
+{
+  static ReloadMap m;
+  ProgramHeader ph;
+  init_map( &m, &ph, 0 );
+  CHECK( check_node_map( &m, sizeof(m), &ph ) == &m.m_Header );
+  CHECK( !check_node_map( &m, sizeof(m) - 4, &ph ) );
+  CHECK_EQUAL( 2u, get_map_owner( &m.m_Header, 5 ) );
+  CHECK_EQUAL( MAP_NONE, get_map_owner( &m.m_Header, RELOAD_IC ) );
+  CHECK_EQUAL( (unsigned int)ACT_EXECUTE, get_map_action( &m.m_Header, 5 ) );
+  CHECK_EQUAL( 0, strcmp( "main", get_map_string( &m.m_Header, m.m_Tree.m_Name ) ) );
+
+  ph.m_IC = RELOAD_IC + 1;
+  CHECK( !check_node_map( &m, sizeof(m), &ph ) );
+  ph.m_IC = RELOAD_IC;
+  m.m_Node[2].m_Slot = 4;
+  CHECK( !check_node_map( &m, sizeof(m), &ph ) );
+}
+
+TEST( ReloadKeepsStateAndMovesInstructionPointers )
+{
+  static ReloadMap fm, tm;
+  ProgramHeader fh, th;
+  init_map( &fm, &fh, 0 );
+  init_map( &tm, &th, 2 );
+  ReloadPlan* rp = create_reload( &fh, &fm.m_Header, &th, &tm.m_Header );
+  CHECK( rp );
+  if( !rp )
+    return;
+
+  ReloadAgent from, to;
+  init_agent( &from );
+  CHECK_EQUAL( E_RELOAD_MIGRATED, reload_agent( rp, &from, &to ) );
+  CHECK_EQUAL( (unsigned int)E_NODE_WORKING, to.m_Word[MAP_MAIN_STATE] );
+  CHECK_EQUAL( 7u, frame_word( to, 1 ) );
+  CHECK_EQUAL( 0xffffffffu, frame_word( to, 2 ) );
+  CHECK_EQUAL( 200u, frame_word( to, 4 ) );
+  //A is not running, it is constructed again before it runs
+  CHECK_EQUAL( 0u, frame_word( to, 3 ) );
+
+  //In place
+  CHECK_EQUAL( E_RELOAD_MIGRATED, reload_agent( rp, &from, &from ) );
+  CHECK_EQUAL( 0, memcmp( &from, &to, sizeof(ReloadAgent) ) );
+  destroy_reload( rp );
+}
+
+TEST( ReloadRestartsChangedRunningNode )
+{
+  static ReloadMap fm, tm;
+  ProgramHeader fh, th;
+  init_map( &fm, &fh, 0 );
+  init_map( &tm, &th, 0 );
+  tm.m_Node[2].m_Signature = 1;
+  //The sequence has the same children, but it is not the same code
+  tm.m_Node[0].m_Signature = 2;
+  ReloadPlan* rp = create_reload( &fh, &fm.m_Header, &th, &tm.m_Header );
+  CHECK( rp );
+  if( !rp )
+    return;
+
+  ReloadAgent from, to;
+  init_agent( &from );
+  CHECK_EQUAL( E_RELOAD_RESTARTED, reload_agent( rp, &from, &to ) );
+  CHECK_EQUAL( (unsigned int)E_NODE_WORKING, to.m_Word[MAP_MAIN_STATE] );
+  CHECK_EQUAL( 0xffffffffu, frame_word( to, 1 ) );
+  CHECK_EQUAL( 0xffffffffu, frame_word( to, 2 ) );
+  CHECK_EQUAL( 0u, frame_word( to, 4 ) );
+
+  //A is not running, so a change to it changes nothing
+  init_map( &tm, &th, 0 );
+  tm.m_Node[1].m_Signature = 1;
+  destroy_reload( rp );
+  rp = create_reload( &fh, &fm.m_Header, &th, &tm.m_Header );
+  CHECK_EQUAL( E_RELOAD_MIGRATED, reload_agent( rp, &from, &to ) );
+  CHECK_EQUAL( 5u, frame_word( to, 1 ) );
+  CHECK_EQUAL( 200u, frame_word( to, 4 ) );
+  destroy_reload( rp );
+}
+
+TEST( ReloadResetsWhenNothingCanRestart )
+{
+  static ReloadMap fm, tm;
+  ProgramHeader fh, th;
+  init_map( &fm, &fh, 0 );
+  init_map( &tm, &th, 0 );
+  tm.m_Node[0].m_Key = 20;
+  ReloadPlan* rp = create_reload( &fh, &fm.m_Header, &th, &tm.m_Header );
+  CHECK( rp );
+  if( !rp )
+    return;
+
+  ReloadAgent from, to, zero;
+  memset( &zero, 0, sizeof(ReloadAgent) );
+  init_agent( &from );
+  CHECK_EQUAL( E_RELOAD_RESET, reload_agent( rp, &from, &to ) );
+  CHECK_EQUAL( 0, memcmp( &to, &zero, sizeof(ReloadAgent) ) );
+
+  //Agents stopped part way through a run are always reset
+  init_map( &tm, &th, 0 );
+  destroy_reload( rp );
+  rp = create_reload( &fh, &fm.m_Header, &th, &tm.m_Header );
+  from.m_Header.m_IP = 3;
+  CHECK_EQUAL( E_RELOAD_RESET, reload_agent( rp, &from, &to ) );
+  destroy_reload( rp );
+
+  //Pooled frames can not be reloaded
+  th.m_FS = 16;
+  CHECK( !create_reload( &fh, &fm.m_Header, &th, &tm.m_Header ) );
+}
+
+TEST( ReloadBatchMovesAgents )
+{
+  static ReloadMap fm, tm;
+  ProgramHeader fh, th;
+  init_map( &fm, &fh, 0 );
+  init_map( &tm, &th, 1 );
+  ReloadPlan* rp = create_reload( &fh, &fm.m_Header, &th, &tm.m_Header );
+  CHECK( rp );
+  if( !rp )
+    return;
+
+  ReloadAgent agents[3];
+  for( unsigned int i = 0; i < 3; ++i )
+    init_agent( agents + i );
+  agents[1].m_Header.m_IP = 3;
+
+  CallbackBatch batch;
+  memset( &batch, 0, sizeof(batch) );
+  batch.m_Program = &fh;
+  batch.m_bss     = agents;
+  batch.m_Stride  = sizeof(ReloadAgent);
+  batch.m_Count   = 3;
+  CHECK_EQUAL( 1u, reload_batch( rp, &batch, agents, sizeof(ReloadAgent) ) );
+  CHECK( batch.m_Program == &th );
+  CHECK_EQUAL( 6u, frame_word( agents[0], 1 ) );
+  CHECK_EQUAL( 0u, frame_word( agents[1], 1 ) );
+  CHECK_EQUAL( 6u, frame_word( agents[2], 1 ) );
+  destroy_reload( rp );
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+using namespace callback;
+
+/*
+ * The bss holds no pointers, so an agent whose bss is copied somewhere else
+ * between runs must run as if it had stayed put.
+ */
+
+static void move_bss( CallbackProgram* cp, TestRun* r, char* to )
+{
+  memcpy( to, r->m_Base, TEST_BSS );
+  memset( r->m_Base, 0xcd, TEST_BSS );
+  r->m_Base = to;
+  cp->m_bss = to;
+}
+
+TEST( MovedBssRunsLikeInPlace )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  CallbackProgram scp, mcp;
+  static TestRun sr, mr;
+  static char other[TEST_BSS];
+  init_run( &scp, &sr, &p, 0 );
+  init_run( &mcp, &mr, &p, 0 );
+
+  for( unsigned int f = 0; f < 10; ++f )
+  {
+    move_bss( &mcp, &mr, (f & 1) ? mr.m_Bss : other );
+    CHECK_EQUAL( run_program( &scp ), run_program( &mcp ) );
+  }
+
+  check_same( sr, mr );
+}
+
+TEST( MovedBssResumesBudgetedRuns )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  CallbackProgram scp, mcp;
+  static TestRun sr, mr;
+  static char other[TEST_BSS];
+  init_run( &scp, &sr, &p, 0 );
+  init_run( &mcp, &mr, &p, 0 );
+
+  //Stop inside the subroutine, move, and finish the run with the JIT
+  for( unsigned int f = 0; f < 10; ++f )
+  {
+    run_program( &scp );
+    run_program_budget( &mcp, 3 + f );
+    move_bss( &mcp, &mr, (f & 1) ? mr.m_Bss : other );
+    mcp.m_Flags = (f & 1) ? E_CALLBACK_JIT : 0;
+    run_program( &mcp );
+  }
+
+  check_same( sr, mr );
+  jit_release( &p );
+}
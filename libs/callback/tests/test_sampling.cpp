@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/sampling.h>
+
+#include <time.h>
+
+using namespace callback;
+
+struct SampledCalls
+{
+  Sample       m_Sample[8];
+  unsigned int m_Count;
+  bool         m_Spin;
+};
+
+static SampledCalls g_Sampled;
+
+static unsigned int sampling_callback( unsigned int id, unsigned int action, void* bss,
+  void** data, void* user_data )
+{
+  if( g_Sampled.m_Count < 8 && take_sample( &g_Sampled.m_Sample[g_Sampled.m_Count] ) )
+    ++g_Sampled.m_Count;
+  if( g_Sampled.m_Spin )
+  {
+    volatile unsigned int x = 0;
+    for( unsigned int i = 0; i < 100000; ++i )
+      x += i;
+  }
+  return test_callback( id, action, bss, data, user_data );
+}
+
+TEST( SamplesShowTheTreeCallsOfTheAgent )
+{
+  static TestProgram p;
+  init_test_program( &p );
+  Sample s;
+  CHECK( !take_sample( &s ) );
+  CHECK( get_running_program() == 0x0 );
+
+  const unsigned int flags[2] = { 0, E_CALLBACK_JIT };
+  for( int f = 0; f < 2; ++f )
+  {
+    CallbackProgram cp;
+    static TestRun r;
+    init_run( &cp, &r, &p, flags[f] );
+    cp.m_Callback = &sampling_callback;
+    memset( &g_Sampled, 0, sizeof(g_Sampled) );
+    run_program( &cp );
+
+    //Construct in main, execute in the subroutine with its frame at 8, destruct in main
+    CHECK_EQUAL( 3u, g_Sampled.m_Count );
+    for( unsigned int i = 0; i < g_Sampled.m_Count; ++i )
+      CHECK( g_Sampled.m_Sample[i].m_Agent == (unsigned long long)(size_t)r.m_Bss );
+    CHECK_EQUAL( 1u, g_Sampled.m_Sample[0].m_Depth );
+    CHECK_EQUAL( 1u, g_Sampled.m_Sample[0].m_IP[0] );
+    CHECK_EQUAL( 2u, g_Sampled.m_Sample[1].m_Depth );
+    CHECK_EQUAL( 14u, g_Sampled.m_Sample[1].m_IP[0] );
+    CHECK_EQUAL( 2u, g_Sampled.m_Sample[1].m_IP[1] );
+    CHECK_EQUAL( 1u, g_Sampled.m_Sample[2].m_Depth );
+    CHECK_EQUAL( 5u, g_Sampled.m_Sample[2].m_IP[0] );
+    CHECK( get_running_program() == 0x0 );
+  }
+}
+
+#if defined(LINUX)
+
+TEST( SamplingTakesSamplesOfRunningPrograms )
+{
+  static TestProgram p;
+  init_test_program( &p );
+  SampleBuffer* sb = create_sample_buffer( 1024 );
+  CHECK( sb );
+  if( !sb )
+    return;
+
+  CallbackProgram cp;
+  static TestRun r;
+  init_run( &cp, &r, &p, 0 );
+  cp.m_Callback = &sampling_callback;
+  memset( &g_Sampled, 0, sizeof(g_Sampled) );
+  g_Sampled.m_Spin = true;
+
+  CHECK( start_sampling( sb, 1000 ) );
+  CHECK( !start_sampling( sb, 1000 ) );
+  const clock_t start = clock();
+  while( clock() - start < CLOCKS_PER_SEC / 5 )
+    run_program( &cp );
+  stop_sampling();
+
+  const unsigned int count = get_sample_count( sb );
+  CHECK( count > 0 );
+  CHECK_EQUAL( 0u, get_samples_dropped( sb ) );
+  const Sample* s = get_samples( sb );
+  for( unsigned int i = 0; i < count; ++i )
+  {
+    CHECK( s[i].m_Agent == (unsigned long long)(size_t)r.m_Bss );
+    CHECK( s[i].m_Depth == 1 || s[i].m_Depth == 2 );
+    CHECK( s[i].m_IP[0] < TEST_INSTRUCTIONS );
+  }
+  destroy_sample_buffer( sb );
+}
+
+#endif
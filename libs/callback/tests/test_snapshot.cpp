@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/snapshot.h>
+
+using namespace callback;
+
+const unsigned int TEST_SNAPSHOT_SIZE = 1024;
+
+TEST( SnapshotOfFreshAgentIsSmall )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  CallbackProgram cp;
+  static TestRun r;
+  init_run( &cp, &r, &p, 0 );
+
+  unsigned int buffer[TEST_SNAPSHOT_SIZE / 4];
+  int size = save_snapshot( &cp, buffer, TEST_SNAPSHOT_SIZE );
+  CHECK( size > 0 );
+  CHECK( size < 64 );
+  CHECK( (unsigned int)size <= get_snapshot_bound( &p, 1 ) );
+}
+
+TEST( SnapshotRollsBack )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  CallbackProgram cp, rcp;
+  static TestRun r, ref;
+  init_run( &cp, &r, &p, 0 );
+  init_run( &rcp, &ref, &p, 0 );
+
+  for( unsigned int f = 0; f < 3; ++f )
+  {
+    run_program( &cp );
+    run_program( &rcp );
+  }
+
+  //Stop in the middle of the subroutine so the registers are saved too
+  run_program_budget( &cp, 12 );
+  run_program_budget( &rcp, 12 );
+
+  unsigned int buffer[TEST_SNAPSHOT_SIZE / 4];
+  int size = save_snapshot( &cp, buffer, TEST_SNAPSHOT_SIZE );
+  CHECK( size > 0 );
+  unsigned int calls = r.m_Calls;
+
+  //Run ahead and scribble over the bss, then go back
+  for( unsigned int f = 0; f < 5; ++f )
+    run_program( &cp );
+  memset( r.m_Bss, 0xcd, TEST_BSS );
+  CHECK_EQUAL( size, load_snapshot( &cp, buffer, size ) );
+  CHECK( memcmp( r.m_Bss, ref.m_Bss, TEST_BSS ) == 0 );
+
+  r.m_Count = ref.m_Count;
+  r.m_Calls = calls;
+  for( unsigned int f = 0; f < 5; ++f )
+    run_program( &cp );
+  for( unsigned int f = 0; f < 5; ++f )
+    run_program( &rcp );
+  check_same( ref, r );
+}
+
+TEST( SnapshotsOfBatches )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  const unsigned int agents = 8;
+  static TestRun r[agents];
+  static char saved[agents][TEST_BSS];
+  void* ud[agents];
+  memset( r, 0, sizeof(r) );
+  for( unsigned int a = 0; a < agents; ++a )
+  {
+    r[a].m_Base  = r[a].m_Bss;
+    r[a].m_Calls = a;
+    ud[a] = &r[a];
+  }
+
+  CallbackBatch b;
+  memset( &b, 0, sizeof(CallbackBatch) );
+  b.m_Program  = &p;
+  b.m_bss      = r[0].m_Bss;
+  b.m_UserData = ud;
+  b.m_Stride   = sizeof(TestRun);
+  b.m_Count    = agents;
+  b.m_Callback = &test_callback;
+
+  for( unsigned int f = 0; f < 4; ++f )
+    run_programs( &b );
+
+  static unsigned int buffer[(TEST_SNAPSHOT_SIZE * agents) / 4];
+  int size = save_snapshots( &b, buffer, sizeof(buffer) );
+  CHECK( size > 0 );
+  CHECK( (unsigned int)size <= get_snapshot_bound( &p, agents ) );
+  for( unsigned int a = 0; a < agents; ++a )
+  {
+    memcpy( saved[a], r[a].m_Bss, TEST_BSS );
+    memset( r[a].m_Bss, 0xcd, TEST_BSS );
+  }
+
+  //The agents are between runs, so all but the registers come back
+  CHECK_EQUAL( size, load_snapshots( &b, buffer, size ) );
+  const unsigned int fields = sizeof(unsigned int) * 4; // m_IC to m_RE
+  for( unsigned int a = 0; a < agents; ++a )
+  {
+    CHECK( memcmp( saved[a], r[a].m_Bss, fields ) == 0 );
+    CHECK( memcmp( saved[a] + sizeof(BssHeader), r[a].m_Bss + sizeof(BssHeader),
+      TEST_BSS - sizeof(BssHeader) ) == 0 );
+  }
+}
+
+TEST( SnapshotRejectsBadInput )
+{
+  static TestProgram p;
+  init_test_program( &p );
+
+  CallbackProgram cp;
+  static TestRun r;
+  init_run( &cp, &r, &p, 0 );
+  run_program( &cp );
+
+  unsigned int buffer[TEST_SNAPSHOT_SIZE / 4];
+  CHECK_EQUAL( -1, save_snapshot( &cp, buffer, 16 ) );
+  int size = save_snapshot( &cp, buffer, TEST_SNAPSHOT_SIZE );
+  CHECK( size > 0 );
+
+  CHECK_EQUAL( -1, load_snapshot( &cp, buffer, size - 4 ) );
+
+  //Another program
+  static TestProgram other;
+  init_test_program( &other );
+  other.m_Header.m_BS += 4;
+  cp.m_Program = &other;
+  CHECK_EQUAL( -1, load_snapshot( &cp, buffer, size ) );
+  cp.m_Program = &p;
+
+  //Another version
+  buffer[1] = SNAPSHOT_VERSION + 1;
+  CHECK_EQUAL( -1, load_snapshot( &cp, buffer, size ) );
+}
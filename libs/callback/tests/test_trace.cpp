@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+#include <callback/trace.h>
+
+using namespace callback;
+
+const unsigned int TRACED_NODE = 0x00120034;
+
+/*
+ * One node with one callback.
+ */
+static void init_traced_program( BuiltProgram* p )
+{
+  ProgramBuilder b;
+  init_builder( &b );
+  b.m_Header.m_CC = 1;
+  b.m_Header.m_CT = add_word( &b, 3 );
+
+  const unsigned int hi = TRACED_NODE >> 16, lo = TRACED_NODE & 0xffff;
+  const unsigned int action = ACT_EXECUTE << TRACE_ACTION_SHIFT;
+  add_instruction( &b, INST_TRACE_NODE, E_TRACE_ENTER, hi, lo );
+  add_instruction( &b, INST_TRACE_NODE, E_TRACE_CALLBACK_BEGIN | action, hi, lo );
+  add_instruction( &b, INST_FUSE_EXEC_FUN, 0, NO_OPERAND, NO_OPERAND );
+  add_instruction( &b, INST_TRACE_NODE, E_TRACE_CALLBACK_END | action, hi, lo );
+  add_instruction( &b, INST_TRACE_NODE, E_TRACE_EXIT, hi, lo );
+  add_instruction( &b, INST_______SUSPEND, 0, 0, 0 );
+  build_program( &b, p, 0 );
+}
+
+TEST( TraceRecordsNodesAndCallbacks )
+{
+  static BuiltProgram p;
+  init_traced_program( &p );
+  TraceBuffer* tb = create_trace_buffer( 64 );
+  CHECK( tb );
+  if( !tb )
+    return;
+
+  CallbackProgram a, b;
+  static TestRun r[2];
+  init_run( &a, r + 0, &p, 0 );
+  init_run( &b, r + 1, &p, E_CALLBACK_JIT );
+  CHECK( set_trace_buffer( tb ) == 0x0 );
+  run_program( &a );
+  run_program( &b );
+  CHECK( set_trace_buffer( 0x0 ) == tb );
+  run_program( &a );
+
+  const unsigned int kinds[4] =
+  {
+    E_TRACE_ENTER, E_TRACE_CALLBACK_BEGIN, E_TRACE_CALLBACK_END, E_TRACE_EXIT
+  };
+  TraceEvent e[16];
+  unsigned int cursor = 0, lost = 0;
+  CHECK_EQUAL( 8u, read_trace( tb, &cursor, e, 16, &lost ) );
+  CHECK_EQUAL( 8u, cursor );
+  CHECK_EQUAL( 0u, lost );
+  for( unsigned int i = 0; i < 8; ++i )
+  {
+    CHECK_EQUAL( TRACED_NODE, e[i].m_Id );
+    CHECK( e[i].m_Agent == (unsigned long long)(size_t)r[i / 4].m_Bss );
+    CHECK_EQUAL( kinds[i % 4], e[i].m_Kind & TRACE_KIND_MASK );
+    if( i > 0 )
+      CHECK( e[i].m_Time >= e[i - 1].m_Time );
+  }
+  CHECK_EQUAL( (unsigned int)ACT_EXECUTE, (unsigned int)(e[1].m_Kind >> TRACE_ACTION_SHIFT) );
+  //The node returns what its callback did, run by the interpreter or not
+  CHECK_EQUAL( e[2].m_Result, e[3].m_Result );
+  CHECK_EQUAL( e[6].m_Result, e[7].m_Result );
+  CHECK_EQUAL( e[3].m_Result, e[7].m_Result );
+  CHECK_EQUAL( 0u, read_trace( tb, &cursor, e, 16, &lost ) );
+  destroy_trace_buffer( tb );
+}
+
+TEST( TraceKeepsTheNewestEvents )
+{
+  static BuiltProgram p;
+  init_traced_program( &p );
+  TraceBuffer* tb = create_trace_buffer( 3 );
+  CHECK( tb );
+  if( !tb )
+    return;
+
+  CallbackProgram a;
+  static TestRun r;
+  init_run( &a, &r, &p, 0 );
+  set_trace_buffer( tb );
+  for( int i = 0; i < 3; ++i )
+    run_program( &a );
+  set_trace_buffer( 0x0 );
+
+  //Four slots, three can be read
+  TraceEvent e[16];
+  unsigned int cursor = 0, lost = 0;
+  CHECK_EQUAL( 2u, read_trace( tb, &cursor, e, 2, &lost ) );
+  CHECK_EQUAL( 9u, lost );
+  CHECK_EQUAL( (unsigned int)E_TRACE_CALLBACK_BEGIN, e[0].m_Kind & TRACE_KIND_MASK );
+  CHECK_EQUAL( (unsigned int)E_TRACE_CALLBACK_END, e[1].m_Kind & TRACE_KIND_MASK );
+  CHECK_EQUAL( 1u, read_trace( tb, &cursor, e, 16, &lost ) );
+  CHECK_EQUAL( (unsigned int)E_TRACE_EXIT, e[0].m_Kind & TRACE_KIND_MASK );
+  CHECK_EQUAL( 12u, cursor );
+  destroy_trace_buffer( tb );
+}
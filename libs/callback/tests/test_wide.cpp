@@ -0,0 +1,56 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include "test_program.h"
+
+using namespace callback;
+
+TEST( WideMatchesNarrow )
+{
+  static TestProgram p;
+  static BuiltProgram w;
+  init_test_program( &p );
+  build_test_program( &w, &p, E_PROGRAM_WIDE );
+
+  CallbackProgram ncp, wcp;
+  static TestRun nr, wr;
+  init_run( &ncp, &nr, &p, 0 );
+  init_run( &wcp, &wr, &w, 0 );
+
+  for( unsigned int f = 0; f < 10; ++f )
+    CHECK_EQUAL( run_program( &ncp ), run_program( &wcp ) );
+
+  CHECK( nr.m_Calls > 10 );
+  check_same( nr, wr );
+}
+
+TEST( WideJitMatchesNarrow )
+{
+  static TestProgram p;
+  static BuiltProgram w;
+  init_test_program( &p );
+  build_test_program( &w, &p, E_PROGRAM_WIDE );
+
+  CallbackProgram ncp, wcp;
+  static TestRun nr, wr;
+  init_run( &ncp, &nr, &p, 0 );
+  init_run( &wcp, &wr, &w, E_CALLBACK_JIT );
+
+  for( unsigned int f = 0; f < 10; ++f )
+  {
+    run_program( &ncp );
+    run_program_budget( &wcp, 3 + f );
+    run_program( &wcp );
+  }
+
+  check_same( nr, wr );
+  jit_release( &w );
+}
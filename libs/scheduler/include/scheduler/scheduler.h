@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <callback/callback.h>
+
+namespace scheduler
+{
+
+/*
+ * The scheduler runs a set of agents once per tick, like calling run_program
+ * on each of them, except that a callback can park its agent. A parked agent
+ * is not run at all until a timer expires or an event it waits on is fired,
+ * so idle agents cost nothing per tick.
+ *
+ * Timers live in a hierarchical timer wheel, TIMER_WHEEL_LEVELS levels of
+ * TIMER_WHEEL_SLOTS slots each. Agents waiting on an event are kept in hash
+ * buckets keyed on the event id.
+ */
+
+const unsigned int TIMER_WHEEL_BITS   = 6;
+const unsigned int TIMER_WHEEL_SLOTS  = 1 << TIMER_WHEEL_BITS;
+const unsigned int TIMER_WHEEL_MASK   = TIMER_WHEEL_SLOTS - 1;
+const unsigned int TIMER_WHEEL_LEVELS = 4;
+const unsigned int EVENT_BUCKET_COUNT = 64;
+
+enum AgentState
+{
+  E_AGENT_REMOVED, /* Not in the scheduler                                 */
+  E_AGENT_RUNNING, /* Run every tick                                       */
+  E_AGENT_WOKEN,   /* Added or woken, runs from the next tick              */
+  E_AGENT_TIMER,   /* Parked until a tick                                  */
+  E_AGENT_EVENT,   /* Parked until an event is fired                       */
+  MAXIMUM_AGENT_STATE_COUNT
+};
+
+struct AgentLink
+{
+  AgentLink* m_Next;
+  AgentLink* m_Prev;
+};
+
+/*
+ * One agent. m_Program is passed to run_program as is, so fill in its program,
+ * bss, user data and handlers before adding the agent. The rest is owned by
+ * the scheduler.
+ */
+struct Agent
+{
+  AgentLink                 m_Link;
+  callback::CallbackProgram m_Program;
+  unsigned int              m_State;
+  unsigned int              m_Wake;      // Tick or event id to wake on
+  unsigned int              m_Park;      // State requested by a callback
+  unsigned int              m_ParkValue;
+};
+
+struct Scheduler
+{
+  AgentLink    m_Running;
+  AgentLink    m_Woken;
+  AgentLink    m_Wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  AgentLink    m_Events[EVENT_BUCKET_COUNT];
+  unsigned int m_Tick;   // The tick being run, or the next one between ticks
+  unsigned int m_Agents; // Agents added
+  unsigned int m_Parked; // Agents parked on a timer or an event
+  unsigned int m_Budget; // Instructions per agent and tick, 0 for no limit
+};
+
+void init( Scheduler* s );
+
+/*
+ * Adds or removes an agent. Added agents start running from the next tick.
+ * Must not be called from a callback.
+ */
+void add_agent( Scheduler* s, Agent* a );
+void remove_agent( Scheduler* s, Agent* a );
+
+/*
+ * Runs one tick: wakes agents whose timer expires on this tick, runs every
+ * agent that is not parked and then advances the tick. Returns the number of
+ * agents that were run.
+ *
+ * If m_Budget is set an agent that runs out of instructions yields and
+ * resumes on the next tick. A park requested before it yielded takes effect
+ * once it has finished.
+ */
+unsigned int run_scheduler( Scheduler* s );
+
+/*
+ * Called from a callback of agent "a" to park it once its run is over. The
+ * callback should return E_NODE_WORKING, the node is executed again when the
+ * agent wakes. park_for wakes the agent "ticks" ticks later (at least one),
+ * park_on_event when "event" is fired.
+ */
+void park_for( Agent* a, unsigned int ticks );
+void park_on_event( Agent* a, unsigned int event );
+
+/*
+ * Wakes every agent waiting on "event", or a single agent no matter what it
+ * waits on. Woken agents run from the next tick. wake_event returns the number
+ * of agents woken. Both may be called from callbacks.
+ */
+unsigned int wake_event( Scheduler* s, unsigned int event );
+void wake_agent( Scheduler* s, Agent* a );
+
+}
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef SCHEDULER_WORKERS_H_
+#define SCHEDULER_WORKERS_H_
+
+#include <callback/callback.h>
+
+namespace scheduler
+{
+
+/*
+ * A pool of worker threads that ticks batches of agents in parallel. Each tick
+ * the agents are cut into chunks and dealt out to per-worker deques, always in
+ * the same way, so an agent's bss stays with one worker from tick to tick
+ * unless its chunk is stolen. A worker that runs out of chunks steals from the
+ * back of the other workers' deques.
+ *
+ * The thread calling run_workers is worker number zero, so a pool of one
+ * thread starts no threads at all.
+ */
+struct WorkerPool;
+
+/*
+ * "worker_data" is either null or holds one pointer per thread, which is
+ * what get_worker_data returns in callbacks run by that worker.
+ */
+WorkerPool* create_worker_pool( unsigned int threads, void** worker_data );
+void destroy_worker_pool( WorkerPool* wp );
+
+/*
+ * Runs every agent of every batch once and returns when all are done. Agents
+ * in different batches may run different programs. Returns the number of
+ * chunks that were stolen.
+ */
+unsigned int run_workers( WorkerPool* wp, callback::CallbackBatch* batches,
+  unsigned int count );
+
+/*
+ * The per-thread user data of the worker calling, or null outside of
+ * run_workers.
+ */
+void* get_worker_data();
+
+}
+
+#endif /* SCHEDULER_WORKERS_H_ */
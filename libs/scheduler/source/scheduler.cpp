@@ -0,0 +1,256 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <scheduler/scheduler.h>
+
+namespace scheduler
+{
+
+using namespace callback;
+
+/*
+ * Timers further away than the wheel can hold are clamped to its range and
+ * simply wake early; callbacks that park for that long re-park when run.
+ */
+const unsigned int TIMER_WHEEL_RANGE = 1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS);
+
+static void list_init( AgentLink* l )
+{
+  l->m_Next = l;
+  l->m_Prev = l;
+}
+
+static bool list_empty( AgentLink* l )
+{
+  return l->m_Next == l;
+}
+
+static void list_unlink( AgentLink* l )
+{
+  l->m_Prev->m_Next = l->m_Next;
+  l->m_Next->m_Prev = l->m_Prev;
+  list_init( l );
+}
+
+static void list_push_back( AgentLink* l, AgentLink* e )
+{
+  e->m_Next = l;
+  e->m_Prev = l->m_Prev;
+  l->m_Prev->m_Next = e;
+  l->m_Prev = e;
+}
+
+static void list_splice_back( AgentLink* l, AgentLink* from )
+{
+  if( list_empty( from ) )
+    return;
+  from->m_Next->m_Prev = l->m_Prev;
+  from->m_Prev->m_Next = l;
+  l->m_Prev->m_Next = from->m_Next;
+  l->m_Prev = from->m_Prev;
+  list_init( from );
+}
+
+/*
+ * Puts a timer agent in the wheel, relative to "base", the earliest tick that
+ * has not had its level zero slot expired yet.
+ */
+static void timer_insert( Scheduler* s, Agent* a, unsigned int base )
+{
+  unsigned int delta = a->m_Wake - base;
+  if( delta >= TIMER_WHEEL_RANGE )
+  {
+    delta = TIMER_WHEEL_RANGE - 1;
+    a->m_Wake = base + delta;
+  }
+
+  unsigned int level = 0;
+  while( level + 1 < TIMER_WHEEL_LEVELS
+      && delta >= (1u << (TIMER_WHEEL_BITS * (level + 1))) )
+    ++level;
+
+  unsigned int slot = (a->m_Wake >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+  list_push_back( &s->m_Wheel[level][slot], &a->m_Link );
+}
+
+/*
+ * Moves the agents in a slot of an upper level down to the levels below.
+ */
+static void timer_cascade( Scheduler* s, unsigned int level, unsigned int slot )
+{
+  AgentLink l;
+  list_init( &l );
+  list_splice_back( &l, &s->m_Wheel[level][slot] );
+  while( !list_empty( &l ) )
+  {
+    Agent* a = (Agent*)l.m_Next;
+    list_unlink( &a->m_Link );
+    timer_insert( s, a, s->m_Tick );
+  }
+}
+
+static void timer_expire( Scheduler* s )
+{
+  const unsigned int t = s->m_Tick;
+  if( (t & TIMER_WHEEL_MASK) == 0 )
+  {
+    for( unsigned int level = 1; level < TIMER_WHEEL_LEVELS; ++level )
+    {
+      unsigned int slot = (t >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+      timer_cascade( s, level, slot );
+      if( slot != 0 )
+        break;
+    }
+  }
+
+  AgentLink* l = &s->m_Wheel[0][t & TIMER_WHEEL_MASK];
+  for( AgentLink* it = l->m_Next; it != l; it = it->m_Next )
+  {
+    ((Agent*)it)->m_State = E_AGENT_RUNNING;
+    --s->m_Parked;
+  }
+  list_splice_back( &s->m_Running, l );
+}
+
+static void park( Scheduler* s, Agent* a )
+{
+  list_unlink( &a->m_Link );
+  a->m_State = a->m_Park;
+  a->m_Park  = E_AGENT_RUNNING;
+  ++s->m_Parked;
+
+  if( a->m_State == E_AGENT_TIMER )
+  {
+    a->m_Wake = s->m_Tick + a->m_ParkValue;
+    timer_insert( s, a, s->m_Tick + 1 );
+  }
+  else
+  {
+    a->m_Wake = a->m_ParkValue;
+    list_push_back( &s->m_Events[a->m_Wake % EVENT_BUCKET_COUNT], &a->m_Link );
+  }
+}
+
+void init( Scheduler* s )
+{
+  list_init( &s->m_Running );
+  list_init( &s->m_Woken );
+  for( unsigned int level = 0; level < TIMER_WHEEL_LEVELS; ++level )
+  {
+    for( unsigned int slot = 0; slot < TIMER_WHEEL_SLOTS; ++slot )
+      list_init( &s->m_Wheel[level][slot] );
+  }
+  for( unsigned int b = 0; b < EVENT_BUCKET_COUNT; ++b )
+    list_init( &s->m_Events[b] );
+  s->m_Tick   = 0;
+  s->m_Agents = 0;
+  s->m_Parked = 0;
+  s->m_Budget = 0;
+}
+
+void add_agent( Scheduler* s, Agent* a )
+{
+  list_init( &a->m_Link );
+  list_push_back( &s->m_Woken, &a->m_Link );
+  a->m_State     = E_AGENT_WOKEN;
+  a->m_Wake      = 0;
+  a->m_Park      = E_AGENT_RUNNING;
+  a->m_ParkValue = 0;
+  ++s->m_Agents;
+}
+
+void remove_agent( Scheduler* s, Agent* a )
+{
+  if( a->m_State == E_AGENT_REMOVED )
+    return;
+  if( a->m_State == E_AGENT_TIMER || a->m_State == E_AGENT_EVENT )
+    --s->m_Parked;
+  list_unlink( &a->m_Link );
+  a->m_State = E_AGENT_REMOVED;
+  --s->m_Agents;
+}
+
+unsigned int run_scheduler( Scheduler* s )
+{
+  for( AgentLink* it = s->m_Woken.m_Next; it != &s->m_Woken; it = it->m_Next )
+    ((Agent*)it)->m_State = E_AGENT_RUNNING;
+  list_splice_back( &s->m_Running, &s->m_Woken );
+
+  timer_expire( s );
+
+  unsigned int count = 0;
+  AgentLink* it = s->m_Running.m_Next;
+  while( it != &s->m_Running )
+  {
+    Agent* a = (Agent*)it;
+    it = it->m_Next;
+
+    ++count;
+    if( s->m_Budget != 0 )
+    {
+      if( run_program_budget( &a->m_Program, s->m_Budget ) == E_RUN_YIELDED )
+        continue;
+    }
+    else
+    {
+      run_program( &a->m_Program );
+    }
+
+    if( a->m_Park != E_AGENT_RUNNING )
+      park( s, a );
+  }
+
+  ++s->m_Tick;
+  return count;
+}
+
+void park_for( Agent* a, unsigned int ticks )
+{
+  a->m_Park      = E_AGENT_TIMER;
+  a->m_ParkValue = ticks > 0 ? ticks : 1;
+}
+
+void park_on_event( Agent* a, unsigned int event )
+{
+  a->m_Park      = E_AGENT_EVENT;
+  a->m_ParkValue = event;
+}
+
+unsigned int wake_event( Scheduler* s, unsigned int event )
+{
+  unsigned int count = 0;
+  AgentLink* l  = &s->m_Events[event % EVENT_BUCKET_COUNT];
+  AgentLink* it = l->m_Next;
+  while( it != l )
+  {
+    Agent* a = (Agent*)it;
+    it = it->m_Next;
+    if( a->m_Wake != event )
+      continue;
+
+    wake_agent( s, a );
+    ++count;
+  }
+  return count;
+}
+
+void wake_agent( Scheduler* s, Agent* a )
+{
+  if( a->m_State != E_AGENT_TIMER && a->m_State != E_AGENT_EVENT )
+    return;
+
+  list_unlink( &a->m_Link );
+  list_push_back( &s->m_Woken, &a->m_Link );
+  a->m_State = E_AGENT_WOKEN;
+  --s->m_Parked;
+}
+
+}
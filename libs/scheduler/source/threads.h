@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#ifndef SCHEDULER_THREADS_H_
+#define SCHEDULER_THREADS_H_
+
+/*
+ * The little bit of threading the worker pool needs: threads, a mutex and
+ * condition variable pair. The spin lock and THREAD_LOCAL are the callback
+ * library's.
+ */
+
+#include <callback/platform.h>
+
+using callback::SpinLock;
+using callback::spin_lock;
+using callback::spin_unlock;
+
+#if defined(MSVC)
+
+#include <windows.h>
+
+typedef HANDLE             ThreadHandle;
+typedef CRITICAL_SECTION   MutexHandle;
+typedef CONDITION_VARIABLE CondHandle;
+
+typedef void (*ThreadEntry)( void* );
+
+struct ThreadStart
+{
+  ThreadEntry m_Entry;
+  void*       m_Arg;
+};
+
+inline DWORD WINAPI thread_trampoline( LPVOID p )
+{
+  ThreadStart* ts = (ThreadStart*)p;
+  ts->m_Entry( ts->m_Arg );
+  return 0;
+}
+
+inline bool thread_create( ThreadHandle* t, ThreadStart* ts )
+{
+  *t = CreateThread( 0x0, 0, &thread_trampoline, ts, 0, 0x0 );
+  return *t != 0x0;
+}
+
+inline void thread_join( ThreadHandle* t )
+{
+  WaitForSingleObject( *t, INFINITE );
+  CloseHandle( *t );
+}
+
+inline void mutex_init( MutexHandle* m )    { InitializeCriticalSection( m ); }
+inline void mutex_destroy( MutexHandle* m ) { DeleteCriticalSection( m ); }
+inline void mutex_lock( MutexHandle* m )    { EnterCriticalSection( m ); }
+inline void mutex_unlock( MutexHandle* m )  { LeaveCriticalSection( m ); }
+
+inline void cond_init( CondHandle* c )      { InitializeConditionVariable( c ); }
+inline void cond_destroy( CondHandle* )     {}
+inline void cond_wait( CondHandle* c, MutexHandle* m ) { SleepConditionVariableCS( c, m, INFINITE ); }
+inline void cond_broadcast( CondHandle* c ) { WakeAllConditionVariable( c ); }
+
+#elif defined(GCC)
+
+#include <pthread.h>
+
+typedef pthread_t       ThreadHandle;
+typedef pthread_mutex_t MutexHandle;
+typedef pthread_cond_t  CondHandle;
+
+typedef void (*ThreadEntry)( void* );
+
+struct ThreadStart
+{
+  ThreadEntry m_Entry;
+  void*       m_Arg;
+};
+
+inline void* thread_trampoline( void* p )
+{
+  ThreadStart* ts = (ThreadStart*)p;
+  ts->m_Entry( ts->m_Arg );
+  return 0x0;
+}
+
+inline bool thread_create( ThreadHandle* t, ThreadStart* ts )
+{
+  return pthread_create( t, 0x0, &thread_trampoline, ts ) == 0;
+}
+
+inline void thread_join( ThreadHandle* t )
+{
+  pthread_join( *t, 0x0 );
+}
+
+inline void mutex_init( MutexHandle* m )    { pthread_mutex_init( m, 0x0 ); }
+inline void mutex_destroy( MutexHandle* m ) { pthread_mutex_destroy( m ); }
+inline void mutex_lock( MutexHandle* m )    { pthread_mutex_lock( m ); }
+inline void mutex_unlock( MutexHandle* m )  { pthread_mutex_unlock( m ); }
+
+inline void cond_init( CondHandle* c )      { pthread_cond_init( c, 0x0 ); }
+inline void cond_destroy( CondHandle* c )   { pthread_cond_destroy( c ); }
+inline void cond_wait( CondHandle* c, MutexHandle* m ) { pthread_cond_wait( c, m ); }
+inline void cond_broadcast( CondHandle* c ) { pthread_cond_broadcast( c ); }
+
+#else
+#error "Compiler not supported."
+#endif
+
+#endif /* SCHEDULER_THREADS_H_ */
@@ -0,0 +1,330 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <scheduler/workers.h>
+
+#include "threads.h"
+
+#include <stdlib.h>
+
+namespace scheduler
+{
+
+using namespace callback;
+
+/*
+ * Agents are handed out in chunks of at most this many, fewer if there would
+ * be less than a handful of chunks per worker.
+ */
+const unsigned int WORKER_CHUNK_SIZE    = 32;
+const unsigned int WORKER_CHUNKS_WANTED = 8;
+
+struct Chunk
+{
+  unsigned int m_Batch;
+  unsigned int m_First;
+  unsigned int m_Count;
+};
+
+/*
+ * The owner takes chunks from the head, thieves from the tail. The deque is
+ * only filled between ticks so a spin lock around the two ends is plenty.
+ */
+struct WorkerDeque
+{
+  SpinLock     m_Lock;
+  unsigned int m_Head;
+  unsigned int m_Tail;
+  unsigned int m_Capacity;
+  Chunk*       m_Chunks;
+  char         m_Pad[64]; // Keep the deques on separate cache lines
+};
+
+struct Worker
+{
+  WorkerPool*  m_Pool;
+  unsigned int m_Index;
+  void*        m_Data;
+  unsigned int m_Steals;
+  ThreadHandle m_Thread;
+  ThreadStart  m_Start;
+};
+
+struct WorkerPool
+{
+  unsigned int   m_Threads;
+  Worker*        m_Workers;
+  WorkerDeque*   m_Deques;
+  CallbackBatch* m_Batches;
+  MutexHandle    m_Mutex;
+  CondHandle     m_Begin;
+  CondHandle     m_End;
+  unsigned int   m_Generation;
+  unsigned int   m_Running;  // Threads still in the tick, under m_Mutex
+  bool           m_Exit;
+};
+
+static THREAD_LOCAL void* g_WorkerData = 0x0;
+
+static bool take_chunk( WorkerDeque* d, Chunk* c )
+{
+  bool r = false;
+  spin_lock( &d->m_Lock );
+  if( d->m_Head != d->m_Tail )
+  {
+    *c = d->m_Chunks[d->m_Head++];
+    r = true;
+  }
+  spin_unlock( &d->m_Lock );
+  return r;
+}
+
+static bool steal_chunk( WorkerDeque* d, Chunk* c )
+{
+  bool r = false;
+  spin_lock( &d->m_Lock );
+  if( d->m_Head != d->m_Tail )
+  {
+    *c = d->m_Chunks[--d->m_Tail];
+    r = true;
+  }
+  spin_unlock( &d->m_Lock );
+  return r;
+}
+
+static void push_chunk( WorkerDeque* d, const Chunk& c )
+{
+  if( d->m_Tail == d->m_Capacity )
+  {
+    d->m_Capacity = d->m_Capacity ? d->m_Capacity * 2 : 16;
+    d->m_Chunks = (Chunk*)realloc( d->m_Chunks, sizeof(Chunk) * d->m_Capacity );
+  }
+  d->m_Chunks[d->m_Tail++] = c;
+}
+
+static void run_chunk( WorkerPool* wp, const Chunk& c )
+{
+  CallbackBatch b = wp->m_Batches[c.m_Batch];
+  b.m_bss   = (char*)b.m_bss + (b.m_Stride * c.m_First);
+  b.m_Count = c.m_Count;
+  if( b.m_UserData )
+    b.m_UserData += c.m_First;
+  run_programs( &b );
+}
+
+static void work( Worker* w )
+{
+  WorkerPool* wp = w->m_Pool;
+  void* old_data = g_WorkerData;
+  g_WorkerData = w->m_Data;
+
+  Chunk c;
+  while( take_chunk( &wp->m_Deques[w->m_Index], &c ) )
+    run_chunk( wp, c );
+
+  //Own deque is empty, nothing is added during a tick so steal until all are
+  bool stole = true;
+  while( stole )
+  {
+    stole = false;
+    for( unsigned int i = 1; i < wp->m_Threads && !stole; ++i )
+    {
+      unsigned int victim = (w->m_Index + i) % wp->m_Threads;
+      if( steal_chunk( &wp->m_Deques[victim], &c ) )
+      {
+        run_chunk( wp, c );
+        ++w->m_Steals;
+        stole = true;
+      }
+    }
+  }
+
+  g_WorkerData = old_data;
+}
+
+static void worker_thread( void* arg )
+{
+  Worker* w = (Worker*)arg;
+  WorkerPool* wp = w->m_Pool;
+  unsigned int seen = 0;
+
+  for( ;; )
+  {
+    mutex_lock( &wp->m_Mutex );
+    while( wp->m_Generation == seen && !wp->m_Exit )
+      cond_wait( &wp->m_Begin, &wp->m_Mutex );
+    seen = wp->m_Generation;
+    bool exit = wp->m_Exit;
+    mutex_unlock( &wp->m_Mutex );
+
+    if( exit )
+      return;
+
+    work( w );
+
+    mutex_lock( &wp->m_Mutex );
+    if( --wp->m_Running == 0 )
+      cond_broadcast( &wp->m_End );
+    mutex_unlock( &wp->m_Mutex );
+  }
+}
+
+WorkerPool* create_worker_pool( unsigned int threads, void** worker_data )
+{
+  if( threads == 0 )
+    threads = 1;
+
+  WorkerPool* wp = new WorkerPool;
+  wp->m_Threads    = threads;
+  wp->m_Workers    = new Worker[threads];
+  wp->m_Deques     = new WorkerDeque[threads];
+  wp->m_Batches    = 0x0;
+  wp->m_Generation = 0;
+  wp->m_Running    = 0;
+  wp->m_Exit       = false;
+  mutex_init( &wp->m_Mutex );
+  cond_init( &wp->m_Begin );
+  cond_init( &wp->m_End );
+
+  for( unsigned int i = 0; i < threads; ++i )
+  {
+    WorkerDeque* d = &wp->m_Deques[i];
+    d->m_Lock     = 0;
+    d->m_Head     = 0;
+    d->m_Tail     = 0;
+    d->m_Capacity = 0;
+    d->m_Chunks   = 0x0;
+
+    Worker* w = &wp->m_Workers[i];
+    w->m_Pool          = wp;
+    w->m_Index         = i;
+    w->m_Data          = worker_data ? worker_data[i] : 0x0;
+    w->m_Steals        = 0;
+    w->m_Start.m_Entry = &worker_thread;
+    w->m_Start.m_Arg   = w;
+  }
+
+  //Worker zero is whoever calls run_workers
+  for( unsigned int i = 1; i < threads; ++i )
+  {
+    if( !thread_create( &wp->m_Workers[i].m_Thread, &wp->m_Workers[i].m_Start ) )
+    {
+      wp->m_Threads = i;
+      break;
+    }
+  }
+
+  return wp;
+}
+
+void destroy_worker_pool( WorkerPool* wp )
+{
+  if( !wp )
+    return;
+
+  mutex_lock( &wp->m_Mutex );
+  wp->m_Exit = true;
+  cond_broadcast( &wp->m_Begin );
+  mutex_unlock( &wp->m_Mutex );
+
+  for( unsigned int i = 1; i < wp->m_Threads; ++i )
+    thread_join( &wp->m_Workers[i].m_Thread );
+
+  for( unsigned int i = 0; i < wp->m_Threads; ++i )
+    free( wp->m_Deques[i].m_Chunks );
+
+  cond_destroy( &wp->m_End );
+  cond_destroy( &wp->m_Begin );
+  mutex_destroy( &wp->m_Mutex );
+  delete [] wp->m_Deques;
+  delete [] wp->m_Workers;
+  delete wp;
+}
+
+unsigned int run_workers( WorkerPool* wp, CallbackBatch* batches,
+  unsigned int count )
+{
+  const unsigned int threads = wp->m_Threads;
+
+  unsigned int total = 0;
+  for( unsigned int b = 0; b < count; ++b )
+    total += batches[b].m_Count;
+  if( total == 0 )
+    return 0;
+
+  unsigned int chunk_size = total / (threads * WORKER_CHUNKS_WANTED);
+  if( chunk_size > WORKER_CHUNK_SIZE )
+    chunk_size = WORKER_CHUNK_SIZE;
+  if( chunk_size == 0 )
+    chunk_size = 1;
+
+  for( unsigned int i = 0; i < threads; ++i )
+  {
+    wp->m_Deques[i].m_Head = 0;
+    wp->m_Deques[i].m_Tail = 0;
+    wp->m_Workers[i].m_Steals = 0;
+  }
+
+  //Deal the chunks out by position, so agents land on the same worker every
+  //tick as long as the batches stay the same
+  unsigned int start = 0;
+  for( unsigned int b = 0; b < count; ++b )
+  {
+    for( unsigned int a = 0; a < batches[b].m_Count; a += chunk_size )
+    {
+      Chunk c;
+      c.m_Batch = b;
+      c.m_First = a;
+      c.m_Count = batches[b].m_Count - a;
+      if( c.m_Count > chunk_size )
+        c.m_Count = chunk_size;
+
+      unsigned int owner = (unsigned int)(((double)(start + a) * threads) / total);
+      push_chunk( &wp->m_Deques[owner], c );
+    }
+    start += batches[b].m_Count;
+  }
+
+  wp->m_Batches = batches;
+
+  if( threads > 1 )
+  {
+    mutex_lock( &wp->m_Mutex );
+    wp->m_Running = threads - 1;
+    ++wp->m_Generation;
+    cond_broadcast( &wp->m_Begin );
+    mutex_unlock( &wp->m_Mutex );
+  }
+
+  work( &wp->m_Workers[0] );
+
+  if( threads > 1 )
+  {
+    mutex_lock( &wp->m_Mutex );
+    while( wp->m_Running != 0 )
+      cond_wait( &wp->m_End, &wp->m_Mutex );
+    mutex_unlock( &wp->m_Mutex );
+  }
+
+  wp->m_Batches = 0x0;
+
+  unsigned int steals = 0;
+  for( unsigned int i = 0; i < threads; ++i )
+    steals += wp->m_Workers[i].m_Steals;
+  return steals;
+}
+
+void* get_worker_data()
+{
+  return g_WorkerData;
+}
+
+}
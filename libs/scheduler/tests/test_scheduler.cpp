@@ -0,0 +1,235 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <UnitTest++.h>
+#include <callback/callback.h>
+#include <callback/instructions.h>
+#include <scheduler/scheduler.h>
+
+#include <string.h>
+
+using namespace callback;
+using namespace scheduler;
+
+/*
+ * A program that makes one execute callback and suspends.
+ */
+struct TestProgram
+{
+  ProgramHeader m_Header;
+  Instruction   m_Inst[2];
+  unsigned int  m_Ids[1];
+};
+
+struct TestAgent
+{
+  Agent        m_Agent;
+  BssHeader    m_Bss;
+  Scheduler*   m_Scheduler;
+  unsigned int m_Runs;
+  unsigned int m_LastTick;
+  unsigned int m_Park;
+  unsigned int m_Event;
+};
+
+static unsigned int test_callback( unsigned int id, unsigned int action, void* bss,
+  void** data, void* user_data )
+{
+  TestAgent* ta = (TestAgent*)user_data;
+  ++ta->m_Runs;
+  ta->m_LastTick = ta->m_Scheduler->m_Tick;
+  if( ta->m_Event != 0 )
+    park_on_event( &ta->m_Agent, ta->m_Event );
+  else if( ta->m_Park != 0 )
+    park_for( &ta->m_Agent, ta->m_Park );
+  return E_NODE_WORKING;
+}
+
+static void init_program( TestProgram* p )
+{
+  memset( p, 0, sizeof(TestProgram) );
+  p->m_Header.m_IC = 2;
+  p->m_Header.m_DS = sizeof(unsigned int);
+  p->m_Header.m_BS = sizeof(BssHeader);
+  p->m_Header.m_CC = 1;
+  p->m_Header.m_CT = 0;
+  p->m_Inst[0].m_I  = INST_FUSE_EXEC_FUN;
+  p->m_Inst[0].m_A1 = 0;
+  p->m_Inst[0].m_A2 = NO_OPERAND;
+  p->m_Inst[0].m_A3 = NO_OPERAND;
+  p->m_Inst[1].m_I  = INST_______SUSPEND;
+  p->m_Ids[0] = 1;
+}
+
+static void init_agent( TestAgent* ta, TestProgram* p, Scheduler* s )
+{
+  memset( ta, 0, sizeof(TestAgent) );
+  ta->m_Scheduler = s;
+  ta->m_Agent.m_Program.m_Program  = p;
+  ta->m_Agent.m_Program.m_bss      = &ta->m_Bss;
+  ta->m_Agent.m_Program.m_UserData = ta;
+  ta->m_Agent.m_Program.m_Callback = &test_callback;
+  add_agent( s, &ta->m_Agent );
+}
+
+TEST( SchedulerRunsUnparkedAgentsEveryTick )
+{
+  TestProgram p;
+  init_program( &p );
+  Scheduler s;
+  init( &s );
+
+  TestAgent ta[3];
+  for( int i = 0; i < 3; ++i )
+    init_agent( &ta[i], &p, &s );
+
+  for( int i = 0; i < 5; ++i )
+    CHECK_EQUAL( 3u, run_scheduler( &s ) );
+
+  for( int i = 0; i < 3; ++i )
+    CHECK_EQUAL( 5u, ta[i].m_Runs );
+  CHECK_EQUAL( 3u, s.m_Agents );
+  CHECK_EQUAL( 0u, s.m_Parked );
+}
+
+TEST( SchedulerWakesTimersOnTheRightTick )
+{
+  const unsigned int delays[] = { 1, 2, 63, 64, 65, 127, 4095, 4096, 4097, 70000 };
+  const unsigned int count = sizeof(delays) / sizeof(delays[0]);
+
+  TestProgram p;
+  init_program( &p );
+  Scheduler s;
+  init( &s );
+
+  //Offset the start so the timers straddle slot boundaries
+  s.m_Tick = 37;
+
+  for( unsigned int d = 0; d < count; ++d )
+  {
+    TestAgent ta;
+    init_agent( &ta, &p, &s );
+    ta.m_Park = delays[d];
+
+    run_scheduler( &s );
+    CHECK_EQUAL( 1u, ta.m_Runs );
+    CHECK_EQUAL( 1u, s.m_Parked );
+    unsigned int parked_on = ta.m_LastTick;
+
+    unsigned int ran = 0;
+    while( ta.m_Runs == 1 )
+      ran += run_scheduler( &s );
+    CHECK_EQUAL( 1u, ran );
+
+    CHECK_EQUAL( delays[d], ta.m_LastTick - parked_on );
+    remove_agent( &s, &ta.m_Agent );
+    CHECK_EQUAL( 0u, s.m_Agents );
+    CHECK_EQUAL( 0u, s.m_Parked );
+  }
+}
+
+TEST( SchedulerDoesNotRunParkedAgents )
+{
+  TestProgram p;
+  init_program( &p );
+  Scheduler s;
+  init( &s );
+
+  TestAgent busy, idle;
+  init_agent( &busy, &p, &s );
+  init_agent( &idle, &p, &s );
+  idle.m_Park = 1000;
+
+  CHECK_EQUAL( 2u, run_scheduler( &s ) );
+  for( int i = 0; i < 100; ++i )
+    CHECK_EQUAL( 1u, run_scheduler( &s ) );
+
+  CHECK_EQUAL( 101u, busy.m_Runs );
+  CHECK_EQUAL( 1u, idle.m_Runs );
+}
+
+TEST( SchedulerWakesAgentsOnEvent )
+{
+  TestProgram p;
+  init_program( &p );
+  Scheduler s;
+  init( &s );
+
+  const unsigned int event = 0x1234;
+
+  TestAgent a, b;
+  init_agent( &a, &p, &s );
+  init_agent( &b, &p, &s );
+  a.m_Event = event;
+  b.m_Event = event + EVENT_BUCKET_COUNT; // Same bucket, different event
+
+  run_scheduler( &s );
+  CHECK_EQUAL( 2u, s.m_Parked );
+  CHECK_EQUAL( 0u, run_scheduler( &s ) );
+
+  CHECK_EQUAL( 1u, wake_event( &s, event ) );
+  CHECK_EQUAL( 0u, wake_event( &s, event ) );
+  CHECK_EQUAL( 1u, s.m_Parked );
+
+  CHECK_EQUAL( 1u, run_scheduler( &s ) );
+  CHECK_EQUAL( 2u, a.m_Runs );
+  CHECK_EQUAL( 1u, b.m_Runs );
+}
+
+TEST( SchedulerWakeAgentWakesTimer )
+{
+  TestProgram p;
+  init_program( &p );
+  Scheduler s;
+  init( &s );
+
+  TestAgent ta;
+  init_agent( &ta, &p, &s );
+  ta.m_Park = 500;
+
+  run_scheduler( &s );
+  ta.m_Park = 0;
+  wake_agent( &s, &ta.m_Agent );
+  CHECK_EQUAL( 0u, s.m_Parked );
+
+  CHECK_EQUAL( 1u, run_scheduler( &s ) );
+  CHECK_EQUAL( 2u, ta.m_Runs );
+
+  //The old timer must be gone
+  for( int i = 0; i < 600; ++i )
+    run_scheduler( &s );
+  CHECK_EQUAL( 602u, ta.m_Runs );
+}
+
+TEST( SchedulerBudgetYieldsAndResumes )
+{
+  TestProgram p;
+  init_program( &p );
+  Scheduler s;
+  init( &s );
+  s.m_Budget = 1;
+
+  TestAgent ta;
+  init_agent( &ta, &p, &s );
+
+  //One instruction per tick: the callback on even ticks, suspend on odd
+  for( int i = 0; i < 10; ++i )
+    CHECK_EQUAL( 1u, run_scheduler( &s ) );
+  CHECK_EQUAL( 5u, ta.m_Runs );
+
+  //The park is requested on the callback tick but done once finished
+  ta.m_Park = 4;
+  run_scheduler( &s );
+  CHECK_EQUAL( 0u, s.m_Parked );
+  run_scheduler( &s );
+  CHECK_EQUAL( 1u, s.m_Parked );
+  CHECK_EQUAL( 6u, ta.m_Runs );
+}
@@ -0,0 +1,153 @@
+/*******************************************************************************
+ * Copyright (c) 2009-04-24 Joacim Jacobsson.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    Joacim Jacobsson - first implementation
+ *******************************************************************************/
+
+#include <UnitTest++.h>
+#include <callback/callback.h>
+#include <callback/instructions.h>
+#include <scheduler/workers.h>
+
+#include <string.h>
+
+using namespace callback;
+using namespace scheduler;
+
+/*
+ * A program that makes one execute callback and suspends.
+ */
+struct WorkerProgram
+{
+  ProgramHeader m_Header;
+  Instruction   m_Inst[2];
+  unsigned int  m_Ids[1];
+};
+
+struct WorkerAgent
+{
+  unsigned int m_Runs;
+  void*        m_Worker;
+  bool         m_Moved;
+};
+
+static unsigned int worker_callback( unsigned int id, unsigned int action, void* bss,
+  void** data, void* user_data )
+{
+  WorkerAgent* wa = (WorkerAgent*)user_data;
+  void* worker = get_worker_data();
+  if( wa->m_Runs != 0 && wa->m_Worker != worker )
+    wa->m_Moved = true;
+  wa->m_Worker = worker;
+  ++wa->m_Runs;
+  return E_NODE_WORKING;
+}
+
+static void init_worker_program( WorkerProgram* p )
+{
+  memset( p, 0, sizeof(WorkerProgram) );
+  p->m_Header.m_IC = 2;
+  p->m_Header.m_DS = sizeof(unsigned int);
+  p->m_Header.m_BS = sizeof(BssHeader);
+  p->m_Header.m_CC = 1;
+  p->m_Header.m_CT = 0;
+  p->m_Inst[0].m_I  = INST_FUSE_EXEC_FUN;
+  p->m_Inst[0].m_A1 = 0;
+  p->m_Inst[0].m_A2 = NO_OPERAND;
+  p->m_Inst[0].m_A3 = NO_OPERAND;
+  p->m_Inst[1].m_I  = INST_______SUSPEND;
+  p->m_Ids[0] = 1;
+}
+
+const unsigned int WORKER_TEST_AGENTS  = 1000;
+const unsigned int WORKER_TEST_THREADS = 4;
+
+struct WorkerTest
+{
+  WorkerProgram m_Program;
+  BssHeader     m_Bss[WORKER_TEST_AGENTS];
+  WorkerAgent   m_Agents[WORKER_TEST_AGENTS];
+  void*         m_UserData[WORKER_TEST_AGENTS];
+  int           m_WorkerData[WORKER_TEST_THREADS];
+  void*         m_Workers[WORKER_TEST_THREADS];
+  CallbackBatch m_Batch[2];
+};
+
+static void init_worker_test( WorkerTest* t )
+{
+  memset( t, 0, sizeof(WorkerTest) );
+  init_worker_program( &t->m_Program );
+  for( unsigned int i = 0; i < WORKER_TEST_AGENTS; ++i )
+    t->m_UserData[i] = &t->m_Agents[i];
+  for( unsigned int i = 0; i < WORKER_TEST_THREADS; ++i )
+    t->m_Workers[i] = &t->m_WorkerData[i];
+
+  //Two batches over the same program, split at an odd place
+  const unsigned int split = 333;
+  for( unsigned int b = 0; b < 2; ++b )
+  {
+    unsigned int first = b == 0 ? 0 : split;
+    t->m_Batch[b].m_Program  = &t->m_Program;
+    t->m_Batch[b].m_bss      = &t->m_Bss[first];
+    t->m_Batch[b].m_UserData = &t->m_UserData[first];
+    t->m_Batch[b].m_Stride   = sizeof(BssHeader);
+    t->m_Batch[b].m_Count    = b == 0 ? split : WORKER_TEST_AGENTS - split;
+    t->m_Batch[b].m_Callback = &worker_callback;
+  }
+}
+
+TEST( WorkersRunEveryAgentOncePerTick )
+{
+  static WorkerTest t;
+  init_worker_test( &t );
+
+  WorkerPool* wp = create_worker_pool( WORKER_TEST_THREADS, t.m_Workers );
+  for( unsigned int tick = 0; tick < 10; ++tick )
+    run_workers( wp, t.m_Batch, 2 );
+  destroy_worker_pool( wp );
+
+  for( unsigned int i = 0; i < WORKER_TEST_AGENTS; ++i )
+    CHECK_EQUAL( 10u, t.m_Agents[i].m_Runs );
+}
+
+TEST( WorkersPassTheirOwnData )
+{
+  static WorkerTest t;
+  init_worker_test( &t );
+
+  WorkerPool* wp = create_worker_pool( WORKER_TEST_THREADS, t.m_Workers );
+  run_workers( wp, t.m_Batch, 2 );
+  destroy_worker_pool( wp );
+
+  for( unsigned int i = 0; i < WORKER_TEST_AGENTS; ++i )
+  {
+    bool known = false;
+    for( unsigned int w = 0; w < WORKER_TEST_THREADS; ++w )
+      known = known || t.m_Agents[i].m_Worker == t.m_Workers[w];
+    CHECK( known );
+  }
+  CHECK( get_worker_data() == 0x0 );
+}
+
+TEST( SingleWorkerRunsOnCallingThread )
+{
+  static WorkerTest t;
+  init_worker_test( &t );
+
+  WorkerPool* wp = create_worker_pool( 1, t.m_Workers );
+  for( unsigned int tick = 0; tick < 3; ++tick )
+    CHECK_EQUAL( 0u, run_workers( wp, t.m_Batch, 2 ) );
+  destroy_worker_pool( wp );
+
+  for( unsigned int i = 0; i < WORKER_TEST_AGENTS; ++i )
+  {
+    CHECK_EQUAL( 3u, t.m_Agents[i].m_Runs );
+    CHECK( t.m_Agents[i].m_Worker == t.m_Workers[0] );
+    CHECK( !t.m_Agents[i].m_Moved );
+  }
+}